@@ -208,9 +208,29 @@ namespace Falcor
             supported |= Device::SupportedFeatures::Raytracing;
         }
 
+        D3D12_FEATURE_DATA_D3D12_OPTIONS6 features6;
+        hr = pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS6, &features6, sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS6));
+        if (FAILED(hr) || features6.VariableShadingRateTier == D3D12_VARIABLE_SHADING_RATE_TIER_NOT_SUPPORTED)
+        {
+            logInfo("Variable-rate shading is not supported on this device.");
+        }
+        else
+        {
+            supported |= Device::SupportedFeatures::VariableRateShadingTier1;
+            if (features6.VariableShadingRateTier == D3D12_VARIABLE_SHADING_RATE_TIER_2) supported |= Device::SupportedFeatures::VariableRateShadingTier2;
+        }
+
         return supported;
     }
 
+    uint32_t getShadingRateImageTileSize(DeviceHandle pDevice)
+    {
+        D3D12_FEATURE_DATA_D3D12_OPTIONS6 features6;
+        HRESULT hr = pDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS6, &features6, sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS6));
+        if (FAILED(hr) || features6.VariableShadingRateTier != D3D12_VARIABLE_SHADING_RATE_TIER_2) return 0;
+        return features6.ShadingRateImageTileSize;
+    }
+
     CommandQueueHandle Device::getCommandQueueHandle(LowLevelContextData::CommandQueueType type, uint32_t index) const
     {
         return mCmdQueues[(uint32_t)type][index];
@@ -289,6 +309,7 @@ namespace Falcor
         }
 
         mSupportedFeatures = getSupportedFeatures(mApiHandle);
+        mShadingRateImageTileSize = getShadingRateImageTileSize(mApiHandle);
 
         if (desc.enableDebugLayer)
         {
@@ -211,6 +211,34 @@ namespace Falcor
         }
     }
 
+    static void D3D12SetShadingRate(RenderContext* pCtx, ID3D12GraphicsCommandList* pList, RenderContext::ShadingRate rate, const Texture* pShadingRateImage)
+    {
+        if (gpDevice->isFeatureSupported(Device::SupportedFeatures::VariableRateShadingTier1) == false)
+        {
+            if (rate != RenderContext::ShadingRate::Rate1x1 || pShadingRateImage) logWarning("Variable-rate shading is not supported on this device. Shading at full rate.");
+            return;
+        }
+
+        static_assert((uint32_t)RenderContext::ShadingRate::Rate2x2 == D3D12_SHADING_RATE_2X2, "ShadingRate::Rate2x2");
+        static_assert((uint32_t)RenderContext::ShadingRate::Rate4x4 == D3D12_SHADING_RATE_4X4, "ShadingRate::Rate4x4");
+
+        GET_COM_INTERFACE(pList, ID3D12GraphicsCommandList5, pList5);
+        bool useImage = pShadingRateImage && gpDevice->isFeatureSupported(Device::SupportedFeatures::VariableRateShadingTier2);
+        if (pShadingRateImage && !useImage)
+        {
+            logWarning("The shading-rate image requires variable-rate shading tier 2. Ignoring it.");
+        }
+
+        // The image, when bound, overrides the rate of the draw. The per-primitive rate isn't used.
+        D3D12_SHADING_RATE_COMBINER combiners[D3D12_RS_SET_SHADING_RATE_COMBINER_COUNT] = { D3D12_SHADING_RATE_COMBINER_PASSTHROUGH, useImage ? D3D12_SHADING_RATE_COMBINER_OVERRIDE : D3D12_SHADING_RATE_COMBINER_PASSTHROUGH };
+        pList5->RSSetShadingRate((D3D12_SHADING_RATE)rate, combiners);
+        if (useImage)
+        {
+            pCtx->resourceBarrier(pShadingRateImage, Resource::State::ShadingRateSource);
+        }
+        pList5->RSSetShadingRateImage(useImage ? pShadingRateImage->getApiHandle().GetInterfacePtr() : nullptr);
+    }
+
     static void D3D12SetViewports(ID3D12GraphicsCommandList* pList, const GraphicsState::Viewport* vp)
     {
         static_assert(offsetof(GraphicsState::Viewport, originX) == offsetof(D3D12_VIEWPORT, TopLeftX), "VP originX offset");
@@ -281,6 +309,11 @@ namespace Falcor
         {
             D3D12SetSamplePositions(pList, mpGraphicsState->getFbo().get());
         }
+        if (is_set(StateBindFlags::ShadingRate, mBindFlags) && mShadingRateDirty)
+        {
+            D3D12SetShadingRate(this, pList, mShadingRate, mpShadingRateImage.get());
+            mShadingRateDirty = false;
+        }
         if (is_set(StateBindFlags::Viewports, mBindFlags))
         {
             D3D12SetViewports(pList, &mpGraphicsState->getViewport(0));
@@ -128,6 +128,8 @@ namespace Falcor
             return D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
         case Resource::State::AccelerationStructure:
             return D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE;
+        case Resource::State::ShadingRateSource:
+            return D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE;
         default:
             should_not_get_here();
             return D3D12_RESOURCE_STATE_GENERIC_READ;
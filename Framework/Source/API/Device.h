@@ -79,7 +79,9 @@ namespace Falcor
             None = 0x0,
             ProgrammableSamplePositionsPartialOnly = 0x1, // On D3D12, this means tier 1 support. Allows one sample position to be set.
             ProgrammableSamplePositionsFull = 0x2,        // On D3D12, this means tier 2 support. Allows up to 4 sample positions to be set.
-            Raytracing = 0x4                              // On D3D12, DirectX Raytracing is supported. It is up to the user to not use raytracing functions when not supported.
+            Raytracing = 0x4,                             // On D3D12, DirectX Raytracing is supported. It is up to the user to not use raytracing functions when not supported.
+            VariableRateShadingTier1 = 0x8,               // On D3D12, this means tier 1 support. Allows a per-draw shading rate to be set.
+            VariableRateShadingTier2 = 0x10               // On D3D12, this means tier 2 support. Allows the shading rate to be set per screen tile from a shading-rate image.
         };
 
         /** Create a new device.
@@ -157,6 +159,10 @@ namespace Falcor
         */
         bool isFeatureSupported(SupportedFeatures flags) const;
 
+        /** Get the size in pixels of a screen tile covered by one texel of a shading-rate image. Returns 0 if variable-rate shading tier 2 isn't supported.
+        */
+        uint32_t getShadingRateImageTileSize() const { return mShadingRateImageTileSize; }
+
 #ifdef FALCOR_VK
         enum class MemoryType
         {
@@ -204,6 +210,7 @@ namespace Falcor
         std::vector<CommandQueueHandle> mCmdQueues[kQueueTypeCount];
 
         SupportedFeatures mSupportedFeatures = SupportedFeatures::None;
+        uint32_t mShadingRateImageTileSize = 0;
 
         // API specific functions
         bool getApiFboData(uint32_t width, uint32_t height, ResourceFormat colorFormat, ResourceFormat depthFormat, std::vector<ResourceHandle>& apiHandles, uint32_t& currentBackBufferIndex);
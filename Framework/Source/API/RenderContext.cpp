@@ -123,6 +123,16 @@ namespace Falcor
     {
         ComputeContext::flush(wait);
         mBindGraphicsRootSig = true;
+        // A new command list starts at full rate
+        mShadingRateDirty = (mShadingRate != ShadingRate::Rate1x1) || mpShadingRateImage;
+    }
+
+    void RenderContext::setShadingRate(ShadingRate rate, const Texture::SharedPtr& pShadingRateImage)
+    {
+        if (rate == mShadingRate && pShadingRateImage == mpShadingRateImage) return;
+        mShadingRate = rate;
+        mpShadingRateImage = pShadingRateImage;
+        mShadingRateDirty = true;
     }
 }
 
@@ -72,9 +72,23 @@ namespace Falcor
             Scissors        = 0x20,             ///<Bind scissors
             PipelineState   = 0x40,             ///<Bind Pipeline State Object
             SamplePositions = 0x80,             ///<Set the programmable sample positions
+            ShadingRate     = 0x100,            ///<Set the variable shading rate
             All             = uint32_t(-1)
         };
 
+        /** Shading rates for variable-rate shading. The values match the D3D12 encoding, which stores log2 of the width and height of the coarse pixel in two bits each.
+        */
+        enum class ShadingRate : uint32_t
+        {
+            Rate1x1 = 0x0,
+            Rate1x2 = 0x1,
+            Rate2x1 = 0x4,
+            Rate2x2 = 0x5,
+            Rate2x4 = 0x6,
+            Rate4x2 = 0x9,
+            Rate4x4 = 0xa,
+        };
+
         /** Create a new object.
         */
         static SharedPtr create(CommandQueueHandle queue);
@@ -198,6 +212,21 @@ namespace Falcor
         */
         StateBindFlags getBindFlags() const { return mBindFlags; }
 
+        /** Set the shading rate used by the following draws. Requires Device::SupportedFeatures::VariableRateShadingTier1, the shading-rate image requires tier 2.
+            The state persists across flushes until it's changed again. Call setShadingRate(ShadingRate::Rate1x1) to go back to full-rate shading.
+            \param[in] rate The shading rate of the draws
+            \param[in] pShadingRateImage Optional R8Uint texture holding one ShadingRate value per screen tile of Device::getShadingRateImageTileSize() pixels. Where it's set, it overrides the draw rate.
+        */
+        void setShadingRate(ShadingRate rate, const Texture::SharedPtr& pShadingRateImage = nullptr);
+
+        /** Get the shading rate set by setShadingRate()
+        */
+        ShadingRate getShadingRate() const { return mShadingRate; }
+
+        /** Get the shading-rate image set by setShadingRate()
+        */
+        const Texture::SharedPtr& getShadingRateImage() const { return mpShadingRateImage; }
+
         /** Resolve an entire multi-sampled resource. The dst and src resources must have the same dimensions, array-size, mip-count and format.
             If any of these properties don't match, you'll have to use `resolveSubresource`
         */
@@ -224,6 +253,10 @@ namespace Falcor
         std::stack<GraphicsState::SharedPtr> mPipelineStateStack;
         std::stack<GraphicsVars::SharedPtr> mpGraphicsVarsStack;
 
+        ShadingRate mShadingRate = ShadingRate::Rate1x1;
+        Texture::SharedPtr mpShadingRateImage;
+        bool mShadingRateDirty = false;
+
         /** Creates command signatures for DrawIndirect, DrawIndexedIndirect. Also calls
         compute context's initDispatchCommandSignature() to create command signature for dispatchIndirect
         */
@@ -77,6 +77,7 @@ namespace Falcor
             NonPixelShader,
 #ifdef FALCOR_D3D12
             AccelerationStructure,
+            ShadingRateSource,
 #endif
         };
 
@@ -39,6 +39,17 @@ namespace Falcor
         apiInit(false);
     }
 
+    void TypedBufferBase::setBlob(const void* pSrc, size_t offset, size_t size)
+    {
+        if (offset + size > mData.size())
+        {
+            logError("TypedBuffer::setBlob() - blob is too large and will result in overflow. Ignoring call.");
+            return;
+        }
+        std::memcpy(mData.data() + offset, pSrc, size);
+        mCpuDirty = true;
+    }
+
     bool TypedBufferBase::uploadToGPU()
     {
         if (mCpuDirty == false)
@@ -49,6 +49,13 @@ namespace Falcor
         */
         uint32_t getElementCount() const { return mElementCount; }
 
+        /** Set a blob of data. Copies into the CPU copy, which is uploaded with the other changes.
+            \param[in] pSrc Pointer to the data
+            \param[in] offset Offset in bytes from the start of the buffer
+            \param[in] size Size in bytes
+        */
+        void setBlob(const void* pSrc, size_t offset, size_t size);
+
         void setGpuCopyDirty() { mGpuDirty = true; }
 
         /** Get the resource format associated with this buffer
@@ -252,7 +252,18 @@ namespace Falcor
 
     void CopyContext::uavBarrier(const Resource* pResource)
     {
-        UNSUPPORTED_IN_VULKAN("uavBarrier");
+        assert(is_set(pResource->getBindFlags(), Resource::BindFlags::UnorderedAccess));
+
+        // The resource stays in the same layout, so a global memory barrier makes the shader writes visible to the following reads, writes and indirect arguments
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+        VkPipelineStageFlags srcStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+        vkCmdPipelineBarrier(mpLowLevelData->getCommandList(), srcStages, dstStages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        mCommandsPending = true;
     }
 
     void CopyContext::apiSubresourceBarrier(const Texture* pTexture, Resource::State newState, Resource::State oldState, uint32_t arraySlice, uint32_t mipLevel)
@@ -214,6 +214,14 @@ namespace Falcor
                 logWarning("The Vulkan backend doesn't support programmable sample positions");
             }
         }
+        if (is_set(StateBindFlags::ShadingRate, mBindFlags) && mShadingRateDirty)
+        {
+            if (mShadingRate != ShadingRate::Rate1x1 || mpShadingRateImage)
+            {
+                logWarning("The Vulkan backend doesn't support variable-rate shading");
+            }
+            mShadingRateDirty = false;
+        }
         if (is_set(RenderContext::StateBindFlags::Viewports, mBindFlags))
         {
             setViewports(mpLowLevelData->getCommandList(), mpGraphicsState->getViewports());
@@ -40,6 +40,11 @@
 #define CsmFilterEvsm4 5
 #define CsmFilterStochasticPcf 6
 
+// Values of CascadedShadowMaps::PartitionMode
+#define CsmPartitionLinear 0
+#define CsmPartitionLogarithmic 1
+#define CsmPartitionPssm 2
+
 struct CsmData
 {
     float4x4 globalMat;
@@ -67,7 +72,34 @@ struct CsmData
 #endif
 };
 
+/** Partition of one cascade. Written by the GPU when the SDSM depth bounds are reduced on the GPU, see SdsmReduction.
+*/
+struct CsmCascadeData
+{
+    float4 scale;
+    float4 offset;
+    float4 range;       // In camera clip-space. Only uses xy.
+};
+
+/** The inputs of the cascade partitioning that don't depend on the scene depth
+*/
+struct CsmPartitionData
+{
+    float4x4 globalMat;
+    float4x4 camProjMat;
+    float4 camFrustum[8];           // World-space corners of the camera frustum. The near plane comes first. Only uses xyz.
+    float nearPlane;
+    float farPlane;
+    uint32_t cascadeCount;
+    uint32_t partitionMode;         // CsmPartitionLinear, CsmPartitionLogarithmic or CsmPartitionPssm
+    float pssmLambda;
+    float cascadeBlendThreshold;
+    uint32_t stabilizeCascades;
+    uint32_t padding;
+};
+
 #ifdef HOST_CODE
 static_assert(sizeof(CsmData) % sizeof(float4) == 0, "CsmData size should be aligned on float4 size");
+static_assert(sizeof(CsmPartitionData) % sizeof(float4) == 0, "CsmPartitionData size should be aligned on float4 size");
 #endif
 #endif //CSMDATA_H
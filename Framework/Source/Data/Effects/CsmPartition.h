@@ -0,0 +1,204 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#ifndef CSMPARTITION_H
+#define CSMPARTITION_H
+
+#include "Data/Effects/CsmData.h"
+
+/*******************************************************************
+    Cascade partitioning shared by the GPU partition in SdsmReduction.cs.slang and the CPU partition in Effects/Shadows/SdsmReduction.cpp.
+    Distances are linear depth, normalized between the camera's near and far planes.
+*******************************************************************/
+
+#ifdef HOST_CODE
+namespace Falcor {
+    using glm::max;
+    using glm::min;
+    using glm::pow;
+    using glm::floor;
+    using glm::lerp;
+    using glm::saturate;
+#endif
+
+/** Transform a position by one of the matrices of CsmPartitionData
+*/
+inline float4 csmTransform(float4x4 mat, float4 pos)
+{
+#ifdef HOST_CODE
+    return mat * pos;
+#else
+    return mul(pos, mat);
+#endif
+}
+
+/** Convert depth bounds into the range of linear depth they cover. Applies the cascade stabilization.
+*/
+inline float2 calcCsmDistanceRange(CsmPartitionData partition, float2 depthRange)
+{
+    // Convert to linear depth, normalized between the near and far planes
+    float4x4 camProj = partition.camProjMat;
+    float2 distanceRange = camProj[2][2] - depthRange * camProj[2][3];
+    distanceRange = camProj[3][2] / distanceRange;
+    distanceRange = (distanceRange - partition.nearPlane) / (partition.farPlane - partition.nearPlane);
+    distanceRange = saturate(distanceRange);
+
+    if (partition.stabilizeCascades != 0)
+    {
+        // Ignore minor changes that can result in swimming. Rounds halves up, where round() differs between the CPU and the GPU.
+        distanceRange = floor(distanceRange * 16.0f + 0.5f) / 16.0f;
+        distanceRange.y = max(distanceRange.y, 0.005f);
+    }
+    return distanceRange;
+}
+
+/** Calculate where a cascade ends, blending between logarithmic and uniform splits of the distance range
+    \param[in] linearBlend 1 for logarithmic splits, 0 for uniform ones
+*/
+inline float calcCsmPssmPartitionEnd(float nearPlane, float camDepthRange, float2 distanceRange, float linearBlend, uint32_t cascade, uint32_t cascadeCount)
+{
+    // Convert to camera space
+    float minDepth = nearPlane + distanceRange.x * camDepthRange;
+    float maxDepth = nearPlane + distanceRange.y * camDepthRange;
+
+    float depthRange = maxDepth - minDepth;
+    float depthScale = maxDepth / minDepth;
+
+    float cascadeScale = float(cascade + 1) / float(cascadeCount);
+    float logSplit = pow(depthScale, cascadeScale) * minDepth;
+    float uniSplit = minDepth + depthRange * cascadeScale;
+
+    float distance = linearBlend * logSplit + (1 - linearBlend) * uniSplit;
+
+    // Convert back to clip-space
+    return (distance - nearPlane) / camDepthRange;
+}
+
+/** Calculate the slice of the camera frustum covered by a cascade. The slice includes the overlap used to blend with the next cascade.
+    \param[in] distanceRange The range to partition
+    \return The start and end of the slice
+*/
+inline float2 calcCsmCascadeSlice(CsmPartitionData partition, float2 distanceRange, uint32_t cascade)
+{
+    float camDepthRange = partition.farPlane - partition.nearPlane;
+    float nextCascadeStart = distanceRange.x;
+    float2 slice = float2(0.0f, 0.0f);
+    for (uint32_t c = 0; c <= cascade; c++)
+    {
+        float cascadeStart = nextCascadeStart;
+
+        switch (partition.partitionMode)
+        {
+        case CsmPartitionLinear:
+            nextCascadeStart = cascadeStart + (distanceRange.y - distanceRange.x) / float(partition.cascadeCount);
+            break;
+        case CsmPartitionLogarithmic:
+            nextCascadeStart = calcCsmPssmPartitionEnd(partition.nearPlane, camDepthRange, distanceRange, 1.0f, c, partition.cascadeCount);
+            break;
+        default:
+            nextCascadeStart = calcCsmPssmPartitionEnd(partition.nearPlane, camDepthRange, distanceRange, partition.pssmLambda, c, partition.cascadeCount);
+            break;
+        }
+
+        // If we blend between cascades, we need to expand the range to make sure we will not try to read off the edge of the shadow-map
+        float blendCorrection = (nextCascadeStart - cascadeStart) * (partition.cascadeBlendThreshold * 0.5f);
+        slice = float2(cascadeStart, nextCascadeStart + blendCorrection);
+        nextCascadeStart -= blendCorrection;
+    }
+    return slice;
+}
+
+/** Calculate the clip-space range and the crop transform of a cascade covering a slice of the camera frustum
+    \param[in] slice The start and end of the slice, see calcCsmCascadeSlice()
+*/
+inline CsmCascadeData calcCsmCascade(CsmPartitionData partition, float2 slice)
+{
+    CsmCascadeData cascade;
+    float nearPlane = partition.nearPlane;
+    float farPlane = partition.farPlane;
+
+    // Calculate the cascade distance in camera-clip space(Where the clip-space range is [0, farPlane])
+    float camClipSpaceCascadeStart = lerp(nearPlane, farPlane, slice.x);
+    float camClipSpaceCascadeEnd = lerp(nearPlane, farPlane, slice.y);
+
+    //Convert to ndc space [0, 1]
+    float projTermA = farPlane / (nearPlane - farPlane);
+    float projTermB = (-farPlane * nearPlane) / (farPlane - nearPlane);
+    float ndcSpaceCascadeStart = (-camClipSpaceCascadeStart * projTermA + projTermB) / camClipSpaceCascadeStart;
+    float ndcSpaceCascadeEnd = (-camClipSpaceCascadeEnd * projTermA + projTermB) / camClipSpaceCascadeEnd;
+    cascade.range = float4(ndcSpaceCascadeStart, ndcSpaceCascadeEnd - ndcSpaceCascadeStart, 0, 0);
+
+    // Transform the frustum of the slice into light clip-space and calculate min-max
+    float4 maxCS = float4(-1, -1, 0, 1);
+    float4 minCS = float4(1, 1, 1, 1);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        float4 nearCorner = partition.camFrustum[i];
+        float4 farCorner = partition.camFrustum[i + 4];
+        float3 edge = float3(farCorner.x - nearCorner.x, farCorner.y - nearCorner.y, farCorner.z - nearCorner.z);
+        for (uint32_t j = 0; j < 2; j++)
+        {
+            float3 corner = float3(nearCorner.x, nearCorner.y, nearCorner.z) + edge * slice[j];
+            float4 c = csmTransform(partition.globalMat, float4(corner, 1.0f));
+            c /= c.w;
+            maxCS = max(maxCS, c);
+            minCS = min(minCS, c);
+        }
+    }
+
+    float4 delta = maxCS - minCS;
+    cascade.scale = float4(2, 2, 1, 1) / delta;
+
+    cascade.offset.x = -0.5f * (maxCS.x + minCS.x) * cascade.scale.x;
+    cascade.offset.y = -0.5f * (maxCS.y + minCS.y) * cascade.scale.y;
+    cascade.offset.z = -minCS.z * cascade.scale.z;
+
+    cascade.scale.w = 1;
+    cascade.offset.w = 0;
+    return cascade;
+}
+
+/** Partition a cascade
+    \param[in] distanceRange The range to partition, see calcCsmDistanceRange()
+*/
+inline CsmCascadeData partitionCsmCascade(CsmPartitionData partition, float2 distanceRange, uint32_t cascade)
+{
+    if (partition.cascadeCount == 1)
+    {
+        CsmCascadeData single;
+        single.scale = float4(1, 1, 1, 1);
+        single.offset = float4(0, 0, 0, 0);
+        single.range = float4(0, 1, 0, 0);
+        return single;
+    }
+    return calcCsmCascade(partition, calcCsmCascadeSlice(partition, distanceRange, cascade));
+}
+
+#ifdef HOST_CODE
+} // namespace Falcor
+#endif
+#endif //CSMPARTITION_H
@@ -0,0 +1,75 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#ifndef LIGHTCLUSTERDATA_H
+#define LIGHTCLUSTERDATA_H
+
+#include "Data/HostDeviceData.h"
+
+#ifdef HOST_CODE
+#include <cmath>
+
+namespace Falcor {
+    using glm::max;
+    using glm::clamp;
+    using std::log;
+#endif
+
+/** Number of light clusters along each axis. x and y split the screen into tiles, z splits the view depth exponentially between the near and far planes.
+*/
+#define LIGHT_CLUSTER_COUNT_X 16
+#define LIGHT_CLUSTER_COUNT_Y 8
+#define LIGHT_CLUSTER_COUNT_Z 24
+
+struct LightClusterData
+{
+    float sliceScale;           ///< LIGHT_CLUSTER_COUNT_Z / log(farZ / nearZ)
+    float sliceBias;            ///< -log(nearZ) * sliceScale
+    uint32_t lightCount;        ///< Number of lights in the light buffer
+    uint32_t padding;
+};
+
+/** Depth slice of a view-space depth (the distance along the view direction)
+*/
+inline uint32_t getLightClusterSlice(LightClusterData data, float viewDepth)
+{
+    float slice = log(max(viewDepth, 1e-6f)) * data.sliceScale + data.sliceBias;
+    return uint32_t(clamp(slice, 0.0f, float(LIGHT_CLUSTER_COUNT_Z - 1)));
+}
+
+/** Index of a cluster in the cluster range buffer. The clusters of a slice are contiguous, and tile row 0 is at the top of the screen.
+*/
+inline uint32_t getLightClusterIndex(uint32_t x, uint32_t y, uint32_t z)
+{
+    return (z * LIGHT_CLUSTER_COUNT_Y + y) * LIGHT_CLUSTER_COUNT_X + x;
+}
+
+#ifdef HOST_CODE
+static_assert(sizeof(LightClusterData) % sizeof(float4) == 0, "LightClusterData size should be aligned on float4 size");
+} // namespace Falcor
+#endif
+#endif //LIGHTCLUSTERDATA_H
@@ -31,7 +31,10 @@
 #include "Data/HostDeviceData.h"
 
 #define EMIT_THREADS 64
-#define SORT_THREADS 1024
+#define SORT_THREADS 256            // Elements per group of the radix sort, one per thread
+#define SORT_RADIX_BITS 8
+#define SORT_RADIX_BINS 256         // 1 << SORT_RADIX_BITS, has to be equal to SORT_THREADS
+#define SORT_SCAN_THREADS 1024
 
 struct Particle
 {
@@ -60,6 +63,22 @@ struct SortData
     float depth;
 };
 
+/** Constants of the kernels in ParticleIndirectArgs.cs.slang
+*/
+struct IndirectArgsPerFrame
+{
+    uint numEmit;           ///< Number of particles passed to the emit shader this frame, 0 if it didn't run
+    uint maxParticles;
+    uint simulateThreads;   ///< Thread group size of the simulate shader
+    uint padding;
+};
+
+struct SortPerPass
+{
+    uint radixShift;        ///< First bit of the digit sorted by this pass
+    uint3 padding;
+};
+
 struct ColorInterpPsPerFrame
 {
     float4 color1;
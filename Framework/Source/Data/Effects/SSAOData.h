@@ -38,6 +38,21 @@ struct SSAOData
     float2 noiseScale DEFAULTS(float2(1, 1));
     uint32_t kernelSize DEFAULTS(1);
     float radius DEFAULTS(0.1f);
+    float2 noiseOffset DEFAULTS(float2(0, 0));  ///< Offset of the noise texture coordinates. Changed every frame when accumulating temporally.
+};
+
+/** Parameters of the bilateral filter passes, used when the AO map is computed at a fraction of the depth-buffer resolution
+*/
+struct SSAOFilterData
+{
+    float2 lowResTexelSize;                     ///< 1 / size of the low-resolution textures
+    float depthSigma DEFAULTS(0.05f);           ///< Relative difference of the distances to the camera at which a neighbor's weight falls to 1/e
+    float normalPower DEFAULTS(8.0f);           ///< Exponent of the cosine between the normals in a neighbor's weight
+    int blurRadius DEFAULTS(4);                 ///< Radius of the separable blur, in low-resolution texels
+    float blurSigma DEFAULTS(2.0f);             ///< Standard deviation of the spatial weights of the blur
+    uint32_t downsampleFactor DEFAULTS(2);      ///< Size of the footprint of a low-resolution texel, in depth-buffer texels
+    float temporalAlpha DEFAULTS(0.1f);         ///< Weight of the current frame in the temporal accumulation
+    uint32_t historyValid DEFAULTS(0);          ///< Whether the history textures hold the previous frame
 };
 
 #endif //SSAODATA_H
@@ -0,0 +1,69 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#ifndef SHADINGCACHEDATA_H
+#define SHADINGCACHEDATA_H
+
+#include "Data/HostDeviceData.h"
+
+#ifdef HOST_CODE
+namespace Falcor {
+#endif
+
+struct ShadingCacheData
+{
+    float2 invResolution;       ///< 1 / size of the render target
+    uint32_t frameIndex;        ///< Selects the pixels that are refreshed this frame
+    uint32_t refreshPeriod;     ///< Every pixel is shaded at least once in this many frames. 1 disables the reuse.
+    float depthThreshold;       ///< Maximum relative difference between the reprojected and the cached linear depth
+    float normalThreshold;      ///< Minimum cosine of the angle between the current and the cached normal
+    uint32_t historyValid;      ///< The history holds a frame rendered with the current settings
+    uint32_t useMotionVectors;  ///< Reproject with gMotionTex instead of the camera matrices
+};
+
+/** Index of a pixel in a 4x4 ordered-dither matrix. Consecutive indices are spread out over the 4x4 block.
+*/
+inline uint32_t getShadingCacheDitherIndex(uint32_t x, uint32_t y)
+{
+    // Recursive 2x2 Bayer matrix [0 2; 3 1]
+    uint32_t fine = ((x ^ y) & 1) * 2 + (y & 1);
+    uint32_t coarse = (((x ^ y) >> 1) & 1) * 2 + ((y >> 1) & 1);
+    return fine * 4 + coarse;
+}
+
+/** Check if a pixel is shaded this frame regardless of the cache. With a power-of-two period up to 16, each frame refreshes the same number of pixels in every 4x4 block.
+*/
+inline bool isShadingCacheRefreshPixel(ShadingCacheData data, uint32_t x, uint32_t y)
+{
+    return ((getShadingCacheDitherIndex(x, y) + data.frameIndex) % data.refreshPeriod) == 0;
+}
+
+#ifdef HOST_CODE
+static_assert(sizeof(ShadingCacheData) % sizeof(float4) == 0, "ShadingCacheData size should be aligned on float4 size");
+} // namespace Falcor
+#endif
+#endif //SHADINGCACHEDATA_H
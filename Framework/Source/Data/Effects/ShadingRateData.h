@@ -0,0 +1,85 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#ifndef SHADINGRATEDATA_H
+#define SHADINGRATEDATA_H
+
+#include "Data/HostDeviceData.h"
+
+#ifdef HOST_CODE
+namespace Falcor {
+#endif
+
+// Shading rates written into the shading-rate image. They match RenderContext::ShadingRate and D3D12_SHADING_RATE.
+#define SHADING_RATE_1X1 0x0
+#define SHADING_RATE_2X2 0x5
+#define SHADING_RATE_4X4 0xa
+
+struct ShadingRateData
+{
+    uint32_t tileSize;          ///< Size in pixels of the screen tile covered by one texel of the shading-rate image
+    uint32_t maxRate;           ///< The coarsest rate a tile can get, SHADING_RATE_2X2 or SHADING_RATE_4X4
+    float contrastThreshold;    ///< Tiles with a higher luminance contrast are shaded at full rate, tiles below half of it at maxRate
+    float motionScale;          ///< Increase of the threshold per pixel of motion. Moving detail is blurred by TAA and harder to see.
+};
+
+/** Luminance used to measure the contrast of a tile. It is compressed like a Reinhard tone-map, so that the contrast of a tile matches what is displayed.
+*/
+inline float getShadingRateLuminance(float r, float g, float b)
+{
+    float luminance = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+    return luminance / (1.0f + luminance);
+}
+
+/** Select the shading rate of a tile
+    \param[in] lumMean The mean of getShadingRateLuminance() over the pixels of the tile
+    \param[in] lumVariance The variance of getShadingRateLuminance() over the pixels of the tile
+    \param[in] maxMotion The largest motion in pixels inside the tile
+*/
+inline uint32_t calcTileShadingRate(ShadingRateData data, float lumMean, float lumVariance, float maxMotion)
+{
+    // The standard deviation relative to the mean, so that dark and bright tiles are treated alike
+    float contrast = sqrt(lumVariance > 0.0f ? lumVariance : 0.0f) / (lumMean > 1e-3f ? lumMean : 1e-3f);
+    float threshold = data.contrastThreshold * (1.0f + maxMotion * data.motionScale);
+    if (contrast >= threshold) return SHADING_RATE_1X1;
+    if (contrast >= 0.5f * threshold) return SHADING_RATE_2X2;
+    return data.maxRate;
+}
+
+/** Get the number of pixel-shader invocations of a coarse pixel relative to full rate
+*/
+inline float getShadingRateCost(uint32_t rate)
+{
+    // The rate stores log2 of the width in bits 2-3 and log2 of the height in bits 0-1
+    return 1.0f / float((1u << ((rate >> 2) & 3)) * (1u << (rate & 3)));
+}
+
+#ifdef HOST_CODE
+static_assert(sizeof(ShadingRateData) % sizeof(float4) == 0, "ShadingRateData size should be aligned on float4 size");
+} // namespace Falcor
+#endif
+#endif //SHADINGRATEDATA_H
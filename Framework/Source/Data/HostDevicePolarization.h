@@ -0,0 +1,163 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#ifndef _HOST_DEVICE_POLARIZATION_H
+#define _HOST_DEVICE_POLARIZATION_H
+
+#include "HostDeviceSharedMacros.h"
+
+/*******************************************************************
+    Polarization functions shared by the shaders and the CPU reference in Utils/Polarization.h.
+
+    psi is the degree of polarization of the specular reflection, so that a linear polarizing filter at
+    angle phi relative to the plane of incidence scales the specular term by (1 + cos(2*phi)*psi).
+
+    ct  - cos(theta), where theta is the angle between the light and the half vector
+    st2 - sin^2(theta)
+*******************************************************************/
+
+#ifdef HOST_CODE
+#include "glm/gtx/compatibility.hpp"
+
+namespace Falcor {
+    using glm::float3;
+    using glm::saturate;
+    using glm::sqrt;
+    using glm::cross;
+    using glm::length;
+#endif
+
+#define POLARIZATION_SQRT2 1.41421356f
+
+/** Specular reflectance at normal incidence of a conductor
+    \param[in] n Simple refractive index
+    \param[in] k Extinction coefficient
+*/
+inline float3 SpecularFromIOR(float3 n, float3 k)
+{
+    float3 t1 = (n - float3(1.0f));
+    float3 t2 = (n + float3(1.0f));
+
+    return saturate((t1*t1 + k*k)/(t2*t2 + k*k));
+}
+
+/*******************************************************************
+    The psi formulas are written once as macros over the value type, and instantiated below for the shaders and the generic CPU path.
+    Utils/Polarization.cpp instantiates them again for its SIMD register type, so all paths evaluate the same expressions in the same order.
+
+    T - The type of the per-channel values (float3 in the shaders, or a SIMD register)
+    S - The type of the angle terms (float, or the same SIMD register)
+*******************************************************************/
+
+/** Exact psi for a conductor
+    n - Simple refractive index
+    k - Extinction coefficient
+*/
+#define POLARIZATION_DEFINE_PSI_EXACT(name, T, S)                                   \
+inline T name(T n, T k, S ct, S st2)                                                \
+{                                                                                   \
+    T n2 = n*n;                                                                     \
+    T k2 = k*k;                                                                     \
+                                                                                    \
+    T c = n2 - k2 - T(st2);                                                         \
+    T h = sqrt(c*c + 4.0f*n2*k2);                                                   \
+    T g = sqrt(h + c);                                                              \
+                                                                                    \
+    return saturate(((POLARIZATION_SQRT2*ct*st2)*g)/((ct*ct)*h + T(st2*st2)));      \
+}
+
+/** Approximate psi for a conductor
+    R0 - Specular color
+*/
+#define POLARIZATION_DEFINE_PSI_METAL_APPROX(name, T, S)                            \
+inline T name(T R0, S ct, S st2)                                                    \
+{                                                                                   \
+    T Rb = T(1.095f) - R0;                                                          \
+    T Rg = T(1.18f) - R0;                                                           \
+    T beta  = T(0.1f)/(Rb*Rb*Rb) + 5.4f*R0*R0 + T(1.0f);                            \
+    T gamma = (0.16f*R0*R0)/(Rg*Rg) + 0.35f*Rg;                                     \
+                                                                                    \
+    T psi = (ct*st2)/(beta*ct*ct + gamma*st2*st2);                                  \
+    return saturate(psi);                                                           \
+}
+
+/** Exact psi for a dielectric
+    R0 - Specular reflectance at normal incidence
+*/
+#define POLARIZATION_DEFINE_PSI_DIELECTRIC_EXACT(name, S)                           \
+inline S name(S R0, S ct, S st2)                                                    \
+{                                                                                   \
+    S n = (1.0f + sqrt(R0))/(1.0f - sqrt(R0));                                      \
+    S c = n*n - st2;                                                                \
+                                                                                    \
+    S psi = (2.0f*sqrt(c)*ct*st2)/(c*ct*ct + st2*st2);                              \
+                                                                                    \
+    return saturate(psi);                                                           \
+}
+
+/** Exact psi for a dielectric with R0 = 0.04, i.e. n = 1.5
+*/
+#define POLARIZATION_DEFINE_PSI_DIELECTRIC_ONE_FIVE(name, S)                        \
+inline S name(S ct, S st2)                                                          \
+{                                                                                   \
+    S e = 2.25f - st2;                                                              \
+    return saturate((2.0f*sqrt(e)*ct*st2)/(e*ct*ct + st2*st2));                     \
+}
+
+POLARIZATION_DEFINE_PSI_EXACT(psi_Exact, float3, float)
+POLARIZATION_DEFINE_PSI_METAL_APPROX(psi_MetalApprox, float3, float)
+POLARIZATION_DEFINE_PSI_DIELECTRIC_EXACT(psi_DielectricExact, float)
+POLARIZATION_DEFINE_PSI_DIELECTRIC_ONE_FIVE(psi_DielectricOneFive, float)
+
+/** Resolution of each axis of the psi lookup textures baked by PsiLut. Texel i holds the value at i/(PSI_LUT_SIZE - 1).
+*/
+#define PSI_LUT_SIZE 128
+
+/** Texture coordinate of a value in [0, 1] along an axis of a psi lookup texture
+*/
+inline float psiLutCoord(float x)
+{
+    return (saturate(x)*float(PSI_LUT_SIZE - 1) + 0.5f)/float(PSI_LUT_SIZE);
+}
+
+/** x axis of the Stokes frame of the light-probe polarization textures baked by ProbePolarization. The y axis is cross(R, x).
+    \param[in] R Direction of the texel
+*/
+inline float3 probePolarizationFrameX(float3 R)
+{
+    float3 x = cross(float3(0.0f, 1.0f, 0.0f), R);
+    float len = length(x);
+    return (len > 1e-4f) ? x/len : float3(1.0f, 0.0f, 0.0f);
+}
+
+#ifdef HOST_CODE
+} // namespace Falcor
+#endif
+
+#endif //_HOST_DEVICE_POLARIZATION_H
@@ -35,6 +35,8 @@
 #include "glm/gtc/packing.hpp"
 #include "Utils/Math/FalcorMath.h"
 #include "Graphics/Scene/Scene.h"
+#include "Utils/PatternGenerators/LowDiscrepancySequence.h"
+#include "Utils/PatternGenerators/BlueNoise.h"
 
 namespace Falcor
 {
@@ -44,9 +46,37 @@ namespace Falcor
     {
         { (uint32_t)SampleDistribution::Random, "Random" },
         { (uint32_t)SampleDistribution::UniformHammersley, "Uniform Hammersley" },
-        { (uint32_t)SampleDistribution::CosineHammersley, "Cosine Hammersley" }
+        { (uint32_t)SampleDistribution::CosineHammersley, "Cosine Hammersley" },
+        { (uint32_t)SampleDistribution::CosineSobol, "Cosine Sobol" }
     };
 
+    const Gui::DropdownList SSAO::kResolutionDropdown =
+    {
+        { (uint32_t)Resolution::Fixed, "Fixed" },
+        { (uint32_t)Resolution::Full, "Full" },
+        { (uint32_t)Resolution::Half, "Half" },
+        { (uint32_t)Resolution::Quarter, "Quarter" }
+    };
+
+    static void setCamera(const Camera* pCamera, GraphicsVars* pVars)
+    {
+        ConstantBuffer* pCB = pVars->getDefaultBlock()->getConstantBuffer("InternalPerFrameCB").get();
+        if (pCB != nullptr)
+        {
+            pCamera->setIntoConstantBuffer(pCB, 0);
+        }
+    }
+
+    static void runPass(RenderContext* pContext, const GraphicsState::SharedPtr& pState, const Fbo::SharedPtr& pFbo, FullScreenPass* pPass, const GraphicsVars::SharedPtr& pVars)
+    {
+        pState->setFbo(pFbo);
+        pContext->pushGraphicsState(pState);
+        pContext->pushGraphicsVars(pVars);
+        pPass->execute(pContext);
+        pContext->popGraphicsVars();
+        pContext->popGraphicsState();
+    }
+
     SSAO::SharedPtr SSAO::create(const uvec2& aoMapSize, uint32_t kernelSize, uint32_t blurSize, float blurSigma, const uvec2& noiseSize, SampleDistribution distribution)
     {
         return SharedPtr(new SSAO(aoMapSize, kernelSize, blurSize, blurSigma, noiseSize, distribution));
@@ -72,19 +102,79 @@ namespace Falcor
                 mDirty = true;
             }
 
+            uint32_t resolution = (uint32_t)mResolution;
+            if (pGui->addDropdown("Resolution", kResolutionDropdown, resolution))
+            {
+                setResolution((Resolution)resolution);
+            }
+
+            if (mResolution != Resolution::Fixed)
+            {
+                bool temporal = mTemporalAccumulation;
+                if (pGui->addCheckBox("Temporal Accumulation", temporal))
+                {
+                    setTemporalAccumulation(temporal);
+                }
+                if (mTemporalAccumulation)
+                {
+                    pGui->addFloatVar("Temporal Alpha", mFilter.data.temporalAlpha, 0.01f, 1.0f);
+                }
+            }
+
             pGui->addCheckBox("Apply Blur", mApplyBlur);
 
-            if (mApplyBlur)
+            if (mApplyBlur && mResolution == Resolution::Fixed)
             {
                 mpBlur->renderUI(pGui, "Blur Settings");
             }
 
+            if (mResolution != Resolution::Fixed && pGui->beginGroup("Bilateral Filter"))
+            {
+                pGui->addIntVar("Blur Radius", mFilter.data.blurRadius, 1, 16);
+                pGui->addFloatVar("Blur Sigma", mFilter.data.blurSigma, 0.5f, 16.0f);
+                pGui->addFloatVar("Depth Sigma", mFilter.data.depthSigma, 0.001f, 1.0f);
+                pGui->addFloatVar("Normal Power", mFilter.data.normalPower, 0.0f, 64.0f);
+                pGui->endGroup();
+            }
+
             if (uiGroup) pGui->endGroup();
         }
     }
 
     Texture::SharedPtr SSAO::generateAOMap(RenderContext* pContext, const Camera* pCamera, const Texture::SharedPtr& pDepthTexture, const Texture::SharedPtr& pNormalTexture)
     {
+        const bool isBilateral = (mResolution != Resolution::Fixed);
+        const uvec2 srcSize(pDepthTexture->getWidth(), pDepthTexture->getHeight());
+        if (mResolution != mFilter.resolution || (isBilateral && srcSize != mFilter.srcSize))
+        {
+            createFilterResources(srcSize.x, srcSize.y);
+        }
+
+        // The bilateral paths compute AO from a downsampled copy of the depth and normals
+        Texture::SharedPtr pAODepth = pDepthTexture;
+        Texture::SharedPtr pAONormals = pNormalTexture;
+        if (isBilateral)
+        {
+            // Offset the noise by whole texels every frame, so that the accumulated frames use different kernel rotations
+            vec2 noiseSize((float)mpNoiseTexture->getWidth(), (float)mpNoiseTexture->getHeight());
+            vec2 noiseOffset = mTemporalAccumulation ? glm::floor(LowDiscrepancySequence::r2(mFilter.frame) * noiseSize) / noiseSize : vec2(0.0f);
+            if (noiseOffset != mData.noiseOffset)
+            {
+                mData.noiseOffset = noiseOffset;
+                mDirty = true;
+            }
+
+            const Fbo::SharedPtr& pDownsampleFbo = mFilter.pDownsampleFbo[mFilter.frame % 2];
+            mFilter.pDownsampleVars->setTexture("gDepthTex", pDepthTexture);
+            mFilter.pDownsampleVars->setTexture("gNormalTex", pNormalTexture);
+            mFilter.pDownsampleVars->getDefaultBlock()->getConstantBuffer("FilterCB")->setBlob(&mFilter.data, 0, sizeof(SSAOFilterData));
+            setCamera(pCamera, mFilter.pDownsampleVars.get());
+            runPass(pContext, mFilter.pState, pDownsampleFbo, mFilter.pDownsamplePass.get(), mFilter.pDownsampleVars);
+
+            pAODepth = pDownsampleFbo->getColorTexture(0);
+            pAONormals = pNormalTexture ? pDownsampleFbo->getColorTexture(1) : nullptr;
+        }
+
         upload();
 
         // Update state/vars
@@ -92,9 +182,9 @@ namespace Falcor
         ParameterBlock* pDefaultBlock = mpSSAOVars->getDefaultBlock().get();
         pDefaultBlock->setSampler(mBindLocations.noiseSampler, 0, mpNoiseSampler);
         pDefaultBlock->setSampler(mBindLocations.textureSampler, 0, mpTextureSampler);
-        pDefaultBlock->setSrv(mBindLocations.depthTex, 0, pDepthTexture->getSRV());
+        pDefaultBlock->setSrv(mBindLocations.depthTex, 0, pAODepth->getSRV());
         pDefaultBlock->setSrv(mBindLocations.noiseTex, 0, mpNoiseTexture->getSRV());
-        pDefaultBlock->setSrv(mBindLocations.normalTex, 0, pNormalTexture ? pNormalTexture->getSRV() : nullptr);
+        pDefaultBlock->setSrv(mBindLocations.normalTex, 0, pAONormals ? pAONormals->getSRV() : nullptr);
 
         ConstantBuffer* pCB = pDefaultBlock->getConstantBuffer(mBindLocations.internalPerFrameCB, 0).get();
         if (pCB != nullptr)
@@ -109,6 +199,11 @@ namespace Falcor
         pContext->popGraphicsVars();
         pContext->popGraphicsState();
 
+        if (isBilateral)
+        {
+            return filterAOMap(pContext, pCamera, pDepthTexture, pNormalTexture);
+        }
+
         // Blur
         if (mApplyBlur)
         {
@@ -118,8 +213,66 @@ namespace Falcor
         return mpAOFbo->getColorTexture(0);
     }
 
+    Texture::SharedPtr SSAO::filterAOMap(RenderContext* pContext, const Camera* pCamera, const Texture::SharedPtr& pDepthTexture, const Texture::SharedPtr& pNormalTexture)
+    {
+        const uint32_t cur = mFilter.frame % 2;
+        const Fbo::SharedPtr& pDownsampleFbo = mFilter.pDownsampleFbo[cur];
+        const Texture::SharedPtr& pLowNormals = pDownsampleFbo->getColorTexture(1);
+        const Texture::SharedPtr& pLowLinearDepth = pDownsampleFbo->getColorTexture(2);
+        Texture::SharedPtr pAO = mpAOFbo->getColorTexture(0);
+
+        // Blend with the reprojected AO of the previous frames, before blurring so the blur doesn't accumulate
+        if (mTemporalAccumulation)
+        {
+            GraphicsVars* pVars = mFilter.pTemporalVars.get();
+            pVars->setTexture("gAOTex", pAO);
+            pVars->setTexture("gDepthTex", pDownsampleFbo->getColorTexture(0));
+            pVars->setTexture("gLinearDepthTex", pLowLinearDepth);
+            pVars->setTexture("gHistoryTex", mFilter.pTemporalFbo[1 - cur]->getColorTexture(0));
+            pVars->setTexture("gHistoryLinearDepthTex", mFilter.pDownsampleFbo[1 - cur]->getColorTexture(2));
+            pVars->getDefaultBlock()->getConstantBuffer("FilterCB")->setBlob(&mFilter.data, 0, sizeof(SSAOFilterData));
+            setCamera(pCamera, pVars);
+            runPass(pContext, mFilter.pState, mFilter.pTemporalFbo[cur], mFilter.pTemporalPass.get(), mFilter.pTemporalVars);
+            pAO = mFilter.pTemporalFbo[cur]->getColorTexture(0);
+        }
+        mFilter.data.historyValid = mTemporalAccumulation ? 1 : 0;
+
+        // Separable bilateral blur at the AO map resolution
+        if (mApplyBlur)
+        {
+            GraphicsVars* pVars = mFilter.pBlurVars.get();
+            pVars->setTexture("gLinearDepthTex", pLowLinearDepth);
+            pVars->setTexture("gNormalTex", pLowNormals);
+            pVars->getDefaultBlock()->getConstantBuffer("FilterCB")->setBlob(&mFilter.data, 0, sizeof(SSAOFilterData));
+            pVars->setTexture("gAOTex", pAO);
+            runPass(pContext, mFilter.pState, mFilter.pBlurFbo[0], mFilter.pHorizontalBlurPass.get(), mFilter.pBlurVars);
+            pVars->setTexture("gAOTex", mFilter.pBlurFbo[0]->getColorTexture(0));
+            runPass(pContext, mFilter.pState, mFilter.pBlurFbo[1], mFilter.pVerticalBlurPass.get(), mFilter.pBlurVars);
+            pAO = mFilter.pBlurFbo[1]->getColorTexture(0);
+        }
+
+        // Joint-bilateral upsampling to the depth-buffer resolution
+        if (mResolution != Resolution::Full)
+        {
+            GraphicsVars* pVars = mFilter.pUpsampleVars.get();
+            pVars->setTexture("gAOTex", pAO);
+            pVars->setTexture("gLowLinearDepthTex", pLowLinearDepth);
+            pVars->setTexture("gLowNormalTex", pLowNormals);
+            pVars->setTexture("gDepthTex", pDepthTexture);
+            pVars->setTexture("gNormalTex", pNormalTexture);
+            pVars->getDefaultBlock()->getConstantBuffer("FilterCB")->setBlob(&mFilter.data, 0, sizeof(SSAOFilterData));
+            setCamera(pCamera, pVars);
+            runPass(pContext, mFilter.pState, mFilter.pUpsampleFbo, mFilter.pUpsamplePass.get(), mFilter.pUpsampleVars);
+            pAO = mFilter.pUpsampleFbo->getColorTexture(0);
+        }
+
+        mFilter.frame++;
+        return pAO;
+    }
+
     SSAO::SSAO(const uvec2& aoMapSize, uint32_t kernelSize, uint32_t blurSize, float blurSigma, const uvec2& noiseSize, SampleDistribution distribution) : RenderPass("SSAO")
     {
+        mFixedAOMapSize = aoMapSize;
         Fbo::Desc fboDesc;
         fboDesc.setColorTarget(0, Falcor::ResourceFormat::R8Unorm);
         mpAOFbo = FboHelper::create2D(aoMapSize.x, aoMapSize.y, fboDesc);
@@ -137,6 +290,8 @@ namespace Falcor
         samplerDesc.setFilterMode(Sampler::Filter::Linear, Sampler::Filter::Linear, Sampler::Filter::Linear).setAddressingMode(Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp);
         mpTextureSampler = Sampler::create(samplerDesc);
 
+        initFilterShaders();
+
         setKernel(kernelSize, distribution);
         setNoiseTexture(noiseSize.x, noiseSize.y);
 
@@ -179,6 +334,87 @@ namespace Falcor
         mBindLocations.noiseTex = pReflector->getResourceBinding("gNoiseTex");
     }
 
+    void SSAO::initFilterShaders()
+    {
+        mFilter.pDownsamplePass = FullScreenPass::create("Effects/SSAODownsample.ps.slang");
+        mFilter.pDownsampleVars = GraphicsVars::create(mFilter.pDownsamplePass->getProgram()->getReflector());
+
+        mFilter.pTemporalPass = FullScreenPass::create("Effects/SSAOTemporal.ps.slang");
+        mFilter.pTemporalVars = GraphicsVars::create(mFilter.pTemporalPass->getProgram()->getReflector());
+        mFilter.pTemporalVars->setSampler("gTextureSampler", mpTextureSampler);
+
+        // Both directions have the same layout, so they share the vars
+        Program::DefineList defines;
+        defines.add("_HORIZONTAL_BLUR");
+        mFilter.pHorizontalBlurPass = FullScreenPass::create("Effects/SSAOBilateralBlur.ps.slang", defines);
+        defines.remove("_HORIZONTAL_BLUR");
+        defines.add("_VERTICAL_BLUR");
+        mFilter.pVerticalBlurPass = FullScreenPass::create("Effects/SSAOBilateralBlur.ps.slang", defines);
+        mFilter.pBlurVars = GraphicsVars::create(mFilter.pHorizontalBlurPass->getProgram()->getReflector());
+
+        mFilter.pUpsamplePass = FullScreenPass::create("Effects/SSAOUpsample.ps.slang");
+        mFilter.pUpsampleVars = GraphicsVars::create(mFilter.pUpsamplePass->getProgram()->getReflector());
+
+        mFilter.pState = GraphicsState::create();
+    }
+
+    void SSAO::createFilterResources(uint32_t width, uint32_t height)
+    {
+        mFilter.resolution = mResolution;
+        mFilter.srcSize = uvec2(width, height);
+        mFilter.data.historyValid = 0;
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            mFilter.pDownsampleFbo[i] = nullptr;
+            mFilter.pTemporalFbo[i] = nullptr;
+            mFilter.pBlurFbo[i] = nullptr;
+        }
+        mFilter.pUpsampleFbo = nullptr;
+
+        Fbo::Desc aoDesc;
+        aoDesc.setColorTarget(0, Falcor::ResourceFormat::R8Unorm);
+
+        uvec2 aoMapSize = mFixedAOMapSize;
+        if (mResolution != Resolution::Fixed)
+        {
+            uint32_t factor = (mResolution == Resolution::Full) ? 1 : ((mResolution == Resolution::Half) ? 2 : 4);
+            aoMapSize = (mFilter.srcSize + uvec2(factor - 1)) / factor;
+            mFilter.data.downsampleFactor = factor;
+            mFilter.data.lowResTexelSize = vec2(1.0f) / vec2(aoMapSize);
+
+            Fbo::Desc downsampleDesc;
+            downsampleDesc.setColorTarget(0, ResourceFormat::R32Float).setColorTarget(1, ResourceFormat::RGBA8Unorm).setColorTarget(2, ResourceFormat::R32Float);
+            Fbo::Desc temporalDesc;
+            temporalDesc.setColorTarget(0, ResourceFormat::R16Float);
+            for (uint32_t i = 0; i < 2; i++)
+            {
+                mFilter.pDownsampleFbo[i] = FboHelper::create2D(aoMapSize.x, aoMapSize.y, downsampleDesc);
+                mFilter.pTemporalFbo[i] = FboHelper::create2D(aoMapSize.x, aoMapSize.y, temporalDesc);
+                mFilter.pBlurFbo[i] = FboHelper::create2D(aoMapSize.x, aoMapSize.y, aoDesc);
+            }
+            if (mResolution != Resolution::Full)
+            {
+                mFilter.pUpsampleFbo = FboHelper::create2D(width, height, aoDesc);
+            }
+        }
+
+        mpAOFbo = FboHelper::create2D(aoMapSize.x, aoMapSize.y, aoDesc);
+        mData.noiseScale = vec2(aoMapSize) / vec2(mpNoiseTexture->getWidth(), mpNoiseTexture->getHeight());
+        mData.noiseOffset = vec2(0.0f);
+        mDirty = true;
+    }
+
+    void SSAO::setResolution(Resolution resolution)
+    {
+        mResolution = resolution;
+    }
+
+    void SSAO::setTemporalAccumulation(bool enable)
+    {
+        mTemporalAccumulation = enable;
+        mFilter.data.historyValid = 0;
+    }
+
     void SSAO::setKernel(uint32_t kernelSize, SampleDistribution distribution)
     {
         kernelSize = glm::clamp(kernelSize, (uint32_t)1, (uint32_t)MAX_SAMPLES);
@@ -203,6 +439,16 @@ namespace Falcor
             case SampleDistribution::CosineHammersley:
                 p = hammersleyCosine(i, kernelSize);
                 break;
+
+            case SampleDistribution::CosineSobol:
+            {
+                vec2 u = LowDiscrepancySequence::owenScrambledSobol(i, 0);
+                float phi = u.y * 2.0f * (float)M_PI;
+                float t = sqrt(1.0f - u.x);
+                float s = sqrt(1.0f - t * t);
+                p = glm::vec3(s * cos(phi), s * sin(phi), t);
+                break;
+            }
             }
 
             mData.sampleKernel[i] = glm::vec4(p, 0.0f);
@@ -218,13 +464,16 @@ namespace Falcor
 
     void SSAO::setNoiseTexture(uint32_t width, uint32_t height)
     {
+        std::vector<uint32_t> ranks = BlueNoise::loadOrGenerate(width, height);
+        assert(ranks.size() == width * height);
         std::vector<uint32_t> data;
         data.resize(width * height);
 
         for (uint32_t i = 0; i < width * height; i++)
         {
-            // Random directions on the XY plane
-            glm::vec2 dir = glm::normalize(glm::linearRand(glm::vec2(-1), glm::vec2(1))) * 0.5f + 0.5f;
+            // Directions on the XY plane, with the angle given by the blue-noise rank
+            float angle = ((float)ranks[i] + 0.5f) / (float)ranks.size() * 2.0f * (float)M_PI;
+            glm::vec2 dir = glm::vec2(cos(angle), sin(angle)) * 0.5f + 0.5f;
             data[i] = glm::packUnorm4x8(glm::vec4(dir, 0.0f, 1.0f));
         }
 
@@ -239,6 +488,38 @@ namespace Falcor
     static const std::string kColorOut = "colorOut";
     static const std::string kDepth = "depth";
     static const std::string kNormals = "normals";
+    static const std::string kResolution = "resolution";
+    static const std::string kTemporal = "temporal";
+
+    SSAO::SharedPtr SSAO::create(const Dictionary& dict)
+    {
+        SharedPtr pSSAO = create(uvec2(1024));
+        pSSAO->setResolution(Resolution::Half);
+        for (const auto& v : dict)
+        {
+            if (v.key() == kResolution)
+            {
+                pSSAO->setResolution((Resolution)(uint32_t)v.val());
+            }
+            else if (v.key() == kTemporal)
+            {
+                pSSAO->setTemporalAccumulation((bool)v.val());
+            }
+            else
+            {
+                logWarning("Unknown field `" + v.key() + "` in an SSAO dictionary");
+            }
+        }
+        return pSSAO;
+    }
+
+    Dictionary SSAO::getScriptingDictionary() const
+    {
+        Dictionary dict;
+        dict[kResolution] = (uint32_t)mResolution;
+        dict[kTemporal] = mTemporalAccumulation;
+        return dict;
+    }
 
     RenderPassReflection  SSAO::reflect() const
     {
@@ -51,7 +51,18 @@ namespace Falcor
         {
             Random,
             UniformHammersley,
-            CosineHammersley
+            CosineHammersley,
+            CosineSobol         ///< Owen-scrambled Sobol points. Every power-of-2 prefix of the kernel is stratified.
+        };
+
+        /** Resolution of the AO map and how it is filtered
+        */
+        enum class Resolution
+        {
+            Fixed,      ///< Render at the AO map size passed to create() and blur with GaussianBlur
+            Full,       ///< Render at the depth-buffer resolution and blur with a depth- and normal-aware bilateral filter
+            Half,       ///< Render at half the depth-buffer resolution, blur with the bilateral filter and upsample guided by the full-resolution depth and normals
+            Quarter,    ///< Same as Half, at a quarter of the depth-buffer resolution
         };
 
         /** Create an SSAO pass object sampling with a hemisphere kernel by default.
@@ -64,7 +75,10 @@ namespace Falcor
             \return SSAO pass object.
         */
         static SharedPtr create(const uvec2& aoMapSize, uint32_t kernelSize = 16, uint32_t blurSize = 5, float blurSigma = 2.0f, const uvec2& noiseSize = uvec2(16), SampleDistribution distribution = SampleDistribution::CosineHammersley);
-        static SharedPtr create(const Dictionary& dict) { return create(uvec2(1024)); }
+
+        /** Create an SSAO pass from a render-graph dictionary. Uses Resolution::Half unless the dictionary overrides it.
+        */
+        static SharedPtr create(const Dictionary& dict);
 
         /** Render GUI for tweaking SSAO settings
         */
@@ -98,16 +112,34 @@ namespace Falcor
         */
         void setKernel(uint32_t kernelSize, SampleDistribution distribution = SampleDistribution::Random);
 
-        /** Recreate noise texture
+        /** Recreate noise texture. The kernel rotations are taken from a blue-noise map, so neighboring pixels use well separated rotations.
             \param[in] width Noise texture width
             \param[in] height Noise texture height
         */
         void setNoiseTexture(uint32_t width, uint32_t height);
 
+        /** Set the resolution of the AO map. The filter resources are created on the next call to generateAOMap().
+        */
+        void setResolution(Resolution resolution);
+
+        /** Get the resolution of the AO map
+        */
+        Resolution getResolution() const { return mResolution; }
+
+        /** Enable temporal accumulation of the AO map. Only used with the bilateral resolutions. The noise texture is offset every frame,
+            and the AO is blended with the reprojected result of the previous frames, which lets smaller kernels converge.
+        */
+        void setTemporalAccumulation(bool enable);
+
+        /** Check if temporal accumulation is enabled
+        */
+        bool isTemporalAccumulationEnabled() const { return mTemporalAccumulation; }
+
         // Render-pass functions
         RenderPassReflection reflect() const override;
         void execute(RenderContext* pRenderContext, const RenderData* pData) override;
         void setScene(const std::shared_ptr<Scene>& pScene) override { mpScene = pScene; }
+        Dictionary getScriptingDictionary() const override;
         std::string getDesc() override { return kDesc; }
     private:
 
@@ -115,11 +147,15 @@ namespace Falcor
 
         void upload();
         void initShader();
+        void initFilterShaders();
+        void createFilterResources(uint32_t width, uint32_t height);
+        Texture::SharedPtr filterAOMap(RenderContext* pContext, const Camera* pCamera, const Texture::SharedPtr& pDepthTexture, const Texture::SharedPtr& pNormalTexture);
 
         SSAOData mData;
         bool mDirty = false;
 
         Fbo::SharedPtr mpAOFbo;
+        uvec2 mFixedAOMapSize;
         GraphicsState::SharedPtr mpSSAOState;
         Sampler::SharedPtr mpNoiseSampler;
         Texture::SharedPtr mpNoiseTexture;
@@ -141,6 +177,7 @@ namespace Falcor
 
         static const Gui::DropdownList kKernelDropdown;
         static const Gui::DropdownList kDistributionDropdown;
+        static const Gui::DropdownList kResolutionDropdown;
 
         FullScreenPass::UniquePtr mpSSAOPass;
         GraphicsVars::SharedPtr mpSSAOVars;
@@ -149,6 +186,32 @@ namespace Falcor
         GaussianBlur::UniquePtr mpBlur;
         std::shared_ptr<Scene> mpScene;
 
+        Resolution mResolution = Resolution::Fixed;
+        bool mTemporalAccumulation = false;
+
+        // Bilateral filter resources. The downsample and temporal FBOs alternate every frame, so the other one holds the history.
+        struct
+        {
+            SSAOFilterData data;
+            FullScreenPass::UniquePtr pDownsamplePass;
+            FullScreenPass::UniquePtr pTemporalPass;
+            FullScreenPass::UniquePtr pHorizontalBlurPass;
+            FullScreenPass::UniquePtr pVerticalBlurPass;
+            FullScreenPass::UniquePtr pUpsamplePass;
+            GraphicsVars::SharedPtr pDownsampleVars;
+            GraphicsVars::SharedPtr pTemporalVars;
+            GraphicsVars::SharedPtr pBlurVars;
+            GraphicsVars::SharedPtr pUpsampleVars;
+            GraphicsState::SharedPtr pState;
+            Fbo::SharedPtr pDownsampleFbo[2];   ///< Device depth, normals and distance to the camera at the AO map resolution
+            Fbo::SharedPtr pTemporalFbo[2];
+            Fbo::SharedPtr pBlurFbo[2];         ///< Intermediate and result of the separable blur
+            Fbo::SharedPtr pUpsampleFbo;
+            uvec2 srcSize = uvec2(0);
+            Resolution resolution = Resolution::Fixed;
+            uint32_t frame = 0;
+        } mFilter;
+
         struct
         {
             FullScreenPass::UniquePtr pApplySSAOPass;
@@ -0,0 +1,306 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "LightClusters.h"
+#include "Graphics/Camera/Camera.h"
+#include "Graphics/Scene/Scene.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/Gui.h"
+#include "Utils/Math/SimdVec.h"
+#include <cfloat>
+
+namespace Falcor
+{
+    const float LightClusters::kDefaultIntensityCutoff = 0.01f;
+
+    namespace
+    {
+        const char kClusterCbName[] = "LightClusterCB";
+        const char kLightBufferName[] = "gClusterLights";
+        const char kRangeBufferName[] = "gClusterRanges";
+        const char kIndexBufferName[] = "gClusterLightIndices";
+
+        using Simd::Vec;
+
+        /** View-space light spheres as a structure of arrays, padded to a multiple of Vec::kWidth
+        */
+        struct SphereList
+        {
+            std::vector<float> x, y, z, radius2;
+            std::vector<uint32_t> lightIndex;
+
+            void clear()
+            {
+                x.clear(); y.clear(); z.clear(); radius2.clear(); lightIndex.clear();
+            }
+
+            void add(const vec3& center, float r2, uint32_t index)
+            {
+                x.push_back(center.x); y.push_back(center.y); z.push_back(center.z); radius2.push_back(r2); lightIndex.push_back(index);
+            }
+
+            // The padding has a negative squared radius, so it never passes the test
+            void pad()
+            {
+                while (lightIndex.size() % Vec::kWidth) add(vec3(0.0f), -1.0f, 0);
+            }
+        };
+
+        float getSliceDepth(const LightClusters::View& view, uint32_t z)
+        {
+            return view.nearZ * std::pow(view.farZ / view.nearZ, float(z) / float(LIGHT_CLUSTER_COUNT_Z));
+        }
+
+        /** Append the lights whose spheres overlap a box
+        */
+        void testSpheres(const SphereList& spheres, const BoundingBox& box, std::vector<uint32_t>& indices)
+        {
+            vec3 boxMin = box.getMinPos();
+            vec3 boxMax = box.getMaxPos();
+            Vec minX(boxMin.x), minY(boxMin.y), minZ(boxMin.z);
+            Vec maxX(boxMax.x), maxY(boxMax.y), maxZ(boxMax.z);
+            Vec zero(0.0f);
+
+            for (uint32_t i = 0; i < (uint32_t)spheres.lightIndex.size(); i += Vec::kWidth)
+            {
+                Vec cx = Vec::load(&spheres.x[i]);
+                Vec cy = Vec::load(&spheres.y[i]);
+                Vec cz = Vec::load(&spheres.z[i]);
+
+                // Distance from the center to the box along each axis, 0 inside the box
+                Vec dx = max(max(minX - cx, cx - maxX), zero);
+                Vec dy = max(max(minY - cy, cy - maxY), zero);
+                Vec dz = max(max(minZ - cz, cz - maxZ), zero);
+
+                uint32_t mask = lessEqualMask(dx*dx + dy*dy + dz*dz, Vec::load(&spheres.radius2[i]));
+                for (uint32_t lane = i; mask != 0; lane++, mask >>= 1)
+                {
+                    if (mask & 1) indices.push_back(spheres.lightIndex[lane]);
+                }
+            }
+        }
+    }
+
+    LightClusters::LightClusters(float intensityCutoff) : mIntensityCutoff(intensityCutoff)
+    {
+        mData = {};
+        mBins.ranges.assign(kClusterCount, glm::uvec2(0));
+    }
+
+    LightClusters::UniquePtr LightClusters::create(float intensityCutoff)
+    {
+        return UniquePtr(new LightClusters(intensityCutoff));
+    }
+
+    LightClusters::View LightClusters::getView(const Camera* pCamera)
+    {
+        const glm::mat4& proj = pCamera->getProjMatrix();
+
+        View view;
+        view.viewMat = pCamera->getViewMatrix();
+        view.tanHalfFovX = 1.0f / proj[0][0];
+        view.tanHalfFovY = 1.0f / proj[1][1];
+        view.nearZ = pCamera->getNearPlane();
+        view.farZ = pCamera->getFarPlane();
+        return view;
+    }
+
+    LightClusterData LightClusters::calcClusterData(const View& view)
+    {
+        LightClusterData data;
+        data.sliceScale = float(LIGHT_CLUSTER_COUNT_Z) / std::log(view.farZ / view.nearZ);
+        data.sliceBias = -std::log(view.nearZ) * data.sliceScale;
+        data.lightCount = 0;
+        data.padding = 0;
+        return data;
+    }
+
+    BoundingBox LightClusters::calcClusterBounds(const View& view, uint32_t x, uint32_t y, uint32_t z)
+    {
+        float d0 = getSliceDepth(view, z);
+        float d1 = getSliceDepth(view, z + 1);
+
+        // NDC bounds of the tile. Tile row 0 is at the top of the screen.
+        float left = -1.0f + 2.0f * float(x) / float(LIGHT_CLUSTER_COUNT_X);
+        float right = -1.0f + 2.0f * float(x + 1) / float(LIGHT_CLUSTER_COUNT_X);
+        float bottom = 1.0f - 2.0f * float(y + 1) / float(LIGHT_CLUSTER_COUNT_Y);
+        float top = 1.0f - 2.0f * float(y) / float(LIGHT_CLUSTER_COUNT_Y);
+
+        // The frustum widens with depth, so the extremes are at either the near or the far end of the slice
+        vec3 minPos(std::min(left * d0, left * d1) * view.tanHalfFovX, std::min(bottom * d0, bottom * d1) * view.tanHalfFovY, -d1);
+        vec3 maxPos(std::max(right * d0, right * d1) * view.tanHalfFovX, std::max(top * d0, top * d1) * view.tanHalfFovY, -d0);
+        return BoundingBox::fromMinMax(minPos, maxPos);
+    }
+
+    float LightClusters::calcLightRadius(const LightData& light, float intensityCutoff)
+    {
+        if (light.type == LightDirectional) return FLT_MAX;
+
+        // Lights.slang attenuates point lights by 1/distance^2
+        float intensity = std::max(light.intensity.r, std::max(light.intensity.g, light.intensity.b));
+        return (intensity > 0.0f) ? std::sqrt(intensity / intensityCutoff) : 0.0f;
+    }
+
+    void LightClusters::binLights(const View& view, const std::vector<LightData>& lights, float intensityCutoff, Bins& bins, uint32_t threadCount)
+    {
+        bins.ranges.assign(kClusterCount, glm::uvec2(0));
+        bins.indices.clear();
+
+        // Directional lights go into every cluster. Point lights are transformed to view space once.
+        std::vector<uint32_t> directional;
+        SphereList spheres;
+        for (uint32_t i = 0; i < (uint32_t)lights.size(); i++)
+        {
+            if (lights[i].type == LightDirectional)
+            {
+                directional.push_back(i);
+                continue;
+            }
+            float radius = calcLightRadius(lights[i], intensityCutoff);
+            if (radius <= 0.0f) continue;
+            spheres.add(vec3(view.viewMat * vec4(lights[i].posW, 1.0f)), radius * radius, i);
+        }
+
+        std::vector<std::vector<uint32_t>> sliceIndices(LIGHT_CLUSTER_COUNT_Z);
+        parallelFor(LIGHT_CLUSTER_COUNT_Z, threadCount, [&](uint32_t z)
+        {
+            // Only test the lights that reach the depth range of the slice
+            float d0 = getSliceDepth(view, z);
+            float d1 = getSliceDepth(view, z + 1);
+            SphereList sliceSpheres;
+            for (size_t i = 0; i < spheres.lightIndex.size(); i++)
+            {
+                float depth = -spheres.z[i];
+                float radius = std::sqrt(spheres.radius2[i]);
+                if (depth + radius >= d0 && depth - radius <= d1)
+                {
+                    sliceSpheres.add(vec3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius2[i], spheres.lightIndex[i]);
+                }
+            }
+            sliceSpheres.pad();
+
+            // The offsets are relative to the slice until the slices are joined
+            std::vector<uint32_t>& indices = sliceIndices[z];
+            for (uint32_t y = 0; y < LIGHT_CLUSTER_COUNT_Y; y++)
+            {
+                for (uint32_t x = 0; x < LIGHT_CLUSTER_COUNT_X; x++)
+                {
+                    uint32_t start = (uint32_t)indices.size();
+                    indices.insert(indices.end(), directional.begin(), directional.end());
+                    testSpheres(sliceSpheres, calcClusterBounds(view, x, y, z), indices);
+                    bins.ranges[getLightClusterIndex(x, y, z)] = glm::uvec2(start, (uint32_t)indices.size() - start);
+                }
+            }
+        });
+
+        // The clusters of a slice are contiguous, so joining the slices in order keeps each light list contiguous
+        for (uint32_t z = 0; z < LIGHT_CLUSTER_COUNT_Z; z++)
+        {
+            uint32_t offset = (uint32_t)bins.indices.size();
+            for (uint32_t c = getLightClusterIndex(0, 0, z); c < getLightClusterIndex(0, 0, z + 1); c++) bins.ranges[c].x += offset;
+            bins.indices.insert(bins.indices.end(), sliceIndices[z].begin(), sliceIndices[z].end());
+        }
+    }
+
+    void LightClusters::update(const Scene* pScene, const Camera* pCamera)
+    {
+        auto start = CpuTimer::getCurrentTimePoint();
+
+        mLights.resize(pScene->getLightCount());
+        for (uint32_t i = 0; i < pScene->getLightCount(); i++)
+        {
+            mLights[i] = pScene->getLight(i)->getData();
+        }
+
+        View view = getView(pCamera);
+        binLights(view, mLights, mIntensityCutoff, mBins);
+        mData = calcClusterData(view);
+        mData.lightCount = (uint32_t)mLights.size();
+
+        mBinningTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    }
+
+    void LightClusters::setIntoProgramVars(ProgramVars* pVars)
+    {
+        ConstantBuffer::SharedPtr pCB = pVars->getConstantBuffer(kClusterCbName);
+        if (pCB == nullptr)
+        {
+            logWarning("LightClusters::setIntoProgramVars() - the program doesn't import LightClusters.slang");
+            return;
+        }
+        pCB->setBlob(&mData, 0, sizeof(mData));
+
+        // The buffers grow as needed and are never empty, so that they can always be bound
+        size_t lightCount = std::max<size_t>(mLights.size(), 1);
+        if (mpLightBuffer == nullptr || mpLightBuffer->getElementCount() < lightCount)
+        {
+            const ReflectionVar* pVar = pVars->getReflection()->getDefaultParameterBlock()->getResource(kLightBufferName).get();
+            ReflectionResourceType::SharedConstPtr pType = pVar->getType()->unwrapArray()->asResourceType()->inherit_shared_from_this::shared_from_this();
+            assert(pType->getSize() == sizeof(LightData));
+            mpLightBuffer = StructuredBuffer::create(kLightBufferName, pType, lightCount, Resource::BindFlags::ShaderResource);
+        }
+        if (mLights.size()) mpLightBuffer->setBlob(mLights.data(), 0, mLights.size() * sizeof(LightData));
+
+        if (mpRangeBuffer == nullptr)
+        {
+            mpRangeBuffer = TypedBuffer<glm::uvec2>::create(kClusterCount, Resource::BindFlags::ShaderResource);
+        }
+        mpRangeBuffer->setBlob(mBins.ranges.data(), 0, kClusterCount * sizeof(glm::uvec2));
+
+        uint32_t indexCount = std::max((uint32_t)mBins.indices.size(), 1u);
+        if (mpIndexBuffer == nullptr || mpIndexBuffer->getElementCount() < indexCount)
+        {
+            uint32_t capacity = mpIndexBuffer ? std::max(indexCount, 2 * mpIndexBuffer->getElementCount()) : indexCount;
+            mpIndexBuffer = TypedBuffer<uint32_t>::create(capacity, Resource::BindFlags::ShaderResource);
+        }
+        if (mBins.indices.size()) mpIndexBuffer->setBlob(mBins.indices.data(), 0, mBins.indices.size() * sizeof(uint32_t));
+
+        pVars->setStructuredBuffer(kLightBufferName, mpLightBuffer);
+        pVars->setTypedBuffer(kRangeBufferName, mpRangeBuffer);
+        pVars->setTypedBuffer(kIndexBufferName, mpIndexBuffer);
+    }
+
+    void LightClusters::renderUI(Gui* pGui, const char* uiGroup)
+    {
+        if (!uiGroup || pGui->beginGroup(uiGroup))
+        {
+            pGui->addFloatVar("Intensity Cutoff", mIntensityCutoff, 1e-4f, FLT_MAX, 0.001f, false, "%.4f");
+
+            uint32_t maxCount = 0;
+            for (const auto& range : mBins.ranges) maxCount = std::max(maxCount, range.y);
+            std::string stats = "Lights: " + std::to_string(mLights.size()) + "\n";
+            stats += "Average lights per cluster: " + std::to_string(float(mBins.indices.size()) / float(kClusterCount)) + "\n";
+            stats += "Max lights per cluster: " + std::to_string(maxCount) + "\n";
+            stats += "Binning time: " + std::to_string(mBinningTime) + " ms";
+            pGui->addText(stats.c_str());
+
+            if (uiGroup) pGui->endGroup();
+        }
+    }
+}
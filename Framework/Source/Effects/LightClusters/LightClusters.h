@@ -0,0 +1,140 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Data/Effects/LightClusterData.h"
+#include "API/TypedBuffer.h"
+#include "API/StructuredBuffer.h"
+#include "Graphics/Program/ProgramVars.h"
+#include "Utils/AABB.h"
+#include <memory>
+#include <vector>
+
+namespace Falcor
+{
+    class Camera;
+    class Scene;
+    class Gui;
+
+    /** Clustered light culling for forward shading.
+        The view frustum is split into LIGHT_CLUSTER_COUNT_X x LIGHT_CLUSTER_COUNT_Y screen tiles and LIGHT_CLUSTER_COUNT_Z depth slices.
+        Every frame the lights are binned into the clusters on the CPU, and the pixel shader only evaluates the lights of its own cluster (see Data/Effects/LightClusters.slang).
+        Point lights don't have a range in Falcor, so they are cut off at the distance where their intensity drops below a threshold. Directional lights are in every cluster.
+    */
+    class LightClusters
+    {
+    public:
+        using UniquePtr = std::unique_ptr<LightClusters>;
+
+        static const uint32_t kClusterCount = LIGHT_CLUSTER_COUNT_X * LIGHT_CLUSTER_COUNT_Y * LIGHT_CLUSTER_COUNT_Z;
+        static const float kDefaultIntensityCutoff;
+
+        /** The perspective view the clusters are built for
+        */
+        struct View
+        {
+            glm::mat4 viewMat;      ///< World to view space. The view looks down the negative z axis.
+            float tanHalfFovX;      ///< Horizontal extent of the frustum at unit depth
+            float tanHalfFovY;      ///< Vertical extent of the frustum at unit depth
+            float nearZ;
+            float farZ;
+        };
+
+        /** The light lists of all clusters
+        */
+        struct Bins
+        {
+            std::vector<glm::uvec2> ranges;     ///< Offset into indices and light count of each cluster, indexed by getLightClusterIndex()
+            std::vector<uint32_t> indices;      ///< Indices of the lights. Directional lights come first in each cluster.
+        };
+
+        /** Create a new object
+            \param[in] intensityCutoff Point lights are ignored where the largest channel of their intensity falls below this value
+        */
+        static UniquePtr create(float intensityCutoff = kDefaultIntensityCutoff);
+
+        /** Get the view of a camera. Ignores the camera jitter.
+        */
+        static View getView(const Camera* pCamera);
+
+        /** Calculate the shader constants of a view
+        */
+        static LightClusterData calcClusterData(const View& view);
+
+        /** Calculate the view-space bounding box of a cluster
+        */
+        static BoundingBox calcClusterBounds(const View& view, uint32_t x, uint32_t y, uint32_t z);
+
+        /** Calculate the distance beyond which a light's intensity is below the cutoff
+            \return The distance, or FLT_MAX for directional lights
+        */
+        static float calcLightRadius(const LightData& light, float intensityCutoff);
+
+        /** Bin lights into the clusters of a view. Each light is tested as a sphere of radius calcLightRadius() against the bounding boxes of the clusters,
+            several lights at a time with SIMD, and the depth slices are distributed across threads.
+            \param[in] threadCount Maximum number of threads to use. 0 will use all hardware threads.
+        */
+        static void binLights(const View& view, const std::vector<LightData>& lights, float intensityCutoff, Bins& bins, uint32_t threadCount = 0);
+
+        /** Bin the lights of a scene for a camera's view. Call once per frame, before setIntoProgramVars().
+        */
+        void update(const Scene* pScene, const Camera* pCamera);
+
+        /** Bind the light lists to a program that imports Data/Effects/LightClusters.slang
+        */
+        void setIntoProgramVars(ProgramVars* pVars);
+
+        /** Render the GUI
+        */
+        void renderUI(Gui* pGui, const char* uiGroup = nullptr);
+
+        /** Set the intensity below which point lights are ignored
+        */
+        void setIntensityCutoff(float cutoff) { mIntensityCutoff = cutoff; }
+
+        /** Get the intensity below which point lights are ignored
+        */
+        float getIntensityCutoff() const { return mIntensityCutoff; }
+
+        /** Get the light lists of the last update
+        */
+        const Bins& getBins() const { return mBins; }
+
+    private:
+        LightClusters(float intensityCutoff);
+
+        float mIntensityCutoff;
+        LightClusterData mData;
+        std::vector<LightData> mLights;
+        Bins mBins;
+        float mBinningTime = 0;
+
+        StructuredBuffer::SharedPtr mpLightBuffer;
+        TypedBuffer<glm::uvec2>::SharedPtr mpRangeBuffer;
+        TypedBuffer<uint32_t>::SharedPtr mpIndexBuffer;
+    };
+}
@@ -37,6 +37,7 @@ namespace Falcor
     const char* ParticleSystem::kVertexShader = "Effects/ParticleVertex.vs.slang";
     const char* ParticleSystem::kSortShader = "Effects/ParticleSort.cs.slang";
     const char* ParticleSystem::kEmitShader = "Effects/ParticleEmit.cs.slang";
+    const char* ParticleSystem::kIndirectArgsShader = "Effects/ParticleIndirectArgs.cs.slang";
     const char* ParticleSystem::kDefaultPixelShader = "Effects/ParticleTexture.ps.slang";
     const char* ParticleSystem::kDefaultSimulateShader = "Effects/ParticleSimulate.cs.slang";
 
@@ -55,16 +56,12 @@ namespace Falcor
 
         //Data that is different if system is sorted
         Program::DefineList defineList;
+        mMaxParticles = maxParticles;
         if (mShouldSort)
         {
-            mMaxParticles = (uint32_t)pow(2, (std::ceil(log2((float)maxParticles))));
             initSortResources();
             defineList.add("_SORT");
         }
-        else
-        {
-            mMaxParticles = maxParticles;
-        }
         //compute cs
         ComputeProgram::SharedPtr pSimulateCs = ComputeProgram::createFromFile(simulateComputeShader, "main", defineList);
   
@@ -79,6 +76,10 @@ namespace Falcor
         emitDefines.add("_SIMULATE_THREADS", std::to_string(mSimulateThreads));
         ComputeProgram::SharedPtr pEmitCs = ComputeProgram::createFromFile(kEmitShader, "main", emitDefines);
 
+        //Indirect args cs
+        ComputeProgram::SharedPtr pPrepareCs = ComputeProgram::createFromFile(kIndirectArgsShader, "prepareSimulate", defineList);
+        ComputeProgram::SharedPtr pFinalizeCs = ComputeProgram::createFromFile(kIndirectArgsShader, "finalizeSimulate", defineList);
+
         //draw shader
         GraphicsProgram::Desc d(kVertexShader);
         d.vsEntry("main").addShaderLibrary(drawPixelShader).psEntry("main");
@@ -101,12 +102,18 @@ namespace Falcor
         std::generate(indices.begin(), indices.end(), [&counter] {return counter++; });
         mpDeadList->setBlob(indices.data(), 0, indices.size() * sizeof(uint32_t));
 
-        // Alive list
-        mpAliveList = StructuredBuffer::create(pSimulateCs, "aliveList", mMaxParticles);
+        // Alive lists
+        uint32_t zero = 0;
+        for (auto& pAliveList : mpAliveList)
+        {
+            pAliveList = StructuredBuffer::create(pSimulateCs, "aliveList", mMaxParticles);
+            pAliveList->getUAVCounter()->updateData(&zero, 0, sizeof(uint32_t));
+        }
 
         // Indirect args
         Resource::BindFlags indirectBindFlags = Resource::BindFlags::IndirectArg | Resource::BindFlags::UnorderedAccess;
-        mpIndirectArgs = StructuredBuffer::create(pSimulateCs, "drawArgs", 1, indirectBindFlags);
+        mpIndirectArgs = StructuredBuffer::create(pFinalizeCs, "drawArgs", 1, indirectBindFlags);
+        mpSimulateArgs = StructuredBuffer::create(pPrepareCs, "simulateArgs", 1, indirectBindFlags);
 
         //initialize the first member of the args, vert count per instance, to be 4 for particle billboards
         uint32_t vertexCountPerInstance = 4;
@@ -118,32 +125,50 @@ namespace Falcor
         mEmitResources.pVars->setStructuredBuffer("deadList", mpDeadList);
         mEmitResources.pVars->setStructuredBuffer("particlePool", mpParticlePool);
         mEmitResources.pVars->setStructuredBuffer("emitList", mpEmitList);
-        mEmitResources.pVars->setRawBuffer("numAlive", mpAliveList->getUAVCounter());
-        //simulate
+        //simulate, the alive lists are bound every frame
         mSimulateResources.pVars = ComputeVars::create(pSimulateCs->getReflector());
         mSimulateResources.pVars->setStructuredBuffer("deadList", mpDeadList);
         mSimulateResources.pVars->setStructuredBuffer("particlePool", mpParticlePool);
-        mSimulateResources.pVars->setStructuredBuffer("drawArgs", mpIndirectArgs);
-        mSimulateResources.pVars->setStructuredBuffer("aliveList", mpAliveList);
-        mSimulateResources.pVars->setRawBuffer("numDead", mpDeadList->getUAVCounter());
+        //indirect args
+        mIndirectArgsResources.pPrepareVars = ComputeVars::create(pPrepareCs->getReflector());
+        mIndirectArgsResources.pPrepareVars->setStructuredBuffer("simulateArgs", mpSimulateArgs);
+        mIndirectArgsResources.pFinalizeVars = ComputeVars::create(pFinalizeCs->getReflector());
+        mIndirectArgsResources.pFinalizeVars->setStructuredBuffer("drawArgs", mpIndirectArgs);
         if (mShouldSort)
         {
-            mSimulateResources.pVars->setStructuredBuffer("sortIterationCounter", mSortResources.pSortIterationCounter);
+            //the simulate shader writes the sort list, and the finalize shader its size
+            mSortResources.pSortList = StructuredBuffer::create(pSimulateCs, "sortList", mMaxParticles);
+            mSortResources.pTmpList = StructuredBuffer::create(pSimulateCs, "sortList", mMaxParticles);
+            mSortResources.pSortArgs = StructuredBuffer::create(pFinalizeCs, "sortArgs", 4, indirectBindFlags | Resource::BindFlags::ShaderResource);
+            mSimulateResources.pVars->setStructuredBuffer("sortList", mSortResources.pSortList);
+            mIndirectArgsResources.pFinalizeVars->setStructuredBuffer("sortArgs", mSortResources.pSortArgs);
             //sort
-            mSortResources.pVars->setStructuredBuffer("sortList", mpAliveList);
-            mSortResources.pVars->setStructuredBuffer("iterationCounter", mSortResources.pSortIterationCounter);
+            uint32_t blockCount = (mMaxParticles + SORT_THREADS - 1) / SORT_THREADS;
+            mSortResources.pBlockOffsets = StructuredBuffer::create(mSortResources.pScanState->getProgram(), "blockOffsets", blockCount * SORT_RADIX_BINS);
+            for (const auto& pVars : { mSortResources.pHistogramVars, mSortResources.pScanVars, mSortResources.pScatterVars })
+            {
+                pVars->setStructuredBuffer("sortArgs", mSortResources.pSortArgs);
+                pVars->setStructuredBuffer("blockOffsets", mSortResources.pBlockOffsets);
+            }
         }
 
         //draw
         mDrawResources.pVars = GraphicsVars::create(pDrawProgram->getReflector());
-        mDrawResources.pVars->setStructuredBuffer("aliveList", mpAliveList);
         mDrawResources.pVars->setStructuredBuffer("particlePool", mpParticlePool);
+        if (mShouldSort)
+        {
+            mDrawResources.pVars->setStructuredBuffer("aliveList", mSortResources.pSortList);
+        }
 
         //State
         mEmitResources.pState = ComputeState::create();
         mEmitResources.pState->setProgram(pEmitCs);
         mSimulateResources.pState = ComputeState::create();
         mSimulateResources.pState->setProgram(pSimulateCs);
+        mIndirectArgsResources.pPrepareState = ComputeState::create();
+        mIndirectArgsResources.pPrepareState->setProgram(pPrepareCs);
+        mIndirectArgsResources.pFinalizeState = ComputeState::create();
+        mIndirectArgsResources.pFinalizeState->setProgram(pFinalizeCs);
         mDrawResources.pState = GraphicsState::create();
         mDrawResources.pState->setProgram(pDrawProgram);
 
@@ -159,8 +184,10 @@ namespace Falcor
         mBindLocations.emitCB = pEmitCs->getReflector()->getDefaultParameterBlock()->getResourceBinding("PerEmit");
     }
 
-    void ParticleSystem::emit(RenderContext* pCtx, uint32_t num)
+    uint32_t ParticleSystem::emit(RenderContext* pCtx, uint32_t num)
     {
+        //the emit list only has room for mMaxEmitPerFrame particles
+        num = min(num, mMaxEmitPerFrame);
         std::vector<Particle> emittedParticles;
         emittedParticles.resize(num);
         for (uint32_t i = 0; i < num; ++i)
@@ -184,7 +211,10 @@ namespace Falcor
         //update emitted particles list
         mpEmitList->setBlob(emittedParticles.data(), 0, emittedParticles.size() * sizeof(Particle));
 
-        //Send vars and call
+        //Send vars and call. Emitted particles are added to the list the simulate shader reads next.
+        const StructuredBuffer::SharedPtr& pAliveList = mpAliveList[mCurAliveList];
+        mEmitResources.pVars->setStructuredBuffer("aliveList", pAliveList);
+        mEmitResources.pVars->setRawBuffer("numAlive", pAliveList->getUAVCounter());
         pCtx->pushComputeState(mEmitResources.pState);
         mEmitResources.pVars->getDefaultBlock()->getConstantBuffer(mBindLocations.emitCB, 0)->setBlob(&emitData, 0u, sizeof(EmitData));
         pCtx->pushComputeVars(mEmitResources.pVars);
@@ -192,16 +222,36 @@ namespace Falcor
         pCtx->dispatch(1, numGroups, 1);
         pCtx->popComputeVars();
         pCtx->popComputeState();
+        return num;
+    }
+
+    void ParticleSystem::runCompute(RenderContext* pCtx, const ComputeState::SharedPtr& pState, const ComputeVars::SharedPtr& pVars, const StructuredBuffer::SharedPtr& pArgs)
+    {
+        pCtx->pushComputeState(pState);
+        pCtx->pushComputeVars(pVars);
+        if (pArgs)
+        {
+            pCtx->dispatchIndirect(pArgs.get(), 0);
+        }
+        else
+        {
+            pCtx->dispatch(1, 1, 1);
+        }
+        pCtx->popComputeVars();
+        pCtx->popComputeState();
     }
 
     void ParticleSystem::update(RenderContext* pCtx, float dt, glm::mat4 view)
     {
         //emit
         mEmitTimer += dt;
+        uint32_t numEmit = 0;
         if (mEmitTimer >= mEmitter.emitFrequency)
         {
             mEmitTimer -= mEmitter.emitFrequency;
-            emit(pCtx, max(mEmitter.emitCount + glm::linearRand(-mEmitter.emitCountOffset, mEmitter.emitCountOffset), 0));
+            numEmit = emit(pCtx, max(mEmitter.emitCount + glm::linearRand(-mEmitter.emitCountOffset, mEmitter.emitCountOffset), 0));
+            //the emit shader reads the counter of the previous list, which the prepare pass overwrites
+            pCtx->uavBarrier(mpAliveList[mCurAliveList]->getUAVCounter().get());
         }
 
         //Simulate
@@ -212,7 +262,6 @@ namespace Falcor
             perFrame.dt = dt;
             perFrame.maxParticles = mMaxParticles;
             mSimulateResources.pVars->getDefaultBlock()->getConstantBuffer(mBindLocations.simulateCB, 0)->setBlob(&perFrame, 0u, sizeof(SimulateWithSortPerFrame));
-            mpAliveList->setBlob(mSortDataReset.data(), 0, sizeof(SortData) * mMaxParticles);
         }
         else
         {
@@ -222,15 +271,34 @@ namespace Falcor
             mSimulateResources.pVars->getDefaultBlock()->getConstantBuffer(mBindLocations.simulateCB, 0)->setBlob(&perFrame, 0u, sizeof(SimulatePerFrame));
         }
 
-        //reset alive list counter to 0
-        uint32_t zero = 0;
-        mpAliveList->getUAVCounter()->updateData(&zero, 0, sizeof(uint32_t));
-
-        pCtx->pushComputeState(mSimulateResources.pState);
-        pCtx->pushComputeVars(mSimulateResources.pVars);
-        pCtx->dispatch(max(mMaxParticles / mSimulateThreads, 1u), 1, 1);
-        pCtx->popComputeVars();
-        pCtx->popComputeState();
+        const StructuredBuffer::SharedPtr& pPrevAliveList = mpAliveList[mCurAliveList];
+        const StructuredBuffer::SharedPtr& pAliveList = mpAliveList[1 - mCurAliveList];
+
+        //add the emitted particles to the alive count, reset the other list and write the simulate args
+        IndirectArgsPerFrame argsPerFrame;
+        argsPerFrame.numEmit = numEmit;
+        argsPerFrame.maxParticles = mMaxParticles;
+        argsPerFrame.simulateThreads = mSimulateThreads;
+        argsPerFrame.padding = 0;
+        mIndirectArgsResources.pPrepareVars->getDefaultBlock()->getConstantBuffer("PerFrame")->setBlob(&argsPerFrame, 0u, sizeof(IndirectArgsPerFrame));
+        mIndirectArgsResources.pPrepareVars->setRawBuffer("numAlive", pPrevAliveList->getUAVCounter());
+        mIndirectArgsResources.pPrepareVars->setRawBuffer("numAliveOut", pAliveList->getUAVCounter());
+        runCompute(pCtx, mIndirectArgsResources.pPrepareState, mIndirectArgsResources.pPrepareVars);
+        //the counters and the pool stay UAVs between the dispatches
+        pCtx->uavBarrier(pAliveList->getUAVCounter().get());
+        pCtx->uavBarrier(mpParticlePool.get());
+
+        //a thread per alive particle
+        mSimulateResources.pVars->setStructuredBuffer("prevAliveList", pPrevAliveList);
+        mSimulateResources.pVars->setRawBuffer("numAlive", pPrevAliveList->getUAVCounter());
+        mSimulateResources.pVars->setStructuredBuffer("aliveList", pAliveList);
+        runCompute(pCtx, mSimulateResources.pState, mSimulateResources.pVars, mpSimulateArgs);
+
+        //write the draw and sort args
+        mIndirectArgsResources.pFinalizeVars->setRawBuffer("numSimulated", pAliveList->getUAVCounter());
+        runCompute(pCtx, mIndirectArgsResources.pFinalizeState, mIndirectArgsResources.pFinalizeVars);
+
+        mCurAliveList = 1 - mCurAliveList;
     }
 
     void ParticleSystem::render(RenderContext* pCtx, glm::mat4 view, glm::mat4 proj)
@@ -238,13 +306,11 @@ namespace Falcor
         //sorting
         if (mShouldSort)
         {
-            pCtx->pushComputeState(mSortResources.pState);
-            pCtx->pushComputeVars(mSortResources.pVars);
-
-            pCtx->dispatch(1, 1, 1);
-
-            pCtx->popComputeVars();
-            pCtx->popComputeState();
+            sort(pCtx);
+        }
+        else
+        {
+            mDrawResources.pVars->setStructuredBuffer("aliveList", mpAliveList[mCurAliveList]);
         }
 
         //Draw cbuf
@@ -295,22 +361,51 @@ namespace Falcor
 
     void ParticleSystem::initSortResources()
     {
-        //Shader
-        ComputeProgram::SharedPtr pSortCs = ComputeProgram::createFromFile(kSortShader, "main");
-
-        //iteration counter buffer
-        mSortResources.pSortIterationCounter = StructuredBuffer::create(pSortCs, "iterationCounter", 2);
-
-        //Sort data reset buffer
-        SortData resetData;
-        resetData.index = (uint32_t)(-1);
-        resetData.depth = std::numeric_limits<float>::max();
-        mSortDataReset.resize(mMaxParticles, resetData);
-
-        //Vars and state
-        mSortResources.pVars = ComputeVars::create(pSortCs->getReflector());
-        mSortResources.pState = ComputeState::create();
-        mSortResources.pState->setProgram(pSortCs);
+        //Shaders
+        ComputeProgram::SharedPtr pHistogramCs = ComputeProgram::createFromFile(kSortShader, "radixHistogram");
+        ComputeProgram::SharedPtr pScanCs = ComputeProgram::createFromFile(kSortShader, "radixScan");
+        ComputeProgram::SharedPtr pScatterCs = ComputeProgram::createFromFile(kSortShader, "radixScatter");
+
+        //Vars and state. The buffers are created with the other resources.
+        mSortResources.pHistogramVars = ComputeVars::create(pHistogramCs->getReflector());
+        mSortResources.pHistogramState = ComputeState::create();
+        mSortResources.pHistogramState->setProgram(pHistogramCs);
+        mSortResources.pScanVars = ComputeVars::create(pScanCs->getReflector());
+        mSortResources.pScanState = ComputeState::create();
+        mSortResources.pScanState->setProgram(pScanCs);
+        mSortResources.pScatterVars = ComputeVars::create(pScatterCs->getReflector());
+        mSortResources.pScatterState = ComputeState::create();
+        mSortResources.pScatterState->setProgram(pScatterCs);
+    }
+
+    void ParticleSystem::sort(RenderContext* pCtx)
+    {
+        //radix sort of the 32 bit keys, SORT_RADIX_BITS at a time. The passes ping-pong between the lists, ending in the sort list.
+        static_assert((32 / SORT_RADIX_BITS) % 2 == 0, "The sort has to end in the sort list");
+        const StructuredBuffer::SharedPtr* pLists[2] = { &mSortResources.pSortList, &mSortResources.pTmpList };
+        for (uint32_t pass = 0; pass < 32 / SORT_RADIX_BITS; pass++)
+        {
+            const StructuredBuffer::SharedPtr& pSrc = *pLists[pass % 2];
+            const StructuredBuffer::SharedPtr& pDst = *pLists[1 - pass % 2];
+            SortPerPass perPass;
+            perPass.radixShift = pass * SORT_RADIX_BITS;
+            perPass.padding = uvec3(0);
+
+            mSortResources.pHistogramVars->getDefaultBlock()->getConstantBuffer("SortCB")->setBlob(&perPass, 0u, sizeof(SortPerPass));
+            mSortResources.pHistogramVars->setStructuredBuffer("srcList", pSrc);
+            runCompute(pCtx, mSortResources.pHistogramState, mSortResources.pHistogramVars, mSortResources.pSortArgs);
+            pCtx->uavBarrier(mSortResources.pBlockOffsets.get());
+
+            runCompute(pCtx, mSortResources.pScanState, mSortResources.pScanVars);
+            pCtx->uavBarrier(mSortResources.pBlockOffsets.get());
+
+            mSortResources.pScatterVars->getDefaultBlock()->getConstantBuffer("SortCB")->setBlob(&perPass, 0u, sizeof(SortPerPass));
+            mSortResources.pScatterVars->setStructuredBuffer("srcList", pSrc);
+            mSortResources.pScatterVars->setStructuredBuffer("dstList", pDst);
+            runCompute(pCtx, mSortResources.pScatterState, mSortResources.pScatterVars, mSortResources.pSortArgs);
+            //the histogram of the next pass overwrites the offsets the scatter reads
+            pCtx->uavBarrier(mSortResources.pBlockOffsets.get());
+        }
     }
 
     void ParticleSystem::setParticleDuration(float dur, float offset)
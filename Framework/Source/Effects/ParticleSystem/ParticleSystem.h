@@ -40,6 +40,7 @@ namespace Falcor
     public:
         static const char* kVertexShader;           ///< Filename for the vertex shader
         static const char* kSortShader;             ///< Filename for the sorting compute shader
+        static const char* kIndirectArgsShader;     ///< Filename for the compute shader that writes the simulate, sort and draw arguments
         static const char* kEmitShader;             ///< Filename for the emit compute shader
         static const char* kDefaultPixelShader;     ///< Filename for the default pixel shader
         static const char* kDefaultSimulateShader;  ///< Filename for the particle update/simulation compute shader
@@ -58,7 +59,8 @@ namespace Falcor
             std::string simulateComputeShader = kDefaultSimulateShader,
             bool sorted = true);
 
-        /** Updates the particle system, emitting if it's time to do so and simulating particles 
+        /** Updates the particle system, emitting if it's time to do so and simulating particles.
+            The simulation is dispatched indirectly with a thread per alive particle, and the counts never leave the GPU.
         */
         void update(RenderContext* pCtx, float dt, glm::mat4 view);
 
@@ -146,7 +148,8 @@ namespace Falcor
         ParticleSystem() = delete;
         ParticleSystem(RenderContext* pCtx, uint32_t maxParticles, uint32_t maxEmitPerFrame,
             std::string drawPixelShader, std::string simulateComputeShader, bool sorted);
-        void emit(RenderContext* pCtx, uint32_t num);
+        uint32_t emit(RenderContext* pCtx, uint32_t num);
+        void runCompute(RenderContext* pCtx, const ComputeState::SharedPtr& pState, const ComputeVars::SharedPtr& pVars, const StructuredBuffer::SharedPtr& pArgs = nullptr);
 
         struct EmitterData
         {
@@ -188,6 +191,14 @@ namespace Falcor
             ComputeState::SharedPtr pState;
         } mSimulateResources;
 
+        struct IndirectArgsResources
+        {
+            ComputeVars::SharedPtr pPrepareVars;
+            ComputeState::SharedPtr pPrepareState;
+            ComputeVars::SharedPtr pFinalizeVars;
+            ComputeState::SharedPtr pFinalizeState;
+        } mIndirectArgsResources;
+
         struct DrawResources
         {
             GraphicsVars::SharedPtr pVars;
@@ -211,20 +222,31 @@ namespace Falcor
         StructuredBuffer::SharedPtr mpParticlePool;
         StructuredBuffer::SharedPtr mpEmitList;
         StructuredBuffer::SharedPtr mpDeadList;
-        StructuredBuffer::SharedPtr mpAliveList;
+        //alive particles, swapped every frame. The simulate shader reads mpAliveList[mCurAliveList] and writes the other one.
+        StructuredBuffer::SharedPtr mpAliveList[2];
+        uint32_t mCurAliveList = 0;
         //for draw (0 - Verts Per Instance, 1 - Instance Count, 
         //2 - start vertex offset, 3 - start instance offset)
         StructuredBuffer::SharedPtr mpIndirectArgs;
+        //for the simulate dispatch, a group per alive particle
+        StructuredBuffer::SharedPtr mpSimulateArgs;
 
         //Data for sorted systems
         void initSortResources();
+        void sort(RenderContext* pCtx);
         bool mShouldSort;
-        std::vector<SortData> mSortDataReset;
         struct SortResources
         {
-            StructuredBuffer::SharedPtr pSortIterationCounter;
-            ComputeState::SharedPtr pState;
-            ComputeVars::SharedPtr pVars;
+            StructuredBuffer::SharedPtr pSortList;      ///< Written by the simulate shader, sorted in place
+            StructuredBuffer::SharedPtr pTmpList;       ///< Destination of the odd radix passes
+            StructuredBuffer::SharedPtr pBlockOffsets;
+            StructuredBuffer::SharedPtr pSortArgs;
+            ComputeState::SharedPtr pHistogramState;
+            ComputeVars::SharedPtr pHistogramVars;
+            ComputeState::SharedPtr pScanState;
+            ComputeVars::SharedPtr pScanVars;
+            ComputeState::SharedPtr pScatterState;
+            ComputeVars::SharedPtr pScatterVars;
         } mSortResources;
     };
 }
@@ -0,0 +1,163 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ShadingCache.h"
+#include "API/RenderContext.h"
+#include "Graphics/Camera/Camera.h"
+#include "Graphics/FboHelper.h"
+#include "Utils/Gui.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        const char kShaderFile[] = "Effects/ShadingCache.ps.slang";
+        const char kCacheCbName[] = "ShadingCacheCB";
+        const uint32_t kReadbackLatency = 2;
+    }
+
+    ShadingCache::UniquePtr ShadingCache::create(uint32_t refreshPeriod)
+    {
+        return UniquePtr(new ShadingCache(refreshPeriod));
+    }
+
+    ShadingCache::ShadingCache(uint32_t refreshPeriod)
+    {
+        mData.invResolution = vec2(0.0f);
+        mData.frameIndex = 0;
+        mData.depthThreshold = 0.01f;
+        mData.normalThreshold = 0.95f;
+        mData.historyValid = 0;
+        mData.useMotionVectors = 0;
+        setRefreshPeriod(refreshPeriod);
+
+        mpPass = FullScreenPass::create(kShaderFile);
+        mpVars = GraphicsVars::create(mpPass->getProgram()->getReflector());
+        mpState = GraphicsState::create();
+    }
+
+    void ShadingCache::createResources(uint32_t width, uint32_t height)
+    {
+        Fbo::Desc fboDesc;
+        fboDesc.setColorTarget(0, ResourceFormat::RGBA32Float).setColorTarget(1, ResourceFormat::RGBA8Unorm).setColorTarget(2, ResourceFormat::RGBA32Float);
+        mpFbo[0] = FboHelper::create2D(width, height, fboDesc);
+        mpFbo[1] = FboHelper::create2D(width, height, fboDesc);
+        mpReuseReduction = ParallelReduction::create(ParallelReduction::Type::Mean, kReadbackLatency, width, height);
+        mData.invResolution = vec2(1.0f) / vec2((float)width, (float)height);
+        mReuseRatio = 0;
+        invalidate();
+    }
+
+    void ShadingCache::reproject(RenderContext* pContext, const Camera* pCamera, const Texture::SharedPtr& pDepth, const Texture::SharedPtr& pMotion)
+    {
+        if (mpFbo[0] == nullptr || mpFbo[0]->getWidth() != pDepth->getWidth() || mpFbo[0]->getHeight() != pDepth->getHeight())
+        {
+            createResources(pDepth->getWidth(), pDepth->getHeight());
+        }
+        mData.frameIndex++;
+        mData.useMotionVectors = pMotion ? 1 : 0;
+
+        mpVars->getConstantBuffer(kCacheCbName)->setBlob(&mData, 0, sizeof(mData));
+        pCamera->setIntoConstantBuffer(mpVars->getConstantBuffer("InternalPerFrameCB").get(), 0);
+        mpVars->setTexture("gDepthTex", pDepth);
+        mpVars->setTexture("gMotionTex", pMotion);
+        mpVars->setTexture("gHistoryColor", mpHistoryColor);
+        mpVars->setTexture("gHistoryNormal", mpHistoryNormal);
+        mpVars->setTexture("gHistoryGeometry", mpFbo[1 - mCurFbo]->getColorTexture(2));
+
+        mpState->setFbo(mpFbo[mCurFbo]);
+        pContext->pushGraphicsState(mpState);
+        pContext->pushGraphicsVars(mpVars);
+        mpPass->execute(pContext);
+        pContext->popGraphicsVars();
+        pContext->popGraphicsState();
+        mReprojected = true;
+    }
+
+    void ShadingCache::setIntoProgramVars(ProgramVars* pVars)
+    {
+        if (mpFbo[mCurFbo] == nullptr)
+        {
+            logWarning("ShadingCache::setIntoProgramVars() - reproject() wasn't called");
+            return;
+        }
+        pVars->setTexture("gShadingCacheColor", mpFbo[mCurFbo]->getColorTexture(0));
+        pVars->setTexture("gShadingCacheNormal", mpFbo[mCurFbo]->getColorTexture(1));
+    }
+
+    void ShadingCache::endFrame(RenderContext* pContext, const Texture::SharedPtr& pColor, const Texture::SharedPtr& pNormal)
+    {
+        auto matches = [](const Texture::SharedPtr& pHistory, const Texture* pTexture)
+        {
+            return pHistory && pHistory->getWidth() == pTexture->getWidth() && pHistory->getHeight() == pTexture->getHeight() && pHistory->getFormat() == pTexture->getFormat();
+        };
+
+        if (matches(mpHistoryColor, pColor.get()) == false)
+        {
+            mpHistoryColor = Texture::create2D(pColor->getWidth(), pColor->getHeight(), pColor->getFormat(), 1, 1);
+        }
+        if (matches(mpHistoryNormal, pNormal.get()) == false)
+        {
+            mpHistoryNormal = Texture::create2D(pNormal->getWidth(), pNormal->getHeight(), pNormal->getFormat(), 1, 1);
+        }
+        pContext->copyResource(mpHistoryColor.get(), pColor.get());
+        pContext->copyResource(mpHistoryNormal.get(), pNormal.get());
+
+        if (mReprojected)
+        {
+            mReuseRatio = mpReuseReduction->reduce(pContext, mpFbo[mCurFbo]->getColorTexture(0)).a;
+        }
+        // The frame is only a valid history if it was reprojected, and nothing was invalidated since
+        mData.historyValid = mReprojected ? 1 : 0;
+        mReprojected = false;
+        mCurFbo = 1 - mCurFbo;
+    }
+
+    void ShadingCache::renderUI(Gui* pGui, const char* uiGroup)
+    {
+        if (!uiGroup || pGui->beginGroup(uiGroup))
+        {
+            int32_t period = (int32_t)mData.refreshPeriod;
+            if (pGui->addIntVar("Refresh Period", period, 1, 16))
+            {
+                setRefreshPeriod((uint32_t)period);
+            }
+            pGui->addTooltip("Every pixel is shaded at least once in this many frames");
+            pGui->addFloatVar("Depth Threshold", mData.depthThreshold, 0.0001f, 1.0f, 0.001f);
+            pGui->addTooltip("Maximum relative depth difference between a pixel and its reprojection");
+            pGui->addFloatVar("Normal Threshold", mData.normalThreshold, -1.0f, 1.0f, 0.01f);
+            pGui->addTooltip("Minimum cosine of the angle between the normal of a pixel and its reprojection");
+            if (pGui->addButton("Invalidate")) invalidate();
+
+            std::string stats = "Reused pixels: " + std::to_string(mReuseRatio * 100.0f) + "%";
+            pGui->addText(stats.c_str());
+
+            if (uiGroup) pGui->endGroup();
+        }
+    }
+}
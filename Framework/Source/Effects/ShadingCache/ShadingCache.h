@@ -0,0 +1,120 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Data/Effects/ShadingCacheData.h"
+#include "API/FBO.h"
+#include "Graphics/FullScreenPass.h"
+#include "Graphics/GraphicsState.h"
+#include "Graphics/Program/ProgramVars.h"
+#include "Utils/Math/ParallelReduction.h"
+#include <memory>
+
+namespace Falcor
+{
+    class RenderContext;
+    class Camera;
+    class Gui;
+
+    /** Temporal cache of the shading of a forward pass.
+        Before the scene is drawn, the lit color and normals of the previous frame are reprojected with the depth of the current frame (see Data/Effects/ShadingCache.ps.slang).
+        A pixel reuses the previous frame if its reprojected depth and depth-buffer normal match the previous frame. The pixel shader of the forward pass looks it up
+        with getCachedShading() from Data/Effects/ShadingCache.slang, and only evaluates the lighting where it returns false.
+        Every pixel is still shaded once per refresh period, so that changes the reprojection can't see (moving lights, specular highlights following the camera) show up after a few frames.
+        Without motion vectors the reprojection only follows the camera, and objects that move have to be handled by calling invalidate().
+    */
+    class ShadingCache
+    {
+    public:
+        using UniquePtr = std::unique_ptr<ShadingCache>;
+
+        /** Create a new object
+            \param[in] refreshPeriod Every pixel is shaded at least once in this many frames, see setRefreshPeriod()
+        */
+        static UniquePtr create(uint32_t refreshPeriod = 8);
+
+        /** Reproject the previous frame. Call after the depth pass and before the forward pass.
+            \param[in] pContext Render context
+            \param[in] pCamera The camera of the current frame
+            \param[in] pDepth Single-sampled depth of the current frame
+            \param[in] pMotion Optional. Motion vectors in xy, as returned by calcMotionVector(), and the linear depth in the previous frame (prevPosH.w) in z.
+                Reprojecting with them reuses the shading of moving and skinned models.
+        */
+        void reproject(RenderContext* pContext, const Camera* pCamera, const Texture::SharedPtr& pDepth, const Texture::SharedPtr& pMotion = nullptr);
+
+        /** Bind the reprojected shading to a program that imports Data/Effects/ShadingCache.slang
+        */
+        void setIntoProgramVars(ProgramVars* pVars);
+
+        /** Store the output of the forward pass as the history of the next frame, and update the reuse statistics.
+            \param[in] pContext Render context
+            \param[in] pColor The lit color
+            \param[in] pNormal The normals written by the forward pass
+        */
+        void endFrame(RenderContext* pContext, const Texture::SharedPtr& pColor, const Texture::SharedPtr& pNormal);
+
+        /** Discard the history, so that the next frame shades every pixel. Call when the lighting or the geometry changes.
+        */
+        void invalidate() { mData.historyValid = 0; mReprojected = false; }
+
+        /** Set the number of frames after which every pixel has been shaded again. 1 shades every pixel every frame.
+            Powers of two up to 16 refresh the same number of pixels every frame.
+        */
+        void setRefreshPeriod(uint32_t period) { mData.refreshPeriod = glm::clamp(period, 1u, 16u); }
+
+        /** Get the refresh period
+        */
+        uint32_t getRefreshPeriod() const { return mData.refreshPeriod; }
+
+        /** Get the fraction of the pixels that reused the cache. Read back with a latency of a few frames.
+        */
+        float getReuseRatio() const { return mReuseRatio; }
+
+        /** Render the GUI
+        */
+        void renderUI(Gui* pGui, const char* uiGroup = nullptr);
+
+    private:
+        ShadingCache(uint32_t refreshPeriod);
+        void createResources(uint32_t width, uint32_t height);
+
+        ShadingCacheData mData;
+        FullScreenPass::UniquePtr mpPass;
+        GraphicsVars::SharedPtr mpVars;
+        GraphicsState::SharedPtr mpState;
+
+        // The reprojection alternates between the FBOs, so that the other one holds the geometry of the previous frame
+        Fbo::SharedPtr mpFbo[2];
+        uint32_t mCurFbo = 0;
+        bool mReprojected = false;      // reproject() ran since the last invalidate() or endFrame()
+        Texture::SharedPtr mpHistoryColor;
+        Texture::SharedPtr mpHistoryNormal;
+
+        ParallelReduction::UniquePtr mpReuseReduction;
+        float mReuseRatio = 0;
+    };
+}
@@ -0,0 +1,176 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ShadingRateGenerator.h"
+#include "API/Device.h"
+#include "API/RenderContext.h"
+#include "Utils/Gui.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        const char kShaderFile[] = "Effects/ShadingRate.cs.slang";
+        const uint32_t kDefaultTileSize = 16;
+    }
+
+    static_assert((uint32_t)RenderContext::ShadingRate::Rate1x1 == SHADING_RATE_1X1, "ShadingRate doesn't match ShadingRateData.h");
+    static_assert((uint32_t)RenderContext::ShadingRate::Rate2x2 == SHADING_RATE_2X2, "ShadingRate doesn't match ShadingRateData.h");
+    static_assert((uint32_t)RenderContext::ShadingRate::Rate4x4 == SHADING_RATE_4X4, "ShadingRate doesn't match ShadingRateData.h");
+
+    ShadingRateGenerator::UniquePtr ShadingRateGenerator::create(uint32_t tileSize)
+    {
+        if (tileSize == 0)
+        {
+            tileSize = gpDevice->getShadingRateImageTileSize();
+            if (tileSize == 0) tileSize = kDefaultTileSize;
+        }
+        return UniquePtr(new ShadingRateGenerator(tileSize));
+    }
+
+    ShadingRateGenerator::ShadingRateGenerator(uint32_t tileSize)
+    {
+        mData.tileSize = tileSize;
+        mData.maxRate = SHADING_RATE_2X2;
+        mData.contrastThreshold = 0.15f;
+        mData.motionScale = 0.1f;
+        mpState = ComputeState::create();
+        createPass(false);
+    }
+
+    void ShadingRateGenerator::createPass(bool useMotion)
+    {
+        Program::DefineList defines;
+        defines.add("_TILE_SIZE", std::to_string(mData.tileSize));
+        if (useMotion) defines.add("_USE_MOTION");
+
+        ComputeProgram::SharedPtr pProgram = ComputeProgram::createFromFile(kShaderFile, "main", defines);
+        mpState->setProgram(pProgram);
+        mpVars = ComputeVars::create(pProgram->getReflector());
+        mUseMotion = useMotion;
+    }
+
+    void ShadingRateGenerator::generate(RenderContext* pContext, const Texture::SharedPtr& pColor, const Texture::SharedPtr& pMotion)
+    {
+        assert(pColor);
+        if (mUseMotion != (pMotion != nullptr))
+        {
+            createPass(pMotion != nullptr);
+        }
+
+        uint32_t tilesX = (pColor->getWidth() + mData.tileSize - 1) / mData.tileSize;
+        uint32_t tilesY = (pColor->getHeight() + mData.tileSize - 1) / mData.tileSize;
+        if (mpShadingRateImage == nullptr || mpShadingRateImage->getWidth() != tilesX || mpShadingRateImage->getHeight() != tilesY)
+        {
+            mpShadingRateImage = Texture::create2D(tilesX, tilesY, ResourceFormat::R8Uint, 1, 1, nullptr, Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess);
+        }
+
+        mpVars->getConstantBuffer("ShadingRateCB")->setBlob(&mData, 0, sizeof(mData));
+        mpVars->setTexture("gColor", pColor);
+        if (pMotion) mpVars->setTexture("gMotion", pMotion);
+        mpVars->setTexture("gShadingRate", mpShadingRateImage);
+
+        pContext->pushComputeState(mpState);
+        pContext->pushComputeVars(mpVars);
+        pContext->dispatch(tilesX, tilesY, 1);
+        pContext->popComputeVars();
+        pContext->popComputeState();
+    }
+
+    void ShadingRateGenerator::renderUI(Gui* pGui, const char* uiGroup)
+    {
+        if (!uiGroup || pGui->beginGroup(uiGroup))
+        {
+            pGui->addFloatVar("Contrast Threshold", mData.contrastThreshold, 0.0f, 2.0f, 0.01f);
+            pGui->addTooltip("Tiles with a higher luminance contrast are shaded at full rate, tiles below half of it at the coarsest rate");
+            pGui->addFloatVar("Motion Scale", mData.motionScale, 0.0f, 1.0f, 0.01f);
+            pGui->addTooltip("Increase of the threshold per pixel of motion");
+            bool quarterRate = isQuarterRateAllowed();
+            if (pGui->addCheckBox("Allow 4x4", quarterRate))
+            {
+                setAllowQuarterRate(quarterRate);
+            }
+            pGui->addText(("Tile size: " + std::to_string(mData.tileSize)).c_str());
+
+            if (uiGroup) pGui->endGroup();
+        }
+    }
+
+    void ShadingRateGenerator::generate(const ShadingRateData& data, const glm::vec4* pColor, const glm::vec2* pMotion, uint32_t width, uint32_t height, std::vector<uint8_t>& rates)
+    {
+        uint32_t tilesX = (width + data.tileSize - 1) / data.tileSize;
+        uint32_t tilesY = (height + data.tileSize - 1) / data.tileSize;
+        rates.resize(size_t(tilesX) * tilesY);
+
+        for (uint32_t tileY = 0; tileY < tilesY; tileY++)
+        {
+            for (uint32_t tileX = 0; tileX < tilesX; tileX++)
+            {
+                float lumSum = 0;
+                float lumSqSum = 0;
+                float maxMotion = 0;
+                uint32_t count = 0;
+                uint32_t endY = std::min((tileY + 1) * data.tileSize, height);
+                uint32_t endX = std::min((tileX + 1) * data.tileSize, width);
+                for (uint32_t y = tileY * data.tileSize; y < endY; y++)
+                {
+                    for (uint32_t x = tileX * data.tileSize; x < endX; x++)
+                    {
+                        size_t pixel = size_t(y) * width + x;
+                        float luminance = getShadingRateLuminance(pColor[pixel].r, pColor[pixel].g, pColor[pixel].b);
+                        lumSum += luminance;
+                        lumSqSum += luminance * luminance;
+                        if (pMotion) maxMotion = std::max(maxMotion, glm::length(pMotion[pixel] * glm::vec2((float)width, (float)height)));
+                        count++;
+                    }
+                }
+
+                float mean = lumSum / float(count);
+                float variance = lumSqSum / float(count) - mean * mean;
+                rates[size_t(tileY) * tilesX + tileX] = (uint8_t)calcTileShadingRate(data, mean, variance, maxMotion);
+            }
+        }
+    }
+
+    float ShadingRateGenerator::calcShadingCost(const uint8_t* rates, uint32_t tileSize, uint32_t width, uint32_t height)
+    {
+        uint32_t tilesX = (width + tileSize - 1) / tileSize;
+        uint32_t tilesY = (height + tileSize - 1) / tileSize;
+        double cost = 0;
+        for (uint32_t tileY = 0; tileY < tilesY; tileY++)
+        {
+            for (uint32_t tileX = 0; tileX < tilesX; tileX++)
+            {
+                // Tiles on the right and bottom edges can be partially outside the render target
+                uint32_t pixelCount = (std::min((tileX + 1) * tileSize, width) - tileX * tileSize) * (std::min((tileY + 1) * tileSize, height) - tileY * tileSize);
+                cost += pixelCount * getShadingRateCost(rates[size_t(tileY) * tilesX + tileX]);
+            }
+        }
+        return float(cost / (double(width) * height));
+    }
+}
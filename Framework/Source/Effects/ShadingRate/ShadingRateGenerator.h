@@ -0,0 +1,129 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Data/Effects/ShadingRateData.h"
+#include "API/Texture.h"
+#include "Graphics/ComputeState.h"
+#include "Graphics/Program/ProgramVars.h"
+#include <memory>
+#include <vector>
+
+namespace Falcor
+{
+    class RenderContext;
+    class Gui;
+
+    /** Builds a shading-rate image for variable-rate shading (see RenderContext::setShadingRate()).
+        The rate of each screen tile is chosen from the luminance contrast of a previous frame and the motion inside the tile (see calcTileShadingRate() in Data/Effects/ShadingRateData.h).
+        Flat and fast-moving tiles are shaded at a coarser rate, tiles with edges and texture detail at full rate.
+        The static functions are the CPU reference of the compute shader.
+    */
+    class ShadingRateGenerator
+    {
+    public:
+        using UniquePtr = std::unique_ptr<ShadingRateGenerator>;
+
+        /** Create a new object
+            \param[in] tileSize The size of the screen tiles. 0 uses Device::getShadingRateImageTileSize(), or 16 when the device doesn't support shading-rate images.
+        */
+        static UniquePtr create(uint32_t tileSize = 0);
+
+        /** Build the shading-rate image
+            \param[in] pContext Render context
+            \param[in] pColor The lit color of the previous frame
+            \param[in] pMotion Optional motion vectors of the previous frame, as written by calcMotionVector()
+        */
+        void generate(RenderContext* pContext, const Texture::SharedPtr& pColor, const Texture::SharedPtr& pMotion = nullptr);
+
+        /** Get the R8Uint shading-rate image written by generate(). nullptr before the first call.
+        */
+        const Texture::SharedPtr& getShadingRateImage() const { return mpShadingRateImage; }
+
+        /** Get the size in pixels of the screen tiles
+        */
+        uint32_t getTileSize() const { return mData.tileSize; }
+
+        /** Set the luminance contrast above which a tile is shaded at full rate
+        */
+        void setContrastThreshold(float threshold) { mData.contrastThreshold = threshold; }
+
+        /** Get the contrast threshold
+        */
+        float getContrastThreshold() const { return mData.contrastThreshold; }
+
+        /** Set how much the threshold grows per pixel of motion
+        */
+        void setMotionScale(float scale) { mData.motionScale = scale; }
+
+        /** Get the motion scale
+        */
+        float getMotionScale() const { return mData.motionScale; }
+
+        /** Allow 4x4 coarse pixels. Otherwise the coarsest rate is 2x2.
+        */
+        void setAllowQuarterRate(bool allow) { mData.maxRate = allow ? SHADING_RATE_4X4 : SHADING_RATE_2X2; }
+
+        /** Check if 4x4 coarse pixels are allowed
+        */
+        bool isQuarterRateAllowed() const { return mData.maxRate == SHADING_RATE_4X4; }
+
+        /** Get the constants of the generator
+        */
+        const ShadingRateData& getData() const { return mData; }
+
+        /** Render the GUI
+        */
+        void renderUI(Gui* pGui, const char* uiGroup = nullptr);
+
+        /** Build a shading-rate image on the CPU
+            \param[in] data The generator constants
+            \param[in] pColor The lit color, row by row
+            \param[in] pMotion Optional motion vectors, row by row
+            \param[out] rates Receives one rate per tile, row by row
+        */
+        static void generate(const ShadingRateData& data, const glm::vec4* pColor, const glm::vec2* pMotion, uint32_t width, uint32_t height, std::vector<uint8_t>& rates);
+
+        /** Get the number of pixel-shader invocations of a shading-rate image relative to shading every pixel
+            \param[in] rates One rate per tile, row by row
+            \param[in] tileSize The size of the tiles in pixels
+            \param[in] width The width of the render target
+            \param[in] height The height of the render target
+        */
+        static float calcShadingCost(const uint8_t* rates, uint32_t tileSize, uint32_t width, uint32_t height);
+
+    private:
+        ShadingRateGenerator(uint32_t tileSize);
+        void createPass(bool useMotion);
+
+        ShadingRateData mData;
+        bool mUseMotion = false;
+        ComputeState::SharedPtr mpState;
+        ComputeVars::SharedPtr mpVars;
+        Texture::SharedPtr mpShadingRateImage;
+    };
+}
@@ -30,6 +30,7 @@
 #include "Graphics/Scene/SceneRenderer.h"
 #include "Utils/Math/FalcorMath.h"
 #include "Graphics/FboHelper.h"
+#include "CascadeCulling.h"
 
 namespace Falcor
 {
@@ -76,11 +77,22 @@ namespace Falcor
 
         void setDepthClamp(bool enable) { mDepthClamp = enable; }
 
+        /** Only draw the casters in a list. The casters are indexed in draw order, see CascadedShadowMaps::collectCasterBounds(). Set to nullptr to draw everything.
+        */
+        void setCasterList(const std::vector<uint32_t>* pCasters) { mpCasters = pCasters; }
+
         void renderScene(RenderContext* pContext, const Camera* pCamera) override
         {
             pContext->getGraphicsState()->setRasterizerState(nullptr);
             mpLastSetRs = nullptr;
+            mCasterID = 0;
+            mCasterListPos = 0;
+
+            // The caster list replaces the camera culling
+            bool cullEnabled = mCullEnabled;
+            mCullEnabled = cullEnabled || (mpCasters != nullptr);
             SceneRenderer::renderScene(pContext, pCamera);
+            mCullEnabled = cullEnabled;
         }
 
     protected:
@@ -108,6 +120,27 @@ namespace Falcor
         bool mMaterialChanged = false;
         Sampler::SharedPtr mpAlphaSampler;
 
+        const std::vector<uint32_t>* mpCasters = nullptr;
+        uint32_t mCasterID = 0;
+        uint32_t mCasterListPos = 0;
+
+        bool cullMeshInstance(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance) override
+        {
+            if (mpCasters == nullptr)
+            {
+                return SceneRenderer::cullMeshInstance(currentData, pModelInstance, pMeshInstance);
+            }
+
+            // Both the list and the draw order are sorted by caster ID
+            uint32_t casterID = mCasterID++;
+            if (mCasterListPos < mpCasters->size() && (*mpCasters)[mCasterListPos] == casterID)
+            {
+                mCasterListPos++;
+                return false;
+            }
+            return true;
+        }
+
         struct
         {
             ProgramReflection::BindLocation alphaMap;
@@ -275,6 +308,7 @@ namespace Falcor
         {
             mSdsmData.readbackLatency = latency;
             mSdsmData.minMaxReduction = nullptr;
+            mSdsmData.pGpuReduction = nullptr;
         }
     }
 
@@ -345,6 +379,7 @@ namespace Falcor
             mipLevels = Texture::kMaxPossible;
         }
         mShadowPass.pFbo = FboHelper::create2D(mapWidth, mapHeight, fboDesc, mCsmData.cascadeCount, mipLevels);
+        mStaticCasters.pFbo = nullptr;
         mDepthPass.pState->setFbo(FboHelper::create2D(mapWidth, mapHeight, fboDesc, mCsmData.cascadeCount));
 
         mShadowPass.fboAspectRatio = (float)mapWidth / (float)mapHeight;
@@ -372,6 +407,7 @@ namespace Falcor
         mPerLightCbLoc = pDefaultBlock->getResourceBinding("PerLightCB");
 
         mpCsmSceneRenderer = CsmSceneRenderer::create(pScene, alphaMapCB, alphaMap, alphaSampler);
+        mStaticCasters.cache.invalidate();
         bool cullMeshes = mpSceneRenderer ? mpSceneRenderer->isMeshCullingEnabled() : true;
         mpSceneRenderer = SceneRenderer::create(std::const_pointer_cast<Scene>(pScene));
         mpSceneRenderer->toggleMeshCulling(cullMeshes);
@@ -429,10 +465,28 @@ namespace Falcor
             if (pGui->addDropdown("Visibility Buffer Bits-Per-Channel", visBufferBits, mVisibilityPassData.mapBitsPerChannel)) setVisibilityBufferBitsPerChannel(mVisibilityPassData.mapBitsPerChannel);
 
             // Mesh culling
-            bool cullEnabled = isMeshCullingEnabled();
-            if (pGui->addCheckBox("Cull Meshes", cullEnabled))
+            pGui->addCheckBox("Per-Cascade Culling", mControls.perCascadeCulling);
+            pGui->addTooltip("Cull the casters against each cascade on the CPU and draw each cascade with its own casters");
+            pGui->addCheckBox("Cache Static Casters", mControls.cacheStaticCasters);
+            pGui->addTooltip("Keep the depth of the static casters of each cascade, and only redraw it when the cascade or its static casters change. Moving and animated casters are drawn on top every frame. Implies per-cascade culling");
+            if (mControls.perCascadeCulling || mControls.cacheStaticCasters)
             {
-                toggleMeshCulling(cullEnabled);
+                pGui->addFloatVar("Min Caster Size", mControls.minCasterSize, 0, FLT_MAX, 0.1f);
+                pGui->addTooltip("Skip casters whose projected size in a cascade is smaller than this, in shadow-map texels");
+                std::string draws = "Caster draws: " + std::to_string(mCasterCulling.drawCount) + " of " + std::to_string(mCasterCulling.unculledDrawCount);
+                if (mControls.cacheStaticCasters)
+                {
+                    draws += "\nStatic cascades redrawn: " + std::to_string(mStaticCasters.redrawCount) + " of " + std::to_string(mCsmData.cascadeCount);
+                }
+                pGui->addText(draws.c_str());
+            }
+            else
+            {
+                bool cullEnabled = isMeshCullingEnabled();
+                if (pGui->addCheckBox("Cull Meshes", cullEnabled))
+                {
+                    toggleMeshCulling(cullEnabled);
+                }
             }
 
             //Filter mode
@@ -474,6 +528,10 @@ namespace Falcor
                 pGui->addCheckBox("Enable", mControls.useMinMaxSdsm);
                 if(mControls.useMinMaxSdsm)
                 {
+                    pGui->addCheckBox("Run on GPU", mControls.gpuSdsm);
+                    pGui->addTooltip("Reduce the depth and partition the cascades in compute shaders, for the current frame. The casters are culled with the bounds read back with latency. "
+                        "While caching static casters, the cascades are partitioned from the bounds read back");
+
                     int32_t latency = mSdsmData.readbackLatency;
                     if (pGui->addIntVar("Readback Latency", latency, 0))
                     {
@@ -563,127 +621,50 @@ namespace Falcor
         }
     }
 
-    forceinline float calcPssmPartitionEnd(float nearPlane, float camDepthRange, const glm::vec2& distanceRange, float linearBlend, uint32_t cascade, uint32_t cascadeCount)
+    CsmPartitionData CascadedShadowMaps::calcPartitionData(const Camera* pCamera) const
     {
-        // Convert to camera space
-        float minDepth = nearPlane + distanceRange.x * camDepthRange;
-        float maxDepth = nearPlane + distanceRange.y * camDepthRange;
-
-        float depthRange = maxDepth - minDepth;
-        float depthScale = maxDepth / minDepth;
-
-        float cascadeScale = float(cascade + 1) / float(cascadeCount);
-        float logSplit = pow(depthScale, cascadeScale) * minDepth;
-        float uniSplit = minDepth + depthRange * cascadeScale;
-
-        float distance = linearBlend * logSplit + (1 - linearBlend) * uniSplit;
-
-        // Convert back to clip-space
-        distance = (distance - nearPlane) / camDepthRange;
-        return distance;
-    }
+        CsmPartitionData partition;
 
-    void getCascadeCropParams(const glm::vec3 crd[8], const glm::mat4& lightVP, glm::vec4& scale, glm::vec4& offset)
-    {
-        // Transform the frustum into light clip-space and calculate min-max
-        glm::vec4 maxCS(-1, -1, 0, 1);
-        glm::vec4 minCS(1, 1, 1, 1);
+        glm::vec3 camFrustum[8];
+        glm::vec3 center;
+        float radius;
+        camClipSpaceToWorldSpace(pCamera, camFrustum, center, radius);
         for(uint32_t i = 0; i < 8; i++)
         {
-            glm::vec4 c = lightVP * glm::vec4(crd[i], 1.0f);
-            c /= c.w;
-            maxCS = max(maxCS, c);
-            minCS = min(minCS, c);
+            partition.camFrustum[i] = glm::vec4(camFrustum[i], 1);
         }
 
-        glm::vec4 delta = maxCS - minCS;
-        scale = glm::vec4(2, 2, 1, 1) / delta;
-
-        offset.x = -0.5f * (maxCS.x + minCS.x) * scale.x;
-        offset.y = -0.5f * (maxCS.y + minCS.y) * scale.y;
-        offset.z = -minCS.z * scale.z;
-
-        scale.w = 1;
-        offset.w = 0;
+        // Create the global shadow space
+        createShadowMatrix(mpLight.get(), center, radius, mShadowPass.fboAspectRatio, partition.globalMat);
+
+        partition.camProjMat = pCamera->getProjMatrix();
+        partition.nearPlane = pCamera->getNearPlane();
+        partition.farPlane = pCamera->getFarPlane();
+        partition.cascadeCount = mCsmData.cascadeCount;
+        partition.partitionMode = (uint32_t)mControls.partitionMode;
+        partition.pssmLambda = mControls.pssmLambda;
+        partition.cascadeBlendThreshold = mCsmData.cascadeBlendThreshold;
+        partition.stabilizeCascades = mControls.stabilizeCascades ? 1 : 0;
+        partition.padding = 0;
+        return partition;
     }
 
-    void CascadedShadowMaps::partitionCascades(const Camera* pCamera, const glm::vec2& distanceRange)
+    void CascadedShadowMaps::partitionCascades(const CsmPartitionData& partition, const glm::vec2& distanceRange, bool forCulling)
     {
-        struct
+        CsmCascadeData cascades[CSM_MAX_CASCADES];
+        if (forCulling)
         {
-            glm::vec3 crd[8];
-            glm::vec3 center;
-            float radius;
-        } camFrustum;
-
-        camClipSpaceToWorldSpace(pCamera, camFrustum.crd, camFrustum.center, camFrustum.radius);
-
-        // Create the global shadow space
-        createShadowMatrix(mpLight.get(), camFrustum.center, camFrustum.radius, mShadowPass.fboAspectRatio, mCsmData.globalMat);
-
-        if(mCsmData.cascadeCount == 1)
+            SdsmReduction::partitionCullingCascades(partition, distanceRange, cascades);
+        }
+        else
         {
-            mCsmData.cascadeScale[0] = glm::vec4(1);
-            mCsmData.cascadeOffset[0] = glm::vec4(0);
-            mCsmData.cascadeRange[0].x = 0;
-            mCsmData.cascadeRange[0].y = 1;
-            return;
+            SdsmReduction::partitionCascades(partition, distanceRange, cascades);
         }
-
-        float nearPlane = pCamera->getNearPlane();
-        float farPlane = pCamera->getFarPlane();
-        float depthRange = farPlane - nearPlane;
-
-        float nextCascadeStart = distanceRange.x;
-
         for(int32_t c = 0; c < mCsmData.cascadeCount; c++)
         {
-            float cascadeStart = nextCascadeStart;
-
-            switch(mControls.partitionMode)
-            {
-            case PartitionMode::Linear:
-                nextCascadeStart = cascadeStart + (distanceRange.y - distanceRange.x) / float(mCsmData.cascadeCount);
-                break;
-            case PartitionMode::Logarithmic:
-                nextCascadeStart = calcPssmPartitionEnd(nearPlane, depthRange, distanceRange, 1.0f, c, mCsmData.cascadeCount);
-                break;
-            case PartitionMode::PSSM:
-                nextCascadeStart = calcPssmPartitionEnd(nearPlane, depthRange, distanceRange, mControls.pssmLambda, c, mCsmData.cascadeCount);
-                break;
-            default:
-                should_not_get_here();
-            }
-
-            // If we blend between cascades, we need to expand the range to make sure we will not try to read off the edge of the shadow-map
-            float blendCorrection = (nextCascadeStart - cascadeStart) *  (mCsmData.cascadeBlendThreshold * 0.5f);
-            float cascadeEnd = nextCascadeStart + blendCorrection;
-            nextCascadeStart -= blendCorrection;
-
-            // Calculate the cascade distance in camera-clip space(Where the clip-space range is [0, farPlane])
-            float camClipSpaceCascadeStart = lerp(nearPlane, farPlane, cascadeStart);
-            float camClipSpaceCascadeEnd = lerp(nearPlane, farPlane, cascadeEnd);
-
-            //Convert to ndc space [0, 1]
-            float projTermA = farPlane / (nearPlane - farPlane);
-            float projTermB = (-farPlane * nearPlane) / (farPlane - nearPlane);
-            float ndcSpaceCascadeStart = (-camClipSpaceCascadeStart * projTermA + projTermB) / camClipSpaceCascadeStart;
-            float ndcSpaceCascadeEnd = (-camClipSpaceCascadeEnd * projTermA + projTermB) / camClipSpaceCascadeEnd;
-            mCsmData.cascadeRange[c].x = ndcSpaceCascadeStart;
-            mCsmData.cascadeRange[c].y = ndcSpaceCascadeEnd - ndcSpaceCascadeStart;
-
-            // Calculate the cascade frustum
-            glm::vec3 cascadeFrust[8];
-            for(uint32_t i = 0; i < 4; i++)
-            {
-                glm::vec3 edge = camFrustum.crd[i + 4] - camFrustum.crd[i];
-                glm::vec3 start = edge * cascadeStart;
-                glm::vec3 end = edge * cascadeEnd;
-                cascadeFrust[i] = camFrustum.crd[i] + start;
-                cascadeFrust[i + 4] = camFrustum.crd[i] + end;
-            }
-
-            getCascadeCropParams(cascadeFrust, mCsmData.globalMat, mCsmData.cascadeScale[c], mCsmData.cascadeOffset[c]);
+            mCsmData.cascadeScale[c] = cascades[c].scale;
+            mCsmData.cascadeOffset[c] = cascades[c].offset;
+            mCsmData.cascadeRange[c] = cascades[c].range;
         }
     }
 
@@ -724,11 +705,146 @@ namespace Falcor
         pCtx->pushGraphicsVars(mShadowPass.pGraphicsVars);
         pCtx->pushGraphicsState(mShadowPass.pState);
         mpLightCamera->setProjectionMatrix(mCsmData.globalMat);
-        mpCsmSceneRenderer->renderScene(pCtx, mpLightCamera.get());
+
+        Program* pProgram = mShadowPass.pState->getProgram().get();
+        bool cullPerCascade = mControls.cacheStaticCasters || mControls.perCascadeCulling;
+        if (cullPerCascade)
+        {
+            collectCasterBounds();
+            // The cascades are larger than the GPU partition they cull for, so a caster's projected size in them says nothing about its size in the shadow-map
+            float minProjectedSize = isGpuPartitionEnabled() ? 0.0f : 2 * mControls.minCasterSize / max(mShadowPass.mapSize.x, mShadowPass.mapSize.y);
+            CascadeCulling::cullCasters(mCsmData, mCasterCulling.casterBounds, minProjectedSize, mCasterCulling.casterLists);
+
+            // Draw each cascade with its own casters. The geometry shader reads the cascade index from the constant buffer instead of instancing.
+            pProgram->addDefine("_PER_CASCADE_DRAW");
+            mCasterCulling.drawCount = 0;
+            if (mControls.cacheStaticCasters)
+            {
+                renderCachedCascades(pCtx, pCB);
+            }
+            else
+            {
+                for (uint32_t c = 0; c < (uint32_t)mCsmData.cascadeCount; c++)
+                {
+                    renderCascadeCasters(pCtx, pCB, c, mCasterCulling.casterLists[c]);
+                }
+            }
+            mCasterCulling.unculledDrawCount = (uint32_t)mCasterCulling.casterBounds.size() * mCsmData.cascadeCount;
+        }
+        else
+        {
+            pProgram->removeDefine("_PER_CASCADE_DRAW");
+            mpCsmSceneRenderer->renderScene(pCtx, mpLightCamera.get());
+        }
         pCtx->popGraphicsState();
         pCtx->popGraphicsVars();
     }
 
+    void CascadedShadowMaps::renderCascadeCasters(RenderContext* pCtx, ConstantBuffer* pCB, uint32_t cascade, const std::vector<uint32_t>& casters)
+    {
+        if (casters.empty()) return;
+
+        pCB->setVariable(pCB->getVariableOffset("gCascadeIndex"), cascade);
+        mpCsmSceneRenderer->setCasterList(&casters);
+        mpCsmSceneRenderer->renderScene(pCtx, mpLightCamera.get());
+        mpCsmSceneRenderer->setCasterList(nullptr);
+        mCasterCulling.drawCount += (uint32_t)casters.size();
+    }
+
+    void CascadedShadowMaps::createStaticCasterFbo()
+    {
+        Fbo::Desc fboDesc;
+        fboDesc.setDepthStencilTarget(mShadowPass.pFbo->getDepthStencilTexture()->getFormat());
+        uint32_t mipLevels = 1;
+        const auto& pColor = mShadowPass.pFbo->getColorTexture(0);
+        if (pColor)
+        {
+            fboDesc.setColorTarget(0, pColor->getFormat());
+            mipLevels = pColor->getMipCount();
+        }
+        mStaticCasters.pFbo = FboHelper::create2D(mShadowPass.pFbo->getWidth(), mShadowPass.pFbo->getHeight(), fboDesc, mCsmData.cascadeCount, mipLevels);
+        mStaticCasters.cache.invalidate();
+    }
+
+    void CascadedShadowMaps::renderCachedCascades(RenderContext* pCtx, ConstantBuffer* pCB)
+    {
+        if (mStaticCasters.pFbo == nullptr)
+        {
+            createStaticCasterFbo();
+        }
+
+        // Settings that change what the static casters write
+        if (mStaticCasters.depthClamp != mControls.depthClamp || mStaticCasters.evsmExponents != mCsmData.evsmExponents)
+        {
+            mStaticCasters.depthClamp = mControls.depthClamp;
+            mStaticCasters.evsmExponents = mCsmData.evsmExponents;
+            mStaticCasters.cache.invalidate();
+        }
+
+        StaticCasterCache& cache = mStaticCasters.cache;
+        cache.update(mCsmData, mCasterCulling.casterLists, mCasterCulling.casterBounds, mCasterCulling.animated);
+
+        // Redraw the static casters of the cascades that changed
+        const Texture* pCacheDepth = mStaticCasters.pFbo->getDepthStencilTexture().get();
+        const Texture* pCacheColor = mStaticCasters.pFbo->getColorTexture(0).get();
+        mShadowPass.pState->setFbo(mStaticCasters.pFbo);
+        mStaticCasters.redrawCount = 0;
+        for (uint32_t c = 0; c < (uint32_t)mCsmData.cascadeCount; c++)
+        {
+            if (cache.isRedrawNeeded(c) == false) continue;
+
+            pCtx->clearDsv(mStaticCasters.pFbo->getDepthStencilTexture()->getDSV(0, c, 1).get(), 1, 0);
+            if (pCacheColor)
+            {
+                pCtx->clearRtv(mStaticCasters.pFbo->getColorTexture(0)->getRTV(0, c, 1).get(), glm::vec4(0));
+            }
+            renderCascadeCasters(pCtx, pCB, c, cache.getStaticLists()[c]);
+            mStaticCasters.redrawCount++;
+        }
+        mShadowPass.pState->setFbo(mShadowPass.pFbo);
+
+        // Start from the static depth and draw the dynamic casters on top
+        pCtx->copyResource(mShadowPass.pFbo->getDepthStencilTexture().get(), pCacheDepth);
+        if (pCacheColor)
+        {
+            pCtx->copyResource(mShadowPass.pFbo->getColorTexture(0).get(), pCacheColor);
+        }
+        for (uint32_t c = 0; c < (uint32_t)mCsmData.cascadeCount; c++)
+        {
+            renderCascadeCasters(pCtx, pCB, c, cache.getDynamicLists()[c]);
+        }
+    }
+
+    void CascadedShadowMaps::collectCasterBounds()
+    {
+        // Same traversal as SceneRenderer::renderScene(), so the caster indices match the draw order
+        mCasterCulling.casterBounds.clear();
+        mCasterCulling.animated.clear();
+        const Scene* pScene = mpSceneRenderer->getScene().get();
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const auto pInstance = pScene->getModelInstance(modelID, instanceID).get();
+                if (pInstance->isVisible() == false) continue;
+
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                    {
+                        const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, meshInstanceID).get();
+                        if (pMeshInstance->isVisible())
+                        {
+                            mCasterCulling.casterBounds.push_back(pMeshInstance->getBoundingBox().transform(pInstance->getTransformMatrix()));
+                            mCasterCulling.animated.push_back(pModel->hasAnimations());
+                        }
+                    }
+                }
+            }
+        }
+    }
+
     void CascadedShadowMaps::executeDepthPass(RenderContext* pCtx, const Camera* pCamera)
     {
         // Must have an FBO attached, otherwise don't know the size of the depth map
@@ -770,7 +886,7 @@ namespace Falcor
         mShadowPass.pVSMTrilinearSampler = Sampler::create(samplerDesc);
     }
 
-    void CascadedShadowMaps::reduceDepthSdsmMinMax(RenderContext* pRenderCtx, const Camera* pCamera, Texture::SharedPtr pDepthBuffer)
+    void CascadedShadowMaps::reduceDepthSdsmMinMax(RenderContext* pRenderCtx, const CsmPartitionData& partition, const Camera* pCamera, Texture::SharedPtr pDepthBuffer)
     {
         if(pDepthBuffer == nullptr)
         {
@@ -780,29 +896,44 @@ namespace Falcor
         }
 
         createSdsmData(pDepthBuffer);
-        vec2 distanceRange = glm::vec2(mSdsmData.minMaxReduction->reduce(pRenderCtx, pDepthBuffer));
+        vec2 depthRange = glm::vec2(mSdsmData.minMaxReduction->reduce(pRenderCtx, pDepthBuffer));
+        mSdsmData.sdsmResult = SdsmReduction::calcDistanceRange(partition, depthRange);
+    }
 
-        // Convert to linear
-        glm::mat4 camProj = pCamera->getProjMatrix();
-        distanceRange = camProj[2][2] - distanceRange*camProj[2][3];
-        distanceRange = camProj[3][2] / distanceRange;
-        distanceRange = (distanceRange - pCamera->getNearPlane()) / (pCamera->getFarPlane() - pCamera->getNearPlane());
-        distanceRange = glm::clamp(distanceRange, glm::vec2(0), glm::vec2(1));
-        mSdsmData.sdsmResult = distanceRange;
+    void CascadedShadowMaps::reduceDepthSdsmGpu(RenderContext* pRenderCtx, const CsmPartitionData& partition, const Camera* pCamera, Texture::SharedPtr pDepthBuffer)
+    {
+        if(pDepthBuffer == nullptr)
+        {
+            // Run a shadow pass
+            executeDepthPass(pRenderCtx, pCamera);
+            pDepthBuffer = mDepthPass.pState->getFbo()->getDepthStencilTexture();
+        }
 
-        if (mControls.stabilizeCascades)
+        if(mSdsmData.pGpuReduction == nullptr)
         {
-            // Ignore minor changes that can result in swimming
-            distanceRange = round(distanceRange * 16.0f) / 16.0f;
-            distanceRange.y = max(distanceRange.y, 0.005f);
+            mSdsmData.pGpuReduction = SdsmReduction::create(mSdsmData.readbackLatency);
         }
+        vec2 depthRange = mSdsmData.pGpuReduction->execute(pRenderCtx, pDepthBuffer, partition);
+        mSdsmData.sdsmResult = SdsmReduction::calcDistanceRange(partition, depthRange);
     }
 
-    vec2 CascadedShadowMaps::calcDistanceRange(RenderContext* pRenderCtx, const Camera* pCamera, const Texture::SharedPtr& pDepthBuffer)
+    bool CascadedShadowMaps::isGpuPartitionEnabled() const
+    {
+        return mControls.useMinMaxSdsm && mControls.gpuSdsm && (mControls.cacheStaticCasters == false);
+    }
+
+    vec2 CascadedShadowMaps::calcDistanceRange(RenderContext* pRenderCtx, const CsmPartitionData& partition, const Camera* pCamera, const Texture::SharedPtr& pDepthBuffer)
     {
         if(mControls.useMinMaxSdsm)
         {
-            reduceDepthSdsmMinMax(pRenderCtx, pCamera, pDepthBuffer);
+            if(mControls.gpuSdsm)
+            {
+                reduceDepthSdsmGpu(pRenderCtx, partition, pCamera, pDepthBuffer);
+            }
+            else
+            {
+                reduceDepthSdsmMinMax(pRenderCtx, partition, pCamera, pDepthBuffer);
+            }
             return mSdsmData.sdsmResult;
         }
         else
@@ -822,11 +953,34 @@ namespace Falcor
     {
         if (!mpLight || !mpSceneRenderer) return;
 
-        const glm::vec4 clearColor(0);
-        pRenderCtx->clearFbo(mShadowPass.pFbo.get(), clearColor, 1, 0, FboAttachmentType::All);
+        // With static caching, the shadow-map is overwritten by the cached static depth
+        if (mControls.cacheStaticCasters == false)
+        {
+            const glm::vec4 clearColor(0);
+            pRenderCtx->clearFbo(mShadowPass.pFbo.get(), clearColor, 1, 0, FboAttachmentType::All);
+        }
 
-        // Calc the bounds
-        glm::vec2 distanceRange = calcDistanceRange(pRenderCtx, pCamera, pSceneDepthBuffer);
+        // Partition the cascades. With the GPU partition, the shadow and visibility passes read the cascades from the partition buffer instead of CsmData.
+        // The cascades of CsmData are then partitioned from the depth bounds read back with latency, and only used to cull the casters.
+        CsmPartitionData partition = calcPartitionData(pCamera);
+        mCsmData.globalMat = partition.globalMat;
+        bool gpuPartition = isGpuPartitionEnabled();
+        partitionCascades(partition, calcDistanceRange(pRenderCtx, partition, pCamera, pSceneDepthBuffer), gpuPartition);
+
+        Program* pShadowProgram = mShadowPass.pState->getProgram().get();
+        Program* pVisibilityProgram = mVisibilityPass.pPass->getProgram().get();
+        if(gpuPartition)
+        {
+            pShadowProgram->addDefine("_CSM_GPU_PARTITION");
+            pVisibilityProgram->addDefine("_CSM_GPU_PARTITION");
+            mShadowPass.pGraphicsVars->setStructuredBuffer("gCsmCascades", mSdsmData.pGpuReduction->getCascadeBuffer());
+            mVisibilityPass.pGraphicsVars->setStructuredBuffer("gCsmCascades", mSdsmData.pGpuReduction->getCascadeBuffer());
+        }
+        else
+        {
+            pShadowProgram->removeDefine("_CSM_GPU_PARTITION");
+            pVisibilityProgram->removeDefine("_CSM_GPU_PARTITION");
+        }
 
         GraphicsState::Viewport VP;
         VP.originX = 0;
@@ -840,7 +994,6 @@ namespace Falcor
         mShadowPass.pState->setViewport(0, VP);
         mpCsmSceneRenderer->setDepthClamp(mControls.depthClamp);
         pRenderCtx->pushGraphicsState(mShadowPass.pState);
-        partitionCascades(pCamera, distanceRange);
         renderScene(pRenderCtx);
         
         if(mCsmData.filterMode == CsmFilterVsm || mCsmData.filterMode == CsmFilterEvsm2 || mCsmData.filterMode == CsmFilterEvsm4)
@@ -28,6 +28,8 @@
 #pragma once
 #include "API/Texture.h"
 #include "Data/Effects/CsmData.h"
+#include "CascadeCulling.h"
+#include "SdsmReduction.h"
 #include "../Utils/GaussianBlur.h"
 #include "Graphics/Light.h"
 #include "Graphics/Scene/Scene.h"
@@ -100,6 +102,17 @@ namespace Falcor
         */
         void toggleMinMaxSdsm(bool enable) { mControls.useMinMaxSdsm = enable; }
 
+        /** Run SDSM in compute shaders. The cascades are partitioned on the GPU from the current frame's depth, instead of reading the depth bounds back with latency.
+            The bounds are still read back to cull the casters per cascade, against the read back partition with each cascade grown to cover its neighbours.
+            Static caster caching needs the exact partition on the CPU, so while it's enabled the cascades are partitioned on the CPU from the read back bounds.
+            Enabled by default.
+        */
+        void toggleGpuSdsm(bool enable) { mControls.gpuSdsm = enable; }
+
+        /** Check if SDSM runs in compute shaders
+        */
+        bool isGpuSdsmEnabled() const { return mControls.gpuSdsm; }
+
         /** Set the min and max distance from the camera to generate shadows for.
         */
         void setDistanceRange(const glm::vec2& range) { mControls.distanceRange = range; }
@@ -144,6 +157,33 @@ namespace Falcor
         */
         bool isMeshCullingEnabled() const;
 
+        /** Enable culling the casters against each cascade on the CPU. Each cascade is then drawn separately with only its own casters, instead of drawing every caster into every cascade.
+            Mesh-culling is ignored while this is enabled.
+        */
+        void togglePerCascadeCulling(bool enabled) { mControls.perCascadeCulling = enabled; }
+
+        /** Check if per-cascade culling is enabled
+        */
+        bool isPerCascadeCullingEnabled() const { return mControls.perCascadeCulling; }
+
+        /** Set the projected size in shadow-map texels below which casters are skipped by per-cascade culling. 0 keeps all casters.
+            Ignored while the cascades are partitioned on the GPU, since the casters are then culled against larger cascades.
+        */
+        void setMinCasterSize(float texels) { mControls.minCasterSize = texels; }
+
+        /** Enable caching the static casters. Each cascade keeps the depth of its static casters, which is only redrawn when the cascade's frustum or its static casters change.
+            Casters that move or are animated are drawn on top of it every frame. Implies per-cascade culling.
+        */
+        void toggleStaticCasterCaching(bool enabled) { mControls.cacheStaticCasters = enabled; }
+
+        /** Check if static caster caching is enabled
+        */
+        bool isStaticCasterCachingEnabled() const { return mControls.cacheStaticCasters; }
+
+        /** Get the number of caster draws of the last shadow pass, and the number of draws it would have taken to draw every caster into every cascade
+        */
+        glm::uvec2 getCasterDrawCount() const { return glm::uvec2(mCasterCulling.drawCount, mCasterCulling.unculledDrawCount); }
+
         /** Enable saving cascade info into the gba channels of the visibility buffer
         */
         void toggleCascadeVisualization(bool shouldVisualze);
@@ -188,12 +228,18 @@ namespace Falcor
 
         // Set shadow map generation parameters into a program.
         void setDataIntoGraphicsVars(GraphicsVars::SharedPtr pVars, const std::string& varName);
-        vec2 calcDistanceRange(RenderContext* pRenderCtx, const Camera* pCamera, const Texture::SharedPtr& pDepthBuffer);
+        vec2 calcDistanceRange(RenderContext* pRenderCtx, const CsmPartitionData& partition, const Camera* pCamera, const Texture::SharedPtr& pDepthBuffer);
+        CsmPartitionData calcPartitionData(const Camera* pCamera) const;
+        bool isGpuPartitionEnabled() const;
         void createDepthPassResources();
         void createShadowPassResources(uint32_t mapWidth, uint32_t mapHeight);
         void createVisibilityPassResources();
-        void partitionCascades(const Camera* pCamera, const glm::vec2& distanceRange);
+        void partitionCascades(const CsmPartitionData& partition, const glm::vec2& distanceRange, bool forCulling);
         void renderScene(RenderContext* pCtx);
+        void collectCasterBounds();
+        void renderCascadeCasters(RenderContext* pCtx, ConstantBuffer* pCB, uint32_t cascade, const std::vector<uint32_t>& casters);
+        void createStaticCasterFbo();
+        void renderCachedCascades(RenderContext* pCtx, ConstantBuffer* pCB);
 
         // Shadow-pass
         struct
@@ -212,6 +258,7 @@ namespace Falcor
         struct SdsmData
         {
             ParallelReduction::UniquePtr minMaxReduction;
+            SdsmReduction::UniquePtr pGpuReduction;
             vec2 sdsmResult;   // Used for displaying the range in the UI
             uint32_t width = 0;
             uint32_t height = 0;
@@ -220,11 +267,32 @@ namespace Falcor
         };
         SdsmData mSdsmData;
         void createSdsmData(Texture::SharedPtr pTexture);
-        void reduceDepthSdsmMinMax(RenderContext* pRenderCtx, const Camera* pCamera, const Texture::SharedPtr pDepthBuffer);
+        void reduceDepthSdsmMinMax(RenderContext* pRenderCtx, const CsmPartitionData& partition, const Camera* pCamera, Texture::SharedPtr pDepthBuffer);
+        void reduceDepthSdsmGpu(RenderContext* pRenderCtx, const CsmPartitionData& partition, const Camera* pCamera, Texture::SharedPtr pDepthBuffer);
         void createVsmSampleState(uint32_t maxAnisotropy);
 
         GaussianBlur::UniquePtr mpGaussianBlur;
 
+        // Per-cascade caster culling
+        struct
+        {
+            std::vector<BoundingBox> casterBounds;      // World-space bounds of the mesh instances, in the order CsmSceneRenderer draws them
+            std::vector<bool> animated;                 // Per caster, true if its model has animations
+            CascadeCulling::CasterLists casterLists;
+            uint32_t drawCount = 0;
+            uint32_t unculledDrawCount = 0;
+        } mCasterCulling;
+
+        // Static caster caching
+        struct
+        {
+            Fbo::SharedPtr pFbo;        // Depth of the static casters, same layout as the shadow-map
+            StaticCasterCache cache;
+            bool depthClamp = true;
+            glm::vec2 evsmExponents;
+            uint32_t redrawCount = 0;
+        } mStaticCasters;
+
         // Depth-pass
         struct
         {
@@ -256,10 +324,14 @@ namespace Falcor
         {
             bool depthClamp = true;
             bool useMinMaxSdsm = true;
+            bool gpuSdsm = true;
             glm::vec2 distanceRange = glm::vec2(0, 1);
             float pssmLambda = 0.5f;
             PartitionMode partitionMode = PartitionMode::Logarithmic;
             bool stabilizeCascades = false;
+            bool perCascadeCulling = true;
+            bool cacheStaticCasters = false;
+            float minCasterSize = 0;    // In shadow-map texels
         };
 
         int32_t renderCascade = 0;
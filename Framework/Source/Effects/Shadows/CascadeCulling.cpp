@@ -0,0 +1,185 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "CascadeCulling.h"
+#include <cfloat>
+#include <algorithm>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Bounds of a box in normalized device coordinates
+        struct NdcBounds
+        {
+            glm::vec3 minPos;
+            glm::vec3 maxPos;
+        };
+
+        // Project the corners of a box. Returns false if a corner is on or behind the eye plane of a perspective projection, in which case the bounds are unknown.
+        bool projectBox(const glm::mat4& mat, const BoundingBox& box, NdcBounds& bounds)
+        {
+            bounds.minPos = glm::vec3(FLT_MAX);
+            bounds.maxPos = glm::vec3(-FLT_MAX);
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                glm::vec3 corner = box.center + box.extent * glm::vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+                glm::vec4 clip = mat * glm::vec4(corner, 1.0f);
+                if (clip.w <= 0) return false;
+                glm::vec3 ndc = glm::vec3(clip) / clip.w;
+                bounds.minPos = glm::min(bounds.minPos, ndc);
+                bounds.maxPos = glm::max(bounds.maxPos, ndc);
+            }
+            return true;
+        }
+
+        bool isBoundsVisible(const NdcBounds& bounds, float minProjectedSize)
+        {
+            // There's no near plane test. Casters in front of the cascade still cast shadows into it.
+            if (bounds.maxPos.x < -1 || bounds.minPos.x > 1) return false;
+            if (bounds.maxPos.y < -1 || bounds.minPos.y > 1) return false;
+            if (bounds.minPos.z > 1) return false;
+
+            glm::vec3 size = bounds.maxPos - bounds.minPos;
+            return max(size.x, size.y) >= minProjectedSize;
+        }
+
+        bool isSameBox(const BoundingBox& a, const BoundingBox& b)
+        {
+            return a.center == b.center && a.extent == b.extent;
+        }
+
+        bool isSameBoxList(const std::vector<BoundingBox>& a, const std::vector<BoundingBox>& b)
+        {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), isSameBox);
+        }
+    }
+
+    glm::mat4 CascadeCulling::calcCascadeMatrix(const CsmData& csmData, uint32_t cascade)
+    {
+        // The crop is applied after the perspective divide, so it's an affine transform of the clip-space position
+        glm::mat4 crop;
+        crop[0][0] = csmData.cascadeScale[cascade].x;
+        crop[1][1] = csmData.cascadeScale[cascade].y;
+        crop[2][2] = csmData.cascadeScale[cascade].z;
+        crop[3] = glm::vec4(glm::vec3(csmData.cascadeOffset[cascade]), 1.0f);
+        return crop * csmData.globalMat;
+    }
+
+    bool CascadeCulling::isCasterVisible(const glm::mat4& cascadeMat, const BoundingBox& box, float minProjectedSize)
+    {
+        NdcBounds bounds;
+        if (projectBox(cascadeMat, box, bounds) == false) return true;
+        return isBoundsVisible(bounds, minProjectedSize);
+    }
+
+    void CascadeCulling::cullCasters(const CsmData& csmData, const std::vector<BoundingBox>& casters, float minProjectedSize, CasterLists& lists)
+    {
+        uint32_t cascadeCount = (uint32_t)csmData.cascadeCount;
+        lists.resize(cascadeCount);
+        for (auto& list : lists)
+        {
+            list.clear();
+        }
+
+        for (uint32_t i = 0; i < (uint32_t)casters.size(); i++)
+        {
+            NdcBounds globalBounds;
+            if (projectBox(csmData.globalMat, casters[i], globalBounds) == false)
+            {
+                for (auto& list : lists)
+                {
+                    list.push_back(i);
+                }
+                continue;
+            }
+
+            // The crop scale is positive, so the cropped bounds are the crop of the global bounds
+            for (uint32_t c = 0; c < cascadeCount; c++)
+            {
+                glm::vec3 scale = glm::vec3(csmData.cascadeScale[c]);
+                glm::vec3 offset = glm::vec3(csmData.cascadeOffset[c]);
+                NdcBounds bounds = { globalBounds.minPos * scale + offset, globalBounds.maxPos * scale + offset };
+                if (isBoundsVisible(bounds, minProjectedSize))
+                {
+                    lists[c].push_back(i);
+                }
+            }
+        }
+    }
+
+    void StaticCasterCache::update(const CsmData& csmData, const CascadeCulling::CasterLists& lists, const std::vector<BoundingBox>& casters, const std::vector<bool>& animated)
+    {
+        uint32_t cascadeCount = (uint32_t)csmData.cascadeCount;
+        mStaticLists.resize(cascadeCount);
+        mDynamicLists.resize(cascadeCount);
+
+        // If the caster count changed, the indices don't match the previous frame, and every caster counts as moved for a frame
+        bool sameCasters = mPrevCasterBounds.size() == casters.size();
+
+        for (uint32_t c = 0; c < cascadeCount; c++)
+        {
+            mStaticLists[c].clear();
+            mDynamicLists[c].clear();
+            mStaticBounds.clear();
+            for (uint32_t i : lists[c])
+            {
+                bool isStatic = sameCasters && (animated[i] == false) && isSameBox(casters[i], mPrevCasterBounds[i]);
+                if (isStatic)
+                {
+                    mStaticLists[c].push_back(i);
+                    mStaticBounds.push_back(casters[i]);
+                }
+                else
+                {
+                    mDynamicLists[c].push_back(i);
+                }
+            }
+
+            Cascade& cascade = mCascades[c];
+            glm::mat4 cascadeMat = CascadeCulling::calcCascadeMatrix(csmData, c);
+            cascade.redraw = (cascade.valid == false) || (cascadeMat != cascade.cascadeMat) || (isSameBoxList(mStaticBounds, cascade.casterBounds) == false);
+            if (cascade.redraw)
+            {
+                cascade.valid = true;
+                cascade.cascadeMat = cascadeMat;
+                cascade.casterBounds = mStaticBounds;
+            }
+        }
+
+        mPrevCasterBounds = casters;
+    }
+
+    void StaticCasterCache::invalidate()
+    {
+        for (auto& cascade : mCascades)
+        {
+            cascade.valid = false;
+        }
+    }
+}
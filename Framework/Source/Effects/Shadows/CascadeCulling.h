@@ -0,0 +1,112 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Data/Effects/CsmData.h"
+#include "Utils/AABB.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU culling of shadow casters against the cascades of CascadedShadowMaps.
+        A cascade's light-space frustum is the global shadow matrix followed by the cascade's crop transform, the same transform the shadow pass geometry shader applies.
+        Casters between the light and a cascade are never rejected, since the shadow pass clamps their depth and they still shadow the cascade.
+    */
+    class CascadeCulling
+    {
+    public:
+        /** Caster indices per cascade, in increasing order
+        */
+        using CasterLists = std::vector<std::vector<uint32_t>>;
+
+        /** Calculate the matrix from world space to the clip space of a cascade
+        */
+        static glm::mat4 calcCascadeMatrix(const CsmData& csmData, uint32_t cascade);
+
+        /** Check if a caster can shadow a cascade. This is the reference cullCasters() is tested against.
+            \param[in] cascadeMat World to cascade clip-space matrix, see calcCascadeMatrix()
+            \param[in] box World-space bounds of the caster
+            \param[in] minProjectedSize Casters whose projected width and height are both smaller than this are rejected. In clip-space units, where 2 covers the whole shadow-map. 0 disables the test.
+        */
+        static bool isCasterVisible(const glm::mat4& cascadeMat, const BoundingBox& box, float minProjectedSize);
+
+        /** Build the visible caster list of every cascade. Each caster is projected into the global light space once, and the cascades are tested against its projected bounds.
+            \param[in] csmData The cascades, after partitioning
+            \param[in] casters World-space bounds of the casters
+            \param[in] minProjectedSize See isCasterVisible()
+            \param[out] lists Receives csmData.cascadeCount lists
+        */
+        static void cullCasters(const CsmData& csmData, const std::vector<BoundingBox>& casters, float minProjectedSize, CasterLists& lists);
+    };
+
+    /** Splits the casters of each cascade into static and dynamic ones, and tracks which cascades need their static casters redrawn.
+        A caster is dynamic while its bounds change between frames, and always if it's animated. A cascade's static casters are redrawn when its frustum changes,
+        or when its list of static casters changes. The latter includes casters starting or stopping to move, and casters becoming visible or hidden.
+    */
+    class StaticCasterCache
+    {
+    public:
+        /** Update for a new frame
+            \param[in] csmData The cascades, after partitioning
+            \param[in] lists Visible casters of each cascade, from CascadeCulling::cullCasters()
+            \param[in] casters World-space bounds of the casters
+            \param[in] animated Per caster, true if its geometry can change while its bounds don't
+        */
+        void update(const CsmData& csmData, const CascadeCulling::CasterLists& lists, const std::vector<BoundingBox>& casters, const std::vector<bool>& animated);
+
+        /** Force all cascades to be redrawn on the next update
+        */
+        void invalidate();
+
+        /** Check if the static casters of a cascade have to be redrawn this frame
+        */
+        bool isRedrawNeeded(uint32_t cascade) const { return mCascades[cascade].redraw; }
+
+        /** Get the static casters of each cascade
+        */
+        const CascadeCulling::CasterLists& getStaticLists() const { return mStaticLists; }
+
+        /** Get the dynamic casters of each cascade. They have to be drawn every frame, on top of the static ones.
+        */
+        const CascadeCulling::CasterLists& getDynamicLists() const { return mDynamicLists; }
+
+    private:
+        struct Cascade
+        {
+            bool valid = false;
+            bool redraw = true;
+            glm::mat4 cascadeMat;
+            std::vector<BoundingBox> casterBounds;    // Bounds of the static casters the cached depth was drawn with
+        };
+
+        Cascade mCascades[CSM_MAX_CASCADES];
+        std::vector<BoundingBox> mPrevCasterBounds;
+        std::vector<BoundingBox> mStaticBounds;
+        CascadeCulling::CasterLists mStaticLists;
+        CascadeCulling::CasterLists mDynamicLists;
+    };
+}
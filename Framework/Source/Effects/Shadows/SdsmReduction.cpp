@@ -0,0 +1,174 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SdsmReduction.h"
+#include "Data/Effects/CsmPartition.h"
+#include "CSM.h"
+#include "API/RenderContext.h"
+
+namespace Falcor
+{
+    static const char* kSdsmShader = "Effects/SdsmReduction.cs.slang";
+    static const uint32_t kGroupSize = 16;  // SDSM_GROUP_SIZE in the shader
+
+    static_assert((uint32_t)CascadedShadowMaps::PartitionMode::Linear == CsmPartitionLinear, "PartitionMode doesn't match CsmData.h");
+    static_assert((uint32_t)CascadedShadowMaps::PartitionMode::Logarithmic == CsmPartitionLogarithmic, "PartitionMode doesn't match CsmData.h");
+    static_assert((uint32_t)CascadedShadowMaps::PartitionMode::PSSM == CsmPartitionPssm, "PartitionMode doesn't match CsmData.h");
+
+    SdsmReduction::UniquePtr SdsmReduction::create(uint32_t readbackLatency, bool useWaveOps)
+    {
+        return UniquePtr(new SdsmReduction(readbackLatency, useWaveOps));
+    }
+
+    SdsmReduction::SdsmReduction(uint32_t readbackLatency, bool useWaveOps) : mUseWaveOps(useWaveOps)
+    {
+        ComputeProgram::SharedPtr pProgram = ComputeProgram::createFromFile(kSdsmShader, "partitionCascades");
+        mPartitionPass.pState = ComputeState::create();
+        mPartitionPass.pState->setProgram(pProgram);
+        mPartitionPass.pVars = ComputeVars::create(pProgram->getReflector());
+
+        // The bounds are reduced with InterlockedMax, so they start at 0. partitionCascades() clears them again after reading them.
+        mpDepthBounds = StructuredBuffer::create(pProgram, "gDepthBounds", 2);
+        const uint32_t zero[2] = { 0, 0 };
+        mpDepthBounds->setBlob(zero, 0, sizeof(zero));
+        mpCascades = StructuredBuffer::create(pProgram, "gCascades", CSM_MAX_CASCADES);
+
+        mPartitionPass.pVars->setStructuredBuffer("gDepthBounds", mpDepthBounds);
+        mPartitionPass.pVars->setStructuredBuffer("gCascades", mpCascades);
+
+        mResultData.resize(readbackLatency + 1);
+        for (auto& res : mResultData)
+        {
+            res.pTexture = Texture::create2D(1, 1, ResourceFormat::RG32Float, 1, 1, nullptr, Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess);
+        }
+    }
+
+    void SdsmReduction::createReducePass(uint32_t sampleCount)
+    {
+        Program::DefineList defines;
+        defines.add("_SAMPLE_COUNT", std::to_string(sampleCount));
+        if (mUseWaveOps) defines.add("_USE_WAVE_OPS");
+
+        ComputeProgram::SharedPtr pProgram = ComputeProgram::createFromFile(kSdsmShader, "reduceDepth", defines, Shader::CompilerFlags::None, mUseWaveOps ? "6_0" : "");
+        mReducePass.pState = ComputeState::create();
+        mReducePass.pState->setProgram(pProgram);
+        mReducePass.pVars = ComputeVars::create(pProgram->getReflector());
+        mReducePass.pVars->setStructuredBuffer("gDepthBounds", mpDepthBounds);
+        mSampleCount = sampleCount;
+    }
+
+    glm::vec2 SdsmReduction::execute(RenderContext* pCtx, const Texture::SharedPtr& pDepth, const CsmPartitionData& partition)
+    {
+        assert(pDepth);
+        if (mSampleCount != pDepth->getSampleCount())
+        {
+            createReducePass(pDepth->getSampleCount());
+        }
+
+        // Reduce the depth
+        mReducePass.pVars->setTexture("gDepth", pDepth);
+        pCtx->pushComputeState(mReducePass.pState);
+        pCtx->pushComputeVars(mReducePass.pVars);
+        pCtx->dispatch((pDepth->getWidth() + kGroupSize - 1) / kGroupSize, (pDepth->getHeight() + kGroupSize - 1) / kGroupSize, 1);
+        pCtx->popComputeVars();
+        pCtx->popComputeState();
+
+        // Both passes access the bounds as a UAV, which doesn't transition the buffer
+        pCtx->uavBarrier(mpDepthBounds.get());
+
+        // Partition the cascades
+        const Texture::SharedPtr& pResult = mResultData[mCurResult].pTexture;
+        mPartitionPass.pVars->getConstantBuffer("PartitionCB")->setBlob(&partition, 0, sizeof(partition));
+        mPartitionPass.pVars->setTexture("gDepthRange", pResult);
+        pCtx->pushComputeState(mPartitionPass.pState);
+        pCtx->pushComputeVars(mPartitionPass.pVars);
+        pCtx->dispatch(1, 1, 1);
+        pCtx->popComputeVars();
+        pCtx->popComputeState();
+
+        // The partition pass clears the bounds for the reduction of the next frame
+        pCtx->uavBarrier(mpDepthBounds.get());
+        mResultData[mCurResult].pReadTask = pCtx->asyncReadTextureSubresource(pResult.get(), 0);
+
+        // Read back the bounds
+        mCurResult = (mCurResult + 1) % mResultData.size();
+        glm::vec2 bounds(0, 1);
+        if (mResultData[mCurResult].pReadTask)
+        {
+            auto texData = mResultData[mCurResult].pReadTask->getData();
+            mResultData[mCurResult].pReadTask = nullptr;
+            bounds = *reinterpret_cast<const glm::vec2*>(texData.data());
+        }
+        return bounds;
+    }
+
+    glm::vec2 SdsmReduction::reduceDepth(const float* pDepth, uint32_t width, uint32_t height, uint32_t sampleCount)
+    {
+        glm::vec2 bounds(1, 0);
+        size_t count = size_t(width) * height * sampleCount;
+        for (size_t i = 0; i < count; i++)
+        {
+            // Skip the background
+            if (pDepth[i] == 1.0f) continue;
+            bounds.x = std::min(bounds.x, pDepth[i]);
+            bounds.y = std::max(bounds.y, pDepth[i]);
+        }
+        return bounds;
+    }
+
+    glm::vec2 SdsmReduction::calcDistanceRange(const CsmPartitionData& partition, const glm::vec2& depthRange)
+    {
+        return calcCsmDistanceRange(partition, depthRange);
+    }
+
+    void SdsmReduction::partitionCascades(const CsmPartitionData& partition, const glm::vec2& distanceRange, CsmCascadeData cascades[CSM_MAX_CASCADES])
+    {
+        assert(partition.partitionMode <= CsmPartitionPssm);
+        for (uint32_t c = 0; c < partition.cascadeCount; c++)
+        {
+            cascades[c] = partitionCsmCascade(partition, distanceRange, c);
+        }
+    }
+
+    void SdsmReduction::partitionCullingCascades(const CsmPartitionData& partition, const glm::vec2& distanceRange, CsmCascadeData cascades[CSM_MAX_CASCADES])
+    {
+        if (partition.cascadeCount == 1)
+        {
+            partitionCascades(partition, distanceRange, cascades);
+            return;
+        }
+
+        for (uint32_t c = 0; c < partition.cascadeCount; c++)
+        {
+            float start = (c > 0) ? calcCsmCascadeSlice(partition, distanceRange, c - 1).x : 0.0f;
+            // The blend overlap can take the last cascade past the far plane
+            float end = (c + 1 < partition.cascadeCount) ? calcCsmCascadeSlice(partition, distanceRange, c + 1).y : std::max(1.0f, calcCsmCascadeSlice(partition, distanceRange, c).y);
+            cascades[c] = calcCsmCascade(partition, glm::vec2(start, end));
+        }
+    }
+}
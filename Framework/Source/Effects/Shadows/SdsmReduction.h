@@ -0,0 +1,121 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Data/Effects/CsmData.h"
+#include "API/StructuredBuffer.h"
+#include "API/Texture.h"
+#include "API/CopyContext.h"
+#include "Graphics/ComputeState.h"
+#include "Graphics/Program/ProgramVars.h"
+#include <memory>
+#include <vector>
+
+namespace Falcor
+{
+    class RenderContext;
+
+    /** Sample distribution shadow-maps on the GPU.
+        A compute shader reduces the depth buffer to its min/max in a single pass, and a second dispatch turns the bounds into the cascade partition.
+        The cascades are written into a structured buffer that the shadow and visibility passes read when _CSM_GPU_PARTITION is defined (see Data/Effects/CascadedShadowMap.slang),
+        so the partition always matches the current frame. The depth bounds are also read back with latency, for the work that needs the cascades on the CPU.
+        The partition is in Data/Effects/CsmPartition.h, which the shader and the static functions share. CascadedShadowMaps also uses them to partition the cascades on the CPU.
+    */
+    class SdsmReduction
+    {
+    public:
+        using UniquePtr = std::unique_ptr<SdsmReduction>;
+
+        /** Create a new object
+            \param[in] readbackLatency Number of frames between execute() reducing the depth and returning the bounds
+            \param[in] useWaveOps Reduce inside a wave with wave intrinsics instead of group-shared memory. Requires shader model 6.0.
+        */
+        static UniquePtr create(uint32_t readbackLatency = 1, bool useWaveOps = false);
+
+        /** Reduce a depth buffer and write the cascade partition into the cascade buffer
+            \param[in] pDepth The scene depth. Can be multi-sampled.
+            \param[in] partition The partition inputs of the current frame
+            \return The depth bounds of readbackLatency calls ago, see reduceDepth(). Returns the full depth range (0, 1) until the first result is available.
+        */
+        glm::vec2 execute(RenderContext* pCtx, const Texture::SharedPtr& pDepth, const CsmPartitionData& partition);
+
+        /** Get the buffer of CSM_MAX_CASCADES CsmCascadeData written by execute()
+        */
+        const StructuredBuffer::SharedPtr& getCascadeBuffer() const { return mpCascades; }
+
+        /** Check if the reduction uses wave intrinsics
+        */
+        bool usesWaveOps() const { return mUseWaveOps; }
+
+        /** Find the min/max of a depth buffer, ignoring the background (depth 1)
+            \param[in] pDepth Depth values, row by row. The samples of a pixel are consecutive.
+            \return The min and max depth, or (1, 0) if every sample is background
+        */
+        static glm::vec2 reduceDepth(const float* pDepth, uint32_t width, uint32_t height, uint32_t sampleCount = 1);
+
+        /** Convert depth bounds into the range of linear depth they cover, normalized between the camera's near and far planes. Applies the cascade stabilization.
+        */
+        static glm::vec2 calcDistanceRange(const CsmPartitionData& partition, const glm::vec2& depthRange);
+
+        /** Partition the cascades
+            \param[in] distanceRange The linear depth range to cover, normalized between the camera's near and far planes
+            \param[out] cascades Receives partition.cascadeCount cascades
+        */
+        static void partitionCascades(const CsmPartitionData& partition, const glm::vec2& distanceRange, CsmCascadeData cascades[CSM_MAX_CASCADES]);
+
+        /** Partition the cascades, and grow each one to also cover the slices of its neighbours. The first and last cascades extend at least to the near and far planes.
+            Culling against these cascades is conservative for the partition of a later frame, unless its distance range moved past a neighbouring cascade.
+            \param[in] distanceRange The linear depth range to cover, normalized between the camera's near and far planes
+            \param[out] cascades Receives partition.cascadeCount cascades
+        */
+        static void partitionCullingCascades(const CsmPartitionData& partition, const glm::vec2& distanceRange, CsmCascadeData cascades[CSM_MAX_CASCADES]);
+
+    private:
+        SdsmReduction(uint32_t readbackLatency, bool useWaveOps);
+        void createReducePass(uint32_t sampleCount);
+
+        bool mUseWaveOps;
+        uint32_t mSampleCount = 0;
+
+        struct
+        {
+            ComputeState::SharedPtr pState;
+            ComputeVars::SharedPtr pVars;
+        } mReducePass, mPartitionPass;
+
+        StructuredBuffer::SharedPtr mpDepthBounds;
+        StructuredBuffer::SharedPtr mpCascades;
+
+        struct ResultData
+        {
+            CopyContext::ReadTextureTask::SharedPtr pReadTask;
+            Texture::SharedPtr pTexture;
+        };
+        std::vector<ResultData> mResultData;
+        uint32_t mCurResult = 0;
+    };
+}
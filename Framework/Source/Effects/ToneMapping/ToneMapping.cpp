@@ -108,6 +108,7 @@ namespace Falcor
             Fbo::Desc desc;
             desc.setColorTarget(0, luminanceFormat);
             mpLuminanceFbo = FboHelper::create2D(requiredWidth, requiredHeight, desc, 1, Fbo::kAttachEntireMipLevel);
+            mpLuminanceReduction = ParallelReduction::create(ParallelReduction::Type::Mean, 0, requiredWidth, requiredHeight);
         }
     }
 
@@ -126,14 +127,29 @@ namespace Falcor
         pRenderContext->setGraphicsVars(mpLuminanceVars);
         pState->setFbo(mpLuminanceFbo);
         mpLuminancePass->execute(pRenderContext);
-        mpLuminanceFbo->getColorTexture(0)->generateMips(pRenderContext);
+
+        // A global operator only needs the average log-luminance, which a compute reduction finds without building the mip-chain
+        const Texture::SharedPtr& pLuminanceTex = mpLuminanceFbo->getColorTexture(0);
+        bool globalLuminance = mConstBufferData.luminanceLod >= float(pLuminanceTex->getMipCount() - 1);
+        Texture::SharedPtr pAvgLuminanceTex = pLuminanceTex;
+        if (mOperator != Operator::Clamp)
+        {
+            if (globalLuminance)
+            {
+                pAvgLuminanceTex = mpLuminanceReduction->execute(pRenderContext, pLuminanceTex);
+            }
+            else
+            {
+                pLuminanceTex->generateMips(pRenderContext);
+            }
+        }
 
         //Set Tone map vars
         if (mOperator != Operator::Clamp)
         {
             mpToneMapCBuffer->setBlob(&mConstBufferData, 0u, sizeof(mConstBufferData));
             mpToneMapVars->getDefaultBlock()->setSampler(mBindLocations.luminanceSampler, 0, mpLinearSampler);
-            mpToneMapVars->getDefaultBlock()->setSrv(mBindLocations.luminanceTex, 0, mpLuminanceFbo->getColorTexture(0)->getSRV());
+            mpToneMapVars->getDefaultBlock()->setSrv(mBindLocations.luminanceTex, 0, pAvgLuminanceTex->getSRV());
         }
 
         //Tone map
@@ -31,6 +31,7 @@
 #include "API/FBO.h"
 #include "API/Sampler.h"
 #include "Utils/Gui.h"
+#include "Utils/Math/ParallelReduction.h"
 #include "Experimental/RenderGraph/RenderPass.h"
 
 namespace Falcor
@@ -147,6 +148,7 @@ namespace Falcor
         FullScreenPass::UniquePtr mpToneMapPass;
         FullScreenPass::UniquePtr mpLuminancePass;
         Fbo::SharedPtr mpLuminanceFbo;
+        ParallelReduction::UniquePtr mpLuminanceReduction;  ///< Average of the luminance texture, used instead of its mip-chain when the LOD selects the top mip
         GraphicsVars::SharedPtr mpToneMapVars;
         GraphicsVars::SharedPtr mpLuminanceVars;
         ConstantBuffer::SharedPtr mpToneMapCBuffer;
@@ -32,10 +32,115 @@
 #include "Utils/Gui.h"
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include "Utils/Math/SimdVec.h"
 
 namespace Falcor
 {
     static std::string kShaderFilename("Effects/GaussianBlur.ps.slang");
+    static std::string kComputeShaderFilename("Effects/GaussianBlur.cs.slang");
+    static const uint32_t kComputeGroupSize = 128;      // BLUR_GROUP_SIZE in GaussianBlur.cs.slang
+    static const uint32_t kMaxKernelWidthUI = 255;
+
+    namespace
+    {
+        /** Get the format of the compute path's temporary textures. sRGB, BGRA and other formats without typed UAV stores are blurred in a float format.
+        */
+        ResourceFormat getComputeFormat(ResourceFormat format)
+        {
+            switch (format)
+            {
+            case ResourceFormat::R8Unorm:
+            case ResourceFormat::RG8Unorm:
+            case ResourceFormat::RGBA8Unorm:
+            case ResourceFormat::R16Float:
+            case ResourceFormat::RG16Float:
+            case ResourceFormat::RGBA16Float:
+            case ResourceFormat::R32Float:
+            case ResourceFormat::RG32Float:
+            case ResourceFormat::RGBA32Float:
+                return format;
+            default:
+                // Keep the precision of 32-bit formats, which hold the large exponential moments of EVSM shadow maps
+                bool is32Bit = getFormatBytesPerBlock(format) >= 4 * getFormatChannelCount(format);
+                return (getFormatType(format) == FormatType::Float && is32Bit) ? ResourceFormat::RGBA32Float : ResourceFormat::RGBA16Float;
+            }
+        }
+
+        /** Accumulate weight * src into dst for a single RGBA texel
+        */
+        inline void madd(vec4& dst, const vec4& src, float weight)
+        {
+#ifdef FALCOR_USE_SSE2
+            __m128 d = _mm_loadu_ps(&dst.x);
+            __m128 s = _mm_loadu_ps(&src.x);
+            _mm_storeu_ps(&dst.x, _mm_add_ps(d, _mm_mul_ps(s, _mm_set1_ps(weight))));
+#else
+            dst += src * weight;
+#endif
+        }
+
+        /** A set of taps at (possibly fractional) offsets from the center texel
+        */
+        struct Kernel
+        {
+            std::vector<int32_t> texelOffsets;  // Texel of the first bilinear sample of each tap
+            std::vector<float> weights0;        // Weight of that texel
+            std::vector<float> weights1;        // Weight of the next one
+            int32_t radius = 0;
+
+            Kernel(const std::vector<float>& offsets, const std::vector<float>& weights)
+            {
+                for (size_t i = 0; i < offsets.size(); i++)
+                {
+                    float base = std::floor(offsets[i]);
+                    float f = offsets[i] - base;
+                    texelOffsets.push_back(int32_t(base));
+                    weights0.push_back(weights[i] * (1 - f));
+                    weights1.push_back(weights[i] * f);
+                    radius = std::max(radius, std::max(std::abs(int32_t(base)), std::abs(int32_t(base) + 1)));
+                }
+            }
+        };
+
+        Kernel createDirectKernel(const std::vector<float>& weights)
+        {
+            int32_t center = int32_t(weights.size() / 2);
+            std::vector<float> offsets(weights.size());
+            for (size_t i = 0; i < weights.size(); i++) offsets[i] = float(int32_t(i) - center);
+            return Kernel(offsets, weights);
+        }
+
+        /** Convolve every line of an image. Each line is copied into a padded cache first, the same as the compute shader.
+            \param[in] texelStride, lineStride Distance between the texels of a line and between lines, in texels
+        */
+        void convolveLines(const Kernel& kernel, const vec4* pSrc, vec4* pDst, uint32_t lineLength, uint32_t lineCount, uint32_t texelStride, uint32_t lineStride)
+        {
+            std::vector<vec4> lineCache(lineLength + 2 * kernel.radius);
+            for (uint32_t line = 0; line < lineCount; line++)
+            {
+                const vec4* pSrcLine = pSrc + size_t(line) * lineStride;
+                for (int32_t i = 0; i < int32_t(lineCache.size()); i++)
+                {
+                    int32_t x = clamp(i - kernel.radius, 0, int32_t(lineLength) - 1);
+                    lineCache[i] = pSrcLine[size_t(x) * texelStride];
+                }
+
+                vec4* pDstLine = pDst + size_t(line) * lineStride;
+                for (uint32_t x = 0; x < lineLength; x++)
+                {
+                    const vec4* pCenter = lineCache.data() + x + kernel.radius;
+                    vec4 c(0);
+                    for (size_t t = 0; t < kernel.texelOffsets.size(); t++)
+                    {
+                        const vec4* pTexel = pCenter + kernel.texelOffsets[t];
+                        madd(c, pTexel[0], kernel.weights0[t]);
+                        if (kernel.weights1[t] != 0) madd(c, pTexel[1], kernel.weights1[t]);
+                    }
+                    pDstLine[size_t(x) * texelStride] = c;
+                }
+            }
+        }
+    }
 
     GaussianBlur::~GaussianBlur() = default;
 
@@ -56,7 +161,7 @@ namespace Falcor
     {
         if (uiGroup == nullptr || pGui->beginGroup(uiGroup))
         {
-            if (pGui->addIntVar("Kernel Width", (int&)mKernelWidth, 1, 15, 2))
+            if (pGui->addIntVar("Kernel Width", (int&)mKernelWidth, 1, kMaxKernelWidthUI, 2))
             {
                 setKernelWidth(mKernelWidth);
             }
@@ -64,6 +169,20 @@ namespace Falcor
             {
                 setSigma(mSigma);
             }
+            switch (getPath(mKernelWidth))
+            {
+            case Path::PixelShader:
+                pGui->addText("Path: Pixel shader, bilinear taps");
+                break;
+            case Path::Compute:
+                pGui->addText("Path: Compute shader");
+                break;
+            case Path::BoxCascade:
+                pGui->addText("Path: Box filter cascade");
+                break;
+            default:
+                should_not_get_here();
+            }
             if (uiGroup) pGui->endGroup();
         }
     }
@@ -84,26 +203,170 @@ namespace Falcor
         return e / a;
     }
 
-    void GaussianBlur::updateKernel()
+    GaussianBlur::Path GaussianBlur::getPath(uint32_t kernelWidth)
+    {
+        if (kernelWidth <= kMaxPixelShaderKernelWidth) return Path::PixelShader;
+        if (kernelWidth <= kMaxComputeKernelWidth) return Path::Compute;
+        return Path::BoxCascade;
+    }
+
+    std::vector<float> GaussianBlur::calcWeights(uint32_t kernelWidth, float sigma)
     {
-        uint32_t center = mKernelWidth / 2;
+        uint32_t center = kernelWidth / 2;
         float sum = 0;
         std::vector<float> weights(center + 1);
         for (uint32_t i = 0; i <= center; i++)
         {
-            weights[i] = getCoefficient(mSigma, (float)mKernelWidth, (float)i);
+            weights[i] = getCoefficient(sigma, (float)kernelWidth, (float)i);
             sum += (i == 0) ? weights[i] : 2 * weights[i];
         }
 
-        TypedBuffer<float>::SharedPtr pBuf = TypedBuffer<float>::create(mKernelWidth, Resource::BindFlags::ShaderResource);
-
+        std::vector<float> kernel(2 * center + 1);
         for (uint32_t i = 0; i <= center; i++)
         {
             float w = weights[i] / sum;
-            pBuf[center + i] = w;
-            pBuf[center - i] = w;
+            kernel[center + i] = w;
+            kernel[center - i] = w;
+        }
+        return kernel;
+    }
+
+    void GaussianBlur::calcLinearTaps(const std::vector<float>& weights, std::vector<float>& offsets, std::vector<float>& tapWeights)
+    {
+        // Taps on the positive side, the negative side is symmetric
+        uint32_t center = uint32_t(weights.size() / 2);
+        std::vector<float> sideOffsets, sideWeights;
+        for (uint32_t i = 1; i <= center; i += 2)
+        {
+            if (i + 1 <= center)
+            {
+                // The bilinear weight of texel i+1 is the fraction of the offset past i
+                float w = weights[center + i] + weights[center + i + 1];
+                sideOffsets.push_back((i * weights[center + i] + (i + 1) * weights[center + i + 1]) / w);
+                sideWeights.push_back(w);
+            }
+            else
+            {
+                sideOffsets.push_back((float)i);
+                sideWeights.push_back(weights[center + i]);
+            }
+        }
+
+        offsets.clear();
+        tapWeights.clear();
+        for (size_t i = sideOffsets.size(); i > 0; i--)
+        {
+            offsets.push_back(-sideOffsets[i - 1]);
+            tapWeights.push_back(sideWeights[i - 1]);
+        }
+        offsets.push_back(0);
+        tapWeights.push_back(weights[center]);
+        for (size_t i = 0; i < sideOffsets.size(); i++)
+        {
+            offsets.push_back(sideOffsets[i]);
+            tapWeights.push_back(sideWeights[i]);
+        }
+    }
+
+    std::vector<uint32_t> GaussianBlur::calcBoxWidths(float sigma)
+    {
+        // n boxes of width w have a variance of n * (w^2 - 1) / 12. Use two consecutive odd widths so that the sum matches sigma^2.
+        const float n = (float)kBoxCascadeCount;
+        float idealWidth = std::sqrt(12 * sigma * sigma / n + 1);
+        int32_t lowerWidth = int32_t(std::floor(idealWidth));
+        if ((lowerWidth & 1) == 0) lowerWidth--;
+        lowerWidth = std::max(lowerWidth, 1);
+        float lowerCount = (12 * sigma * sigma - n * lowerWidth * lowerWidth - 4 * n * lowerWidth - 3 * n) / (-4.0f * lowerWidth - 4);
+        uint32_t m = (uint32_t)clamp(int32_t(std::round(lowerCount)), 0, int32_t(kBoxCascadeCount));
+
+        std::vector<uint32_t> widths(kBoxCascadeCount);
+        for (uint32_t i = 0; i < kBoxCascadeCount; i++)
+        {
+            uint32_t w = uint32_t((i < m) ? lowerWidth : lowerWidth + 2);
+            widths[i] = std::min(w, kMaxComputeKernelWidth);
+        }
+        return widths;
+    }
+
+    void GaussianBlur::execute(uint32_t kernelWidth, float sigma, const glm::vec4* pSrc, uint32_t width, uint32_t height, glm::vec4* pDst)
+    {
+        kernelWidth |= 1;
+        std::vector<vec4> tmp(size_t(width) * height);
+        Path path = getPath(kernelWidth);
+
+        if (path == Path::BoxCascade)
+        {
+            // Horizontal boxes, then vertical ones, ping-ponging between two temporary images
+            std::vector<uint32_t> boxWidths = calcBoxWidths(sigma);
+            std::vector<vec4> tmp2(tmp.size());
+            vec4* pBuffers[2] = { tmp.data(), tmp2.data() };
+            const vec4* pCur = pSrc;
+            uint32_t next = 0;
+            for (uint32_t axis = 0; axis < 2; axis++)
+            {
+                for (uint32_t w : boxWidths)
+                {
+                    Kernel kernel = createDirectKernel(std::vector<float>(w, 1.0f / w));
+                    if (axis == 0) convolveLines(kernel, pCur, pBuffers[next], width, height, 1, width);
+                    else convolveLines(kernel, pCur, pBuffers[next], height, width, width, 1);
+                    pCur = pBuffers[next];
+                    next = 1 - next;
+                }
+            }
+            std::copy(pCur, pCur + tmp.size(), pDst);
+            return;
+        }
+
+        std::vector<float> weights = calcWeights(kernelWidth, sigma);
+        std::vector<float> offsets, tapWeights;
+        if (path == Path::PixelShader)
+        {
+            calcLinearTaps(weights, offsets, tapWeights);
+        }
+        Kernel kernel = (path == Path::PixelShader) ? Kernel(offsets, tapWeights) : createDirectKernel(weights);
+        convolveLines(kernel, pSrc, tmp.data(), width, height, 1, width);
+        convolveLines(kernel, tmp.data(), pDst, height, width, width, 1);
+    }
+
+    void GaussianBlur::updateKernel()
+    {
+        std::vector<float> weights = calcWeights(mKernelWidth, mSigma);
+        if (mPath == Path::PixelShader)
+        {
+            std::vector<float> offsets, tapWeights;
+            calcLinearTaps(weights, offsets, tapWeights);
+            uint32_t tapCount = (uint32_t)offsets.size();
+
+            TypedBuffer<float>::SharedPtr pOffsets = TypedBuffer<float>::create(tapCount, Resource::BindFlags::ShaderResource);
+            TypedBuffer<float>::SharedPtr pWeights = TypedBuffer<float>::create(tapCount, Resource::BindFlags::ShaderResource);
+            for (uint32_t i = 0; i < tapCount; i++)
+            {
+                pOffsets[i] = offsets[i];
+                pWeights[i] = tapWeights[i];
+            }
+            mpVars->setTypedBuffer("tapOffsets", pOffsets);
+            mpVars->setTypedBuffer("tapWeights", pWeights);
+        }
+        else
+        {
+            mCompute.pWeights = TypedBuffer<float>::create(mKernelWidth, Resource::BindFlags::ShaderResource);
+            for (uint32_t i = 0; i < mKernelWidth; i++)
+            {
+                mCompute.pWeights[i] = weights[i];
+            }
+
+            mCompute.boxWidths = calcBoxWidths(mSigma);
+            mCompute.boxWeights.clear();
+            for (uint32_t w : mCompute.boxWidths)
+            {
+                TypedBuffer<float>::SharedPtr pBuf = TypedBuffer<float>::create(w, Resource::BindFlags::ShaderResource);
+                for (uint32_t i = 0; i < w; i++)
+                {
+                    pBuf[i] = 1.0f / w;
+                }
+                mCompute.boxWeights.push_back(pBuf);
+            }
         }
-        mpVars->setTypedBuffer("weights", pBuf);
     }
 
     void GaussianBlur::createTmpFbo(const Texture* pSrc)
@@ -124,41 +387,109 @@ namespace Falcor
             Fbo::Desc fboDesc;
             fboDesc.setColorTarget(0, srcFormat);
             mpTmpFbo = FboHelper::create2D(pSrc->getWidth(), pSrc->getHeight(), fboDesc, pSrc->getArraySize());
+            mDirty = true;  // The program depends on the array size
         }
     }
 
-    void GaussianBlur::createProgram()
+    void GaussianBlur::createTmpTextures(const Texture* pSrc)
+    {
+        const Texture* pTmp = mCompute.pTmpTex[0].get();
+        bool createTextures = (pTmp == nullptr) ||
+            (pSrc->getWidth() != pTmp->getWidth()) ||
+            (pSrc->getHeight() != pTmp->getHeight()) ||
+            (getComputeFormat(pSrc->getFormat()) != pTmp->getFormat()) ||
+            (pSrc->getArraySize() != pTmp->getArraySize());
+
+        if (createTextures)
+        {
+            for (auto& pTex : mCompute.pTmpTex)
+            {
+                pTex = Texture::create2D(pSrc->getWidth(), pSrc->getHeight(), getComputeFormat(pSrc->getFormat()), pSrc->getArraySize(), 1, nullptr, Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess);
+            }
+            mDirty = true;
+        }
+    }
+
+    void GaussianBlur::createProgram(uint32_t arraySize)
     {
         Program::DefineList defines;
-        defines.add("_KERNEL_WIDTH", std::to_string(mKernelWidth));
-        if(mpTmpFbo->getColorTexture(0)->getArraySize() > 1)
+        if (arraySize > 1)
         {
             defines.add("_USE_TEX2D_ARRAY");
         }
 
-        uint32_t arraySize = mpTmpFbo->getColorTexture(0)->getArraySize();
-        uint32_t layerMask = (arraySize > 1) ? ((1 << arraySize) - 1) : 0;
-        mpHorizontalBlur = FullScreenPass::create(kShaderFilename, defines, true, true, layerMask);
-        mpHorizontalBlur->getProgram()->addDefine("_HORIZONTAL_BLUR");
-        mpVerticalBlur = FullScreenPass::create(kShaderFilename, defines, true, true, layerMask);
-        mpVerticalBlur->getProgram()->addDefine("_VERTICAL_BLUR");
+        if (mPath == Path::PixelShader)
+        {
+            std::vector<float> offsets, tapWeights;
+            calcLinearTaps(calcWeights(mKernelWidth, mSigma), offsets, tapWeights);
+            defines.add("_TAP_COUNT", std::to_string(offsets.size()));
+
+            uint32_t layerMask = (arraySize > 1) ? ((1 << arraySize) - 1) : 0;
+            mpHorizontalBlur = FullScreenPass::create(kShaderFilename, defines, true, true, layerMask);
+            mpHorizontalBlur->getProgram()->addDefine("_HORIZONTAL_BLUR");
+            mpVerticalBlur = FullScreenPass::create(kShaderFilename, defines, true, true, layerMask);
+            mpVerticalBlur->getProgram()->addDefine("_VERTICAL_BLUR");
+
+            ProgramReflection::SharedConstPtr pReflector = mpHorizontalBlur->getProgram()->getReflector();
+            mpVars = GraphicsVars::create(pReflector);
+
+            mBindLocations.sampler = pReflector->getDefaultParameterBlock()->getResourceBinding("gSampler");
+            mBindLocations.srcTexture = pReflector->getDefaultParameterBlock()->getResourceBinding("gSrcTex");
+        }
+        else
+        {
+            Program::DefineList horizontalDefines = defines;
+            horizontalDefines.add("_HORIZONTAL_BLUR");
+            ComputeProgram::SharedPtr pHorizontalProgram = ComputeProgram::createFromFile(kComputeShaderFilename, "main", horizontalDefines);
+            mCompute.pHorizontalState = ComputeState::create();
+            mCompute.pHorizontalState->setProgram(pHorizontalProgram);
 
-        ProgramReflection::SharedConstPtr pReflector = mpHorizontalBlur->getProgram()->getReflector();
-        mpVars = GraphicsVars::create(pReflector);
+            Program::DefineList verticalDefines = defines;
+            verticalDefines.add("_VERTICAL_BLUR");
+            mCompute.pVerticalState = ComputeState::create();
+            mCompute.pVerticalState->setProgram(ComputeProgram::createFromFile(kComputeShaderFilename, "main", verticalDefines));
 
-        mBindLocations.sampler = pReflector->getDefaultParameterBlock()->getResourceBinding("gSampler");
-        mBindLocations.srcTexture = pReflector->getDefaultParameterBlock()->getResourceBinding("gSrcTex");
+            mCompute.pVars = ComputeVars::create(pHorizontalProgram->getReflector());
+        }
 
         updateKernel();
         mDirty = false;
     }
 
+    GaussianBlur::Path GaussianBlur::selectPath(const Texture* pSrc, const Fbo* pDst) const
+    {
+        Path path = getPath(mKernelWidth);
+        if (path == Path::PixelShader) return path;
+
+        // The compute path copies its result into the destination if the formats match, and blits it otherwise. Blits don't support arrays.
+        const Texture* pDstTex = pDst->getColorTexture(0).get();
+        bool canCopy = (pDstTex->getFormat() == getComputeFormat(pSrc->getFormat())) &&
+            (pDstTex->getWidth() == pSrc->getWidth()) &&
+            (pDstTex->getHeight() == pSrc->getHeight()) &&
+            (pDstTex->getArraySize() == pSrc->getArraySize());
+        bool canBlit = (pSrc->getArraySize() == 1) && (pDstTex->getArraySize() == 1);
+        return (canCopy || canBlit) ? path : Path::PixelShader;
+    }
+
     void GaussianBlur::execute(RenderContext* pRenderContext, Texture::SharedPtr pSrc, Fbo::SharedPtr pDst)
     {
+        Path path = selectPath(pSrc.get(), pDst.get());
+        if (path != mPath)
+        {
+            mPath = path;
+            mDirty = true;
+        }
+
+        if (mPath != Path::PixelShader)
+        {
+            executeCompute(pRenderContext, pSrc, pDst);
+            return;
+        }
+
         createTmpFbo(pSrc.get());
         if (mDirty)
         {
-            createProgram();
+            createProgram(pSrc->getArraySize());
         }
 
         uint32_t arraySize = pSrc->getArraySize();
@@ -199,4 +530,71 @@ namespace Falcor
 
         pRenderContext->popGraphicsVars();
     }
-}
\ No newline at end of file
+
+    void GaussianBlur::runComputePass(RenderContext* pRenderContext, const ComputeState::SharedPtr& pState, const Texture::SharedPtr& pSrc, const Texture::SharedPtr& pDst, const TypedBuffer<float>::SharedPtr& pWeights, uint32_t kernelWidth)
+    {
+        mCompute.pVars->setTexture("gSrcTex", pSrc);
+        mCompute.pVars->setTexture("gDstTex", pDst);
+        mCompute.pVars->setTypedBuffer("weights", pWeights);
+        mCompute.pVars["BlurCB"]["gKernelWidth"] = kernelWidth;
+
+        // A group per kComputeGroupSize texels of a line
+        bool horizontal = (pState == mCompute.pHorizontalState);
+        uint32_t lineLength = horizontal ? pSrc->getWidth() : pSrc->getHeight();
+        uint32_t lineCount = horizontal ? pSrc->getHeight() : pSrc->getWidth();
+
+        pRenderContext->pushComputeState(pState);
+        pRenderContext->pushComputeVars(mCompute.pVars);
+        pRenderContext->dispatch((lineLength + kComputeGroupSize - 1) / kComputeGroupSize, lineCount, pSrc->getArraySize());
+        pRenderContext->popComputeVars();
+        pRenderContext->popComputeState();
+    }
+
+    void GaussianBlur::executeCompute(RenderContext* pRenderContext, Texture::SharedPtr pSrc, Fbo::SharedPtr pDst)
+    {
+        createTmpTextures(pSrc.get());
+        if (mDirty)
+        {
+            createProgram(pSrc->getArraySize());
+        }
+
+        // Ping-pong between the temporary textures, starting from the source
+        Texture::SharedPtr pCur = pSrc;
+        uint32_t next = 0;
+        auto runPass = [&](const ComputeState::SharedPtr& pState, const TypedBuffer<float>::SharedPtr& pWeights, uint32_t kernelWidth)
+        {
+            runComputePass(pRenderContext, pState, pCur, mCompute.pTmpTex[next], pWeights, kernelWidth);
+            pCur = mCompute.pTmpTex[next];
+            next = 1 - next;
+        };
+
+        if (mPath == Path::BoxCascade)
+        {
+            for (size_t i = 0; i < mCompute.boxWidths.size(); i++)
+            {
+                runPass(mCompute.pHorizontalState, mCompute.boxWeights[i], mCompute.boxWidths[i]);
+            }
+            for (size_t i = 0; i < mCompute.boxWidths.size(); i++)
+            {
+                runPass(mCompute.pVerticalState, mCompute.boxWeights[i], mCompute.boxWidths[i]);
+            }
+        }
+        else
+        {
+            runPass(mCompute.pHorizontalState, mCompute.pWeights, mKernelWidth);
+            runPass(mCompute.pVerticalState, mCompute.pWeights, mKernelWidth);
+        }
+
+        const Texture::SharedPtr& pDstTex = pDst->getColorTexture(0);
+        if (pDstTex->getFormat() == pCur->getFormat() && pDstTex->getWidth() == pCur->getWidth() && pDstTex->getHeight() == pCur->getHeight() && pDstTex->getArraySize() == pCur->getArraySize())
+        {
+            pRenderContext->copyResource(pDstTex.get(), pCur.get());
+        }
+        else
+        {
+            // Like the pixel-shader path, the result covers the top-left corner of a larger destination
+            uvec4 dstRect(0, 0, pCur->getWidth(), pCur->getHeight());
+            pRenderContext->blit(pCur->getSRV(0, 1, 0, 1), pDstTex->getRTV(0, 0, 1), uvec4(-1), dstRect, Sampler::Filter::Point);
+        }
+    }
+}
@@ -30,6 +30,8 @@
 #include "Graphics/FullScreenPass.h"
 #include "API/Sampler.h"
 #include "Graphics/Program/ProgramVars.h"
+#include "Graphics/ComputeState.h"
+#include "API/TypedBuffer.h"
 #include <memory>
 
 namespace Falcor
@@ -40,11 +42,29 @@ namespace Falcor
     class Gui;
 
     /** Gaussian-blur technique
+        The path depends on the kernel width, see getPath():
+        - Small kernels run in a pixel shader. Adjacent texels are merged into a single bilinear tap, which halves the number of fetches.
+        - Larger kernels run in a compute shader, which caches a line of texels in shared memory.
+        - Wider kernels than the line cache can hold are approximated by a cascade of kBoxCascadeCount box filters with the same variance.
+        The compute paths blur into temporary textures with a UAV-capable format, and copy or blit the result into the destination.
+        Texture arrays which can't be copied into the destination fall back to the pixel shader.
+        The static execute() runs the same filter on the CPU.
     */
     class GaussianBlur
     {
     public:
         using UniquePtr = std::unique_ptr<GaussianBlur>;
+
+        enum class Path
+        {
+            PixelShader,    ///< Bilinear taps in a pixel shader
+            Compute,        ///< Compute shader with a line cache
+            BoxCascade,     ///< Compute shader, running a cascade of box filters
+        };
+
+        static const uint32_t kMaxPixelShaderKernelWidth = 15;
+        static const uint32_t kMaxComputeKernelWidth = 129;     // Matches BLUR_MAX_RADIUS in GaussianBlur.cs.slang
+        static const uint32_t kBoxCascadeCount = 3;
         /** Destructor
         */
         ~GaussianBlur();
@@ -80,6 +100,31 @@ namespace Falcor
         */
         float getSigma() const { return mSigma; }
 
+        /** Get the path used for a kernel width
+        */
+        static Path getPath(uint32_t kernelWidth);
+
+        /** Calculate the normalized weights of a kernel, one per texel
+        */
+        static std::vector<float> calcWeights(uint32_t kernelWidth, float sigma);
+
+        /** Merge the pairs of adjacent weights into bilinear taps. The center weight stays a tap of its own.
+            \param[in] weights The weights returned by calcWeights()
+            \param[out] offsets The offset of each tap from the center, in texels
+            \param[out] tapWeights The weight of each tap
+        */
+        static void calcLinearTaps(const std::vector<float>& weights, std::vector<float>& offsets, std::vector<float>& tapWeights);
+
+        /** Calculate the widths of the box filters that approximate a Gaussian, see Path::BoxCascade
+        */
+        static std::vector<uint32_t> calcBoxWidths(float sigma);
+
+        /** Blur an image on the CPU, with the same path as the GPU. Pixels outside the image are clamped to the edge.
+            \param[in] pSrc width * height texels, row by row
+            \param[out] pDst Receives width * height texels. Can't be pSrc.
+        */
+        static void execute(uint32_t kernelWidth, float sigma, const glm::vec4* pSrc, uint32_t width, uint32_t height, glm::vec4* pDst);
+
         /** Render UI controls for blur settings.
             \param[in] pGui GUI instance to render UI elements with
             \param[in] uiGroup Optional name. If specified, UI elements will be rendered within a named group
@@ -92,14 +137,20 @@ namespace Falcor
         float mSigma;
         uint32_t vpMask;
         void createTmpFbo(const Texture* pSrc);
-        void createProgram();
+        void createTmpTextures(const Texture* pSrc);
+        void createProgram(uint32_t arraySize);
+        void createComputeProgram(uint32_t arraySize);
         void updateKernel();
+        Path selectPath(const Texture* pSrc, const Fbo* pDst) const;
+        void executeCompute(RenderContext* pRenderContext, Texture::SharedPtr pSrc, Fbo::SharedPtr pDst);
+        void runComputePass(RenderContext* pRenderContext, const ComputeState::SharedPtr& pState, const Texture::SharedPtr& pSrc, const Texture::SharedPtr& pDst, const TypedBuffer<float>::SharedPtr& pWeights, uint32_t kernelWidth);
 
         FullScreenPass::UniquePtr mpHorizontalBlur;
         FullScreenPass::UniquePtr mpVerticalBlur;
         Fbo::SharedPtr mpTmpFbo;
         Sampler::SharedPtr mpSampler;
         bool mDirty = true;
+        Path mPath = Path::PixelShader;     // The path the program was created for
         GraphicsVars::SharedPtr mpVars;
 
         struct
@@ -107,5 +158,16 @@ namespace Falcor
             ParameterBlockReflection::BindLocation sampler;
             ParameterBlockReflection::BindLocation srcTexture;
         } mBindLocations;
+
+        struct
+        {
+            ComputeState::SharedPtr pHorizontalState;
+            ComputeState::SharedPtr pVerticalState;
+            ComputeVars::SharedPtr pVars;
+            TypedBuffer<float>::SharedPtr pWeights;
+            std::vector<uint32_t> boxWidths;
+            std::vector<TypedBuffer<float>::SharedPtr> boxWeights;
+            Texture::SharedPtr pTmpTex[2];
+        } mCompute;
     };
 }
\ No newline at end of file
@@ -27,6 +27,8 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "ForwardLightingPass.h"
+#include "API/Device.h"
+#include "API/RenderContext.h"
 
 namespace Falcor
 {
@@ -38,6 +40,7 @@ namespace Falcor
     static std::string kMotionVecs = "motionVecs";
     static std::string kNormals = "normals";
     static std::string kVisBuffer = "visibilityBuffer";
+    static std::string kShadingRate = "shadingRate";
 
     static std::string kSampleCount = "sampleCount";
     static std::string kSuperSampling = "enableSuperSampling";
@@ -87,6 +90,7 @@ namespace Falcor
         RenderPassReflection reflector;
 
         reflector.addInput(kVisBuffer, "Visibility buffer used for shadowing. Range is [0,1] where 0 means the pixel is fully-shadowed and 1 means the pixel is not shadowed at all").flags(RenderPassReflection::Field::Flags::Optional);
+        reflector.addInput(kShadingRate, "Shading-rate image, see ShadingRateGenerator. Ignored when the device doesn't support variable-rate shading tier 2").flags(RenderPassReflection::Field::Flags::Optional);
         reflector.addInputOutput(kColor, "Color texture").format(mColorFormat).texture2D(0, 0, mSampleCount);
 
         auto& depthField = mUsePreGenDepth ? reflector.addInputOutput(kDepth, "Pre-initialized depth-buffer") : reflector.addOutput(kDepth, "Depth buffer");
@@ -157,10 +161,15 @@ namespace Falcor
             mpVars["PerFrameCB"]["gRenderTargetDim"] = vec2(mpFbo->getWidth(), mpFbo->getHeight());
             mpVars->setTexture(kVisBuffer, pRenderData->getTexture(kVisBuffer));
 
+            const auto& pShadingRate = pRenderData->getTexture(kShadingRate);
+            bool useShadingRate = pShadingRate && gpDevice->isFeatureSupported(Device::SupportedFeatures::VariableRateShadingTier2);
+
             mpState->setFbo(mpFbo);
             pContext->pushGraphicsState(mpState);
             pContext->pushGraphicsVars(mpVars);
+            if (useShadingRate) pContext->setShadingRate(RenderContext::ShadingRate::Rate1x1, pShadingRate);
             mpSceneRenderer->renderScene(pContext);
+            if (useShadingRate) pContext->setShadingRate(RenderContext::ShadingRate::Rate1x1);
             pContext->popGraphicsState();
             pContext->popGraphicsVars();
         }
@@ -110,6 +110,7 @@
 
 // Utils
 #include "Utils/Bitmap.h"
+#include "Utils/BlockCompression.h"
 #include "Utils/DDSHeader.h"
 #include "Utils/Font.h"
 #include "Utils/Gui.h"
@@ -125,9 +126,21 @@
 #include "Utils/Video/VideoDecoder.h"
 #include "Utils/Platform/OS.h"
 #include "Utils/Platform/ProgressBar.h"
+#include "Utils/PixelConversion.h"
+#include "Utils/ImageMetrics.h"
+#include "Utils/FileWatcher.h"
+#include "Utils/TextureBaker.h"
+#include "Utils/Polarization.h"
+#include "Utils/PsiLut.h"
+#include "Utils/SpectralIoR.h"
+#include "Utils/TriangleBvh.h"
+#include "Utils/MuellerCalculus.h"
+#include "Utils/ProbePolarization.h"
 #include "Utils/ThreadPool.h"
 #include "Utils/PatternGenerators/DxSamplePattern.h"
 #include "Utils/PatternGenerators/HaltonSamplePattern.h"
+#include "Utils/PatternGenerators/LowDiscrepancySamplePattern.h"
+#include "Utils/PatternGenerators/BlueNoise.h"
 
 // VR
 #include "VR/OpenVR/VRSystem.h"
@@ -143,6 +156,9 @@
 #include "Effects/ParticleSystem/ParticleSystem.h"
 #include "Effects/TAA/TAA.h"
 #include "Effects/FXAA/FXAA.h"
+#include "Effects/LightClusters/LightClusters.h"
+#include "Effects/ShadingCache/ShadingCache.h"
+#include "Effects/ShadingRate/ShadingRateGenerator.h"
 
 #define FALCOR_MAJOR_VERSION 3
 #define FALCOR_MINOR_VERSION 2
@@ -39,6 +39,7 @@
 #include "API/Texture.h"
 #include "Graphics/Material/Material.h"
 #include "API/Device.h"
+#include "Utils/PixelConversion.h"
 #include <numeric>
 #include <cstring>
 
@@ -448,23 +449,19 @@ namespace Falcor
         {
             dataSize = bpp * texelCount;
         }
-        size_t storageSize = dataSize;
-        if(bpp == 3)
-            storageSize = 4 * texelCount;
-
-        data.data.resize(storageSize);
-        stream.read(data.data.data(), dataSize);
-
-        // Convert 3-channel 8-bits RGB formats to 4-channel RGBX by adding padding
         if(bpp == 3)
         {
-            for(int32_t i=texelCount-1;i>=0;--i)
-            {
-                data.data[i * 4 + 0] = data.data[i * 3 + 0];
-                data.data[i * 4 + 1] = data.data[i * 3 + 1];
-                data.data[i * 4 + 2] = data.data[i * 3 + 2];
-                data.data[i * 4 + 3] = 0xff;
-            }
+            // Convert 3-channel 8-bits RGB formats to 4-channel RGBX by adding padding. The byte order is kept, so this works for BGR as well.
+            std::vector<uint8_t> packed(dataSize);
+            stream.read(packed.data(), dataSize);
+            data.data.resize(4 * texelCount);
+            uint32_t pixelCount = std::min((uint32_t)texelCount, (uint32_t)dataSize / 3);
+            PixelConversion::convertPixels<PixelConversion::Layout::RGB8, PixelConversion::Layout::RGBA8>(packed.data(), data.data.data(), pixelCount);
+        }
+        else
+        {
+            data.data.resize(dataSize);
+            stream.read(data.data.data(), dataSize);
         }
 
         return true;
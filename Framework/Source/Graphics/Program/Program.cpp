@@ -172,6 +172,11 @@ namespace Falcor
 
     Program::~Program()
     {
+        for (const auto& file : mFileSubscriptions)
+        {
+            FileWatcher::unsubscribe(file.second);
+        }
+
         // Remove the current program from the program vector
         for(auto it = sPrograms.begin() ; it != sPrograms.end() ; it++)
         {
@@ -306,7 +311,7 @@ namespace Falcor
             return false;
         }
 
-        // Have any of the files we depend on changed?
+        // Have any of the files we depend on changed? Only files which couldn't be watched are in the map.
         for(auto& entry : mFileTimeMap)
         {
             auto& path = entry.first;
@@ -565,8 +570,7 @@ namespace Falcor
         int depFileCount = spGetDependencyFileCount(slangRequest);
         for(int ii = 0; ii < depFileCount; ++ii)
         {
-            std::string depFilePath = spGetDependencyFilePath(slangRequest, ii);
-            mFileTimeMap[depFilePath] = getFileModifiedTime(depFilePath);
+            watchFile(spGetDependencyFilePath(slangRequest, ii));
         }
 
         spDestroyCompileRequest(slangRequest);
@@ -643,6 +647,30 @@ namespace Falcor
         }
     }
 
+    void Program::watchFile(const std::string& filename) const
+    {
+        if (mFileSubscriptions.count(filename) || mFileTimeMap.count(filename)) return;
+
+        FileWatcher::SubscriptionId id = FileWatcher::subscribe(filename, [this](const std::string& path) { const_cast<Program*>(this)->onFileChanged(path); });
+        if (id == FileWatcher::kInvalidSubscriptionId)
+        {
+            mFileTimeMap[filename] = getFileModifiedTime(filename);
+        }
+        else
+        {
+            mFileSubscriptions[filename] = id;
+        }
+    }
+
+    void Program::onFileChanged(const std::string& filename)
+    {
+        // Only invalidate programs which were linked. The new source will be picked up by the next link anyway.
+        if (mActiveProgram.pVersion == nullptr) return;
+
+        logInfo("'" + filename + "' changed, reloading " + getProgramDescString());
+        reset();
+    }
+
     void Program::reset()
     {
         mActiveProgram = VersionData();
@@ -30,6 +30,7 @@
 #include <map>
 #include <vector>
 #include "Graphics/Program//ProgramVersion.h"
+#include "Utils/FileWatcher.h"
 
 namespace Falcor
 {
@@ -262,7 +263,8 @@ namespace Falcor
         */
         virtual const DefineList& getDefines() const override { return mDefineList; }
 
-        /** Reload and relink all programs.
+        /** Reload and relink all programs whose shader files changed.
+            Programs are also reset automatically when one of their shader files is saved, see FileWatcher.
         */
         static void reloadAllPrograms();
 
@@ -306,9 +308,13 @@ namespace Falcor
         std::string getProgramDescString() const;
         static std::vector<Program*> sPrograms;
 
+        // Shader files are watched for changes and the program is reset when one is saved. Files which can't be watched are polled by checkIfFilesChanged().
         using string_time_map = std::unordered_map<std::string, time_t>;
         mutable string_time_map mFileTimeMap;
+        mutable std::unordered_map<std::string, FileWatcher::SubscriptionId> mFileSubscriptions;
 
+        void watchFile(const std::string& filename) const;
+        void onFileChanged(const std::string& filename);
         bool checkIfFilesChanged();
         void reset();
     };
@@ -39,7 +39,7 @@ namespace Falcor
 
     const Scene::UserVariable Scene::kInvalidVar;
 
-    const FileDialogFilterVec Scene::kFileExtensionFilters = { {"fscene", "Falcor Scene Files"} };
+    const FileDialogFilterVec Scene::kFileExtensionFilters = { {"fscene", "Falcor Scene Files"}, {"fscenebin", "Falcor Binary Scene Files"} };
 
     Scene::SharedPtr Scene::loadFromFile(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags)
     {
@@ -186,6 +186,36 @@ namespace Falcor
         mExtentsDirty = true;
     }
 
+    void Scene::addModelInstances(const Model::SharedPtr& pModel, uint32_t count, const glm::vec3* pTranslations, const glm::vec3* pYawPitchRolls, const glm::vec3* pScalings, const std::string* pNames)
+    {
+        if (count == 0) return;
+
+        // Find the instance list once for all the instances
+        ModelInstanceList* pList = nullptr;
+        for (auto& instances : mModels)
+        {
+            if (instances[0]->getObject() == pModel)
+            {
+                pList = &instances;
+                break;
+            }
+        }
+
+        if (pList == nullptr)
+        {
+            mModels.emplace_back();
+            pList = &mModels.back();
+        }
+
+        pList->reserve(pList->size() + count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            std::string name = pNames ? pNames[i] : "Instance " + std::to_string(i);
+            pList->push_back(ModelInstance::create(pModel, pTranslations[i], pYawPitchRolls[i], pScalings[i], name));
+        }
+        mExtentsDirty = true;
+    }
+
     void Scene::deleteModelInstance(uint32_t modelID, uint32_t instanceID)
     {
         // Delete instance
@@ -104,6 +104,8 @@ namespace Falcor
             GenerateAreaLights = 0x1,    ///< Create area light(s) for meshes that have emissive material
         };
 
+        /** Load a scene from a .fscene file, or from a binary .fscenebin snapshot written by SceneExporter
+        */
         static Scene::SharedPtr loadFromFile(const std::string& filename, Model::LoadFlags modelLoadFlags = Model::LoadFlags::None, Scene::LoadFlags sceneLoadFlags = LoadFlags::None);
         static Scene::SharedPtr create(const std::string& filename = "");
 
@@ -118,6 +120,15 @@ namespace Falcor
         // Model Instances
         virtual void addModelInstance(const ModelInstance::SharedPtr& pInstance);
         void addModelInstance(const Model::SharedPtr& pModel, const std::string& instanceName, const glm::vec3& translation = glm::vec3(), const glm::vec3& yawPitchRoll = glm::vec3(), const glm::vec3& scaling = glm::vec3(1));
+        /** Add instances of a model from contiguous arrays of transforms. This is much faster than adding the instances one by one.
+            \param[in] pModel The model to instantiate
+            \param[in] count Number of instances to add
+            \param[in] pTranslations Array of count translations
+            \param[in] pYawPitchRolls Array of count rotations, in radians
+            \param[in] pScalings Array of count scaling vectors
+            \param[in] pNames Optional. Array of count instance names.
+        */
+        void addModelInstances(const Model::SharedPtr& pModel, uint32_t count, const glm::vec3* pTranslations, const glm::vec3* pYawPitchRolls, const glm::vec3* pScalings, const std::string* pNames = nullptr);
         // Adds a model instance and shares ownership of it
         uint32_t getModelInstanceCount(uint32_t modelID) const;
         const ModelInstance::SharedPtr& getModelInstance(uint32_t modelID, uint32_t instanceID) const { return mModels[modelID][instanceID]; };
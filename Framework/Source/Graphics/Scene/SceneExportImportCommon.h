@@ -102,4 +102,36 @@ namespace Falcor
 
         static const char* kUserDefined = "user_defined";
     };
+
+    /** Binary scene snapshot layout, written by SceneExporter and read by SceneImporter when the file has the kFileExtension extension.
+        The file starts with kMagic and kVersion, followed by a list of sections. Each section starts with its Section tag and its size in bytes,
+        so readers can skip sections they don't know. The list is terminated by Section::End.
+        Strings are stored as a uint32_t length followed by the characters. Model instance transforms are stored as contiguous arrays of glm::vec3.
+    */
+    namespace SceneBinary
+    {
+        static const uint32_t kMagic = 0x42435346;    // "FSCB"
+        static const uint32_t kVersion = 1;
+        static const char kFileExtension[] = ".fscenebin";
+
+        enum class Section : uint32_t
+        {
+            End,
+            GlobalSettings,
+            Models,
+            Lights,
+            Cameras,
+            Paths,
+            UserDefined,
+        };
+
+        enum class PathObjectType : uint32_t
+        {
+            ModelInstance,
+            Camera,
+            Light,
+        };
+
+        static const uint32_t kNoActiveAnimation = (uint32_t)-1;
+    };
 }
\ No newline at end of file
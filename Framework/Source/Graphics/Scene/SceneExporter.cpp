@@ -32,6 +32,7 @@
 #include "SceneExporter.h"
 #include <fstream>
 #include "Utils/Platform/OS.h"
+#include "Utils/StringUtils.h"
 #include "Graphics/Scene/Editor/SceneEditor.h"
 
 #define SCENE_EXPORTER
@@ -46,6 +47,10 @@ namespace Falcor
     bool SceneExporter::saveScene(const std::string& filename, const Scene::SharedPtr& pScene, uint32_t exportOptions)
     {
         SceneExporter exporter(filename, pScene);
+        if (hasSuffix(filename, SceneBinary::kFileExtension, false))
+        {
+            return exporter.saveBinary(exportOptions);
+        }
         return exporter.save(exportOptions);
     }
 
@@ -466,4 +471,259 @@ namespace Falcor
 
         addJsonValue(mJDoc, allocator, SceneKeys::kUserDefined, jsonUserValues);
     }
+
+    /** Accumulates the binary scene snapshot in memory. Sections are written with their size, so they are assembled in a separate buffer first.
+    */
+    class SceneBinaryWriter
+    {
+    public:
+        template<typename T>
+        void write(const T& val) { write(&val, sizeof(T)); }
+
+        void write(const void* pData, size_t size)
+        {
+            const uint8_t* pBytes = (const uint8_t*)pData;
+            mSection.insert(mSection.end(), pBytes, pBytes + size);
+        }
+
+        void writeString(const std::string& str)
+        {
+            write((uint32_t)str.size());
+            write(str.data(), str.size());
+        }
+
+        template<typename T>
+        void writeArray(const std::vector<T>& vec)
+        {
+            write(vec.data(), vec.size() * sizeof(T));
+        }
+
+        void endSection(SceneBinary::Section section)
+        {
+            const uint32_t tag = (uint32_t)section;
+            const uint64_t size = mSection.size();
+            mData.insert(mData.end(), (const uint8_t*)&tag, (const uint8_t*)&tag + sizeof(tag));
+            mData.insert(mData.end(), (const uint8_t*)&size, (const uint8_t*)&size + sizeof(size));
+            mData.insert(mData.end(), mSection.begin(), mSection.end());
+            mSection.clear();
+        }
+
+        bool saveToFile(const std::string& filename)
+        {
+            endSection(SceneBinary::Section::End);
+            std::ofstream outputStream(filename.c_str(), std::ios::binary);
+            if (outputStream.fail())
+            {
+                logError("Can't open output scene file " + filename + ".\nExporting failed.");
+                return false;
+            }
+            outputStream.write((const char*)&SceneBinary::kMagic, sizeof(SceneBinary::kMagic));
+            outputStream.write((const char*)&SceneBinary::kVersion, sizeof(SceneBinary::kVersion));
+            outputStream.write((const char*)mData.data(), mData.size());
+            return outputStream.good();
+        }
+
+    private:
+        std::vector<uint8_t> mData;
+        std::vector<uint8_t> mSection;
+    };
+
+    bool SceneExporter::saveBinary(uint32_t exportOptions)
+    {
+        SceneBinaryWriter writer;
+
+        if (exportOptions & ExportGlobalSettings)
+        {
+            writer.write(mpScene->getSceneUnit());
+            writer.write(mpScene->getCameraSpeed());
+            writer.write(mpScene->getLightingScale());
+            writer.writeString(mpScene->getCameraCount() > 0 ? mpScene->getActiveCamera()->getName() : "");
+            const auto& pEnvMap = mpScene->getEnvironmentMap();
+            writer.writeString(pEnvMap ? stripDataDirectories(pEnvMap->getSourceFilename()) : "");
+            writer.endSection(SceneBinary::Section::GlobalSettings);
+        }
+
+        if ((exportOptions & ExportModels) && mpScene->getModelCount())
+        {
+            std::vector<glm::vec3> translations, rotations, scalings;
+            writer.write(mpScene->getModelCount());
+            for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+            {
+                const Model* pModel = mpScene->getModel(modelID).get();
+                writer.writeString(stripDataDirectories(pModel->getFilename()));
+                writer.writeString(pModel->getName());
+                writer.write(pModel->getMesh(0)->getMaterial()->getShadingModel());
+                writer.write(pModel->hasAnimations() ? pModel->getActiveAnimation() : SceneBinary::kNoActiveAnimation);
+
+                // Transforms are written as one array per component, so the importer can create all instances in a single call
+                const uint32_t instanceCount = mpScene->getModelInstanceCount(modelID);
+                translations.resize(instanceCount);
+                rotations.resize(instanceCount);
+                scalings.resize(instanceCount);
+                for (uint32_t i = 0; i < instanceCount; i++)
+                {
+                    const auto& pInstance = mpScene->getModelInstance(modelID, i);
+                    translations[i] = pInstance->getTranslation();
+                    rotations[i] = pInstance->getRotation();
+                    scalings[i] = pInstance->getScaling();
+                }
+
+                writer.write(instanceCount);
+                writer.writeArray(translations);
+                writer.writeArray(rotations);
+                writer.writeArray(scalings);
+                for (uint32_t i = 0; i < instanceCount; i++)
+                {
+                    writer.writeString(mpScene->getModelInstance(modelID, i)->getName());
+                }
+            }
+            writer.endSection(SceneBinary::Section::Models);
+        }
+
+        if (exportOptions & ExportLights)
+        {
+            std::vector<const Light*> lights;
+            for (const auto& pLight : mpScene->getLights())
+            {
+                if (pLight->getType() == LightPoint || pLight->getType() == LightDirectional) lights.push_back(pLight.get());
+            }
+
+            if (lights.size())
+            {
+                writer.write((uint32_t)lights.size());
+                for (const Light* pLight : lights)
+                {
+                    writer.write(pLight->getType());
+                    writer.writeString(pLight->getName());
+                    writer.write(pLight->getData().intensity);
+                    if (pLight->getType() == LightPoint)
+                    {
+                        const PointLight* pPointLight = (const PointLight*)pLight;
+                        writer.write(pPointLight->getWorldPosition());
+                        writer.write(pPointLight->getWorldDirection());
+                        writer.write(pPointLight->getOpeningAngle());
+                        writer.write(pPointLight->getPenumbraAngle());
+                    }
+                    else
+                    {
+                        writer.write(((const DirectionalLight*)pLight)->getWorldDirection());
+                    }
+                }
+                writer.endSection(SceneBinary::Section::Lights);
+            }
+        }
+
+        if ((exportOptions & ExportCameras) && mpScene->getCameraCount())
+        {
+            writer.write(mpScene->getCameraCount());
+            for (uint32_t i = 0; i < mpScene->getCameraCount(); i++)
+            {
+                const auto pCamera = mpScene->getCamera(i);
+                writer.writeString(pCamera->getName());
+                writer.write(pCamera->getPosition());
+                writer.write(pCamera->getTarget());
+                writer.write(pCamera->getUpVector());
+                writer.write(pCamera->getFocalLength());
+                writer.write(pCamera->getNearPlane());
+                writer.write(pCamera->getFarPlane());
+                writer.write(pCamera->getAspectRatio());
+            }
+            writer.endSection(SceneBinary::Section::Cameras);
+        }
+
+        if ((exportOptions & ExportUserDefined) && mpScene->getUserVariableCount())
+        {
+            writer.write(mpScene->getUserVariableCount());
+            for (uint32_t varID = 0; varID < mpScene->getUserVariableCount(); varID++)
+            {
+                std::string name;
+                const auto& var = mpScene->getUserVariable(varID, name);
+                writer.writeString(name);
+                writer.write(var.type);
+
+                switch (var.type)
+                {
+                case Scene::UserVariable::Type::Int:
+                case Scene::UserVariable::Type::Uint:
+                case Scene::UserVariable::Type::Int64:
+                case Scene::UserVariable::Type::Uint64:
+                case Scene::UserVariable::Type::Double:
+                case Scene::UserVariable::Type::Bool:
+                    writer.write(var.u64);
+                    break;
+                case Scene::UserVariable::Type::String:
+                    writer.writeString(var.str);
+                    break;
+                case Scene::UserVariable::Type::Vec2:
+                    writer.write(var.vec2);
+                    break;
+                case Scene::UserVariable::Type::Vec3:
+                    writer.write(var.vec3);
+                    break;
+                case Scene::UserVariable::Type::Vec4:
+                    writer.write(var.vec4);
+                    break;
+                case Scene::UserVariable::Type::Vector:
+                    writer.write((uint32_t)var.vector.size());
+                    writer.writeArray(var.vector);
+                    break;
+                default:
+                    should_not_get_here();
+                    return false;
+                }
+            }
+            writer.endSection(SceneBinary::Section::UserDefined);
+        }
+
+        // Paths come last, the objects they reference must be loaded first
+        if ((exportOptions & ExportPaths) && mpScene->getPathCount())
+        {
+            writer.write(mpScene->getPathCount());
+            for (uint32_t pathID = 0; pathID < mpScene->getPathCount(); pathID++)
+            {
+                const auto pPath = mpScene->getPath(pathID);
+                writer.writeString(pPath->getName());
+                writer.write((uint32_t)pPath->isRepeatOn());
+
+                writer.write(pPath->getKeyFrameCount());
+                for (uint32_t frameID = 0; frameID < pPath->getKeyFrameCount(); frameID++)
+                {
+                    const auto& frame = pPath->getKeyFrame(frameID);
+                    writer.write(frame.time);
+                    writer.write(frame.position);
+                    writer.write(frame.target);
+                    writer.write(frame.up);
+                }
+
+                // Unlike the JSON format, objects of unknown type are skipped instead of being written without a type
+                std::vector<std::pair<SceneBinary::PathObjectType, std::string>> objects;
+                for (uint32_t i = 0; i < pPath->getAttachedObjectCount(); i++)
+                {
+                    const auto& pMovable = pPath->getAttachedObject(i);
+                    if (const auto& pModelInstance = std::dynamic_pointer_cast<Scene::ModelInstance>(pMovable))
+                    {
+                        objects.emplace_back(SceneBinary::PathObjectType::ModelInstance, pModelInstance->getName());
+                    }
+                    else if (const auto& pCamera = std::dynamic_pointer_cast<Camera>(pMovable))
+                    {
+                        objects.emplace_back(SceneBinary::PathObjectType::Camera, pCamera->getName());
+                    }
+                    else if (const auto& pLight = std::dynamic_pointer_cast<Light>(pMovable))
+                    {
+                        objects.emplace_back(SceneBinary::PathObjectType::Light, pLight->getName());
+                    }
+                }
+
+                writer.write((uint32_t)objects.size());
+                for (const auto& object : objects)
+                {
+                    writer.write(object.first);
+                    writer.writeString(object.second);
+                }
+            }
+            writer.endSection(SceneBinary::Section::Paths);
+        }
+
+        return writer.saveToFile(mFilename);
+    }
 }
@@ -53,6 +53,12 @@ namespace Falcor
             ExportAll = 0xFFFFFFFF
         };
 
+        /** Save a scene. Files with a .fscenebin extension are written as a binary snapshot, which loads much faster than the JSON .fscene format.
+            \param[in] filename Output filename
+            \param[in] pScene The scene to save
+            \param[in] exportOptions Combination of the Export* flags
+            \return true on success, otherwise false
+        */
         static bool saveScene(const std::string& filename, const Scene::SharedPtr& pScene, uint32_t exportOptions = ExportAll);
 
         static const uint32_t kVersion = 2;
@@ -63,6 +69,7 @@ namespace Falcor
             : mpScene(pScene), mFilename(filename) {}
 
         bool save(uint32_t exportOptions);
+        bool saveBinary(uint32_t exportOptions);
 
         void writeModels();
         void writeLights();
@@ -30,9 +30,13 @@
 #include "rapidjson/error/en.h"
 #include "Scene.h"
 #include "Utils/Platform/OS.h"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/StringUtils.h"
+#include "SceneExporter.h"
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <cstring>
 #include "Graphics/TextureHelper.h"
 #include "API/Device.h"
 #include "Data/HostDeviceSharedMacros.h"
@@ -1004,6 +1008,11 @@ namespace Falcor
 
         if (findFileInDataDirectories(filename, fullpath))
         {
+            if (hasSuffix(fullpath, SceneBinary::kFileExtension, false))
+            {
+                return loadBinary(fullpath);
+            }
+
             // Load the file
             std::string jsonData = readFile(fullpath);
             rapidjson::StringStream JStream(jsonData.c_str());
@@ -1387,4 +1396,358 @@ namespace Falcor
 
         return true;
     }
-}
\ No newline at end of file
+
+    /** Reads values from a binary scene snapshot held in memory. Reading past the end of the data sets the fail flag and returns zeroed values.
+    */
+    class SceneBinaryReader
+    {
+    public:
+        SceneBinaryReader(const std::vector<uint8_t>& data) : mData(data) {}
+
+        template<typename T>
+        T read()
+        {
+            T val = {};
+            read(&val, sizeof(T));
+            return val;
+        }
+
+        void read(void* pDst, size_t size)
+        {
+            if (size > mData.size() - mOffset)
+            {
+                mFailed = true;
+                return;
+            }
+            std::memcpy(pDst, mData.data() + mOffset, size);
+            mOffset += size;
+        }
+
+        std::string readString()
+        {
+            uint32_t length = read<uint32_t>();
+            if (length > mData.size() - mOffset)
+            {
+                mFailed = true;
+                return {};
+            }
+            std::string str((const char*)mData.data() + mOffset, length);
+            mOffset += length;
+            return str;
+        }
+
+        template<typename T>
+        void readArray(std::vector<T>& vec, uint32_t count)
+        {
+            if ((uint64_t)count * sizeof(T) > mData.size() - mOffset)
+            {
+                mFailed = true;
+                return;
+            }
+            vec.resize(count);
+            read(vec.data(), count * sizeof(T));
+        }
+
+        void skip(size_t size) { mOffset = std::min(mOffset + size, mData.size()); }
+        size_t getOffset() const { return mOffset; }
+        bool failed() const { return mFailed; }
+
+    private:
+        const std::vector<uint8_t>& mData;
+        size_t mOffset = 0;
+        bool mFailed = false;
+    };
+
+    bool SceneImporter::loadBinary(const std::string& fullpath)
+    {
+        std::vector<uint8_t> data;
+        {
+            BinaryFileStream stream(fullpath, BinaryFileStream::Mode::Read);
+            data.resize(stream.getRemainingStreamSize());
+            stream.read(data.data(), data.size());
+            if (stream.isFail())
+            {
+                return error("Can't read file.");
+            }
+        }
+
+        SceneBinaryReader reader(data);
+        if (reader.read<uint32_t>() != SceneBinary::kMagic)
+        {
+            return error("Not a binary scene file.");
+        }
+        uint32_t version = reader.read<uint32_t>();
+        if (version != SceneBinary::kVersion)
+        {
+            return error("Unsupported binary scene version " + std::to_string(version) + ". Expected version " + std::to_string(SceneBinary::kVersion) + ".");
+        }
+
+        auto last = fullpath.find_last_of("/\\");
+        mDirectory = fullpath.substr(0, last);
+        mScene.setVersion(SceneExporter::kVersion);
+
+        std::string activeCamera;
+        std::vector<glm::vec3> translations, rotations, scalings;
+        std::vector<std::string> names;
+
+        while (true)
+        {
+            SceneBinary::Section section = reader.read<SceneBinary::Section>();
+            uint64_t sectionSize = reader.read<uint64_t>();
+            if (reader.failed())
+            {
+                return error("Unexpected end of file.");
+            }
+            if (section == SceneBinary::Section::End)
+            {
+                break;
+            }
+            const size_t sectionEnd = reader.getOffset() + (size_t)sectionSize;
+
+            switch (section)
+            {
+            case SceneBinary::Section::GlobalSettings:
+            {
+                mScene.setSceneUnit(reader.read<float>());
+                mScene.setCameraSpeed(reader.read<float>());
+                mScene.setLightingScale(reader.read<float>());
+                activeCamera = reader.readString();
+
+                std::string envMap = reader.readString();
+                if (envMap.size())
+                {
+                    std::string filename = mDirectory + '/' + envMap;
+                    if (doesFileExist(filename) == false && findFileInDataDirectories(envMap, filename) == false)
+                    {
+                        return error("Can't find environment map file " + envMap);
+                    }
+                    mScene.setEnvironmentMap(createTextureFromFile(filename, false, true));
+                }
+                break;
+            }
+            case SceneBinary::Section::Models:
+            {
+                uint32_t modelCount = reader.read<uint32_t>();
+                for (uint32_t modelID = 0; modelID < modelCount && reader.failed() == false; modelID++)
+                {
+                    std::string modelFile = reader.readString();
+                    std::string name = reader.readString();
+                    uint32_t shadingModel = reader.read<uint32_t>();
+                    uint32_t activeAnimation = reader.read<uint32_t>();
+                    uint32_t instanceCount = reader.read<uint32_t>();
+                    reader.readArray(translations, instanceCount);
+                    reader.readArray(rotations, instanceCount);
+                    reader.readArray(scalings, instanceCount);
+                    names.resize(reader.failed() ? 0 : instanceCount);
+                    for (auto& instanceName : names)
+                    {
+                        instanceName = reader.readString();
+                    }
+                    if (reader.failed()) break;
+
+                    std::string file = mDirectory + '/' + modelFile;
+                    if (doesFileExist(file) == false)
+                    {
+                        file = modelFile;
+                    }
+
+                    Model::LoadFlags modelFlags = mModelLoadFlags;
+                    if (shadingModel == ShadingModelSpecGloss) modelFlags |= Model::LoadFlags::UseSpecGlossMaterials;
+                    else if (shadingModel == ShadingModelMetalRough) modelFlags |= Model::LoadFlags::UseMetalRoughMaterials;
+
+                    auto pModel = Model::createFromFile(file.c_str(), modelFlags);
+                    if (pModel == nullptr)
+                    {
+                        return error("Could not load model: " + file);
+                    }
+                    pModel->setName(name);
+                    if (activeAnimation != SceneBinary::kNoActiveAnimation && activeAnimation < pModel->getAnimationsCount())
+                    {
+                        pModel->setActiveAnimation(activeAnimation);
+                    }
+
+                    if (instanceCount == 0)
+                    {
+                        mScene.addModelInstance(pModel, "Instance 0");
+                    }
+                    else
+                    {
+                        mScene.addModelInstances(pModel, instanceCount, translations.data(), rotations.data(), scalings.data(), names.data());
+                    }
+                }
+                break;
+            }
+            case SceneBinary::Section::Lights:
+            {
+                uint32_t lightCount = reader.read<uint32_t>();
+                for (uint32_t i = 0; i < lightCount && reader.failed() == false; i++)
+                {
+                    uint32_t type = reader.read<uint32_t>();
+                    std::string name = reader.readString();
+                    glm::vec3 intensity = reader.read<glm::vec3>();
+
+                    if (type == LightPoint)
+                    {
+                        auto pPointLight = PointLight::create();
+                        pPointLight->setName(name);
+                        pPointLight->setIntensity(intensity);
+                        pPointLight->setWorldPosition(reader.read<glm::vec3>());
+                        pPointLight->setWorldDirection(reader.read<glm::vec3>());
+                        pPointLight->setOpeningAngle(reader.read<float>());
+                        pPointLight->setPenumbraAngle(reader.read<float>());
+                        mLightMap[name] = pPointLight;
+                        mScene.addLight(pPointLight);
+                    }
+                    else if (type == LightDirectional)
+                    {
+                        auto pDirLight = DirectionalLight::create();
+                        pDirLight->setName(name);
+                        pDirLight->setIntensity(intensity);
+                        pDirLight->setWorldDirection(reader.read<glm::vec3>());
+                        mLightMap[name] = pDirLight;
+                        mScene.addLight(pDirLight);
+                    }
+                    else
+                    {
+                        return error("Invalid light type " + std::to_string(type) + ".");
+                    }
+                }
+                break;
+            }
+            case SceneBinary::Section::Cameras:
+            {
+                uint32_t cameraCount = reader.read<uint32_t>();
+                for (uint32_t i = 0; i < cameraCount && reader.failed() == false; i++)
+                {
+                    auto pCamera = Camera::create();
+                    pCamera->setName(reader.readString());
+                    pCamera->setPosition(reader.read<glm::vec3>());
+                    pCamera->setTarget(reader.read<glm::vec3>());
+                    pCamera->setUpVector(reader.read<glm::vec3>());
+                    pCamera->setFocalLength(reader.read<float>());
+                    float nearZ = reader.read<float>();
+                    float farZ = reader.read<float>();
+                    pCamera->setDepthRange(nearZ, farZ);
+                    pCamera->setAspectRatio(reader.read<float>());
+                    mCameraMap[pCamera->getName()] = pCamera;
+                    mScene.addCamera(pCamera);
+                }
+                mScene.setActiveCamera(0);
+                break;
+            }
+            case SceneBinary::Section::UserDefined:
+            {
+                uint32_t varCount = reader.read<uint32_t>();
+                for (uint32_t i = 0; i < varCount && reader.failed() == false; i++)
+                {
+                    std::string name = reader.readString();
+                    Scene::UserVariable var;
+                    var.type = reader.read<Scene::UserVariable::Type>();
+                    switch (var.type)
+                    {
+                    case Scene::UserVariable::Type::Int:
+                    case Scene::UserVariable::Type::Uint:
+                    case Scene::UserVariable::Type::Int64:
+                    case Scene::UserVariable::Type::Uint64:
+                    case Scene::UserVariable::Type::Double:
+                    case Scene::UserVariable::Type::Bool:
+                        var.u64 = reader.read<uint64_t>();
+                        break;
+                    case Scene::UserVariable::Type::String:
+                        var.str = reader.readString();
+                        break;
+                    case Scene::UserVariable::Type::Vec2:
+                        var.vec2 = reader.read<glm::vec2>();
+                        break;
+                    case Scene::UserVariable::Type::Vec3:
+                        var.vec3 = reader.read<glm::vec3>();
+                        break;
+                    case Scene::UserVariable::Type::Vec4:
+                        var.vec4 = reader.read<glm::vec4>();
+                        break;
+                    case Scene::UserVariable::Type::Vector:
+                        reader.readArray(var.vector, reader.read<uint32_t>());
+                        break;
+                    default:
+                        return error("Invalid type found for user variable \"" + name + "\".");
+                    }
+                    mScene.addUserVariable(name, var);
+                }
+                break;
+            }
+            case SceneBinary::Section::Paths:
+            {
+                // Only paths reference instances by name, so don't pay for the map unless there are paths
+                for (uint32_t modelID = 0; modelID < mScene.getModelCount(); modelID++)
+                {
+                    for (uint32_t i = 0; i < mScene.getModelInstanceCount(modelID); i++)
+                    {
+                        const auto& pInstance = mScene.getModelInstance(modelID, i);
+                        mInstanceMap[pInstance->getName()] = pInstance;
+                    }
+                }
+
+                uint32_t pathCount = reader.read<uint32_t>();
+                for (uint32_t pathID = 0; pathID < pathCount && reader.failed() == false; pathID++)
+                {
+                    auto pPath = ObjectPath::create();
+                    pPath->setName(reader.readString());
+                    pPath->setAnimationRepeat(reader.read<uint32_t>() != 0);
+
+                    uint32_t frameCount = reader.read<uint32_t>();
+                    for (uint32_t frameID = 0; frameID < frameCount && reader.failed() == false; frameID++)
+                    {
+                        float time = reader.read<float>();
+                        glm::vec3 pos = reader.read<glm::vec3>();
+                        glm::vec3 target = reader.read<glm::vec3>();
+                        glm::vec3 up = reader.read<glm::vec3>();
+                        pPath->addKeyFrame(time, pos, target, up);
+                    }
+
+                    uint32_t objectCount = reader.read<uint32_t>();
+                    for (uint32_t i = 0; i < objectCount && reader.failed() == false; i++)
+                    {
+                        SceneBinary::PathObjectType type = reader.read<SceneBinary::PathObjectType>();
+                        std::string name = reader.readString();
+                        const ObjectMap& objectMap = (type == SceneBinary::PathObjectType::ModelInstance) ? mInstanceMap : (type == SceneBinary::PathObjectType::Camera) ? mCameraMap : mLightMap;
+                        const auto& it = objectMap.find(name);
+                        if (it == objectMap.end())
+                        {
+                            return error("Can't find object \"" + name + "\" attached to path \"" + pPath->getName() + "\".");
+                        }
+                        pPath->attachObject(it->second);
+                    }
+                    mScene.addPath(pPath);
+                }
+                break;
+            }
+            default:
+                logWarning("Unknown section found in binary scene file '" + mFilename + "'. Ignoring section.");
+                reader.skip((size_t)sectionSize);
+                break;
+            }
+
+            if (reader.failed() || reader.getOffset() != sectionEnd)
+            {
+                return error("File is corrupted.");
+            }
+        }
+
+        // The active camera is stored with the global settings, which come before the cameras
+        for (uint32_t i = 0; i < mScene.getCameraCount(); i++)
+        {
+            if (activeCamera == mScene.getCamera(i)->getName())
+            {
+                mScene.setActiveCamera(i);
+                break;
+            }
+        }
+
+        if (is_set(mSceneLoadFlags, Scene::LoadFlags::GenerateAreaLights))
+        {
+            mScene.createAreaLights();
+        }
+
+        return true;
+    }
+}
@@ -64,6 +64,8 @@ namespace Falcor
 
         bool topLevelLoop();
 
+        bool loadBinary(const std::string& fullpath);
+
         bool loadIncludeFile(const std::string& Include);
 
         bool createModel(const rapidjson::Value& jsonModel);
@@ -122,18 +122,23 @@ namespace Falcor
                 currentData.pCamera->setIntoConstantBuffer(pCB, sCameraDataOffset);
             }
 
-            // Set lights
+            // Set lights. The array in the shader holds at most MAX_LIGHT_SOURCES lights. Programs that need more read them from a buffer, see LightClusters.
+            uint32_t lightCount = std::min(mpScene->getLightCount(), (uint32_t)MAX_LIGHT_SOURCES);
             if (sLightArrayOffset != ConstantBuffer::kInvalidOffset)
             {
-                assert(mpScene->getLightCount() <= MAX_LIGHT_SOURCES);  // Max array size in the shader
-                for (uint32_t i = 0; i < mpScene->getLightCount(); i++)
+                if (mpScene->getLightCount() > lightCount && mpScene->getLightCount() != mLightLimitWarningCount)
+                {
+                    logWarning("SceneRenderer - the scene has " + std::to_string(mpScene->getLightCount()) + " lights, but only the first " + std::to_string(lightCount) + " are set into the light array. Use LightClusters to shade with all of them.");
+                    mLightLimitWarningCount = mpScene->getLightCount();
+                }
+                for (uint32_t i = 0; i < lightCount; i++)
                 {
                     mpScene->getLight(i)->setIntoProgramVars(currentData.pVars, pCB, sLightArrayOffset + (i * Light::getShaderStructSize()));
                 }
             }
             if (sLightCountOffset != ConstantBuffer::kInvalidOffset)
             {
-                pCB->setVariable(sLightCountOffset, mpScene->getLightCount());
+                pCB->setVariable(sLightCountOffset, lightCount);
             }
             if (mpScene->getLightProbeCount() > 0)
             {
@@ -161,5 +161,6 @@ namespace Falcor
         const Material* mpLastMaterial = nullptr;
         bool mCullEnabled = true;
         bool mCompileMaterialWithProgram = true;
+        uint32_t mLightLimitWarningCount = 0;   // Light count the MAX_LIGHT_SOURCES warning was logged for
     };
 }
@@ -676,10 +676,12 @@ namespace Falcor
             format = linearToSrgbFormat(format);
         }
 
+        // Files which already contain a mip-chain (for example, the output of TextureBaker) are used as-is
+        uint32_t fileMipLevels = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
         uint32_t mipLevels;
-        if (generateMips == false || isCompressedFormat(format))
+        if (generateMips == false || isCompressedFormat(format) || fileMipLevels > 1)
         {
-            mipLevels = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
+            mipLevels = fileMipLevels;
         }
         else
         {
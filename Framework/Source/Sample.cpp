@@ -31,6 +31,7 @@
 #include <fstream>
 #include "API/Window.h"
 #include "Graphics/Program/Program.h"
+#include "Utils/FileWatcher.h"
 #include "Utils/Platform/OS.h"
 #include "API/FBO.h"
 #include "VR/OpenVR/VRSystem.h"
@@ -300,6 +301,7 @@ namespace Falcor
         mpRenderer->onShutdown(this);
         if (gpDevice) gpDevice->flushAndSync();
         mpRenderer = nullptr;
+        logDataDirectoryCacheStats();
         Logger::shutdown();
     }
 
@@ -470,6 +472,9 @@ namespace Falcor
         }
 
         mFrameRate.newFrame();
+
+        // Deliver file change notifications before rendering, so that modified shaders and assets are used in this frame
+        FileWatcher::dispatchEvents();
         {
             PROFILE("onFrameRender");
             calculateTime();
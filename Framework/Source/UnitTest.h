@@ -121,6 +121,11 @@ namespace Falcor
          */
         ComputeVars& vars() { return *mpVars; }
 
+        /** getRenderContext returns the render context the test runs on, for
+            tests that drive framework classes instead of a test program.
+         */
+        RenderContext* getRenderContext() { return mpContext; }
+
         /** operator[] returns the |ConstantBuffer| with the given name (or
             nullptr if no such constant buffer exists).
          */
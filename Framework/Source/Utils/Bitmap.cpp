@@ -33,12 +33,15 @@
 #include <cstring>
 #include "StringUtils.h"
 #include "API/Texture.h"
+#include "Utils/PixelConversion.h"
 
 namespace Falcor
 {
 #ifdef FALCOR_VK
     static bool isRGB32fSupported() 
     { 
+        // Offline tools load images without creating a device
+        if (gpDevice == nullptr) return false;
         VkFormatProperties p;
         vkGetPhysicalDeviceFormatProperties(gpDevice->getApiHandle(), VK_FORMAT_R32G32B32_SFLOAT, &p);
         return p.optimalTilingFeatures != 0;
@@ -291,20 +294,16 @@ namespace Falcor
         FIBITMAP* pImage = nullptr;
         uint32_t bytesPerPixel = getFormatBytesPerBlock(resourceFormat);
 
-        //TODO replace this code for swapping channels. Can't use freeimage masks b/c they only care about 16 bpp images
-        //issue #74 in gitlab
+        // FreeImage expects BGRA. Can't use freeimage masks b/c they only care about 16 bpp images
         if (resourceFormat == ResourceFormat::RGBA8Unorm || resourceFormat == ResourceFormat::RGBA8Snorm || resourceFormat == ResourceFormat::RGBA8UnormSrgb)
         {
-            for (uint32_t a = 0; a < width*height; a++)
+            if (is_set(exportFlags, ExportFlags::ExportAlpha))
             {
-                uint32_t* pPixel = (uint32_t*)pData;
-                pPixel += a;
-                uint8_t* ch = (uint8_t*)pPixel;
-                std::swap(ch[0], ch[2]);
-                if (is_set(exportFlags, ExportFlags::ExportAlpha) == false)
-                {
-                    ch[3] = 0xff;
-                }
+                PixelConversion::convertPixels<PixelConversion::Layout::RGBA8, PixelConversion::Layout::BGRA8>(pData, pData, width * height);
+            }
+            else
+            {
+                PixelConversion::convertPixels<PixelConversion::Layout::RGBA8, PixelConversion::Layout::BGRX8>(pData, pData, width * height);
             }
         }
 
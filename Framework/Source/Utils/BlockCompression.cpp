@@ -0,0 +1,627 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BlockCompression.h"
+#include "Utils/ThreadPool.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace Falcor
+{
+    namespace BlockCompression
+    {
+        namespace
+        {
+            // Interpolation weights of the 4-bit BC7 index palette, in 1/64ths
+            const uint32_t kBC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+            // Weights used to interpolate BC1 palette entries, in the order they are referenced by the 2-bit indices
+            const float kBC1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+            uint8_t clampToByte(float v)
+            {
+                return (uint8_t)clamp(int32_t(v + 0.5f), 0, 255);
+            }
+
+            /** Find the principal axis of a set of points using power iteration on the covariance matrix.
+                Returns the mean of the points in pMean and the normalized axis in pAxis.
+            */
+            template<uint32_t dims>
+            void findPrincipalAxis(const uint8_t texels[64], float* pMean, float* pAxis)
+            {
+                for (uint32_t c = 0; c < dims; c++)
+                {
+                    pMean[c] = 0;
+                    for (uint32_t i = 0; i < 16; i++) pMean[c] += texels[i * 4 + c];
+                    pMean[c] /= 16.0f;
+                }
+
+                float cov[dims][dims] = {};
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    float d[dims];
+                    for (uint32_t c = 0; c < dims; c++) d[c] = texels[i * 4 + c] - pMean[c];
+                    for (uint32_t r = 0; r < dims; r++)
+                    {
+                        for (uint32_t c = 0; c < dims; c++) cov[r][c] += d[r] * d[c];
+                    }
+                }
+
+                // Start from the bounding-box diagonal, which is usually close to the principal axis
+                float axis[dims];
+                for (uint32_t c = 0; c < dims; c++)
+                {
+                    uint8_t mn = 255, mx = 0;
+                    for (uint32_t i = 0; i < 16; i++)
+                    {
+                        mn = std::min(mn, texels[i * 4 + c]);
+                        mx = std::max(mx, texels[i * 4 + c]);
+                    }
+                    axis[c] = float(mx - mn);
+                }
+
+                for (uint32_t iter = 0; iter < 8; iter++)
+                {
+                    float next[dims] = {};
+                    for (uint32_t r = 0; r < dims; r++)
+                    {
+                        for (uint32_t c = 0; c < dims; c++) next[r] += cov[r][c] * axis[c];
+                    }
+                    float len = 0;
+                    for (uint32_t c = 0; c < dims; c++) len = std::max(len, std::abs(next[c]));
+                    if (len < 1e-6f) break;
+                    for (uint32_t c = 0; c < dims; c++) axis[c] = next[c] / len;
+                }
+
+                float len = 0;
+                for (uint32_t c = 0; c < dims; c++) len += axis[c] * axis[c];
+                len = std::sqrt(len);
+                for (uint32_t c = 0; c < dims; c++) pAxis[c] = (len > 0) ? axis[c] / len : 0.0f;
+            }
+
+            /** Project the block onto the principal axis and return the extreme points
+            */
+            template<uint32_t dims>
+            void findEndpoints(const uint8_t texels[64], float* pE0, float* pE1)
+            {
+                float mean[dims], axis[dims];
+                findPrincipalAxis<dims>(texels, mean, axis);
+
+                float tMin = 0, tMax = 0;
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    float t = 0;
+                    for (uint32_t c = 0; c < dims; c++) t += (texels[i * 4 + c] - mean[c]) * axis[c];
+                    tMin = std::min(tMin, t);
+                    tMax = std::max(tMax, t);
+                }
+
+                for (uint32_t c = 0; c < dims; c++)
+                {
+                    pE0[c] = clamp(mean[c] + axis[c] * tMax, 0.0f, 255.0f);
+                    pE1[c] = clamp(mean[c] + axis[c] * tMin, 0.0f, 255.0f);
+                }
+            }
+
+            uint16_t packRgb565(const float c[3])
+            {
+                uint32_t r = clamp(int32_t(c[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+                uint32_t g = clamp(int32_t(c[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+                uint32_t b = clamp(int32_t(c[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+                return uint16_t((r << 11) | (g << 5) | b);
+            }
+
+            void unpackRgb565(uint16_t v, float c[3])
+            {
+                uint32_t r = (v >> 11) & 31;
+                uint32_t g = (v >> 5) & 63;
+                uint32_t b = v & 31;
+                c[0] = float((r << 3) | (r >> 2));
+                c[1] = float((g << 2) | (g >> 4));
+                c[2] = float((b << 3) | (b >> 2));
+            }
+
+            /** Pick the closest BC1 palette entry for every texel. Returns the total squared error.
+            */
+            float selectBC1Indices(const uint8_t texels[64], uint16_t c0, uint16_t c1, uint32_t indices[16])
+            {
+                float e0[3], e1[3];
+                unpackRgb565(c0, e0);
+                unpackRgb565(c1, e1);
+
+                float palette[4][3];
+                for (uint32_t p = 0; p < 4; p++)
+                {
+                    for (uint32_t c = 0; c < 3; c++) palette[p][c] = e0[c] * (1 - kBC1Weights[p]) + e1[c] * kBC1Weights[p];
+                }
+
+                float totalError = 0;
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    float bestError = FLT_MAX;
+                    for (uint32_t p = 0; p < 4; p++)
+                    {
+                        float error = 0;
+                        for (uint32_t c = 0; c < 3; c++)
+                        {
+                            float d = texels[i * 4 + c] - palette[p][c];
+                            error += d * d;
+                        }
+                        if (error < bestError)
+                        {
+                            bestError = error;
+                            indices[i] = p;
+                        }
+                    }
+                    totalError += bestError;
+                }
+                return totalError;
+            }
+
+            /** Solve for the endpoints which minimize the squared error for a fixed set of indices
+            */
+            bool refineBC1Endpoints(const uint8_t texels[64], const uint32_t indices[16], float e0[3], float e1[3])
+            {
+                float aa = 0, ab = 0, bb = 0;
+                float ax[3] = {}, bx[3] = {};
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    float b = kBC1Weights[indices[i]];
+                    float a = 1 - b;
+                    aa += a * a;
+                    ab += a * b;
+                    bb += b * b;
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        ax[c] += a * texels[i * 4 + c];
+                        bx[c] += b * texels[i * 4 + c];
+                    }
+                }
+
+                float det = aa * bb - ab * ab;
+                if (std::abs(det) < 1e-6f) return false;
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    e0[c] = clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+                    e1[c] = clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+                }
+                return true;
+            }
+
+            void writeBC1Block(uint16_t c0, uint16_t c1, uint32_t indices[16], uint8_t* pBlock)
+            {
+                // Make sure the decoder uses the 4-color palette
+                if (c0 < c1)
+                {
+                    std::swap(c0, c1);
+                    for (uint32_t i = 0; i < 16; i++) indices[i] ^= 1;
+                }
+                else if (c0 == c1)
+                {
+                    for (uint32_t i = 0; i < 16; i++) indices[i] = 0;
+                }
+
+                uint32_t bits = 0;
+                for (uint32_t i = 0; i < 16; i++) bits |= indices[i] << (i * 2);
+
+                std::memcpy(pBlock, &c0, 2);
+                std::memcpy(pBlock + 2, &c1, 2);
+                std::memcpy(pBlock + 4, &bits, 4);
+            }
+
+            /** LSB-first bit writer/reader for BC7 blocks
+            */
+            struct BitStream
+            {
+                uint8_t* pData;
+                uint32_t pos;
+            };
+
+            void writeBits(BitStream& stream, uint32_t value, uint32_t count)
+            {
+                for (uint32_t i = 0; i < count; i++, stream.pos++)
+                {
+                    if ((value >> i) & 1) stream.pData[stream.pos / 8] |= uint8_t(1 << (stream.pos % 8));
+                }
+            }
+
+            uint32_t readBits(const uint8_t* pData, uint32_t& pos, uint32_t count)
+            {
+                uint32_t value = 0;
+                for (uint32_t i = 0; i < count; i++, pos++)
+                {
+                    value |= uint32_t((pData[pos / 8] >> (pos % 8)) & 1) << i;
+                }
+                return value;
+            }
+
+            /** Quantize a BC7 mode 6 endpoint to 7 bits per channel plus a shared p-bit
+            */
+            void quantizeBC7Endpoint(const float e[4], uint32_t q[4], uint32_t& pBit)
+            {
+                float bestError = FLT_MAX;
+                for (uint32_t p = 0; p < 2; p++)
+                {
+                    uint32_t candidate[4];
+                    float error = 0;
+                    for (uint32_t c = 0; c < 4; c++)
+                    {
+                        candidate[c] = clamp(int32_t((e[c] - p) * 0.5f + 0.5f), 0, 127);
+                        float d = float((candidate[c] << 1) | p) - e[c];
+                        error += d * d;
+                    }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        pBit = p;
+                        std::memcpy(q, candidate, sizeof(candidate));
+                    }
+                }
+            }
+
+            void decodeBC1(const uint8_t* pBlock, uint8_t texels[64], bool forceFourColors)
+            {
+                uint16_t c0, c1;
+                uint32_t bits;
+                std::memcpy(&c0, pBlock, 2);
+                std::memcpy(&c1, pBlock + 2, 2);
+                std::memcpy(&bits, pBlock + 4, 4);
+
+                float e0[3], e1[3];
+                unpackRgb565(c0, e0);
+                unpackRgb565(c1, e1);
+
+                uint8_t palette[4][4];
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    palette[0][c] = uint8_t(e0[c]);
+                    palette[1][c] = uint8_t(e1[c]);
+                    if (c0 > c1 || forceFourColors)
+                    {
+                        palette[2][c] = uint8_t((2 * uint32_t(e0[c]) + uint32_t(e1[c])) / 3);
+                        palette[3][c] = uint8_t((uint32_t(e0[c]) + 2 * uint32_t(e1[c])) / 3);
+                    }
+                    else
+                    {
+                        palette[2][c] = uint8_t((uint32_t(e0[c]) + uint32_t(e1[c])) / 2);
+                        palette[3][c] = 0;
+                    }
+                }
+                for (uint32_t p = 0; p < 4; p++) palette[p][3] = 255;
+                if (c0 <= c1 && forceFourColors == false) palette[3][3] = 0;
+
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    std::memcpy(texels + i * 4, palette[(bits >> (i * 2)) & 3], 4);
+                }
+            }
+
+            void decodeBC4(const uint8_t* pBlock, uint32_t channel, uint8_t texels[64])
+            {
+                uint32_t a0 = pBlock[0];
+                uint32_t a1 = pBlock[1];
+                uint32_t palette[8] = { a0, a1 };
+                for (uint32_t p = 2; p < 8; p++)
+                {
+                    palette[p] = (a0 > a1) ? ((8 - p) * a0 + (p - 1) * a1) / 7 : ((6 - p) * a0 + (p - 1) * a1) / 5;
+                }
+                if (a0 <= a1)
+                {
+                    palette[6] = 0;
+                    palette[7] = 255;
+                }
+
+                uint64_t bits = 0;
+                std::memcpy(&bits, pBlock + 2, 6);
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    texels[i * 4 + channel] = uint8_t(palette[(bits >> (i * 3)) & 7]);
+                }
+            }
+
+            bool decodeBC7(const uint8_t* pBlock, uint8_t texels[64])
+            {
+                // Only mode 6 is supported
+                if ((pBlock[0] & 0x7f) != 0x40) return false;
+
+                uint32_t pos = 7;
+                uint32_t e[2][4];
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    e[0][c] = readBits(pBlock, pos, 7);
+                    e[1][c] = readBits(pBlock, pos, 7);
+                }
+                uint32_t p0 = readBits(pBlock, pos, 1);
+                uint32_t p1 = readBits(pBlock, pos, 1);
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    e[0][c] = (e[0][c] << 1) | p0;
+                    e[1][c] = (e[1][c] << 1) | p1;
+                }
+
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    uint32_t w = kBC7Weights4[readBits(pBlock, pos, (i == 0) ? 3 : 4)];
+                    for (uint32_t c = 0; c < 4; c++)
+                    {
+                        texels[i * 4 + c] = uint8_t(((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6);
+                    }
+                }
+                return true;
+            }
+
+            uint32_t getBlockSize(ResourceFormat format)
+            {
+                switch (format)
+                {
+                case ResourceFormat::BC1Unorm:
+                case ResourceFormat::BC1UnormSrgb:
+                case ResourceFormat::BC4Unorm:
+                    return 8;
+                case ResourceFormat::BC3Unorm:
+                case ResourceFormat::BC3UnormSrgb:
+                case ResourceFormat::BC5Unorm:
+                case ResourceFormat::BC7Unorm:
+                case ResourceFormat::BC7UnormSrgb:
+                    return 16;
+                default:
+                    return 0;
+                }
+            }
+        }
+
+        void encodeBC1(const uint8_t texels[64], uint8_t* pBlock)
+        {
+            float e0[3], e1[3];
+            findEndpoints<3>(texels, e0, e1);
+
+            uint16_t c0 = packRgb565(e0);
+            uint16_t c1 = packRgb565(e1);
+            uint32_t indices[16];
+            float error = selectBC1Indices(texels, c0, c1, indices);
+
+            // One round of least-squares refinement usually recovers the error introduced by the 565 quantization
+            if (error > 0 && refineBC1Endpoints(texels, indices, e0, e1))
+            {
+                uint16_t r0 = packRgb565(e0);
+                uint16_t r1 = packRgb565(e1);
+                uint32_t refined[16];
+                if (selectBC1Indices(texels, r0, r1, refined) < error)
+                {
+                    c0 = r0;
+                    c1 = r1;
+                    std::memcpy(indices, refined, sizeof(indices));
+                }
+            }
+
+            writeBC1Block(c0, c1, indices, pBlock);
+        }
+
+        void encodeBC4(const uint8_t texels[64], uint32_t channel, uint8_t* pBlock)
+        {
+            uint32_t a0 = 0, a1 = 255;
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                a0 = std::max(a0, uint32_t(texels[i * 4 + channel]));
+                a1 = std::min(a1, uint32_t(texels[i * 4 + channel]));
+            }
+
+            uint64_t bits = 0;
+            if (a0 != a1)
+            {
+                // a0 > a1 selects the 8-value palette
+                uint32_t palette[8] = { a0, a1 };
+                for (uint32_t p = 2; p < 8; p++) palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    int32_t v = texels[i * 4 + channel];
+                    uint32_t best = 0;
+                    for (uint32_t p = 1; p < 8; p++)
+                    {
+                        if (std::abs(v - int32_t(palette[p])) < std::abs(v - int32_t(palette[best]))) best = p;
+                    }
+                    bits |= uint64_t(best) << (i * 3);
+                }
+            }
+
+            pBlock[0] = uint8_t(a0);
+            pBlock[1] = uint8_t(a1);
+            std::memcpy(pBlock + 2, &bits, 6);
+        }
+
+        void encodeBC3(const uint8_t texels[64], uint8_t* pBlock)
+        {
+            encodeBC4(texels, 3, pBlock);
+            encodeBC1(texels, pBlock + 8);
+        }
+
+        void encodeBC5(const uint8_t texels[64], uint8_t* pBlock)
+        {
+            encodeBC4(texels, 0, pBlock);
+            encodeBC4(texels, 1, pBlock + 8);
+        }
+
+        void encodeBC7(const uint8_t texels[64], uint8_t* pBlock)
+        {
+            float e[2][4];
+            findEndpoints<4>(texels, e[0], e[1]);
+
+            uint32_t q[2][4];
+            uint32_t pBits[2];
+            quantizeBC7Endpoint(e[0], q[0], pBits[0]);
+            quantizeBC7Endpoint(e[1], q[1], pBits[1]);
+
+            uint32_t endpoints[2][4];
+            for (uint32_t j = 0; j < 2; j++)
+            {
+                for (uint32_t c = 0; c < 4; c++) endpoints[j][c] = (q[j][c] << 1) | pBits[j];
+            }
+
+            uint32_t indices[16];
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                uint32_t bestError = UINT32_MAX;
+                for (uint32_t p = 0; p < 16; p++)
+                {
+                    uint32_t w = kBC7Weights4[p];
+                    uint32_t error = 0;
+                    for (uint32_t c = 0; c < 4; c++)
+                    {
+                        int32_t v = int32_t(((64 - w) * endpoints[0][c] + w * endpoints[1][c] + 32) >> 6);
+                        int32_t d = v - int32_t(texels[i * 4 + c]);
+                        error += uint32_t(d * d);
+                    }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        indices[i] = p;
+                    }
+                }
+            }
+
+            // The MSB of the first index is implicitly 0
+            if (indices[0] & 8)
+            {
+                std::swap(q[0], q[1]);
+                std::swap(pBits[0], pBits[1]);
+                for (uint32_t i = 0; i < 16; i++) indices[i] = 15 - indices[i];
+            }
+
+            std::memset(pBlock, 0, 16);
+            BitStream stream = { pBlock, 0 };
+            writeBits(stream, 1 << 6, 7);
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                writeBits(stream, q[0][c], 7);
+                writeBits(stream, q[1][c], 7);
+            }
+            writeBits(stream, pBits[0], 1);
+            writeBits(stream, pBits[1], 1);
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                writeBits(stream, indices[i], (i == 0) ? 3 : 4);
+            }
+            assert(stream.pos == 128);
+        }
+
+        bool decodeBlock(ResourceFormat format, const uint8_t* pBlock, uint8_t texels[64])
+        {
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                texels[i * 4 + 0] = texels[i * 4 + 1] = texels[i * 4 + 2] = 0;
+                texels[i * 4 + 3] = 255;
+            }
+
+            switch (format)
+            {
+            case ResourceFormat::BC1Unorm:
+            case ResourceFormat::BC1UnormSrgb:
+                decodeBC1(pBlock, texels, false);
+                return true;
+            case ResourceFormat::BC3Unorm:
+            case ResourceFormat::BC3UnormSrgb:
+                decodeBC1(pBlock + 8, texels, true);
+                decodeBC4(pBlock, 3, texels);
+                return true;
+            case ResourceFormat::BC4Unorm:
+                decodeBC4(pBlock, 0, texels);
+                return true;
+            case ResourceFormat::BC5Unorm:
+                decodeBC4(pBlock, 0, texels);
+                decodeBC4(pBlock + 8, 1, texels);
+                return true;
+            case ResourceFormat::BC7Unorm:
+            case ResourceFormat::BC7UnormSrgb:
+                return decodeBC7(pBlock, texels);
+            default:
+                return false;
+            }
+        }
+
+        std::vector<uint8_t> compressImage(ResourceFormat format, uint32_t width, uint32_t height, const uint8_t* pTexels, uint32_t threadCount)
+        {
+            uint32_t blockSize = getBlockSize(format);
+            if (blockSize == 0)
+            {
+                logError("BlockCompression::compressImage() - unsupported format " + to_string(format));
+                return {};
+            }
+
+            uint32_t blocksX = std::max(1u, (width + 3) / 4);
+            uint32_t blocksY = std::max(1u, (height + 3) / 4);
+            std::vector<uint8_t> blocks(blocksX * blocksY * blockSize);
+
+            parallelFor(blocksY, threadCount, [&](uint32_t by)
+            {
+                uint8_t texels[64];
+                for (uint32_t bx = 0; bx < blocksX; bx++)
+                {
+                    // Gather the block, replicating the last row/column for partial blocks
+                    for (uint32_t y = 0; y < 4; y++)
+                    {
+                        uint32_t srcY = std::min(by * 4 + y, height - 1);
+                        for (uint32_t x = 0; x < 4; x++)
+                        {
+                            uint32_t srcX = std::min(bx * 4 + x, width - 1);
+                            std::memcpy(texels + (y * 4 + x) * 4, pTexels + (srcY * width + srcX) * 4, 4);
+                        }
+                    }
+
+                    uint8_t* pBlock = blocks.data() + (by * blocksX + bx) * blockSize;
+                    switch (format)
+                    {
+                    case ResourceFormat::BC1Unorm:
+                    case ResourceFormat::BC1UnormSrgb:
+                        encodeBC1(texels, pBlock);
+                        break;
+                    case ResourceFormat::BC3Unorm:
+                    case ResourceFormat::BC3UnormSrgb:
+                        encodeBC3(texels, pBlock);
+                        break;
+                    case ResourceFormat::BC4Unorm:
+                        encodeBC4(texels, 0, pBlock);
+                        break;
+                    case ResourceFormat::BC5Unorm:
+                        encodeBC5(texels, pBlock);
+                        break;
+                    case ResourceFormat::BC7Unorm:
+                    case ResourceFormat::BC7UnormSrgb:
+                        encodeBC7(texels, pBlock);
+                        break;
+                    default:
+                        should_not_get_here();
+                    }
+                }
+            });
+
+            return blocks;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU encoders for the BCn block-compressed texture formats.
+        All block functions operate on a 4x4 block of RGBA8 texels stored in row-major order (64 bytes).
+        Encoding doesn't require a device, so it can be used by offline tools.
+    */
+    namespace BlockCompression
+    {
+        /** Encode the RGB channels of a block as BC1. Alpha is ignored.
+            \param[in] texels 16 RGBA8 texels
+            \param[out] pBlock 8 bytes of output
+        */
+        void encodeBC1(const uint8_t texels[64], uint8_t* pBlock);
+
+        /** Encode a block as BC3 (BC4 alpha followed by a BC1 color block).
+            \param[out] pBlock 16 bytes of output
+        */
+        void encodeBC3(const uint8_t texels[64], uint8_t* pBlock);
+
+        /** Encode a single channel of a block as BC4.
+            \param[in] channel Index of the channel to encode (0-3)
+            \param[out] pBlock 8 bytes of output
+        */
+        void encodeBC4(const uint8_t texels[64], uint32_t channel, uint8_t* pBlock);
+
+        /** Encode the red and green channels of a block as BC5.
+            \param[out] pBlock 16 bytes of output
+        */
+        void encodeBC5(const uint8_t texels[64], uint8_t* pBlock);
+
+        /** Encode a block as BC7. Only mode 6 (single subset, RGBA endpoints with 4-bit indices) is used.
+            \param[out] pBlock 16 bytes of output
+        */
+        void encodeBC7(const uint8_t texels[64], uint8_t* pBlock);
+
+        /** Decode a single block. Supports everything the encoders produce, BC7 is limited to mode 6 blocks.
+            \param[in] format One of the BC1/BC3/BC4/BC5/BC7 formats
+            \param[in] pBlock The compressed block
+            \param[out] texels 16 RGBA8 texels. Channels not stored in the format are set to 0, except alpha which is set to 255.
+            \return false if the format or the block isn't supported
+        */
+        bool decodeBlock(ResourceFormat format, const uint8_t* pBlock, uint8_t texels[64]);
+
+        /** Compress an RGBA8 image. Edge blocks of images which are not a multiple of 4 replicate the border texels.
+            \param[in] format The destination format. Must be one of BC1, BC3, BC4, BC5 or BC7 (sRGB variants are allowed).
+            \param[in] pTexels Tightly packed RGBA8 texels
+            \param[in] threadCount Number of worker threads. 0 will use all hardware threads.
+            \return The compressed blocks in row-major order, or an empty vector if the format isn't supported
+        */
+        std::vector<uint8_t> compressImage(ResourceFormat format, uint32_t width, uint32_t height, const uint8_t* pTexels, uint32_t threadCount = 0);
+    }
+}
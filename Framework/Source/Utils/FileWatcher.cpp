@@ -0,0 +1,150 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "FileWatcher.h"
+#include "Utils/Platform/OS.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Falcor
+{
+    namespace
+    {
+        struct Subscription
+        {
+            std::string path;
+            FileWatcher::Callback callback;
+        };
+
+        struct WatcherData
+        {
+            std::unordered_map<FileWatcher::SubscriptionId, Subscription> subscriptions;
+            std::unordered_map<std::string, std::vector<FileWatcher::SubscriptionId>> files;
+            FileWatcher::SubscriptionId nextId = FileWatcher::kInvalidSubscriptionId + 1;
+
+            // Written by the monitor thread, consumed by dispatchEvents()
+            std::mutex pendingMutex;
+            std::unordered_set<std::string> pendingFiles;
+            std::atomic<bool> hasPendingFiles{ false };
+        };
+
+        WatcherData& getData()
+        {
+            static WatcherData* pData = new WatcherData;
+            return *pData;
+        }
+
+        void onFileChanged(const std::string& path)
+        {
+            WatcherData& data = getData();
+            std::lock_guard<std::mutex> lock(data.pendingMutex);
+            data.pendingFiles.insert(path);
+            data.hasPendingFiles = true;
+        }
+    }
+
+    FileWatcher::SubscriptionId FileWatcher::subscribe(const std::string& filename, const Callback& callback)
+    {
+        std::string path;
+        if (findFileInDataDirectories(filename, path) == false)
+        {
+            logWarning("FileWatcher::subscribe() - can't find file '" + filename + "'");
+            return kInvalidSubscriptionId;
+        }
+
+        WatcherData& data = getData();
+        auto& subscribers = data.files[path];
+        if (subscribers.empty())
+        {
+            if (monitorFileUpdates(path, [path]() { onFileChanged(path); }) == false)
+            {
+                data.files.erase(path);
+                return kInvalidSubscriptionId;
+            }
+        }
+
+        SubscriptionId id = data.nextId++;
+        subscribers.push_back(id);
+        data.subscriptions[id] = { path, callback };
+        return id;
+    }
+
+    void FileWatcher::unsubscribe(SubscriptionId id)
+    {
+        WatcherData& data = getData();
+        auto it = data.subscriptions.find(id);
+        if (it == data.subscriptions.end()) return;
+
+        auto fileIt = data.files.find(it->second.path);
+        auto& subscribers = fileIt->second;
+        subscribers.erase(std::find(subscribers.begin(), subscribers.end(), id));
+        if (subscribers.empty())
+        {
+            closeSharedFile(fileIt->first);
+            data.files.erase(fileIt);
+        }
+        data.subscriptions.erase(it);
+    }
+
+    void FileWatcher::dispatchEvents()
+    {
+        WatcherData& data = getData();
+        if (data.hasPendingFiles == false) return;
+
+        std::unordered_set<std::string> changedFiles;
+        {
+            std::lock_guard<std::mutex> lock(data.pendingMutex);
+            changedFiles.swap(data.pendingFiles);
+            data.hasPendingFiles = false;
+        }
+
+        for (const auto& path : changedFiles)
+        {
+            auto fileIt = data.files.find(path);
+            if (fileIt == data.files.end()) continue;
+
+            // Callbacks can subscribe or unsubscribe, so iterate over a copy and skip subscriptions which were removed in the meantime
+            const std::vector<SubscriptionId> subscribers = fileIt->second;
+            for (SubscriptionId id : subscribers)
+            {
+                auto it = data.subscriptions.find(id);
+                if (it == data.subscriptions.end()) continue;
+                Callback callback = it->second.callback;
+                callback(path);
+            }
+        }
+    }
+
+    size_t FileWatcher::getWatchedFileCount()
+    {
+        return getData().files.size();
+    }
+}
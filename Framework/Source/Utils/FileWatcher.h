@@ -0,0 +1,73 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <functional>
+
+namespace Falcor
+{
+    /** Delivers file change notifications to subscribers.
+        Changes are detected by the OS file monitor (monitorFileUpdates()) on a background thread. They are queued and coalesced, and the
+        callbacks are called from dispatchEvents(), which the sample calls once per frame on the main thread. A file saved several times
+        between two frames results in a single callback.
+        All functions must be called from the main thread.
+    */
+    class FileWatcher
+    {
+    public:
+        using SubscriptionId = uint32_t;
+        static const SubscriptionId kInvalidSubscriptionId = 0;
+
+        /** Callback type. The argument is the full path of the file which changed.
+        */
+        using Callback = std::function<void(const std::string&)>;
+
+        /** Subscribe to changes of a file.
+            \param[in] filename The file to watch. Relative paths are searched for in the data directories.
+            \param[in] callback Function to call on the main thread when the file changed.
+            \return A subscription ID, or kInvalidSubscriptionId if the file can't be found or watched.
+        */
+        static SubscriptionId subscribe(const std::string& filename, const Callback& callback);
+
+        /** Remove a subscription. Once this returns, the callback will not be called again, even if a change is already queued.
+            Calling this with kInvalidSubscriptionId is a no-op.
+        */
+        static void unsubscribe(SubscriptionId id);
+
+        /** Call the callbacks of all files which changed since the last call. Must be called from the main thread.
+        */
+        static void dispatchEvents();
+
+        /** Get the number of files currently being watched
+        */
+        static size_t getWatchedFileCount();
+
+    private:
+        FileWatcher() = delete;
+    };
+}
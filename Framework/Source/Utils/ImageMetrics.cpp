@@ -0,0 +1,136 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ImageMetrics.h"
+#include <cmath>
+#include <limits>
+
+namespace Falcor
+{
+    namespace ImageMetrics
+    {
+        namespace
+        {
+            const uint32_t kSsimWindow = 8;
+            const uint32_t kSsimStride = 4;
+            const uint32_t kChannelCount = 3;
+
+            double calcWindowSsim(const uint8_t* pReference, const uint8_t* pTest, uint32_t width, uint32_t x0, uint32_t y0, uint32_t sizeX, uint32_t sizeY, uint32_t channel)
+            {
+                // Stabilizing constants for 8-bit values
+                const double c1 = (0.01 * 255) * (0.01 * 255);
+                const double c2 = (0.03 * 255) * (0.03 * 255);
+
+                double sumRef = 0, sumTest = 0, sumRefSq = 0, sumTestSq = 0, sumCross = 0;
+                for (uint32_t y = y0; y < y0 + sizeY; y++)
+                {
+                    for (uint32_t x = x0; x < x0 + sizeX; x++)
+                    {
+                        size_t i = (size_t(y) * width + x) * 4 + channel;
+                        double r = pReference[i];
+                        double t = pTest[i];
+                        sumRef += r;
+                        sumTest += t;
+                        sumRefSq += r * r;
+                        sumTestSq += t * t;
+                        sumCross += r * t;
+                    }
+                }
+
+                double n = double(sizeX) * sizeY;
+                double meanRef = sumRef / n;
+                double meanTest = sumTest / n;
+                double varRef = sumRefSq / n - meanRef * meanRef;
+                double varTest = sumTestSq / n - meanTest * meanTest;
+                double covariance = sumCross / n - meanRef * meanTest;
+                return ((2 * meanRef * meanTest + c1) * (2 * covariance + c2)) / ((meanRef * meanRef + meanTest * meanTest + c1) * (varRef + varTest + c2));
+            }
+        }
+
+        double calcPsnr(double mse)
+        {
+            if (mse == 0) return std::numeric_limits<double>::infinity();
+            return 10.0 * std::log10(255.0 * 255.0 / mse);
+        }
+
+        double calcSsim(const uint8_t* pReference, const uint8_t* pTest, uint32_t width, uint32_t height, uint32_t channel)
+        {
+            if (width < kSsimWindow || height < kSsimWindow)
+            {
+                return calcWindowSsim(pReference, pTest, width, 0, 0, width, height, channel);
+            }
+
+            double sum = 0;
+            uint32_t count = 0;
+            for (uint32_t y = 0; y + kSsimWindow <= height; y += kSsimStride)
+            {
+                for (uint32_t x = 0; x + kSsimWindow <= width; x += kSsimStride)
+                {
+                    sum += calcWindowSsim(pReference, pTest, width, x, y, kSsimWindow, kSsimWindow, channel);
+                    count++;
+                }
+            }
+            return sum / count;
+        }
+
+        Result compare(const uint8_t* pReference, const uint8_t* pTest, uint32_t width, uint32_t height)
+        {
+            Result result;
+            size_t pixelCount = size_t(width) * height;
+            if (pixelCount == 0) return result;
+
+            double sqErrorSum = 0;
+            size_t visibleErrors = 0;
+            for (size_t p = 0; p < pixelCount; p++)
+            {
+                uint32_t pixelError = 0;
+                for (uint32_t c = 0; c < kChannelCount; c++)
+                {
+                    int32_t diff = int32_t(pReference[p * 4 + c]) - int32_t(pTest[p * 4 + c]);
+                    uint32_t error = (uint32_t)std::abs(diff);
+                    sqErrorSum += double(diff) * diff;
+                    pixelError = std::max(pixelError, error);
+                }
+                result.maxError = std::max(result.maxError, pixelError);
+                if (pixelError > kVisibleError) visibleErrors++;
+            }
+
+            result.mse = sqErrorSum / double(pixelCount * kChannelCount);
+            result.psnr = calcPsnr(result.mse);
+            result.errorFraction = double(visibleErrors) / double(pixelCount);
+
+            result.ssim = 0;
+            for (uint32_t c = 0; c < kChannelCount; c++)
+            {
+                result.ssim += calcSsim(pReference, pTest, width, height, c);
+            }
+            result.ssim /= kChannelCount;
+            return result;
+        }
+    }
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+
+namespace Falcor
+{
+    /** Full-reference image quality metrics, used to compare an image rendered with a faster technique against a reference.
+        The images are tightly packed 8-bit images with 4 bytes per pixel. The fourth byte is ignored, and the channels are compared separately,
+        so RGBA and BGRA images can be compared as long as both images use the same layout.
+    */
+    namespace ImageMetrics
+    {
+        struct Result
+        {
+            double mse = 0;             ///< Mean squared error of the color channels
+            double psnr = 0;            ///< Peak signal-to-noise ratio in dB. Infinite for identical images.
+            double ssim = 1;            ///< Mean structural similarity of the color channels, 1 for identical images
+            uint32_t maxError = 0;      ///< Largest difference of a channel
+            double errorFraction = 0;   ///< Fraction of the pixels with a channel that differs by more than kVisibleError
+        };
+
+        /** Channel differences above this count as visible in Result::errorFraction
+        */
+        static const uint32_t kVisibleError = 8;
+
+        /** Compare two images
+            \param[in] pReference The reference image
+            \param[in] pTest The image to compare against the reference
+            \param[in] width Width of both images
+            \param[in] height Height of both images
+        */
+        Result compare(const uint8_t* pReference, const uint8_t* pTest, uint32_t width, uint32_t height);
+
+        /** Calculate the PSNR in dB of a mean squared error of 8-bit values
+        */
+        double calcPsnr(double mse);
+
+        /** Calculate the mean SSIM of one channel over 8x8 windows spaced 4 pixels apart.
+            Uses the constants of Wang et al. 2004 with box-filtered windows instead of a Gaussian. Images smaller than a window are compared as a single window.
+            \param[in] channel The channel of the 4-byte pixels to compare
+        */
+        double calcSsim(const uint8_t* pReference, const uint8_t* pTest, uint32_t width, uint32_t height, uint32_t channel);
+    }
+}
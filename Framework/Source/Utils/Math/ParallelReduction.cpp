@@ -27,61 +27,158 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "ParallelReduction.h"
-#include "Graphics/FboHelper.h"
 #include "API/RenderContext.h"
 #include <cstring>
 
 namespace Falcor
 {
-    const char* fsFilename = "Framework/Shaders/ParallelReduction.ps.slang";
+    static const char* kShaderFilename = "Framework/Shaders/ParallelReduction.cs.slang";
+    static const uint32_t kThreadCount = ParallelReduction::kGroupSize * ParallelReduction::kGroupSize;
+    static const float kLogEpsilon = 0.0001f;
+    static const glm::vec3 kLuminanceWeights(0.299f, 0.587f, 0.114f);
+
+    static_assert(ParallelReduction::kHistogramBinCount == kThreadCount, "buildHistogram() has a thread per bin");
+
+    namespace
+    {
+        uint32_t divRoundUp(uint32_t a, uint32_t b) { return (a + b - 1) / b; }
+
+        // The CPU version of the shader functions
+        struct CpuReduction
+        {
+            ParallelReduction::Type type;
+            const glm::vec4* pTexels;
+            uint32_t width;
+            uint32_t sampleCount;
+
+            glm::vec4 loadPixel(uint32_t x, uint32_t y) const
+            {
+                const glm::vec4* pPixel = pTexels + (size_t(y) * width + x) * sampleCount;
+                glm::vec4 sum(0);
+                for (uint32_t s = 0; s < sampleCount; s++) sum += pPixel[s];
+                return sum / float(sampleCount);
+            }
+
+            glm::vec4 getIdentity() const
+            {
+                return (type == ParallelReduction::Type::MinMax) ? glm::vec4(1, 0, 0, 0) : glm::vec4(0);
+            }
+
+            glm::vec4 loadValue(uint32_t x, uint32_t y) const
+            {
+                switch (type)
+                {
+                case ParallelReduction::Type::MinMax:
+                {
+                    glm::vec4 range = getIdentity();
+                    const glm::vec4* pPixel = pTexels + (size_t(y) * width + x) * sampleCount;
+                    for (uint32_t s = 0; s < sampleCount; s++)
+                    {
+                        float v = pPixel[s].r;
+                        if (v != 1.0f)
+                        {
+                            range.x = std::min(range.x, v);
+                            range.y = std::max(range.y, v);
+                        }
+                    }
+                    return range;
+                }
+                case ParallelReduction::Type::LogAverage:
+                {
+                    glm::vec4 p = glm::max(loadPixel(x, y), glm::vec4(kLogEpsilon));
+                    return glm::vec4(log2(p.x), log2(p.y), log2(p.z), log2(p.w));
+                }
+                default:
+                    return loadPixel(x, y);
+                }
+            }
+
+            glm::vec4 combine(const glm::vec4& a, const glm::vec4& b) const
+            {
+                if (type == ParallelReduction::Type::MinMax) return glm::vec4(std::min(a.x, b.x), std::max(a.y, b.y), 0, 0);
+                return a + b;
+            }
+
+            glm::vec4 finalize(const glm::vec4& v, float pixelCount) const
+            {
+                switch (type)
+                {
+                case ParallelReduction::Type::Mean:
+                    return v / pixelCount;
+                case ParallelReduction::Type::LogAverage:
+                {
+                    glm::vec4 m = v / pixelCount;
+                    return glm::vec4(exp2(m.x), exp2(m.y), exp2(m.z), exp2(m.w));
+                }
+                default:
+                    return v;
+                }
+            }
+
+            // The same tree as reduceGroup(), so the rounding matches the GPU
+            glm::vec4 reduceGroup(glm::vec4 tile[kThreadCount]) const
+            {
+                for (uint32_t stride = kThreadCount / 2; stride > 0; stride /= 2)
+                {
+                    for (uint32_t i = 0; i < stride; i++) tile[i] = combine(tile[i], tile[i + stride]);
+                }
+                return tile[0];
+            }
+        };
+
+        uint32_t getHistogramBin(float luminance, const glm::vec2& histogramRange)
+        {
+            float t = (log2(std::max(luminance, kLogEpsilon)) - histogramRange.x) / (histogramRange.y - histogramRange.x);
+            t = glm::clamp(t, 0.0f, 1.0f);
+            return std::min(uint32_t(t * ParallelReduction::kHistogramBinCount), ParallelReduction::kHistogramBinCount - 1);
+        }
+    }
 
     ParallelReduction::ParallelReduction(ParallelReduction::Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height, uint32_t sampleCount) : mReductionType(reductionType)
     {
-        ResourceFormat texFormat;
         Program::DefineList defines;
         defines.add("_SAMPLE_COUNT", std::to_string(sampleCount));
-        defines.add("_TILE_SIZE", std::to_string(kTileSize));
         switch(reductionType)
         {
         case Type::MinMax:
-           texFormat = ResourceFormat::RG32Float;
-           defines.add("_MIN_MAX_REDUCTION");
-           break;
+            defines.add("_MIN_MAX_REDUCTION");
+            break;
+        case Type::Sum:
+            defines.add("_SUM_REDUCTION");
+            break;
+        case Type::Mean:
+            defines.add("_MEAN_REDUCTION");
+            break;
+        case Type::LogAverage:
+            defines.add("_LOG_AVERAGE_REDUCTION");
+            break;
+        case Type::Histogram:
+            defines.add("_HISTOGRAM_REDUCTION");
+            break;
         default:
             should_not_get_here();
             return;
         }
 
-        Sampler::Desc samplerDesc;
-        samplerDesc.setAddressingMode(Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp).setFilterMode(Sampler::Filter::Point, Sampler::Filter::Point, Sampler::Filter::Point).setLodParams(0, 0, 0);
-        mpPointSampler = Sampler::create(samplerDesc);
-
+        Resource::BindFlags bindFlags = Resource::BindFlags::ShaderResource | Resource::BindFlags::UnorderedAccess;
         mResultData.resize(readbackLatency + 1);
-        for(auto& res : mResultData)
+        if (reductionType == Type::Histogram)
         {
-            Fbo::Desc fboDesc;
-            fboDesc.setColorTarget(0, texFormat);
-            res.pFbo = FboHelper::create2D(1, 1, fboDesc);
+            mHistogramPass = createPass("buildHistogram", defines);
+            for (auto& res : mResultData)
+            {
+                res.pTexture = Texture::create2D(kHistogramBinCount, 1, ResourceFormat::R32Uint, 1, 1, nullptr, bindFlags);
+            }
         }
-        mpFirstIterProg = FullScreenPass::create(fsFilename, defines);
-        mpFirstIterProg->getProgram()->addDefine("_FIRST_ITERATION");
-        mpRestIterProg = FullScreenPass::create(fsFilename, defines);
-        mpVars = GraphicsVars::create(mpFirstIterProg->getProgram()->getReflector());
-
-        // Calculate the number of reduction passes
-        if(width > kTileSize || height > kTileSize)
+        else
         {
-            while(width > 1 || height > 1)
+            mTilePass = createPass("reduceTiles", defines);
+            mPartialPass = createPass("reducePartials", defines);
+            mPartialCapacity = divRoundUp(width, kGroupSize) * divRoundUp(height, kGroupSize);
+            mpPartials = StructuredBuffer::create(mTilePass.pState->getProgram(), "gPartials", mPartialCapacity);
+            for (auto& res : mResultData)
             {
-                width = (width + kTileSize - 1) / kTileSize;;
-                height = (height + kTileSize - 1) / kTileSize;;
-
-                width = max(width, 1u);
-                height = max(height, 1u);
-
-                Fbo::Desc fboDesc;
-                fboDesc.setColorTarget(0, texFormat);
-                mpTmpResultFbo.push_back(FboHelper::create2D(width, height, fboDesc));
+                res.pTexture = Texture::create2D(1, 1, ResourceFormat::RGBA32Float, 1, 1, nullptr, bindFlags);
             }
         }
     }
@@ -91,55 +188,139 @@ namespace Falcor
         return ParallelReduction::UniquePtr(new ParallelReduction(reductionType, readbackLatency, width, height, sampleCount));
     }
 
-    void runProgram(RenderContext* pRenderCtx, Texture::SharedPtr pInput, const FullScreenPass* pProgram, Fbo::SharedPtr pDst, GraphicsVars::SharedPtr pVars, Sampler::SharedPtr pPointSampler)
+    ParallelReduction::Pass ParallelReduction::createPass(const std::string& entryPoint, const Program::DefineList& defines)
     {
-        GraphicsState::SharedPtr pState = pRenderCtx->getGraphicsState();
-        auto pDefaultBlock = pVars->getDefaultBlock().get();
-        pDefaultBlock->setTexture("gInputTex", pInput);
-        pDefaultBlock->setSampler("gSampler", pPointSampler);
-
-        //Set draw params
-        pState->pushFbo(pDst);
-        pRenderCtx->pushGraphicsVars(pVars);
-
-        // Launch the program
-        pProgram->execute(pRenderCtx);
- 
-        // Restore state
-        pState->popFbo();
-        pRenderCtx->popGraphicsVars();
+        Pass pass;
+        ComputeProgram::SharedPtr pProgram = ComputeProgram::createFromFile(kShaderFilename, entryPoint, defines);
+        pass.pState = ComputeState::create();
+        pass.pState->setProgram(pProgram);
+        pass.pVars = ComputeVars::create(pProgram->getReflector());
+        return pass;
     }
 
-    glm::vec4 ParallelReduction::reduce(RenderContext* pRenderCtx, Texture::SharedPtr pInput)
+    void ParallelReduction::runPass(RenderContext* pRenderCtx, const Pass& pass, uint32_t groupsX, uint32_t groupsY)
     {
-        const FullScreenPass* pProgram = mpFirstIterProg.get();
+        pRenderCtx->pushComputeState(pass.pState);
+        pRenderCtx->pushComputeVars(pass.pVars);
+        pRenderCtx->dispatch(groupsX, groupsY, 1);
+        pRenderCtx->popComputeVars();
+        pRenderCtx->popComputeState();
+    }
+
+    const Texture::SharedPtr& ParallelReduction::execute(RenderContext* pRenderCtx, const Texture::SharedPtr& pInput)
+    {
+        const Texture::SharedPtr& pResult = mResultData[mCurResult].pTexture;
+        uint32_t groupsX = divRoundUp(pInput->getWidth(), kGroupSize);
+        uint32_t groupsY = divRoundUp(pInput->getHeight(), kGroupSize);
 
-        for(size_t i = 0; i < mpTmpResultFbo.size(); i++)
+        if (mReductionType == Type::Histogram)
         {
-            runProgram(pRenderCtx, pInput, pProgram, mpTmpResultFbo[i], mpVars, mpPointSampler);
-            pProgram = mpRestIterProg.get();
-            pInput = mpTmpResultFbo[i]->getColorTexture(0);
+            pRenderCtx->clearUAV(pResult->getUAV().get(), glm::uvec4(0));
+            // The clear leaves the histogram in the UAV state, so the atomics need an explicit barrier
+            pRenderCtx->uavBarrier(pResult.get());
+            mHistogramPass.pVars->setTexture("gInput", pInput);
+            mHistogramPass.pVars->setTexture("gHistogram", pResult);
+            mHistogramPass.pVars["ReductionCB"]["gHistogramRange"] = mHistogramRange;
+            runPass(pRenderCtx, mHistogramPass, groupsX, groupsY);
         }
+        else
+        {
+            uint32_t partialCount = groupsX * groupsY;
+            if (partialCount > mPartialCapacity)
+            {
+                mPartialCapacity = partialCount;
+                mpPartials = StructuredBuffer::create(mTilePass.pState->getProgram(), "gPartials", mPartialCapacity);
+            }
+
+            // Reduce the tiles
+            mTilePass.pVars->setTexture("gInput", pInput);
+            mTilePass.pVars->setStructuredBuffer("gPartials", mpPartials);
+            runPass(pRenderCtx, mTilePass, groupsX, groupsY);
+            pRenderCtx->uavBarrier(mpPartials.get());
+
+            // Reduce the partial results
+            mPartialPass.pVars->setStructuredBuffer("gPartials", mpPartials);
+            mPartialPass.pVars->setTexture("gResult", pResult);
+            mPartialPass.pVars["ReductionCB"]["gPartialCount"] = partialCount;
+            mPartialPass.pVars["ReductionCB"]["gPixelCount"] = float(pInput->getWidth() * pInput->getHeight());
+            runPass(pRenderCtx, mPartialPass, 1, 1);
+        }
+        return pResult;
+    }
+
+    glm::vec4 ParallelReduction::reduce(RenderContext* pRenderCtx, Texture::SharedPtr pInput)
+    {
+        const Texture* pResult = execute(pRenderCtx, pInput).get();
+        mResultData[mCurResult].pReadTask = pRenderCtx->asyncReadTextureSubresource(pResult, 0);
 
-        runProgram(pRenderCtx, pInput, pProgram, mResultData[mCurFbo].pFbo, mpVars, mpPointSampler);
-        mResultData[mCurFbo].pReadTask = pRenderCtx->asyncReadTextureSubresource(mResultData[mCurFbo].pFbo->getColorTexture(0).get(), 0);
         // Read back the results
-        mCurFbo = (mCurFbo + 1) % mResultData.size();
+        mCurResult = (mCurResult + 1) % mResultData.size();
         glm::vec4 result(0);
-        if(mResultData[mCurFbo].pReadTask)
+        if(mResultData[mCurResult].pReadTask)
         {
-            auto texData = mResultData[mCurFbo].pReadTask->getData();
-            mResultData[mCurFbo].pReadTask = nullptr;
+            auto texData = mResultData[mCurResult].pReadTask->getData();
+            mResultData[mCurResult].pReadTask = nullptr;
 
-            switch (mReductionType)
+            if (mReductionType == Type::Histogram)
             {
-            case Type::MinMax:
-                result = vec4(*reinterpret_cast<vec2*>(texData.data()), 0, 0);
-                break;
-            default:
-                should_not_get_here();
+                mHistogram.resize(kHistogramBinCount);
+                std::memcpy(mHistogram.data(), texData.data(), kHistogramBinCount * sizeof(uint32_t));
+                uint32_t pixelCount = 0;
+                for (uint32_t count : mHistogram) pixelCount += count;
+                result.x = float(pixelCount);
+            }
+            else
+            {
+                result = *reinterpret_cast<const glm::vec4*>(texData.data());
             }
         }
         return result;
     }
-}
\ No newline at end of file
+
+    glm::vec4 ParallelReduction::reduce(Type reductionType, const glm::vec4* pTexels, uint32_t width, uint32_t height, uint32_t sampleCount)
+    {
+        assert(reductionType != Type::Histogram);
+        CpuReduction r = { reductionType, pTexels, width, sampleCount };
+
+        // Reduce the tiles
+        uint32_t groupsX = divRoundUp(width, kGroupSize);
+        uint32_t groupsY = divRoundUp(height, kGroupSize);
+        std::vector<glm::vec4> partials(groupsX * groupsY);
+        glm::vec4 tile[kThreadCount];
+        for (uint32_t groupY = 0; groupY < groupsY; groupY++)
+        {
+            for (uint32_t groupX = 0; groupX < groupsX; groupX++)
+            {
+                for (uint32_t i = 0; i < kThreadCount; i++)
+                {
+                    uint32_t x = groupX * kGroupSize + i % kGroupSize;
+                    uint32_t y = groupY * kGroupSize + i / kGroupSize;
+                    tile[i] = (x < width && y < height) ? r.loadValue(x, y) : r.getIdentity();
+                }
+                partials[groupY * groupsX + groupX] = r.reduceGroup(tile);
+            }
+        }
+
+        // Reduce the partial results
+        for (uint32_t i = 0; i < kThreadCount; i++)
+        {
+            tile[i] = r.getIdentity();
+            for (size_t p = i; p < partials.size(); p += kThreadCount) tile[i] = r.combine(tile[i], partials[p]);
+        }
+        return r.finalize(r.reduceGroup(tile), float(width * height));
+    }
+
+    void ParallelReduction::calcHistogram(const glm::vec4* pTexels, uint32_t width, uint32_t height, uint32_t sampleCount, const glm::vec2& histogramRange, std::vector<uint32_t>& bins)
+    {
+        CpuReduction r = { Type::Histogram, pTexels, width, sampleCount };
+        bins.assign(kHistogramBinCount, 0);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                float luminance = glm::dot(glm::vec3(r.loadPixel(x, y)), kLuminanceWeights);
+                bins[getHistogramBin(luminance, histogramRange)]++;
+            }
+        }
+    }
+}
@@ -27,46 +27,107 @@
 ***************************************************************************/
 #pragma once
 #include "Framework.h"
-#include "Graphics/FullScreenPass.h"
+#include "Graphics/ComputeState.h"
 #include "Graphics/Program/ProgramVars.h"
-#include "API/FBO.h"
-#include "API/Sampler.h"
+#include "API/StructuredBuffer.h"
+#include "API/Texture.h"
 #include "API/CopyContext.h"
 
 namespace Falcor
 {
     class RenderContext;
-    class Texture;
 
+    /** Reduces a texture to a few statistics in compute shaders, see Data/Framework/Shaders/ParallelReduction.cs.slang.
+        Each thread group reduces a tile of kGroupSize x kGroupSize pixels in shared memory, and a second dispatch reduces the tiles.
+        The result is read back with a configurable latency, or can be used on the GPU directly with execute().
+        The static functions run the same reductions on the CPU.
+    */
     class ParallelReduction
     {
     public:
         using UniquePtr = std::unique_ptr<ParallelReduction>;
         enum class Type
         {
-            MinMax
+            MinMax,         ///< Range of the red channel of every sample, in xy. Ignores 1, the background of a depth buffer. (1, 0) if there is nothing else.
+            Sum,            ///< Sum of the pixels, per channel
+            Mean,           ///< Average of the pixels, per channel
+            LogAverage,     ///< Geometric mean of the pixels, per channel
+            Histogram,      ///< Histogram of the log2 luminance of the pixels, in kHistogramBinCount bins
         };
+
+        static const uint32_t kGroupSize = 16;
+        static const uint32_t kHistogramBinCount = 256;
+
+        /** Create a new object
+            \param[in] reductionType The reduction to run
+            \param[in] readbackLatency Number of frames between reduce() running the reduction and returning its result
+            \param[in] width, height The size of the textures that will be reduced
+            \param[in] sampleCount The sample count of the textures. Only MinMax looks at the individual samples, the other reductions use the average of the samples.
+        */
         static UniquePtr create(Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height, uint32_t sampleCount = 1);
+
+        /** Run the reduction and return the result of readbackLatency calls ago. Returns 0 until the first result is available.
+            For histograms, the result is returned by getHistogram() and this returns the number of pixels in x.
+        */
         glm::vec4 reduce(RenderContext* pRenderCtx, Texture::SharedPtr pInput);
 
+        /** Run the reduction without reading it back.
+            \return A 1x1 RGBA32Float texture with the result, or a kHistogramBinCount x 1 R32Uint texture for histograms. Overwritten by the next call.
+        */
+        const Texture::SharedPtr& execute(RenderContext* pRenderCtx, const Texture::SharedPtr& pInput);
+
+        /** Get the histogram read back by the last call to reduce()
+        */
+        const std::vector<uint32_t>& getHistogram() const { return mHistogram; }
+
+        /** Set the range of the histogram, in log2 luminance. Luminance outside the range goes to the first or last bin.
+        */
+        void setHistogramRange(float minLog2, float maxLog2) { mHistogramRange = glm::vec2(minLog2, maxLog2); }
+
+        /** Get the range of the histogram, in log2 luminance
+        */
+        const glm::vec2& getHistogramRange() const { return mHistogramRange; }
+
+        /** Run a reduction on the CPU
+            \param[in] pTexels width * height * sampleCount texels, row by row. The samples of a pixel are consecutive.
+            \return The same result as reduce(). Histogram isn't supported, use calcHistogram().
+        */
+        static glm::vec4 reduce(Type reductionType, const glm::vec4* pTexels, uint32_t width, uint32_t height, uint32_t sampleCount = 1);
+
+        /** Build a luminance histogram on the CPU
+            \param[in] pTexels See reduce()
+            \param[in] histogramRange The range of the histogram in log2 luminance, see setHistogramRange()
+            \param[out] bins Receives kHistogramBinCount bins
+        */
+        static void calcHistogram(const glm::vec4* pTexels, uint32_t width, uint32_t height, uint32_t sampleCount, const glm::vec2& histogramRange, std::vector<uint32_t>& bins);
+
     private:
         ParallelReduction(Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height, uint32_t sampleCount);
-        FullScreenPass::UniquePtr mpFirstIterProg;
-        FullScreenPass::UniquePtr mpRestIterProg;
-        GraphicsVars::SharedPtr mpVars;
+
+        struct Pass
+        {
+            ComputeState::SharedPtr pState;
+            ComputeVars::SharedPtr pVars;
+        };
+        Pass createPass(const std::string& entryPoint, const Program::DefineList& defines);
+        void runPass(RenderContext* pRenderCtx, const Pass& pass, uint32_t groupsX, uint32_t groupsY);
+
+        Pass mTilePass;
+        Pass mPartialPass;
+        Pass mHistogramPass;
+        StructuredBuffer::SharedPtr mpPartials;
+        uint32_t mPartialCapacity = 0;
 
         struct ResultData
         {
             CopyContext::ReadTextureTask::SharedPtr pReadTask;
-            Fbo::SharedPtr pFbo;
+            Texture::SharedPtr pTexture;
         };
         std::vector<ResultData> mResultData;
 
-        uint32_t mCurFbo = 0;
+        uint32_t mCurResult = 0;
         Type mReductionType;
-        Sampler::SharedPtr mpPointSampler;
-
-        std::vector<Fbo::SharedPtr> mpTmpResultFbo;
-        static const uint32_t kTileSize = 16;
+        glm::vec2 mHistogramRange = glm::vec2(-10, 10);
+        std::vector<uint32_t> mHistogram;
     };
-}
\ No newline at end of file
+}
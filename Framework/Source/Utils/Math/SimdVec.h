@@ -0,0 +1,135 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+/** Instruction set detection shared by the CPU kernels.
+    FALCOR_USE_SSE2 is defined whenever the SSE2 intrinsics are available, for code which uses them directly.
+    FALCOR_USE_SIMD_VEC is defined when Simd::Vec maps to a SIMD register, using the widest of AVX2, SSE2 and NEON.
+*/
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FALCOR_USE_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FALCOR_USE_SSE2
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FALCOR_USE_NEON
+#endif
+#if defined(FALCOR_USE_AVX2) || defined(FALCOR_USE_SSE2) || defined(FALCOR_USE_NEON)
+#define FALCOR_USE_SIMD_VEC
+#endif
+
+namespace Falcor
+{
+    namespace Simd
+    {
+        /** A SIMD register of floats. Without SIMD support it holds a single float, so kernels written against it still compile.
+        */
+        struct Vec
+        {
+#if defined(FALCOR_USE_AVX2)
+            using Native = __m256;
+            static const uint32_t kWidth = 8;
+            Vec(float f) : v(_mm256_set1_ps(f)) {}
+            static Vec load(const float* p) { return _mm256_loadu_ps(p); }
+            void store(float* p) const { _mm256_storeu_ps(p, v); }
+#elif defined(FALCOR_USE_SSE2)
+            using Native = __m128;
+            static const uint32_t kWidth = 4;
+            Vec(float f) : v(_mm_set1_ps(f)) {}
+            static Vec load(const float* p) { return _mm_loadu_ps(p); }
+            void store(float* p) const { _mm_storeu_ps(p, v); }
+#elif defined(FALCOR_USE_NEON)
+            using Native = float32x4_t;
+            static const uint32_t kWidth = 4;
+            Vec(float f) : v(vdupq_n_f32(f)) {}
+            static Vec load(const float* p) { return vld1q_f32(p); }
+            void store(float* p) const { vst1q_f32(p, v); }
+#else
+            using Native = float;
+            static const uint32_t kWidth = 1;
+            static Vec load(const float* p) { return *p; }
+            void store(float* p) const { *p = v; }
+#endif
+            Vec(Native n) : v(n) {}
+            Native v;
+        };
+
+#if defined(FALCOR_USE_AVX2)
+        inline const char* getName() { return "AVX2"; }
+        inline Vec operator+(Vec a, Vec b) { return _mm256_add_ps(a.v, b.v); }
+        inline Vec operator-(Vec a, Vec b) { return _mm256_sub_ps(a.v, b.v); }
+        inline Vec operator*(Vec a, Vec b) { return _mm256_mul_ps(a.v, b.v); }
+        inline Vec operator/(Vec a, Vec b) { return _mm256_div_ps(a.v, b.v); }
+        inline Vec sqrt(Vec a) { return _mm256_sqrt_ps(a.v); }
+        inline Vec max(Vec a, Vec b) { return _mm256_max_ps(a.v, b.v); }
+        inline Vec saturate(Vec a) { return _mm256_min_ps(_mm256_max_ps(a.v, _mm256_setzero_ps()), _mm256_set1_ps(1.0f)); }
+        inline uint32_t lessEqualMask(Vec a, Vec b) { return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)); }
+#elif defined(FALCOR_USE_SSE2)
+        inline const char* getName() { return "SSE2"; }
+        inline Vec operator+(Vec a, Vec b) { return _mm_add_ps(a.v, b.v); }
+        inline Vec operator-(Vec a, Vec b) { return _mm_sub_ps(a.v, b.v); }
+        inline Vec operator*(Vec a, Vec b) { return _mm_mul_ps(a.v, b.v); }
+        inline Vec operator/(Vec a, Vec b) { return _mm_div_ps(a.v, b.v); }
+        inline Vec sqrt(Vec a) { return _mm_sqrt_ps(a.v); }
+        inline Vec max(Vec a, Vec b) { return _mm_max_ps(a.v, b.v); }
+        inline Vec saturate(Vec a) { return _mm_min_ps(_mm_max_ps(a.v, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+        inline uint32_t lessEqualMask(Vec a, Vec b) { return (uint32_t)_mm_movemask_ps(_mm_cmple_ps(a.v, b.v)); }
+#elif defined(FALCOR_USE_NEON)
+        inline const char* getName() { return "NEON"; }
+        inline Vec operator+(Vec a, Vec b) { return vaddq_f32(a.v, b.v); }
+        inline Vec operator-(Vec a, Vec b) { return vsubq_f32(a.v, b.v); }
+        inline Vec operator*(Vec a, Vec b) { return vmulq_f32(a.v, b.v); }
+        inline Vec operator/(Vec a, Vec b) { return vdivq_f32(a.v, b.v); }
+        inline Vec sqrt(Vec a) { return vsqrtq_f32(a.v); }
+        inline Vec max(Vec a, Vec b) { return vmaxq_f32(a.v, b.v); }
+        inline Vec saturate(Vec a) { return vminq_f32(vmaxq_f32(a.v, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f)); }
+        inline uint32_t lessEqualMask(Vec a, Vec b)
+        {
+            static const uint32_t kBits[4] = { 1, 2, 4, 8 };
+            return vaddvq_u32(vandq_u32(vcleq_f32(a.v, b.v), vld1q_u32(kBits)));
+        }
+#else
+        inline const char* getName() { return "None"; }
+        inline Vec operator+(Vec a, Vec b) { return a.v + b.v; }
+        inline Vec operator-(Vec a, Vec b) { return a.v - b.v; }
+        inline Vec operator*(Vec a, Vec b) { return a.v * b.v; }
+        inline Vec operator/(Vec a, Vec b) { return a.v / b.v; }
+        inline Vec sqrt(Vec a) { return std::sqrt(a.v); }
+        inline Vec max(Vec a, Vec b) { return std::max(a.v, b.v); }
+        inline Vec saturate(Vec a) { return std::min(std::max(a.v, 0.0f), 1.0f); }
+        inline uint32_t lessEqualMask(Vec a, Vec b) { return a.v <= b.v ? 1 : 0; }
+#endif
+    }
+}
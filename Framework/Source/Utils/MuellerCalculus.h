@@ -0,0 +1,120 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <complex>
+
+namespace Falcor
+{
+    /** Mueller calculus for tracking polarized light on the CPU.
+        A Stokes vector (S0, S1, S2, S3) is expressed in a reference frame (x, y) perpendicular to the direction of propagation d,
+        with y = cross(d, x). S1 > 0 means light polarized along x, and S2 > 0 along (x + y)/sqrt(2).
+        Mueller matrices are glm::mat4, so M[column][row].
+    */
+    namespace Polarization
+    {
+        /** Mueller matrix of a Fresnel reflection, in the s/p frames of the incident and reflected light.
+            The s axis is perpendicular to the plane of incidence and the p axes follow from y = cross(d, x) on each side.
+            For unpolarized incident light the reflected light has S1/S0 = psi_Exact().
+            \param[in] n Simple refractive index
+            \param[in] k Extinction coefficient
+            \param[in] cosTheta Cosine of the angle of incidence
+        */
+        inline glm::mat4 muellerFresnelReflection(float n, float k, float cosTheta)
+        {
+            using complex = std::complex<float>;
+            cosTheta = glm::clamp(cosTheta, 0.0f, 1.0f);
+            complex eta(n, k);
+            complex eta2 = eta * eta;
+            complex cosT = std::sqrt(eta2 - complex(1.0f - cosTheta * cosTheta));  // eta * cos(theta_t)
+
+            complex rs = (complex(cosTheta) - cosT) / (complex(cosTheta) + cosT);
+            complex rp = (eta2 * cosTheta - cosT) / (eta2 * cosTheta + cosT);
+
+            float Rs = std::norm(rs);
+            float Rp = std::norm(rp);
+            complex c = rs * std::conj(rp);
+
+            glm::mat4 m(0.0f);
+            m[0][0] = 0.5f * (Rs + Rp);
+            m[1][0] = 0.5f * (Rs - Rp);
+            m[0][1] = 0.5f * (Rs - Rp);
+            m[1][1] = 0.5f * (Rs + Rp);
+            m[2][2] = c.real();
+            m[3][2] = c.imag();
+            m[2][3] = -c.imag();
+            m[3][3] = c.real();
+            return m;
+        }
+
+        /** Mueller matrix that re-expresses a Stokes vector from the frame (x, y) in the frame (cos(a)x + sin(a)y, ...)
+            \param[in] cos2a cos(2a)
+            \param[in] sin2a sin(2a)
+        */
+        inline glm::mat4 muellerRotation(float cos2a, float sin2a)
+        {
+            glm::mat4 m(1.0f);
+            m[1][1] = cos2a;
+            m[2][1] = sin2a;
+            m[1][2] = -sin2a;
+            m[2][2] = cos2a;
+            return m;
+        }
+
+        /** Mueller matrix that re-expresses a Stokes vector from the frame (fromX, fromY) in a frame with the x axis toX.
+            All vectors must be unit length and perpendicular to the same direction of propagation.
+        */
+        inline glm::mat4 muellerRotation(const glm::vec3& fromX, const glm::vec3& fromY, const glm::vec3& toX)
+        {
+            float c = glm::dot(toX, fromX);
+            float s = glm::dot(toX, fromY);
+            return muellerRotation(c * c - s * s, 2.0f * c * s);
+        }
+
+        /** Mueller matrix of an ideal depolarizer, such as a Lambertian reflection
+            \param[in] albedo Fraction of the intensity that is kept
+        */
+        inline glm::mat4 muellerDepolarizer(float albedo)
+        {
+            glm::mat4 m(0.0f);
+            m[0][0] = albedo;
+            return m;
+        }
+
+        /** Intensity transmitted by a linear polarizer, scaled so that unpolarized light passes unchanged.
+            This matches the polarizing filter of the renderers, where the specular term is scaled by (1 + cos(2(angle - polarizationAngle))*psi).
+            \param[in] stokes Stokes vector
+            \param[in] angle Angle of the transmission axis from the x axis of the Stokes frame towards the y axis, in radians
+        */
+        inline float linearPolarizerIntensity(const glm::vec4& stokes, float angle)
+        {
+            return stokes.x + cos(2.0f * angle) * stokes.y + sin(2.0f * angle) * stokes.z;
+        }
+    }
+}
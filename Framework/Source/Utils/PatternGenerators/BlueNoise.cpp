@@ -0,0 +1,261 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BlueNoise.h"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/Platform/OS.h"
+#include "Utils/CpuTimer.h"
+#include "API/Texture.h"
+#include "Utils/Math/SimdVec.h"
+#include <numeric>
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kFileMagic = 0x4e425643; // "CVBN"
+        const uint32_t kFileVersion = 1;
+        const uint32_t kMaxTexels = 1 << 16;
+
+        void addScaled(float* pDst, const float* pSrc, uint32_t count, float scale)
+        {
+            uint32_t i = 0;
+#ifdef FALCOR_USE_SSE2
+            const __m128 s = _mm_set1_ps(scale);
+            for (; i + 4 <= count; i += 4)
+            {
+                _mm_storeu_ps(pDst + i, _mm_add_ps(_mm_loadu_ps(pDst + i), _mm_mul_ps(_mm_loadu_ps(pSrc + i), s)));
+            }
+#endif
+            for (; i < count; i++) pDst[i] += pSrc[i] * scale;
+        }
+
+        // Binary pattern with the energy of every texel
+        class VoidAndCluster
+        {
+        public:
+            VoidAndCluster(uint32_t width, uint32_t height, float sigma) : mWidth(width), mHeight(height)
+            {
+                // The Gaussian of the toroidal offset (dx, dy), so splatting a texel is a rotated copy of the table
+                mKernel.resize(width * height);
+                for (uint32_t y = 0; y < height; y++)
+                {
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        float dx = float(std::min(x, width - x));
+                        float dy = float(std::min(y, height - y));
+                        mKernel[y * width + x] = expf(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+                    }
+                }
+                mEnergy.assign(width * height, 0.0f);
+                mIsSet.assign(width * height, 0);
+            }
+
+            void set(uint32_t texel, bool value)
+            {
+                assert(mIsSet[texel] != uint8_t(value));
+                mIsSet[texel] = uint8_t(value);
+
+                uint32_t px = texel % mWidth;
+                uint32_t py = texel / mWidth;
+                float scale = value ? 1.0f : -1.0f;
+                for (uint32_t y = 0; y < mHeight; y++)
+                {
+                    float* pRow = &mEnergy[y * mWidth];
+                    const float* pKernelRow = &mKernel[((y + mHeight - py) % mHeight) * mWidth];
+                    addScaled(pRow + px, pKernelRow, mWidth - px, scale);
+                    addScaled(pRow, pKernelRow + mWidth - px, px, scale);
+                }
+            }
+
+            // The set texel with the highest energy
+            uint32_t findTightestCluster() const
+            {
+                uint32_t best = 0;
+                float bestEnergy = -FLT_MAX;
+                for (uint32_t i = 0; i < mEnergy.size(); i++)
+                {
+                    if (mIsSet[i] && mEnergy[i] > bestEnergy)
+                    {
+                        best = i;
+                        bestEnergy = mEnergy[i];
+                    }
+                }
+                return best;
+            }
+
+            // The unset texel with the lowest energy. Past half of the texels, this is also the tightest cluster of unset texels, as the energy of the unset texels is the constant total minus the energy of the set ones.
+            uint32_t findLargestVoid() const
+            {
+                uint32_t best = 0;
+                float bestEnergy = FLT_MAX;
+                for (uint32_t i = 0; i < mEnergy.size(); i++)
+                {
+                    if (mIsSet[i] == 0 && mEnergy[i] < bestEnergy)
+                    {
+                        best = i;
+                        bestEnergy = mEnergy[i];
+                    }
+                }
+                return best;
+            }
+
+        private:
+            uint32_t mWidth;
+            uint32_t mHeight;
+            std::vector<float> mKernel;
+            std::vector<float> mEnergy;
+            std::vector<uint8_t> mIsSet;
+        };
+
+        std::string getCacheFilename(uint32_t width, uint32_t height, uint32_t seed)
+        {
+            return BlueNoise::getCacheDirectory() + "/BlueNoise_" + std::to_string(width) + "x" + std::to_string(height) + "_" + std::to_string(seed) + ".bin";
+        }
+
+        bool loadRanks(const std::string& filename, uint32_t width, uint32_t height, uint32_t seed, std::vector<uint32_t>& ranks)
+        {
+            BinaryFileStream stream(filename, BinaryFileStream::Mode::Read);
+            uint32_t header[5] = {};
+            stream.read(header, sizeof(header));
+            if (stream.isFail() || header[0] != kFileMagic || header[1] != kFileVersion || header[2] != width || header[3] != height || header[4] != seed) return false;
+
+            std::vector<uint16_t> data(width * height);
+            stream.read(data.data(), data.size() * sizeof(uint16_t));
+            if (stream.isFail()) return false;
+            ranks.assign(data.begin(), data.end());
+            return true;
+        }
+
+        bool saveRanks(const std::string& filename, uint32_t width, uint32_t height, uint32_t seed, const std::vector<uint32_t>& ranks)
+        {
+            const std::string& dir = BlueNoise::getCacheDirectory();
+            if ((isDirectoryExists(dir) || createDirectory(dir)) == false) return false;
+
+            std::vector<uint16_t> data(ranks.begin(), ranks.end());
+            uint32_t header[5] = { kFileMagic, kFileVersion, width, height, seed };
+            BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+            stream.write(header, sizeof(header));
+            stream.write(data.data(), data.size() * sizeof(uint16_t));
+            return stream.isFail() == false;
+        }
+    }
+
+    std::vector<uint32_t> BlueNoise::generate(uint32_t width, uint32_t height, uint32_t seed, float sigma)
+    {
+        const uint32_t texelCount = width * height;
+        if (texelCount == 0 || texelCount > kMaxTexels)
+        {
+            logError("BlueNoise::generate() - the map must have between 1 and " + std::to_string(kMaxTexels) + " texels");
+            return {};
+        }
+
+        // Initial pattern, 10% of the texels set at random
+        std::mt19937 rng(seed);
+        std::vector<uint32_t> order(texelCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), rng);
+        const uint32_t initialCount = std::max(1u, texelCount / 10);
+        VoidAndCluster prototype(width, height, sigma);
+        for (uint32_t i = 0; i < initialCount; i++) prototype.set(order[i], true);
+
+        // Move texels from the tightest cluster to the largest void until that doesn't change the pattern
+        for (uint32_t i = 0; i < texelCount; i++)
+        {
+            uint32_t cluster = prototype.findTightestCluster();
+            prototype.set(cluster, false);
+            uint32_t largestVoid = prototype.findLargestVoid();
+            prototype.set(largestVoid, true);
+            if (largestVoid == cluster) break;
+        }
+
+        std::vector<uint32_t> ranks(texelCount);
+
+        // Ranks below the initial count, removing the tightest clusters
+        VoidAndCluster pattern = prototype;
+        for (uint32_t rank = initialCount; rank-- > 0;)
+        {
+            uint32_t cluster = pattern.findTightestCluster();
+            pattern.set(cluster, false);
+            ranks[cluster] = rank;
+        }
+
+        // The remaining ranks, filling the largest voids
+        for (uint32_t rank = initialCount; rank < texelCount; rank++)
+        {
+            uint32_t largestVoid = prototype.findLargestVoid();
+            prototype.set(largestVoid, true);
+            ranks[largestVoid] = rank;
+        }
+
+        return ranks;
+    }
+
+    std::vector<uint32_t> BlueNoise::loadOrGenerate(uint32_t width, uint32_t height, uint32_t seed)
+    {
+        std::vector<uint32_t> ranks;
+        const std::string filename = getCacheFilename(width, height, seed);
+        if (doesFileExist(filename))
+        {
+            if (loadRanks(filename, width, height, seed, ranks)) return ranks;
+            logWarning("BlueNoise - can't use the cached map " + filename + ". Generating it again.");
+        }
+
+        auto start = CpuTimer::getCurrentTimePoint();
+        ranks = generate(width, height, seed);
+        if (ranks.empty()) return ranks;
+        logInfo("BlueNoise - generated a " + std::to_string(width) + "x" + std::to_string(height) + " map in " + std::to_string(CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint())) + " ms");
+
+        if (saveRanks(filename, width, height, seed, ranks) == false)
+        {
+            logWarning("BlueNoise - can't write the cached map " + filename);
+        }
+        return ranks;
+    }
+
+    Texture::SharedPtr BlueNoise::createTexture(uint32_t width, uint32_t height, uint32_t seed)
+    {
+        std::vector<uint32_t> ranks = loadOrGenerate(width, height, seed);
+        if (ranks.empty()) return nullptr;
+
+        std::vector<uint16_t> texels(ranks.size());
+        const double scale = 65535.0 / double(ranks.size());
+        for (size_t i = 0; i < ranks.size(); i++)
+        {
+            texels[i] = uint16_t((ranks[i] + 0.5) * scale + 0.5);
+        }
+        return Texture::create2D(width, height, ResourceFormat::R16Unorm, 1, 1, texels.data());
+    }
+
+    const std::string& BlueNoise::getCacheDirectory()
+    {
+        static const std::string kDir = getExecutableDirectory() + "/BlueNoiseCache";
+        return kDir;
+    }
+}
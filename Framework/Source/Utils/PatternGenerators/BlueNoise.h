@@ -0,0 +1,65 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <memory>
+#include <vector>
+
+namespace Falcor
+{
+    class Texture;
+
+    /** Tileable blue-noise rank maps, generated with the void-and-cluster method (Ulichney, "The void-and-cluster method for dither array generation", 1993).
+        Every texel holds a unique rank in [0, width * height). Thresholding the map at any rank gives a blue-noise point set, which makes the
+        maps suitable as per-pixel sample offsets and rotations that converge quickly when blurred or accumulated.
+        Generation is quadratic in the texel count, so maps are cached on disk and later runs with the same parameters only load the file.
+    */
+    class BlueNoise
+    {
+    public:
+        /** Generate a rank map. The energy of a texel is the sum of a Gaussian of the toroidal distance to every set texel, so the map tiles.
+            \param[in] width Map width
+            \param[in] height Map height. width * height must be at most 65536.
+            \param[in] seed Seed of the initial random pattern
+            \param[in] sigma Standard deviation of the Gaussian, in texels
+            \return The ranks, row-major
+        */
+        static std::vector<uint32_t> generate(uint32_t width, uint32_t height, uint32_t seed = 0, float sigma = 1.5f);
+
+        /** Load a rank map from the cache, or generate it and add it to the cache
+        */
+        static std::vector<uint32_t> loadOrGenerate(uint32_t width, uint32_t height, uint32_t seed = 0);
+
+        /** Create an R16Unorm texture of a cached rank map. Texels hold (rank + 0.5) / (width * height).
+        */
+        static std::shared_ptr<Texture> createTexture(uint32_t width, uint32_t height, uint32_t seed = 0);
+
+        /** Get the directory of the cached maps
+        */
+        static const std::string& getCacheDirectory();
+    };
+}
@@ -0,0 +1,68 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "PatternGenerator.h"
+#include "LowDiscrepancySequence.h"
+
+namespace Falcor
+{
+    /** Sample pattern that cycles through the first points of a low-discrepancy sequence, centered around 0
+    */
+    class LowDiscrepancySamplePattern : public PatternGenerator, public inherit_shared_from_this<PatternGenerator, LowDiscrepancySamplePattern>
+    {
+    public:
+        using SharedPtr = std::shared_ptr<LowDiscrepancySamplePattern>;
+        virtual ~LowDiscrepancySamplePattern() = default;
+
+        /** Create a sample pattern
+            \param[in] type Sequence type
+            \param[in] sampleCount Number of samples before the pattern repeats. Use a power of 2 to keep the Sobol and PMJ02 patterns stratified.
+            \param[in] seed Seed of the sequence
+        */
+        static SharedPtr create(LowDiscrepancySequence::Type type, uint32_t sampleCount = 16, uint32_t seed = 0) { return SharedPtr(new LowDiscrepancySamplePattern(type, sampleCount, seed)); }
+
+        virtual uint32_t getSampleCount() const override { return (uint32_t)mPattern.size(); }
+
+        virtual void reset(uint32_t startID = 0) override { mCurSample = startID; }
+
+        virtual vec2 next() override
+        {
+            return mPattern[(mCurSample++) % mPattern.size()];
+        }
+    protected:
+        LowDiscrepancySamplePattern(LowDiscrepancySequence::Type type, uint32_t sampleCount, uint32_t seed) : mPattern(sampleCount)
+        {
+            assert(sampleCount > 0);
+            LowDiscrepancySequence::generate(type, 0, sampleCount, seed, mPattern.data());
+            for (auto& p : mPattern) p -= vec2(0.5f);
+        }
+
+        uint32_t mCurSample = 0;
+        std::vector<vec2> mPattern;
+    };
+}
@@ -0,0 +1,442 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "LowDiscrepancySequence.h"
+#include "Utils/Math/SimdVec.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        // 0.32 fixed-point increments of the R2 sequence, 1/g and 1/g^2 for the plastic number g
+        const uint32_t kR2Alpha[2] = { 3242174889u, 2447445414u };
+        const uint32_t kHalf = 0x80000000u;
+
+        // Direction numbers of the second Sobol dimension. The first dimension is the bit-reversed index.
+        struct SobolDirections
+        {
+            uint32_t v[32];
+            SobolDirections()
+            {
+                v[0] = 1u << 31;
+                for (uint32_t i = 1; i < 32; i++) v[i] = v[i - 1] ^ (v[i - 1] >> 1);
+            }
+        };
+        const SobolDirections kSobol;
+
+        uint32_t reverseBits(uint32_t x)
+        {
+            x = (x << 16) | (x >> 16);
+            x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+            x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+            x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+            x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+            return x;
+        }
+
+        uint32_t sobolY(uint32_t index)
+        {
+            uint32_t y = 0;
+            for (uint32_t i = 0; index; index >>= 1, i++)
+            {
+                if (index & 1) y ^= kSobol.v[i];
+            }
+            return y;
+        }
+
+        // Each bit only affects the bits above it, so this is an Owen scramble of the bit-reversed value
+        uint32_t laineKarras(uint32_t x, uint32_t seed)
+        {
+            x += seed;
+            x ^= x * 0x6c50b47cu;
+            x ^= x * 0xb82f1e52u;
+            x ^= x * 0xc7afe638u;
+            x ^= x * 0x8d22f6e6u;
+            return x;
+        }
+
+        uint32_t hash(uint32_t x)
+        {
+            x ^= x >> 16;
+            x *= 0x7feb352du;
+            x ^= x >> 15;
+            x *= 0x846ca68bu;
+            x ^= x >> 16;
+            return x;
+        }
+
+        uint32_t hashCombine(uint32_t seed, uint32_t v)
+        {
+            return seed ^ (v + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+        }
+
+        struct ScrambleSeeds
+        {
+            uint32_t index, x, y;
+            ScrambleSeeds(uint32_t seed)
+            {
+                index = hash(seed);
+                x = hashCombine(index, 1);
+                y = hashCombine(index, 2);
+            }
+        };
+
+        uint32_t r2Offset(uint32_t seed, uint32_t dim)
+        {
+            return seed ? hash(hashCombine(seed, dim)) : kHalf;
+        }
+
+        float toFloat(uint32_t x)
+        {
+            return float(x >> 8) * (1.0f / float(1 << 24));
+        }
+
+#ifdef FALCOR_USE_SSE2
+        // 32-bit multiplication, _mm_mullo_epi32() requires SSE4.1
+        __m128i mullo(__m128i a, __m128i b)
+        {
+            __m128i even = _mm_mul_epu32(a, b);
+            __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+            return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        }
+
+        __m128i swapBits(__m128i x, uint32_t mask, int shift)
+        {
+            __m128i m = _mm_set1_epi32(int(mask));
+            return _mm_or_si128(_mm_slli_epi32(_mm_and_si128(x, m), shift), _mm_and_si128(_mm_srli_epi32(x, shift), m));
+        }
+
+        __m128i reverseBits(__m128i x)
+        {
+            x = _mm_or_si128(_mm_slli_epi32(x, 16), _mm_srli_epi32(x, 16));
+            x = swapBits(x, 0x00ff00ffu, 8);
+            x = swapBits(x, 0x0f0f0f0fu, 4);
+            x = swapBits(x, 0x33333333u, 2);
+            return swapBits(x, 0x55555555u, 1);
+        }
+
+        __m128i sobolY(__m128i index)
+        {
+            const __m128i one = _mm_set1_epi32(1);
+            __m128i y = _mm_setzero_si128();
+            for (uint32_t i = 0; i < 32; i++)
+            {
+                __m128i mask = _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(_mm_srli_epi32(index, i), one));
+                y = _mm_xor_si128(y, _mm_and_si128(mask, _mm_set1_epi32(int(kSobol.v[i]))));
+            }
+            return y;
+        }
+
+        __m128i laineKarras(__m128i x, uint32_t seed)
+        {
+            x = _mm_add_epi32(x, _mm_set1_epi32(int(seed)));
+            x = _mm_xor_si128(x, mullo(x, _mm_set1_epi32(int(0x6c50b47cu))));
+            x = _mm_xor_si128(x, mullo(x, _mm_set1_epi32(int(0xb82f1e52u))));
+            x = _mm_xor_si128(x, mullo(x, _mm_set1_epi32(int(0xc7afe638u))));
+            x = _mm_xor_si128(x, mullo(x, _mm_set1_epi32(int(0x8d22f6e6u))));
+            return x;
+        }
+
+        void store(__m128i x, __m128i y, vec2* pOut)
+        {
+            const __m128 scale = _mm_set1_ps(1.0f / float(1 << 24));
+            __m128 fx = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(x, 8)), scale);
+            __m128 fy = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(y, 8)), scale);
+            _mm_storeu_ps(&pOut[0].x, _mm_unpacklo_ps(fx, fy));
+            _mm_storeu_ps(&pOut[2].x, _mm_unpackhi_ps(fx, fy));
+        }
+
+        // Generates count & ~3 points and returns that number
+        uint32_t generateSse(LowDiscrepancySequence::Type type, uint32_t first, uint32_t count, uint32_t seed, vec2* pOut)
+        {
+            const ScrambleSeeds seeds(seed);
+            const uint32_t offset[2] = { r2Offset(seed, 0), r2Offset(seed, 1) };
+            __m128i index = _mm_add_epi32(_mm_set1_epi32(int(first)), _mm_setr_epi32(0, 1, 2, 3));
+            const __m128i step = _mm_set1_epi32(4);
+            uint32_t i = 0;
+            for (; i + 4 <= count; i += 4, index = _mm_add_epi32(index, step))
+            {
+                __m128i x, y;
+                switch (type)
+                {
+                case LowDiscrepancySequence::Type::Sobol:
+                    x = reverseBits(index);
+                    y = sobolY(index);
+                    break;
+                case LowDiscrepancySequence::Type::OwenScrambledSobol:
+                {
+                    __m128i shuffled = reverseBits(laineKarras(reverseBits(index), seeds.index));
+                    x = reverseBits(laineKarras(shuffled, seeds.x));
+                    y = reverseBits(laineKarras(reverseBits(sobolY(shuffled)), seeds.y));
+                    break;
+                }
+                case LowDiscrepancySequence::Type::R2:
+                    x = _mm_add_epi32(_mm_set1_epi32(int(offset[0])), mullo(index, _mm_set1_epi32(int(kR2Alpha[0]))));
+                    y = _mm_add_epi32(_mm_set1_epi32(int(offset[1])), mullo(index, _mm_set1_epi32(int(kR2Alpha[1]))));
+                    break;
+                default:
+                    should_not_get_here();
+                    return 0;
+                }
+                store(x, y, pOut + i);
+            }
+            return i;
+        }
+#endif
+
+        // Builds a PMJ02 sequence following Christensen et al., "Progressive Multi-Jittered Sample Sequences", 2018.
+        // Points are kept as 24-bit fixed-point coordinates, so the strata they fall in are exact.
+        class Pmj02Builder
+        {
+        public:
+            Pmj02Builder(uint32_t seed) : mRng(seed) {}
+
+            std::vector<vec2> build(uint32_t count)
+            {
+                assert(count <= (1u << kBits));
+                mSamples.clear();
+                mSamples.reserve(count);
+                mSamples.push_back(glm::uvec2(randomBits(kBits), randomBits(kBits)));
+
+                for (uint32_t log2n = 0; mSamples.size() < count; log2n++)
+                {
+                    // Retry with different random choices if a sample can't be placed. This is very rare.
+                    const uint32_t n = 1u << log2n;
+                    bool success = false;
+                    for (uint32_t attempt = 0; attempt < kMaxAttempts && success == false; attempt++)
+                    {
+                        mSamples.resize(n);
+                        success = (log2n % 2 == 0) ? extendEven(log2n) : extendOdd(log2n);
+                    }
+                    if (success == false)
+                    {
+                        logWarning("LowDiscrepancySequence::generatePMJ02() - can't extend the sequence past " + std::to_string(n) + " points");
+                        break;
+                    }
+                }
+
+                std::vector<vec2> points(std::min(count, uint32_t(mSamples.size())));
+                for (size_t i = 0; i < points.size(); i++)
+                {
+                    points[i] = vec2(mSamples[i]) * (1.0f / float(1 << kBits));
+                }
+                return points;
+            }
+
+        private:
+            static const uint32_t kBits = 24;
+            static const uint32_t kMaxAttempts = 16;
+            static const uint32_t kRandomCandidates = 16;
+
+            // n = 4^k points, one per cell of a 2^k x 2^k grid. Each new point goes into the subquadrant diagonally opposite of the existing point in its cell.
+            bool extendEven(uint32_t log2n)
+            {
+                const uint32_t n = 1u << log2n;
+                const uint32_t subShift = kBits - (log2n / 2 + 1);
+                markOccupied(log2n + 1);
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    glm::uvec2 sub = (mSamples[i] >> subShift) ^ glm::uvec2(1);
+                    if (addSample(sub, subShift) == false) return false;
+                }
+                return true;
+            }
+
+            // n = 2 * 4^k points, two per cell of a 2^k x 2^k grid in diagonal subquadrants. Point i < n/2 and its partner i + n/2 share a cell.
+            // The first new point of each cell goes into the subquadrant horizontally or vertically opposite of point i, the second into the last free one.
+            bool extendOdd(uint32_t log2n)
+            {
+                const uint32_t n = 1u << log2n;
+                const uint32_t subShift = kBits - (log2n / 2 + 1);
+                markOccupied(log2n + 1);
+                std::vector<uint8_t> flipX(n / 2);
+                for (uint32_t i = 0; i < n / 2; i++)
+                {
+                    flipX[i] = uint8_t(randomBits(1));
+                    glm::uvec2 sub = (mSamples[i] >> subShift) ^ (flipX[i] ? glm::uvec2(1, 0) : glm::uvec2(0, 1));
+                    if (addSample(sub, subShift) == false) return false;
+                }
+                for (uint32_t i = 0; i < n / 2; i++)
+                {
+                    glm::uvec2 sub = (mSamples[i] >> subShift) ^ (flipX[i] ? glm::uvec2(0, 1) : glm::uvec2(1, 0));
+                    if (addSample(sub, subShift) == false) return false;
+                }
+                return true;
+            }
+
+            // Rebuild the occupancy of the elementary intervals of 2^log2N points. Interval j has 2^j columns and 2^(log2N-j) rows.
+            void markOccupied(uint32_t log2N)
+            {
+                mLog2N = log2N;
+                mOccupied.assign((log2N + 1) << log2N, 0);
+                for (const auto& s : mSamples) setOccupied(s >> (kBits - log2N));
+            }
+
+            uint32_t intervalIndex(glm::uvec2 strata, uint32_t j) const
+            {
+                return (j << mLog2N) + ((strata.x >> (mLog2N - j)) << (mLog2N - j)) + (strata.y >> j);
+            }
+
+            bool isFree(glm::uvec2 strata) const
+            {
+                for (uint32_t j = 0; j <= mLog2N; j++)
+                {
+                    if (mOccupied[intervalIndex(strata, j)]) return false;
+                }
+                return true;
+            }
+
+            void setOccupied(glm::uvec2 strata)
+            {
+                for (uint32_t j = 0; j <= mLog2N; j++) mOccupied[intervalIndex(strata, j)] = 1;
+            }
+
+            // Add a point inside the given subquadrant, in a stratum that doesn't share an elementary interval with any existing point
+            bool addSample(glm::uvec2 sub, uint32_t subShift)
+            {
+                // Strata of the finest columns and rows that intersect the subquadrant and are still free
+                const uint32_t stratumShift = kBits - mLog2N;
+                const uint32_t strataPerSub = 1u << (subShift - stratumShift);
+                mFreeX.clear();
+                mFreeY.clear();
+                for (uint32_t s = 0; s < strataPerSub; s++)
+                {
+                    uint32_t x = sub.x * strataPerSub + s;
+                    uint32_t y = sub.y * strataPerSub + s;
+                    if (mOccupied[intervalIndex(glm::uvec2(x, 0), mLog2N)] == 0) mFreeX.push_back(x);
+                    if (mOccupied[intervalIndex(glm::uvec2(0, y), 0)] == 0) mFreeY.push_back(y);
+                }
+                if (mFreeX.empty() || mFreeY.empty()) return false;
+
+                // Try a few random candidates first, then search all of them
+                glm::uvec2 strata;
+                bool found = false;
+                for (uint32_t c = 0; c < kRandomCandidates && found == false; c++)
+                {
+                    strata = glm::uvec2(mFreeX[randomIndex(mFreeX.size())], mFreeY[randomIndex(mFreeY.size())]);
+                    found = isFree(strata);
+                }
+                if (found == false)
+                {
+                    uint32_t validCount = 0;
+                    for (uint32_t x : mFreeX)
+                    {
+                        for (uint32_t y : mFreeY)
+                        {
+                            // Reservoir sampling picks uniformly among the valid candidates
+                            if (isFree(glm::uvec2(x, y)) && randomIndex(++validCount) == 0) strata = glm::uvec2(x, y);
+                        }
+                    }
+                    if (validCount == 0) return false;
+                }
+
+                setOccupied(strata);
+                mSamples.push_back((strata << stratumShift) | glm::uvec2(randomBits(stratumShift), randomBits(stratumShift)));
+                return true;
+            }
+
+            uint32_t randomBits(uint32_t bits)
+            {
+                return bits ? uint32_t(mRng()) >> (32 - bits) : 0;
+            }
+
+            uint32_t randomIndex(size_t count)
+            {
+                return std::uniform_int_distribution<uint32_t>(0, uint32_t(count) - 1)(mRng);
+            }
+
+            std::mt19937 mRng;
+            std::vector<glm::uvec2> mSamples;
+            std::vector<uint8_t> mOccupied;
+            std::vector<uint32_t> mFreeX, mFreeY;
+            uint32_t mLog2N = 0;
+        };
+    }
+
+    vec2 LowDiscrepancySequence::sobol(uint32_t index)
+    {
+        return vec2(toFloat(reverseBits(index)), toFloat(sobolY(index)));
+    }
+
+    uint32_t LowDiscrepancySequence::owenScramble(uint32_t x, uint32_t seed)
+    {
+        return reverseBits(laineKarras(reverseBits(x), seed));
+    }
+
+    vec2 LowDiscrepancySequence::owenScrambledSobol(uint32_t index, uint32_t seed)
+    {
+        // Shuffling the index with a nested uniform scramble keeps power-of-2 prefixes inside a single aligned block of the sequence, so they stay nets
+        const ScrambleSeeds seeds(seed);
+        index = owenScramble(index, seeds.index);
+        return vec2(toFloat(owenScramble(reverseBits(index), seeds.x)), toFloat(owenScramble(sobolY(index), seeds.y)));
+    }
+
+    vec2 LowDiscrepancySequence::r2(uint32_t index, uint32_t seed)
+    {
+        return vec2(toFloat(r2Offset(seed, 0) + index * kR2Alpha[0]), toFloat(r2Offset(seed, 1) + index * kR2Alpha[1]));
+    }
+
+    void LowDiscrepancySequence::generate(Type type, uint32_t first, uint32_t count, uint32_t seed, vec2* pOut)
+    {
+        if (type == Type::PMJ02)
+        {
+            std::vector<vec2> points = generatePMJ02(first + count, seed);
+            std::copy(points.begin() + first, points.end(), pOut);
+            return;
+        }
+
+        uint32_t i = 0;
+#ifdef FALCOR_USE_SSE2
+        i = generateSse(type, first, count, seed, pOut);
+#endif
+        for (; i < count; i++)
+        {
+            switch (type)
+            {
+            case Type::Sobol:
+                pOut[i] = sobol(first + i);
+                break;
+            case Type::OwenScrambledSobol:
+                pOut[i] = owenScrambledSobol(first + i, seed);
+                break;
+            case Type::R2:
+                pOut[i] = r2(first + i, seed);
+                break;
+            default:
+                should_not_get_here();
+            }
+        }
+    }
+
+    std::vector<vec2> LowDiscrepancySequence::generatePMJ02(uint32_t count, uint32_t seed)
+    {
+        if (count == 0) return {};
+        return Pmj02Builder(seed).build(count);
+    }
+}
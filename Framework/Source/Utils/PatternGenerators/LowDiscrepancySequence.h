@@ -0,0 +1,85 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+
+namespace Falcor
+{
+    /** 2D low-discrepancy sequences in [0, 1)^2.
+        All generators are deterministic for a given seed. Coordinates have 24 bits of precision, so they are exact as floats and never round up to 1.
+        The batch generator processes four indices at a time with SSE2 where available.
+    */
+    class LowDiscrepancySequence
+    {
+    public:
+        enum class Type
+        {
+            Sobol,                  ///< The first two dimensions of the Sobol sequence, a (0,2)-sequence
+            OwenScrambledSobol,     ///< Sobol with hash-based Owen scrambling and index shuffling. Every power-of-2 prefix is a (0,m,2)-net and different seeds are decorrelated.
+            R2,                     ///< Additive recurrence based on the plastic number. Works well for any sample count, not only powers of 2.
+            PMJ02,                  ///< Progressive multi-jittered (0,2) sequence. Every power-of-2 prefix is a (0,m,2)-net and the points are jittered inside their strata.
+        };
+
+        /** Get a single point of the Sobol sequence
+        */
+        static vec2 sobol(uint32_t index);
+
+        /** Get a single point of the Owen-scrambled Sobol sequence
+            \param[in] index Sample index
+            \param[in] seed Scrambling seed
+        */
+        static vec2 owenScrambledSobol(uint32_t index, uint32_t seed);
+
+        /** Get a single point of the R2 sequence
+            \param[in] index Sample index
+            \param[in] seed Seed of a toroidal shift applied to the sequence. 0 uses the standard start point of (0.5, 0.5).
+        */
+        static vec2 r2(uint32_t index, uint32_t seed = 0);
+
+        /** Generate consecutive points of a sequence
+            \param[in] type Sequence type
+            \param[in] first Index of the first point
+            \param[in] count Number of points to generate
+            \param[in] seed Seed of the sequence. Ignored for Type::Sobol.
+            \param[out] pOut Buffer of at least count points
+        */
+        static void generate(Type type, uint32_t first, uint32_t count, uint32_t seed, vec2* pOut);
+
+        /** Generate the first points of a PMJ02 sequence. Unlike the other sequences, PMJ02 points can't be computed independently, so the whole prefix is built.
+            Generation is roughly quadratic in the count, so large tables should be built once and kept.
+            \param[in] count Number of points. Must be at most 2^24.
+            \param[in] seed Seed of the random choices
+        */
+        static std::vector<vec2> generatePMJ02(uint32_t count, uint32_t seed);
+
+        /** Nested uniform (Owen) scrambling of a 32-bit fixed-point value, using the Laine-Karras hash.
+            Bit k of the result depends only on the bits of x above k, which preserves the stratification of (t,m,s)-nets.
+        */
+        static uint32_t owenScramble(uint32_t x, uint32_t seed);
+    };
+}
@@ -0,0 +1,376 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "PixelConversion.h"
+#include "Utils/Math/SimdVec.h"
+#include <cstring>
+
+namespace Falcor
+{
+    namespace PixelConversion
+    {
+        namespace
+        {
+            uint8_t toUnorm8(float c)
+            {
+                return (uint8_t)(std::min(std::max(c, 0.0f), 1.0f) * 255.0f + 0.5f);
+            }
+
+            void readPixel(Layout layout, const uint8_t* p, float c[4])
+            {
+                switch (layout)
+                {
+                case Layout::RGBA8:         for (uint32_t i = 0; i < 4; i++) c[i] = p[i] / 255.0f; break;
+                case Layout::BGRA8:         c[0] = p[2] / 255.0f; c[1] = p[1] / 255.0f; c[2] = p[0] / 255.0f; c[3] = p[3] / 255.0f; break;
+                case Layout::BGRX8:         c[0] = p[2] / 255.0f; c[1] = p[1] / 255.0f; c[2] = p[0] / 255.0f; c[3] = 1.0f; break;
+                case Layout::RGB8:          c[0] = p[0] / 255.0f; c[1] = p[1] / 255.0f; c[2] = p[2] / 255.0f; c[3] = 1.0f; break;
+                case Layout::BGR8:          c[0] = p[2] / 255.0f; c[1] = p[1] / 255.0f; c[2] = p[0] / 255.0f; c[3] = 1.0f; break;
+                case Layout::RGBA32Float:   std::memcpy(c, p, 4 * sizeof(float)); break;
+                default:                    should_not_get_here();
+                }
+            }
+
+            void writePixel(Layout layout, const float c[4], uint8_t* p)
+            {
+                switch (layout)
+                {
+                case Layout::RGBA8:         for (uint32_t i = 0; i < 4; i++) p[i] = toUnorm8(c[i]); break;
+                case Layout::BGRA8:         p[0] = toUnorm8(c[2]); p[1] = toUnorm8(c[1]); p[2] = toUnorm8(c[0]); p[3] = toUnorm8(c[3]); break;
+                case Layout::BGRX8:         p[0] = toUnorm8(c[2]); p[1] = toUnorm8(c[1]); p[2] = toUnorm8(c[0]); p[3] = 0xff; break;
+                case Layout::RGB8:          p[0] = toUnorm8(c[0]); p[1] = toUnorm8(c[1]); p[2] = toUnorm8(c[2]); break;
+                case Layout::BGR8:          p[0] = toUnorm8(c[2]); p[1] = toUnorm8(c[1]); p[2] = toUnorm8(c[0]); break;
+                case Layout::RGBA32Float:   std::memcpy(p, c, 4 * sizeof(float)); break;
+                default:                    should_not_get_here();
+                }
+            }
+
+            // Scalar versions of the kernels, used for the pixels left over after the SIMD loops
+            inline uint32_t swapRB(uint32_t v)
+            {
+                return (v & 0xff00ff00) | ((v & 0xff) << 16) | ((v >> 16) & 0xff);
+            }
+
+            inline uint32_t loadRGB8(const uint8_t* p)
+            {
+                return p[0] | (p[1] << 8) | (p[2] << 16) | 0xff000000;
+            }
+
+            inline uint32_t load32(const uint8_t* p)
+            {
+                uint32_t v;
+                std::memcpy(&v, p, sizeof(v));
+                return v;
+            }
+
+            inline void store32(uint8_t* p, uint32_t v)
+            {
+                std::memcpy(p, &v, sizeof(v));
+            }
+
+#ifdef FALCOR_USE_SSE2
+            inline __m128i swapRB(__m128i v)
+            {
+                const __m128i kMaskAG = _mm_set1_epi32(0xff00ff00);
+                const __m128i kMaskLow = _mm_set1_epi32(0xff);
+                __m128i ag = _mm_and_si128(v, kMaskAG);
+                __m128i r = _mm_slli_epi32(_mm_and_si128(v, kMaskLow), 16);
+                __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), kMaskLow);
+                return _mm_or_si128(ag, _mm_or_si128(r, b));
+            }
+
+            /** Expand four 3-byte pixels to 4 bytes, setting the 4th byte to 255. Reads 16 bytes from p.
+            */
+            inline __m128i expand3To4(const uint8_t* p)
+            {
+                __m128i v = _mm_loadu_si128((const __m128i*)p);
+                __m128i p01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+                __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+                return _mm_or_si128(_mm_unpacklo_epi64(p01, p23), _mm_set1_epi32(0xff000000));
+            }
+
+            /** Convert a float RGBA pixel to integers in [0, 255], using the same rounding as toUnorm8()
+            */
+            inline __m128i floatToUnorm8(__m128 v)
+            {
+                v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                v = _mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f));
+                return _mm_cvttps_epi32(v);
+            }
+#endif
+
+            template<bool swap, bool forceAlpha>
+            void convert4To4(const uint8_t* pSrc, uint8_t* pDst, uint32_t count)
+            {
+                uint32_t i = 0;
+#ifdef FALCOR_USE_SSE2
+                for (; i + 4 <= count; i += 4)
+                {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(pSrc + i * 4));
+                    if (swap) v = swapRB(v);
+                    if (forceAlpha) v = _mm_or_si128(v, _mm_set1_epi32(0xff000000));
+                    _mm_storeu_si128((__m128i*)(pDst + i * 4), v);
+                }
+#endif
+                for (; i < count; i++)
+                {
+                    uint32_t v = load32(pSrc + i * 4);
+                    if (swap) v = swapRB(v);
+                    if (forceAlpha) v |= 0xff000000;
+                    store32(pDst + i * 4, v);
+                }
+            }
+
+            template<bool swap>
+            void convert3To4(const uint8_t* pSrc, uint8_t* pDst, uint32_t count)
+            {
+                uint32_t i = 0;
+#ifdef FALCOR_USE_SSE2
+                // Each iteration reads 16 bytes, so stop while there are still 4 bytes left after the 4 pixels being converted
+                for (; i + 6 <= count; i += 4)
+                {
+                    __m128i v = expand3To4(pSrc + i * 3);
+                    if (swap) v = swapRB(v);
+                    _mm_storeu_si128((__m128i*)(pDst + i * 4), v);
+                }
+#endif
+                for (; i < count; i++)
+                {
+                    uint32_t v = loadRGB8(pSrc + i * 3);
+                    if (swap) v = swapRB(v);
+                    store32(pDst + i * 4, v);
+                }
+            }
+
+            template<bool swap>
+            void convertFloatTo8(const uint8_t* pSrc, uint8_t* pDst, uint32_t count)
+            {
+                const float* pSrcF = (const float*)pSrc;
+                uint32_t i = 0;
+#ifdef FALCOR_USE_SSE2
+                for (; i + 4 <= count; i += 4)
+                {
+                    __m128 f[4];
+                    for (uint32_t j = 0; j < 4; j++)
+                    {
+                        f[j] = _mm_loadu_ps(pSrcF + (i + j) * 4);
+                        if (swap) f[j] = _mm_shuffle_ps(f[j], f[j], _MM_SHUFFLE(3, 0, 1, 2));
+                    }
+                    __m128i lo = _mm_packs_epi32(floatToUnorm8(f[0]), floatToUnorm8(f[1]));
+                    __m128i hi = _mm_packs_epi32(floatToUnorm8(f[2]), floatToUnorm8(f[3]));
+                    _mm_storeu_si128((__m128i*)(pDst + i * 4), _mm_packus_epi16(lo, hi));
+                }
+#endif
+                for (; i < count; i++)
+                {
+                    const float* c = pSrcF + i * 4;
+                    uint8_t* p = pDst + i * 4;
+                    p[0] = toUnorm8(c[swap ? 2 : 0]);
+                    p[1] = toUnorm8(c[1]);
+                    p[2] = toUnorm8(c[swap ? 0 : 2]);
+                    p[3] = toUnorm8(c[3]);
+                }
+            }
+
+            void convert8ToFloat(const uint8_t* pSrc, uint8_t* pDst, uint32_t count)
+            {
+                float* pDstF = (float*)pDst;
+                uint32_t i = 0;
+#ifdef FALCOR_USE_SSE2
+                const __m128i zero = _mm_setzero_si128();
+                const __m128 scale = _mm_set1_ps(255.0f);
+                for (; i + 4 <= count; i += 4)
+                {
+                    __m128i v = _mm_loadu_si128((const __m128i*)(pSrc + i * 4));
+                    __m128i lo = _mm_unpacklo_epi8(v, zero);
+                    __m128i hi = _mm_unpackhi_epi8(v, zero);
+                    // Divide rather than multiply by the reciprocal so the results match readPixel() exactly
+                    _mm_storeu_ps(pDstF + i * 4 + 0, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+                    _mm_storeu_ps(pDstF + i * 4 + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+                    _mm_storeu_ps(pDstF + i * 4 + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+                    _mm_storeu_ps(pDstF + i * 4 + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+                }
+#endif
+                for (uint32_t j = i * 4; j < count * 4; j++)
+                {
+                    pDstF[j] = pSrc[j] / 255.0f;
+                }
+            }
+
+            // Polyphase filter weights for one output coordinate. Filters are 2 taps wide for even source sizes and 3 for odd ones.
+            void getDownscaleWeights(uint32_t srcSize, uint32_t dstSize, uint32_t i, uint32_t& taps, uint32_t w[3])
+            {
+                taps = (srcSize == 1) ? 1 : ((srcSize & 1) == 0) ? 2 : 3;
+                w[0] = w[1] = w[2] = dstSize;
+                if (taps == 3)
+                {
+                    w[0] = dstSize - i;
+                    w[2] = i + 1;
+                }
+            }
+        }
+
+        uint32_t getPixelSize(Layout layout)
+        {
+            switch (layout)
+            {
+            case Layout::RGB8:
+            case Layout::BGR8:
+                return 3;
+            case Layout::RGBA32Float:
+                return 16;
+            default:
+                return 4;
+            }
+        }
+
+        template<> void convertPixels<Layout::RGBA8, Layout::BGRA8>(const void* pSrc, void* pDst, uint32_t count) { convert4To4<true, false>((const uint8_t*)pSrc, (uint8_t*)pDst, count); }
+        template<> void convertPixels<Layout::BGRA8, Layout::RGBA8>(const void* pSrc, void* pDst, uint32_t count) { convert4To4<true, false>((const uint8_t*)pSrc, (uint8_t*)pDst, count); }
+        template<> void convertPixels<Layout::RGBA8, Layout::BGRX8>(const void* pSrc, void* pDst, uint32_t count) { convert4To4<true, true>((const uint8_t*)pSrc, (uint8_t*)pDst, count); }
+        template<> void convertPixels<Layout::RGB8, Layout::RGBA8>(const void* pSrc, void* pDst, uint32_t count) { convert3To4<false>((const uint8_t*)pSrc, (uint8_t*)pDst, count); }
+        template<> void convertPixels<Layout::BGR8, Layout::BGRA8>(const void* pSrc, void* pDst, uint32_t count) { convert3To4<false>((const uint8_t*)pSrc, (uint8_t*)pDst, count); }
+        template<> void convertPixels<Layout::RGB8, Layout::BGRA8>(const void* pSrc, void* pDst, uint32_t count) { convert3To4<true>((const uint8_t*)pSrc, (uint8_t*)pDst, count); }
+        template<> void convertPixels<Layout::BGR8, Layout::RGBA8>(const void* pSrc, void* pDst, uint32_t count) { convert3To4<true>((const uint8_t*)pSrc, (uint8_t*)pDst, count); }
+        template<> void convertPixels<Layout::RGBA32Float, Layout::RGBA8>(const void* pSrc, void* pDst, uint32_t count) { convertFloatTo8<false>((const uint8_t*)pSrc, (uint8_t*)pDst, count); }
+        template<> void convertPixels<Layout::RGBA32Float, Layout::BGRA8>(const void* pSrc, void* pDst, uint32_t count) { convertFloatTo8<true>((const uint8_t*)pSrc, (uint8_t*)pDst, count); }
+        template<> void convertPixels<Layout::RGBA8, Layout::RGBA32Float>(const void* pSrc, void* pDst, uint32_t count) { convert8ToFloat((const uint8_t*)pSrc, (uint8_t*)pDst, count); }
+
+        bool convertPixels(Layout src, Layout dst, const void* pSrc, void* pDst, uint32_t count)
+        {
+#define convert_pair(s, d) if (src == Layout::s && dst == Layout::d) { convertPixels<Layout::s, Layout::d>(pSrc, pDst, count); return true; }
+            convert_pair(RGBA8, BGRA8);
+            convert_pair(BGRA8, RGBA8);
+            convert_pair(RGBA8, BGRX8);
+            convert_pair(RGB8, RGBA8);
+            convert_pair(BGR8, BGRA8);
+            convert_pair(RGB8, BGRA8);
+            convert_pair(BGR8, RGBA8);
+            convert_pair(RGBA32Float, RGBA8);
+            convert_pair(RGBA32Float, BGRA8);
+            convert_pair(RGBA8, RGBA32Float);
+#undef convert_pair
+
+            convertPixelsGeneric(src, dst, pSrc, pDst, count);
+            return false;
+        }
+
+        void convertPixelsGeneric(Layout src, Layout dst, const void* pSrc, void* pDst, uint32_t count)
+        {
+            const uint32_t srcSize = getPixelSize(src);
+            const uint32_t dstSize = getPixelSize(dst);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                float c[4];
+                readPixel(src, (const uint8_t*)pSrc + i * srcSize, c);
+                writePixel(dst, c, (uint8_t*)pDst + i * dstSize);
+            }
+        }
+
+        bool downscale2xGeneric(const void* pSrc, uint32_t width, uint32_t height, void* pDst)
+        {
+            const uint64_t area = uint64_t(width) * height;
+            if (area <= 1) return false;
+
+            const uint32_t dstWidth = std::max(width >> 1, 1u);
+            const uint32_t dstHeight = std::max(height >> 1, 1u);
+            const uint8_t* pSrc8 = (const uint8_t*)pSrc;
+            uint8_t* pDst8 = (uint8_t*)pDst;
+
+            for (uint32_t y = 0; y < dstHeight; y++)
+            {
+                uint32_t th, wy[3];
+                getDownscaleWeights(height, dstHeight, y, th, wy);
+
+                for (uint32_t x = 0; x < dstWidth; x++)
+                {
+                    uint32_t tw, wx[3];
+                    getDownscaleWeights(width, dstWidth, x, tw, wx);
+
+                    uint64_t sum[4] = {};
+                    for (uint32_t yy = 0; yy < th; yy++)
+                    {
+                        const uint8_t* pRow = pSrc8 + ((size_t(y) * 2 + yy) * width + x * 2) * 4;
+                        for (uint32_t xx = 0; xx < tw; xx++)
+                        {
+                            uint64_t weight = uint64_t(wx[xx]) * wy[yy];
+                            for (uint32_t c = 0; c < 4; c++) sum[c] += pRow[xx * 4 + c] * weight;
+                        }
+                    }
+
+                    uint8_t* p = pDst8 + (size_t(y) * dstWidth + x) * 4;
+                    for (uint32_t c = 0; c < 4; c++) p[c] = (uint8_t)((sum[c] + (area >> 1)) / area);
+                }
+            }
+            return true;
+        }
+
+        bool downscale2x(const void* pSrc, uint32_t width, uint32_t height, void* pDst)
+        {
+#ifdef FALCOR_USE_SSE2
+            // For even dimensions the polyphase filter reduces to a 2x2 box filter with rounding
+            if ((width & 1) == 0 && (height & 1) == 0 && width > 0 && height > 0)
+            {
+                const uint32_t dstWidth = width / 2;
+                const uint32_t dstHeight = height / 2;
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i round = _mm_set1_epi16(2);
+
+                for (uint32_t y = 0; y < dstHeight; y++)
+                {
+                    const uint8_t* pRow0 = (const uint8_t*)pSrc + size_t(y) * 2 * width * 4;
+                    const uint8_t* pRow1 = pRow0 + size_t(width) * 4;
+                    uint8_t* pDstRow = (uint8_t*)pDst + size_t(y) * dstWidth * 4;
+
+                    uint32_t x = 0;
+                    for (; x + 2 <= dstWidth; x += 2)
+                    {
+                        __m128i r0 = _mm_loadu_si128((const __m128i*)(pRow0 + x * 8));
+                        __m128i r1 = _mm_loadu_si128((const __m128i*)(pRow1 + x * 8));
+                        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r1, zero));
+                        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r1, zero));
+                        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+                        __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), round), 2);
+                        _mm_storel_epi64((__m128i*)(pDstRow + x * 4), _mm_packus_epi16(sum, sum));
+                    }
+
+                    for (; x < dstWidth; x++)
+                    {
+                        for (uint32_t c = 0; c < 4; c++)
+                        {
+                            uint32_t sum = pRow0[x * 8 + c] + pRow0[x * 8 + 4 + c] + pRow1[x * 8 + c] + pRow1[x * 8 + 4 + c];
+                            pDstRow[x * 4 + c] = (uint8_t)((sum + 2) >> 2);
+                        }
+                    }
+                }
+                return true;
+            }
+#endif
+            return downscale2xGeneric(pSrc, width, height, pDst);
+        }
+    }
+}
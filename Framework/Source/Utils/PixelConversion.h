@@ -0,0 +1,88 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+
+namespace Falcor
+{
+    /** CPU pixel format conversion and downscaling of tightly packed scanlines.
+        The common conversions have SSE2 kernels. The kernel for a conversion is selected at compile time when calling
+        convertPixels<Src, Dst>(), and at runtime when calling convertPixels(src, dst, ...), which falls back to a per-pixel path for
+        pairs that don't have a kernel.
+    */
+    namespace PixelConversion
+    {
+        /** Memory layout of a pixel
+        */
+        enum class Layout
+        {
+            RGBA8,          ///< 4 bytes, R first
+            BGRA8,          ///< 4 bytes, B first
+            BGRX8,          ///< 4 bytes, B first. Alpha is written as 255 and ignored when reading.
+            RGB8,           ///< 3 bytes, R first. Alpha is read as 255.
+            BGR8,           ///< 3 bytes, B first. Alpha is read as 255.
+            RGBA32Float,    ///< 16 bytes. 8-bit destinations are clamped to [0, 1] and rounded to nearest.
+        };
+
+        /** Get the size of a pixel in bytes
+        */
+        uint32_t getPixelSize(Layout layout);
+
+        /** Convert pixels between two layouts, using the kernel of the pair. Only pairs with a specialized kernel can be instantiated:
+            RGBA8 <-> BGRA8, RGBA8 -> BGRX8, RGB8/BGR8 -> RGBA8/BGRA8, RGBA32Float -> RGBA8/BGRA8 and RGBA8 -> RGBA32Float.
+            Conversions between 4-byte layouts can be done in place.
+            \param[in] pSrc The source pixels
+            \param[out] pDst The destination pixels
+            \param[in] count Number of pixels to convert
+        */
+        template<Layout Src, Layout Dst>
+        void convertPixels(const void* pSrc, void* pDst, uint32_t count);
+
+        /** Convert pixels between two layouts. Uses the specialized kernel if the pair has one, otherwise converts one pixel at a time.
+            \return Whether a specialized kernel was used
+        */
+        bool convertPixels(Layout src, Layout dst, const void* pSrc, void* pDst, uint32_t count);
+
+        /** Convert pixels one at a time through an RGBA intermediate. This is the reference the specialized kernels are checked against.
+        */
+        void convertPixelsGeneric(Layout src, Layout dst, const void* pSrc, void* pDst, uint32_t count);
+
+        /** Downscale a tightly packed 4-byte-per-pixel image (RGBA8, BGRA8 or BGRX8) by 2 in each dimension.
+            Odd dimensions use the polyphase filter from the NVIDIA "Non-Power-of-Two Mipmapping" whitepaper, so no source texels are dropped.
+            \param[in] pSrc The source image
+            \param[in] width Source width
+            \param[in] height Source height
+            \param[out] pDst The destination image. Must hold max(width / 2, 1) * max(height / 2, 1) pixels.
+            \return false if the image is 1x1 or smaller, otherwise true
+        */
+        bool downscale2x(const void* pSrc, uint32_t width, uint32_t height, void* pDst);
+
+        /** Same as downscale2x(), without the SIMD kernel. Used as a reference.
+        */
+        bool downscale2xGeneric(const void* pSrc, uint32_t width, uint32_t height, void* pDst);
+    }
+}
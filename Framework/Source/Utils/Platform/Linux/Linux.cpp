@@ -34,6 +34,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/ptrace.h>
+#include <sys/inotify.h>
+#include <unistd.h>
 #include <gtk/gtk.h>
 #include <fstream>
 #include <fcntl.h>
@@ -42,6 +44,8 @@
 #include <algorithm>
 #include <experimental/filesystem>
 #include <dlfcn.h>
+#include <mutex>
+#include <unordered_map>
 namespace fs = std::experimental::filesystem;
 
 namespace Falcor
@@ -189,16 +193,145 @@ namespace Falcor
         return (stat(pathname, &sb) == 0) && S_ISDIR(sb.st_mode);
     }
     
-    void monitorFileUpdates(const std::string& filePath, const std::function<void()>& callback)
+    /** A single inotify instance shared by all monitored files.
+        Watches are placed on the parent directories rather than on the files themselves, so that editors which save by writing a temporary
+        file and renaming it over the original are handled the same way as in-place writes. Events are read on one background thread.
+    */
+    class FileMonitor
     {
-        (void)filePath; (void)callback;
-        should_not_get_here();
+    public:
+        static FileMonitor& get()
+        {
+            // Intentionally never destroyed, the reader thread may still be blocked in read() during static destruction
+            static FileMonitor* pMonitor = new FileMonitor;
+            return *pMonitor;
+        }
+
+        bool add(const std::string& filePath, const std::function<void()>& callback)
+        {
+            if (mFd < 0) return false;
+
+            fs::path path(filePath);
+            std::string dir = path.has_parent_path() ? path.parent_path().string() : ".";
+            std::string name = path.filename().string();
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto dirIt = mDirectories.find(dir);
+            if (dirIt == mDirectories.end())
+            {
+                int wd = inotify_add_watch(mFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+                if (wd < 0)
+                {
+                    logWarning("Can't monitor file updates in '" + dir + "'. inotify_add_watch() failed with error " + std::to_string(errno));
+                    return false;
+                }
+                mWatchToDirectory[wd] = dir;
+                dirIt = mDirectories.emplace(dir, WatchedDirectory{ wd, {} }).first;
+            }
+            dirIt->second.files[name] = callback;
+
+            if (mThreadStarted == false)
+            {
+                std::thread(&FileMonitor::readEvents, this).detach();
+                mThreadStarted = true;
+            }
+            return true;
+        }
+
+        void remove(const std::string& filePath)
+        {
+            fs::path path(filePath);
+            std::string dir = path.has_parent_path() ? path.parent_path().string() : ".";
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto dirIt = mDirectories.find(dir);
+            if (dirIt == mDirectories.end()) return;
+
+            dirIt->second.files.erase(path.filename().string());
+            if (dirIt->second.files.empty())
+            {
+                inotify_rm_watch(mFd, dirIt->second.wd);
+                mWatchToDirectory.erase(dirIt->second.wd);
+                mDirectories.erase(dirIt);
+            }
+        }
+
+    private:
+        FileMonitor()
+        {
+            mFd = inotify_init1(IN_CLOEXEC);
+            if (mFd < 0)
+            {
+                logWarning("inotify_init1() failed with error " + std::to_string(errno) + ". File updates will not be monitored.");
+            }
+        }
+
+        struct WatchedDirectory
+        {
+            int wd;
+            std::unordered_map<std::string, std::function<void()>> files;
+        };
+
+        void readEvents()
+        {
+            // Large enough for a burst of events. inotify never splits an event across reads.
+            alignas(inotify_event) char buffer[16 * 1024];
+            std::vector<std::function<void()>> callbacks;
+
+            while (true)
+            {
+                ssize_t bytesRead = read(mFd, buffer, sizeof(buffer));
+                if (bytesRead <= 0)
+                {
+                    if (bytesRead < 0 && errno == EINTR) continue;
+                    logWarning("Failed to read file update events. Error " + std::to_string(errno));
+                    return;
+                }
+
+                // Collect the callbacks under the lock, but call them outside of it so they can add or remove files
+                callbacks.clear();
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    for (ssize_t offset = 0; offset < bytesRead;)
+                    {
+                        const inotify_event* pEvent = reinterpret_cast<const inotify_event*>(buffer + offset);
+                        offset += sizeof(inotify_event) + pEvent->len;
+
+                        if (pEvent->len == 0) continue;
+                        auto wdIt = mWatchToDirectory.find(pEvent->wd);
+                        if (wdIt == mWatchToDirectory.end()) continue;
+
+                        const auto& files = mDirectories.at(wdIt->second).files;
+                        auto fileIt = files.find(pEvent->name);
+                        if (fileIt != files.end() && fileIt->second)
+                        {
+                            callbacks.push_back(fileIt->second);
+                        }
+                    }
+                }
+
+                for (const auto& callback : callbacks)
+                {
+                    callback();
+                }
+            }
+        }
+
+        int mFd = -1;
+        bool mThreadStarted = false;
+        std::mutex mMutex;
+        std::unordered_map<std::string, WatchedDirectory> mDirectories;
+        std::unordered_map<int, std::string> mWatchToDirectory;
+    };
+
+    bool monitorFileUpdates(const std::string& filePath, const std::function<void()>& callback)
+    {
+        return FileMonitor::get().add(filePath, callback);
     }
 
     void closeSharedFile(const std::string& filePath)
     {
-        (void)filePath;
-        should_not_get_here();
+        FileMonitor::get().remove(filePath);
     }
 
     std::string getTempFilename()
@@ -29,6 +29,9 @@
 #include "Utils/Platform/OS.h"
 #include "Utils/StringUtils.h"
 #include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <experimental/filesystem>
 namespace fs = std::experimental::filesystem;
 
@@ -75,25 +78,176 @@ namespace Falcor
         return gDataDirectories;
     }
 
+    namespace
+    {
+        /** Speeds up findFileInDataDirectories().
+            Instead of querying the file system for every data directory, lookups are answered from the listings of the directories that were searched.
+            Each directory is listed once, the first time a lookup touches it. Results of previous lookups, including misses, are stored as well.
+        */
+        struct DataDirectoryCache
+        {
+            struct Entry
+            {
+                std::string fullpath;
+                uint32_t probes;    // Number of candidate paths that were checked to find the file
+            };
+
+            std::mutex mutex;
+            std::unordered_map<std::string, std::unordered_set<std::string>> directories;   // Directory -> names of its entries
+            std::unordered_map<std::string, Entry> resolved;                               // Requested filename -> result
+            std::unordered_set<std::string> missing;                                       // Requested filenames which weren't found
+
+            uint64_t lookups = 0;
+            uint64_t repeatedLookups = 0;
+            uint64_t avoidedQueries = 0;
+            uint64_t directoryScans = 0;
+            uint64_t staleIndexHits = 0;
+        };
+
+        DataDirectoryCache gDataDirectoryCache;
+
+        std::string getCacheKey(const std::string& path)
+        {
+            std::string key = replaceSubstring(path, "\\", "/");
+#ifdef _WIN32
+            // The file system is case-insensitive
+            std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+#endif
+            return key;
+        }
+
+        const std::unordered_set<std::string>& getDirectoryEntries(const std::string& dir)
+        {
+            auto& cache = gDataDirectoryCache;
+            auto it = cache.directories.find(dir);
+            if (it != cache.directories.end()) return it->second;
+
+            // Nonexistent directories are stored as well, with no entries
+            std::unordered_set<std::string> entries;
+            std::error_code ec;
+            for (fs::directory_iterator i(dir.empty() ? "." : dir, ec), end; !ec && i != end; i.increment(ec))
+            {
+                entries.insert(getCacheKey(i->path().filename().string()));
+            }
+            cache.directoryScans++;
+            return cache.directories.emplace(dir, std::move(entries)).first->second;
+        }
+
+        /** Split a path into the directory and the name of the entry. The path must use forward slashes.
+        */
+        void splitPath(const std::string& path, std::string& dir, std::string& name)
+        {
+            size_t slash = path.find_last_of('/');
+            name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+            dir = (slash == std::string::npos) ? "" : path.substr(0, slash);
+            if (slash == 0 || (dir.size() && dir.back() == ':')) dir += '/';    // Root of the file system or a drive
+        }
+
+        /** Check if a file or directory exists using the directory listings. The path must use forward slashes.
+        */
+        bool existsInDirectoryIndex(const std::string& path)
+        {
+            std::string dir, name;
+            splitPath(path, dir, name);
+
+            // Listings don't contain the special entries
+            if (name.empty() || name == "." || name == "..") return doesFileExist(path);
+
+            return getDirectoryEntries(getCacheKey(dir)).count(getCacheKey(name)) != 0;
+        }
+
+        bool findFileInDirectoryIndex(const std::string& filename, std::string& fullpath, uint32_t& probes)
+        {
+            std::string path = replaceSubstring(filename, "\\", "/");
+            probes = 1;
+            if (existsInDirectoryIndex(path))
+            {
+                fullpath = canonicalizeFilename(filename);
+                return true;
+            }
+
+            for (const auto& dir : gDataDirectories)
+            {
+                probes++;
+                if (existsInDirectoryIndex(replaceSubstring(dir, "\\", "/") + '/' + path))
+                {
+                    fullpath = canonicalizeFilename(dir + '/' + filename);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /** Search the file system directly. On success, candidate is the path that was found, before canonicalization.
+        */
+        bool findFileInFileSystem(const std::string& filename, std::string& fullpath, std::string& candidate)
+        {
+            // Check if this is an absolute path
+            if (doesFileExist(filename))
+            {
+                candidate = filename;
+                fullpath = canonicalizeFilename(filename);
+                return true;
+            }
+
+            for (const auto& Dir : gDataDirectories)
+            {
+                candidate = Dir + '/' + filename;
+                fullpath = canonicalizeFilename(candidate);
+                if (doesFileExist(fullpath))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    }
+
     void addDataDirectory(const std::string& dataDir)
     {
+        std::lock_guard<std::mutex> lock(gDataDirectoryCache.mutex);
+
         //Insert unique elements
         if (std::find(gDataDirectories.begin(), gDataDirectories.end(), dataDir) == gDataDirectories.end())
         {
             gDataDirectories.push_back(dataDir);
+            gDataDirectoryCache.resolved.clear();
+            gDataDirectoryCache.missing.clear();
         }
     }
 
     void removeDataDirectory(const std::string& dataDir)
     {
-        //Insert unique elements
+        std::lock_guard<std::mutex> lock(gDataDirectoryCache.mutex);
+
         auto it = std::find(gDataDirectories.begin(), gDataDirectories.end(), dataDir);
         if (it != gDataDirectories.end())
         {
             gDataDirectories.erase(it);
+            gDataDirectoryCache.resolved.clear();
+            gDataDirectoryCache.missing.clear();
         }
     }
 
+    void clearDataDirectoryCache()
+    {
+        std::lock_guard<std::mutex> lock(gDataDirectoryCache.mutex);
+        gDataDirectoryCache.directories.clear();
+        gDataDirectoryCache.resolved.clear();
+        gDataDirectoryCache.missing.clear();
+    }
+
+    void logDataDirectoryCacheStats()
+    {
+        std::lock_guard<std::mutex> lock(gDataDirectoryCache.mutex);
+        const auto& cache = gDataDirectoryCache;
+        std::string msg = "Data directory lookups: " + std::to_string(cache.lookups) + " (" + std::to_string(cache.repeatedLookups) + " repeated). ";
+        msg += "Avoided " + std::to_string(cache.avoidedQueries) + " file system queries using " + std::to_string(cache.directoryScans) + " directory scans";
+        if (cache.staleIndexHits) msg += ". " + std::to_string(cache.staleIndexHits) + " lookups found files created after their directory was indexed";
+        logInfo(msg + ".");
+    }
+
     std::string canonicalizeFilename(const std::string& filename)
     {
         fs::path path(replaceSubstring(filename, "\\", "/"));
@@ -114,23 +268,49 @@ namespace Falcor
             bInit = true;
         }
 
-        // Check if this is an absolute path
-        if (doesFileExist(filename))
+        std::lock_guard<std::mutex> lock(gDataDirectoryCache.mutex);
+        auto& cache = gDataDirectoryCache;
+        cache.lookups++;
+
+        auto it = cache.resolved.find(filename);
+        if (it != cache.resolved.end())
         {
-            fullpath = canonicalizeFilename(filename);
+            cache.repeatedLookups++;
+            cache.avoidedQueries += it->second.probes;
+            fullpath = it->second.fullpath;
             return true;
         }
+        if (cache.missing.count(filename))
+        {
+            cache.repeatedLookups++;
+            cache.avoidedQueries += (uint32_t)gDataDirectories.size() + 1;
+            return false;
+        }
 
-        for (const auto& Dir : gDataDirectories)
+        uint32_t probes;
+        bool found = findFileInDirectoryIndex(filename, fullpath, probes);
+        if (found)
+        {
+            cache.avoidedQueries += probes;
+        }
+        else
         {
-            fullpath = canonicalizeFilename(Dir + '/' + filename);
-            if (doesFileExist(fullpath))
+            // Directories are only listed once, so files created after that are missing from the index. Confirm misses on the file system.
+            std::string candidate;
+            found = findFileInFileSystem(filename, fullpath, candidate);
+            if (found)
             {
-                return true;
+                // Only the listing of the directory which contains the file is outdated
+                std::string dir, name;
+                splitPath(replaceSubstring(candidate, "\\", "/"), dir, name);
+                cache.directories.erase(getCacheKey(dir));
+                cache.staleIndexHits++;
             }
         }
 
-        return false;
+        if (found) cache.resolved[filename] = { fullpath, probes };
+        else cache.missing.insert(filename);
+        return found;
     }
 
     bool findAvailableFilename(const std::string& prefix, const std::string& directory, const std::string& extension, std::string& filename)
@@ -85,12 +85,23 @@ namespace Falcor
     MsgBoxButton msgBox(const std::string& msg, MsgBoxType mbType = MsgBoxType::Ok);
 
     /** Finds a file in one of the media directories. The arguments must not alias.
+        Lookups are answered from a cache of the directory contents. Files which are created after their directory was first searched are still found, but
+        a file which was deleted after it was found will keep resolving to its old path, and a file which wasn't found stays missing, until
+        clearDataDirectoryCache() is called.
         \param[in] filename The file to look for
         \param[in] fullPath If the file was found, the full path to the file. If the file wasn't found, this is invalid.
         \return true if the file was found, otherwise false
     */
     bool findFileInDataDirectories(const std::string& filename, std::string& fullPath);
 
+    /** Clear the cache used by findFileInDataDirectories(). Call this after deleting or moving files in the data directories, or after creating files which were looked up before.
+    */
+    void clearDataDirectoryCache();
+
+    /** Log statistics about findFileInDataDirectories(), including the number of file system queries avoided by its cache.
+    */
+    void logDataDirectoryCacheStats();
+
     /** Given a filename, returns the shortest possible path to the file relative to the data directories.
         If the file is not relative to the data directories, return the original filename
     */
@@ -134,12 +145,15 @@ namespace Falcor
     bool isDirectoryExists(const std::string& filename);
     
     /** Open watch thread for file changes and call callback when the file is written to.
+        The callback is called from a background thread, possibly more than once per save. Use FileWatcher to get coalesced notifications on the main thread.
+        Only one callback per file is supported.
         \param[in] full path to the file to watch for changes
         \param[in] callback function
+        \return false if the file can't be monitored, true otherwise
     */
-    void monitorFileUpdates(const std::string& filePath, const std::function<void()>& callback = {});
+    bool monitorFileUpdates(const std::string& filePath, const std::function<void()>& callback = {});
 
-    /** Close watch thread for file changes
+    /** Close watch thread for file changes. On Windows each file has its own thread, which is joined here.
         \param[in] full path to the file that was being watched for changes
     */
     void closeSharedFile(const std::string& filePath);
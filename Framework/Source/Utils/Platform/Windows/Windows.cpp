@@ -346,100 +346,106 @@ namespace Falcor
         CloseHandle((HANDLE)processID);
     }
 
-    static std::unordered_map<std::string, std::pair<std::thread, bool> > fileThreads;
-
-    static void checkFileModifiedStatus(const std::string& filePath, const std::function<void()>& callback)
+    namespace
     {
-        std::string fileName = getFilenameFromPath(filePath);
-        std::string dir = getDirectoryFromFile(filePath);
-        
-        HANDLE hFile = CreateFileA(dir.c_str(), GENERIC_READ | FILE_LIST_DIRECTORY,
-            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
-        assert(hFile != INVALID_HANDLE_VALUE);
+        /** Watches the directory of a file on a background thread. The thread waits for either a change or the stop event, so it can be joined.
+        */
+        struct FileMonitor
+        {
+            std::thread thread;
+            HANDLE hDir = INVALID_HANDLE_VALUE;
+            HANDLE hStopEvent = nullptr;
+        };
 
-        // overlapped struct requires unique event handle to be valid
-        OVERLAPPED overlapped{};
+        std::unordered_map<std::string, std::unique_ptr<FileMonitor>> gFileMonitors;
 
-        while (true)
+        void checkFileModifiedStatus(FileMonitor* pMonitor, const std::string& filePath, const std::function<void()>& callback)
         {
-            size_t offset = 0;
-            uint32_t bytesReturned = 0;
-            std::vector<uint32_t> buffer;
-            buffer.resize(1024);
+            std::string fileName = getFilenameFromPath(filePath);
 
-            if (!ReadDirectoryChangesW(hFile, buffer.data(), static_cast<uint32_t>(sizeof(uint32_t) * buffer.size()), FALSE,
-                FILE_NOTIFY_CHANGE_LAST_WRITE, 0, &overlapped, nullptr))
-            {
-                logError("Failed to read directory changes for shared file.");
-                CloseHandle(hFile);
-                return;
-            }
+            // overlapped struct requires unique event handle to be valid
+            OVERLAPPED overlapped{};
+            overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+            HANDLE events[2] = { overlapped.hEvent, pMonitor->hStopEvent };
+            std::vector<uint32_t> buffer(1024);
 
-            if (!GetOverlappedResult(hFile, &overlapped, (LPDWORD)&bytesReturned, true))
+            while (true)
             {
-                logError("Failed to read directory changes for shared file.");
-                CloseHandle(hFile);
-                return;
-                
-            }
-
-            // don't check for another overlapped result if main thread is closed
-            if (!fileThreads.at(filePath).second)
-            {
-                break;
-            }
-
-            if (!bytesReturned) continue;
+                ResetEvent(overlapped.hEvent);
+                if (!ReadDirectoryChangesW(pMonitor->hDir, buffer.data(), static_cast<uint32_t>(sizeof(uint32_t) * buffer.size()), FALSE,
+                    FILE_NOTIFY_CHANGE_LAST_WRITE, 0, &overlapped, nullptr))
+                {
+                    logError("Failed to read directory changes for shared file.");
+                    break;
+                }
 
-            while (offset < buffer.size())
-            {
-                _FILE_NOTIFY_INFORMATION* pNotifyInformation = reinterpret_cast<_FILE_NOTIFY_INFORMATION*>(buffer.data());
-                std::string currentFileName;
-                currentFileName.resize(pNotifyInformation->FileNameLength / 2);
-                wcstombs(&currentFileName.front(), pNotifyInformation->FileName, pNotifyInformation->FileNameLength);
+                DWORD bytesReturned = 0;
+                if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0)
+                {
+                    // Stopped. Cancel the pending read and wait for it, since it writes to the buffer and the overlapped struct.
+                    CancelIoEx(pMonitor->hDir, &overlapped);
+                    GetOverlappedResult(pMonitor->hDir, &overlapped, &bytesReturned, TRUE);
+                    break;
+                }
 
-                if (currentFileName == fileName && pNotifyInformation->Action == FILE_ACTION_MODIFIED)
+                if (!GetOverlappedResult(pMonitor->hDir, &overlapped, &bytesReturned, FALSE))
                 {
-                    callback();
+                    logError("Failed to read directory changes for shared file.");
                     break;
                 }
 
-                if (!pNotifyInformation->NextEntryOffset) break;
-                offset += pNotifyInformation->NextEntryOffset;
+                size_t offset = 0;
+                while (offset < bytesReturned)
+                {
+                    const _FILE_NOTIFY_INFORMATION* pNotifyInformation = reinterpret_cast<const _FILE_NOTIFY_INFORMATION*>(reinterpret_cast<const uint8_t*>(buffer.data()) + offset);
+                    std::string currentFileName;
+                    currentFileName.resize(pNotifyInformation->FileNameLength / 2);
+                    wcstombs(&currentFileName.front(), pNotifyInformation->FileName, currentFileName.size());
+
+                    if (currentFileName == fileName && pNotifyInformation->Action == FILE_ACTION_MODIFIED)
+                    {
+                        if (callback) callback();
+                        break;
+                    }
+
+                    if (!pNotifyInformation->NextEntryOffset) break;
+                    offset += pNotifyInformation->NextEntryOffset;
+                }
             }
-        }
 
-        CloseHandle(hFile);
+            CloseHandle(overlapped.hEvent);
+        }
     }
 
-    void monitorFileUpdates(const std::string& filePath, const std::function<void()>& callback)
+    bool monitorFileUpdates(const std::string& filePath, const std::function<void()>& callback)
     {
-        const auto& fileThreadsIt = fileThreads.find(filePath);
-
         // only have one thread waiting on file write
-        if(fileThreadsIt != fileThreads.end())
-        {
-            if (fileThreadsIt->second.first.joinable())
-            {
-                fileThreadsIt->second.first.join();
-            }
-        }
-        
-        fileThreads[filePath].first = std::thread(checkFileModifiedStatus, filePath, callback);
-        fileThreads[filePath].second = true;
+        closeSharedFile(filePath);
+
+        std::string dir = getDirectoryFromFile(filePath);
+        HANDLE hDir = CreateFileA(dir.c_str(), GENERIC_READ | FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+        if (hDir == INVALID_HANDLE_VALUE) return false;
+
+        auto pMonitor = std::make_unique<FileMonitor>();
+        pMonitor->hDir = hDir;
+        pMonitor->hStopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        pMonitor->thread = std::thread(checkFileModifiedStatus, pMonitor.get(), filePath, callback);
+        gFileMonitors[filePath] = std::move(pMonitor);
+        return true;
     }
 
     void closeSharedFile(const std::string& filePath)
     {
-        const auto& fileThreadsIt = fileThreads.find(filePath);
+        auto it = gFileMonitors.find(filePath);
+        if (it == gFileMonitors.end()) return;
 
-        // only have one thread waiting on file write
-        if (fileThreadsIt != fileThreads.end())
-        {
-            fileThreadsIt->second.second = false;
-
-            fileThreadsIt->second.first.detach();
-        }
+        FileMonitor* pMonitor = it->second.get();
+        SetEvent(pMonitor->hStopEvent);
+        pMonitor->thread.join();
+        CloseHandle(pMonitor->hStopEvent);
+        CloseHandle(pMonitor->hDir);
+        gFileMonitors.erase(it);
     }
 
     void enumerateFiles(std::string searchString, std::vector<std::string>& filenames)
@@ -0,0 +1,149 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Polarization.h"
+#include "Data/HostDevicePolarization.h"
+#include "Utils/Math/SimdVec.h"
+
+namespace Falcor
+{
+    namespace Polarization
+    {
+        namespace
+        {
+            PsiInputs offsetInputs(const PsiInputs& inputs, uint32_t offset)
+            {
+                auto advance = [offset](const float* p) { return p ? p + offset : nullptr; };
+                PsiInputs result;
+                result.pN = advance(inputs.pN);
+                result.pK = advance(inputs.pK);
+                result.pR0 = advance(inputs.pR0);
+                result.pCosTheta = advance(inputs.pCosTheta);
+                result.pSin2Theta = advance(inputs.pSin2Theta);
+                return result;
+            }
+
+#ifdef FALCOR_USE_SIMD_VEC
+            using Simd::Vec;
+
+            // The formulas of HostDevicePolarization.h, instantiated for the SIMD registers,
+            // so that they evaluate the same expressions and round the same way as the generic path
+            POLARIZATION_DEFINE_PSI_EXACT(psiExact, Vec, Vec)
+            POLARIZATION_DEFINE_PSI_METAL_APPROX(psiMetalApprox, Vec, Vec)
+            POLARIZATION_DEFINE_PSI_DIELECTRIC_EXACT(psiDielectricExact, Vec)
+            POLARIZATION_DEFINE_PSI_DIELECTRIC_ONE_FIVE(psiDielectricOneFive, Vec)
+
+            /** Run a kernel over the full SIMD registers of a batch
+                \return The number of elements processed
+            */
+            template<typename Kernel>
+            uint32_t runKernel(const PsiInputs& inputs, float* pPsi, uint32_t count, const Kernel& kernel)
+            {
+                uint32_t simdCount = count - count % Vec::kWidth;
+                for (uint32_t i = 0; i < simdCount; i += Vec::kWidth)
+                {
+                    kernel(offsetInputs(inputs, i)).store(pPsi + i);
+                }
+                return simdCount;
+            }
+#endif
+        }
+
+        const char* getPsiModelName(PsiModel model)
+        {
+            switch (model)
+            {
+            case PsiModel::Exact:               return "Exact";
+            case PsiModel::MetalApprox:         return "MetalApprox";
+            case PsiModel::DielectricExact:     return "DielectricExact";
+            case PsiModel::DielectricOneFive:   return "DielectricOneFive";
+            default:                            should_not_get_here(); return "";
+            }
+        }
+
+        const char* getSimdName()
+        {
+#ifdef FALCOR_USE_SIMD_VEC
+            return Simd::getName();
+#else
+            return "None";
+#endif
+        }
+
+        void evaluatePsi(PsiModel model, const PsiInputs& inputs, float* pPsi, uint32_t count)
+        {
+            uint32_t done = 0;
+#ifdef FALCOR_USE_SIMD_VEC
+            switch (model)
+            {
+            case PsiModel::Exact:
+                done = runKernel(inputs, pPsi, count, [](const PsiInputs& in) { return psiExact(Vec::load(in.pN), Vec::load(in.pK), Vec::load(in.pCosTheta), Vec::load(in.pSin2Theta)); });
+                break;
+            case PsiModel::MetalApprox:
+                done = runKernel(inputs, pPsi, count, [](const PsiInputs& in) { return psiMetalApprox(Vec::load(in.pR0), Vec::load(in.pCosTheta), Vec::load(in.pSin2Theta)); });
+                break;
+            case PsiModel::DielectricExact:
+                done = runKernel(inputs, pPsi, count, [](const PsiInputs& in) { return psiDielectricExact(Vec::load(in.pR0), Vec::load(in.pCosTheta), Vec::load(in.pSin2Theta)); });
+                break;
+            case PsiModel::DielectricOneFive:
+                done = runKernel(inputs, pPsi, count, [](const PsiInputs& in) { return psiDielectricOneFive(Vec::load(in.pCosTheta), Vec::load(in.pSin2Theta)); });
+                break;
+            default:
+                should_not_get_here();
+            }
+#endif
+            // The remaining elements
+            evaluatePsiGeneric(model, offsetInputs(inputs, done), pPsi + done, count - done);
+        }
+
+        void evaluatePsiGeneric(PsiModel model, const PsiInputs& inputs, float* pPsi, uint32_t count)
+        {
+            const float* pCt = inputs.pCosTheta;
+            const float* pSt2 = inputs.pSin2Theta;
+            switch (model)
+            {
+            case PsiModel::Exact:
+                for (uint32_t i = 0; i < count; i++) pPsi[i] = psi_Exact(float3(inputs.pN[i]), float3(inputs.pK[i]), pCt[i], pSt2[i]).x;
+                break;
+            case PsiModel::MetalApprox:
+                for (uint32_t i = 0; i < count; i++) pPsi[i] = psi_MetalApprox(float3(inputs.pR0[i]), pCt[i], pSt2[i]).x;
+                break;
+            case PsiModel::DielectricExact:
+                for (uint32_t i = 0; i < count; i++) pPsi[i] = psi_DielectricExact(inputs.pR0[i], pCt[i], pSt2[i]);
+                break;
+            case PsiModel::DielectricOneFive:
+                for (uint32_t i = 0; i < count; i++) pPsi[i] = psi_DielectricOneFive(pCt[i], pSt2[i]);
+                break;
+            default:
+                should_not_get_here();
+            }
+        }
+    }
+}
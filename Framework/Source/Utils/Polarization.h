@@ -0,0 +1,81 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+
+namespace Falcor
+{
+    /** CPU reference implementation of the polarization functions in Data/HostDevicePolarization.h, evaluated over batches.
+        The inputs and outputs are in structure-of-arrays layout with one element per color channel. The batch functions use
+        AVX2, SSE2 or NEON kernels depending on the target, while the generic functions call the shared shader code one element at a time.
+    */
+    namespace Polarization
+    {
+        /** The psi functions
+        */
+        enum class PsiModel
+        {
+            Exact,              ///< psi_Exact(). Uses n and k.
+            MetalApprox,        ///< psi_MetalApprox(). Uses R0.
+            DielectricExact,    ///< psi_DielectricExact(). Uses R0.
+            DielectricOneFive,  ///< psi_DielectricOneFive()
+        };
+
+        /** Inputs of a batch. Arrays that the model doesn't use can be nullptr.
+        */
+        struct PsiInputs
+        {
+            const float* pN = nullptr;          ///< Simple refractive index
+            const float* pK = nullptr;          ///< Extinction coefficient
+            const float* pR0 = nullptr;         ///< Specular reflectance at normal incidence
+            const float* pCosTheta = nullptr;   ///< cos(theta)
+            const float* pSin2Theta = nullptr;  ///< sin^2(theta)
+        };
+
+        /** Get a short name of a model
+        */
+        const char* getPsiModelName(PsiModel model);
+
+        /** Get the name of the instruction set used by evaluatePsi()
+        */
+        const char* getSimdName();
+
+        /** Evaluate psi for a batch of elements
+            \param[in] model The function to evaluate
+            \param[in] inputs The inputs
+            \param[out] pPsi The results. Must hold count elements.
+            \param[in] count Number of elements
+        */
+        void evaluatePsi(PsiModel model, const PsiInputs& inputs, float* pPsi, uint32_t count);
+
+        /** Same as evaluatePsi(), without the SIMD kernels. Used as a reference.
+        */
+        void evaluatePsiGeneric(PsiModel model, const PsiInputs& inputs, float* pPsi, uint32_t count);
+    }
+}
@@ -0,0 +1,356 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ProbePolarization.h"
+#include "Utils/PsiLut.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/Platform/OS.h"
+#include "Utils/Math/FalcorMath.h"
+#include "Utils/Bitmap.h"
+#include "Utils/CpuTimer.h"
+#include "Data/HostDevicePolarization.h"
+#include "API/Texture.h"
+#include "Graphics/LightProbe.h"
+#include "Graphics/TextureHelper.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        // Increment when the baked terms or the file layout change, so that old cache files are ignored
+        const uint32_t kCacheVersion = 1;
+
+        const uint32_t kCoherenceSampleCount = 1024;
+        const ResourceFormat kFormat = ResourceFormat::RGBA16Float;
+        const float kPi = float(M_PI);
+
+        /** 64-bit FNV-1a hash
+        */
+        class Hash
+        {
+        public:
+            void add(const void* pData, size_t size)
+            {
+                const uint8_t* pBytes = (const uint8_t*)pData;
+                for (size_t i = 0; i < size; i++) mHash = (mHash ^ pBytes[i]) * 1099511628211ull;
+            }
+
+            std::string getFilename(const std::string& name) const
+            {
+                char hash[17];
+                snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)mHash);
+                return PsiLut::getCacheDirectory() + "/" + name + "_" + hash + ".dds";
+            }
+
+        private:
+            uint64_t mHash = 14695981039346656037ull;
+        };
+
+        /** A GGX-distributed half vector in tangent space, with N = (0, 0, 1)
+        */
+        vec3 sampleGgx(uint32_t i, uint32_t sampleCount, float alpha, float& phi)
+        {
+            phi = 2.0f * kPi * float(i) / float(sampleCount);
+            float u = radicalInverse(i);
+            float cosTheta = sqrt((1.0f - u) / (1.0f + (alpha * alpha - 1.0f) * u));
+            float sinTheta = sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+            return vec3(sinTheta * cos(phi), sinTheta * sin(phi), cosTheta);
+        }
+
+        float smithG1(float NdotX, float alpha)
+        {
+            float a2 = alpha * alpha;
+            return 2.0f * NdotX / (NdotX + sqrt(a2 + (1.0f - a2) * NdotX * NdotX));
+        }
+
+        /** Same mappings as dirToSphericalCrd() and sphericalCrdToDir() in Helpers.slang
+        */
+        vec2 dirToLatLong(const vec3& dir)
+        {
+            return vec2((1.0f + atan2(-dir.z, dir.x) / kPi) * 0.5f, acos(glm::clamp(dir.y, -1.0f, 1.0f)) / kPi);
+        }
+
+        vec3 latLongToDir(const vec2& uv)
+        {
+            float phi = kPi * uv.y;
+            float theta = 2.0f * kPi * uv.x - 0.5f * kPi;
+            return glm::normalize(vec3(sin(phi) * sin(theta), cos(phi), sin(phi) * cos(theta)));
+        }
+
+        /** Bilinear lookup in a lat-long image. Wraps horizontally and clamps vertically.
+        */
+        vec3 sampleBilinear(const TextureBaker::Image& image, const vec2& uv)
+        {
+            float x = uv.x * image.width - 0.5f;
+            float y = glm::clamp(uv.y * image.height - 0.5f, 0.0f, float(image.height - 1));
+            float fx = floor(x);
+            float fy = floor(y);
+            vec2 t(x - fx, y - fy);
+
+            int32_t x0 = int32_t(fx) % int32_t(image.width);
+            if (x0 < 0) x0 += image.width;
+            uint32_t x1 = (x0 + 1) % image.width;
+            uint32_t y0 = uint32_t(fy);
+            uint32_t y1 = std::min(y0 + 1, image.height - 1);
+
+            vec3 a = glm::mix(vec3(image.texels[y0 * image.width + x0]), vec3(image.texels[y0 * image.width + x1]), t.x);
+            vec3 b = glm::mix(vec3(image.texels[y1 * image.width + x0]), vec3(image.texels[y1 * image.width + x1]), t.x);
+            return glm::mix(a, b, t.y);
+        }
+
+        /** Trilinear lookup in the mip-chain of a lat-long image
+        */
+        vec3 sampleTrilinear(const std::vector<TextureBaker::Image>& mips, const vec2& uv, float lod)
+        {
+            lod = glm::clamp(lod, 0.0f, float(mips.size() - 1));
+            uint32_t level = uint32_t(lod);
+            if (level + 1 == mips.size()) return sampleBilinear(mips[level], uv);
+            return glm::mix(sampleBilinear(mips[level], uv), sampleBilinear(mips[level + 1], uv), lod - float(level));
+        }
+
+        /** A sample of the lobe around the texel direction. Only depends on the mip level, so it's shared by all texels of a level.
+        */
+        struct LobeSample
+        {
+            vec3 L;         ///< Tangent space, in the frame of probePolarizationFrameX()
+            float weight;
+            float cos2Phi;
+            float sin2Phi;
+            float lod;      ///< Mip level of the source image, from the solid angle of the sample
+        };
+
+        std::vector<LobeSample> createLobeSamples(float alpha, uint32_t sampleCount, const TextureBaker::Image& source)
+        {
+            // Solid angle of a texel at the equator of the source image
+            float texelSolidAngle = 2.0f * kPi * kPi / float(source.width * source.height);
+
+            // The samples come in groups of eight, rotated by 45 degrees around R. The cos(2*phi) and sin(2*phi) weights of a group sum to zero,
+            // so a uniform environment has no polarization, and both terms respond equally to the environment regardless of the sample count.
+            const uint32_t kGroupSize = 8;
+            uint32_t groupCount = std::max(1u, sampleCount / kGroupSize);
+            std::vector<LobeSample> samples;
+            for (uint32_t i = 0; i < groupCount; i++)
+            {
+                float phi;
+                vec3 H = sampleGgx(i, groupCount, alpha, phi);
+
+                // N = V = R, so L is H reflected about the z axis
+                vec3 L = 2.0f * H.z * H - vec3(0.0f, 0.0f, 1.0f);
+                if (L.z <= 0.0f) continue;
+
+                // pdf(L) = D(H) * NdotH / (4 * LdotH), and NdotH = LdotH
+                float d = (alpha * alpha - 1.0f) * H.z * H.z + 1.0f;
+                float pdf = alpha * alpha / (kPi * d * d) * 0.25f;
+                float lod = std::max(0.0f, 0.5f * std::log2(1.0f / (float(groupCount * kGroupSize) * pdf * texelSolidAngle)) + 1.0f);
+
+                for (uint32_t r = 0; r < kGroupSize; r++)
+                {
+                    float rotatedPhi = phi + 2.0f * kPi * float(r) / float(kGroupSize);
+                    float sinTheta = sqrt(L.x * L.x + L.y * L.y);
+
+                    LobeSample s;
+                    s.L = vec3(sinTheta * cos(rotatedPhi), sinTheta * sin(rotatedPhi), L.z);
+                    s.weight = L.z;
+                    s.cos2Phi = cos(2.0f * rotatedPhi);
+                    s.sin2Phi = sin(2.0f * rotatedPhi);
+                    s.lod = lod;
+                    samples.push_back(s);
+                }
+            }
+            return samples;
+        }
+
+        bool loadCachedMips(const std::string& filename, uint32_t size, uint32_t mipCount, Texture::SharedPtr& pTexture)
+        {
+            if (doesFileExist(filename) == false) return false;
+            pTexture = createTextureFromFile(filename, false, false);
+            return pTexture && pTexture->getWidth() == size && pTexture->getMipCount() == mipCount && pTexture->getFormat() == kFormat;
+        }
+
+        Texture::SharedPtr createMipTexture(const std::vector<TextureBaker::Image>& mips, const std::string& filename)
+        {
+            std::vector<uint8_t> data = TextureBaker::encodeMipChain(mips, kFormat);
+            const std::string& dir = PsiLut::getCacheDirectory();
+            if ((isDirectoryExists(dir) || createDirectory(dir)) == false || TextureBaker::saveDds(filename, kFormat, mips[0].width, mips[0].height, (uint32_t)mips.size(), data.data(), data.size()) == false)
+            {
+                logWarning("ProbePolarization - can't write the cached texture " + filename);
+            }
+            return Texture::create2D(mips[0].width, mips[0].height, kFormat, 1, (uint32_t)mips.size(), data.data());
+        }
+    }
+
+    void ProbePolarization::bakeEnvironment(const TextureBaker::Image& environment, uint32_t size, uint32_t sampleCount, std::vector<TextureBaker::Image>& cosMips, std::vector<TextureBaker::Image>& sinMips, uint32_t threadCount)
+    {
+        std::vector<TextureBaker::Image> source = TextureBaker::generateMipChain(environment, TextureBaker::MipFilter::Box, threadCount);
+
+        uint32_t mipCount = 1;
+        while ((size >> mipCount) > 0) mipCount++;
+        cosMips.resize(mipCount);
+        sinMips.resize(mipCount);
+
+        for (uint32_t level = 0; level < mipCount; level++)
+        {
+            float linearRoughness = (mipCount > 1) ? float(level) / float(mipCount - 1) : 0.0f;
+            std::vector<LobeSample> samples = createLobeSamples(std::max(0.01f, linearRoughness * linearRoughness), sampleCount, source[0]);
+
+            uint32_t levelSize = size >> level;
+            for (TextureBaker::Image* pImage : { &cosMips[level], &sinMips[level] })
+            {
+                pImage->width = levelSize;
+                pImage->height = levelSize;
+                pImage->texels.resize(levelSize * levelSize);
+            }
+
+            parallelFor(levelSize, threadCount, [&](uint32_t y)
+            {
+                for (uint32_t x = 0; x < levelSize; x++)
+                {
+                    vec3 R = latLongToDir(vec2((float(x) + 0.5f) / float(levelSize), (float(y) + 0.5f) / float(levelSize)));
+                    vec3 frameX = probePolarizationFrameX(R);
+                    vec3 frameY = glm::cross(R, frameX);
+
+                    vec3 cosSum(0.0f);
+                    vec3 sinSum(0.0f);
+                    float weightSum = 0.0f;
+                    for (const LobeSample& s : samples)
+                    {
+                        vec3 L = s.L.x * frameX + s.L.y * frameY + s.L.z * R;
+                        vec3 radiance = sampleTrilinear(source, dirToLatLong(L), s.lod) * s.weight;
+                        cosSum += radiance * s.cos2Phi;
+                        sinSum += radiance * s.sin2Phi;
+                        weightSum += s.weight;
+                    }
+
+                    float scale = (weightSum > 0.0f) ? 1.0f / weightSum : 0.0f;
+                    cosMips[level].texels[y * levelSize + x] = vec4(cosSum * scale, 1.0f);
+                    sinMips[level].texels[y * levelSize + x] = vec4(sinSum * scale, 1.0f);
+                }
+            });
+        }
+    }
+
+    TextureBaker::Image ProbePolarization::bakeCoherence(uint32_t sampleCount, uint32_t threadCount)
+    {
+        TextureBaker::Image image;
+        image.width = PSI_LUT_SIZE;
+        image.height = PSI_LUT_SIZE;
+        image.texels.resize(image.width * image.height);
+
+        parallelFor(image.height, threadCount, [&](uint32_t row)
+        {
+            float alpha = float(row) / float(PSI_LUT_SIZE - 1);
+            for (uint32_t col = 0; col < PSI_LUT_SIZE; col++)
+            {
+                // N = (0, 0, 1) and V in the xz-plane. The s-axis of N is the y axis, and the Stokes frame of the reflection is (sN, yN).
+                float NdotV = glm::clamp(float(col) / float(PSI_LUT_SIZE - 1), 1e-3f, 0.9999f);
+                vec3 V(sqrt(1.0f - NdotV * NdotV), 0.0f, NdotV);
+                vec3 sN(0.0f, 1.0f, 0.0f);
+                vec3 yN = glm::cross(V, sN);
+
+                float sum = 0.0f;
+                float weightSum = 0.0f;
+                for (uint32_t i = 0; i < sampleCount; i++)
+                {
+                    float phi;
+                    vec3 H = sampleGgx(i, sampleCount, alpha, phi);
+                    float VdotH = glm::dot(V, H);
+                    vec3 L = 2.0f * VdotH * H - V;
+                    if (L.z <= 0.0f || VdotH <= 0.0f) continue;
+
+                    // BRDF * NdotL / pdf, without the Fresnel term
+                    float weight = smithG1(L.z, alpha) * smithG1(NdotV, alpha) * VdotH / (NdotV * H.z);
+
+                    vec3 sH = glm::cross(H, V);
+                    float c = glm::dot(sH, sN);
+                    float s = glm::dot(sH, yN);
+                    float len2 = c * c + s * s;
+                    if (len2 <= 0.0f) continue;
+
+                    sum += weight * (c * c - s * s) / len2;
+                    weightSum += weight;
+                }
+
+                float coherence = (weightSum > 0.0f) ? sum / weightSum : 1.0f;
+                image.texels[row * image.width + col] = vec4(coherence, 0.0f, 0.0f, 1.0f);
+            }
+        });
+        return image;
+    }
+
+    bool ProbePolarization::createEnvironmentTextures(const LightProbe* pProbe, EnvironmentTextures& textures, uint32_t size, uint32_t sampleCount)
+    {
+        // The scene loader and the samples always load 8-bit light-probe images as sRGB
+        const Texture::SharedPtr& pSource = pProbe->getOrigTexture();
+        Bitmap::UniqueConstPtr pBitmap = pSource ? Bitmap::createFromFile(pSource->getSourceFilename(), true) : nullptr;
+        if (pBitmap == nullptr)
+        {
+            logWarning("ProbePolarization::createEnvironmentTextures() - can't load the light probe image");
+            return false;
+        }
+        TextureBaker::Image environment = TextureBaker::createImage(pBitmap.get(), true);
+
+        Hash hash;
+        hash.add(&kCacheVersion, sizeof(kCacheVersion));
+        hash.add(&size, sizeof(size));
+        hash.add(&sampleCount, sizeof(sampleCount));
+        hash.add(&environment.width, sizeof(environment.width));
+        hash.add(&environment.height, sizeof(environment.height));
+        hash.add(environment.texels.data(), environment.texels.size() * sizeof(vec4));
+        std::string cosFilename = hash.getFilename("ProbePolarizationCos");
+        std::string sinFilename = hash.getFilename("ProbePolarizationSin");
+
+        uint32_t mipCount = 1;
+        while ((size >> mipCount) > 0) mipCount++;
+        if (loadCachedMips(cosFilename, size, mipCount, textures.pCos) && loadCachedMips(sinFilename, size, mipCount, textures.pSin)) return true;
+
+        auto start = CpuTimer::getCurrentTimePoint();
+        std::vector<TextureBaker::Image> cosMips, sinMips;
+        bakeEnvironment(environment, size, sampleCount, cosMips, sinMips);
+        logInfo("ProbePolarization - baked the environment terms in " + std::to_string(CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint())) + " ms");
+
+        textures.pCos = createMipTexture(cosMips, cosFilename);
+        textures.pSin = createMipTexture(sinMips, sinFilename);
+        return true;
+    }
+
+    std::shared_ptr<Texture> ProbePolarization::createCoherenceTexture()
+    {
+        Hash hash;
+        hash.add(&kCacheVersion, sizeof(kCacheVersion));
+        hash.add(&kCoherenceSampleCount, sizeof(kCoherenceSampleCount));
+        uint32_t size = PSI_LUT_SIZE;
+        hash.add(&size, sizeof(size));
+        std::string filename = hash.getFilename("ProbePolarizationCoherence");
+
+        Texture::SharedPtr pTexture;
+        if (loadCachedMips(filename, PSI_LUT_SIZE, 1, pTexture)) return pTexture;
+        return createMipTexture({ bakeCoherence(kCoherenceSampleCount) }, filename);
+    }
+}
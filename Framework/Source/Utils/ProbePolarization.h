@@ -0,0 +1,94 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Utils/TextureBaker.h"
+#include <memory>
+
+namespace Falcor
+{
+    class Texture;
+    class LightProbe;
+
+    /** Prefiltered polarization terms of light probes, baked on the CPU and sampled by shaders compiled with _PROBE_POLARIZATION.
+        The specular term of a light probe is one texture fetch, which treats the whole GGX lobe as a single mirror direction. Two effects change
+        the polarization of the reflection when the lobe is wide:
+        - The planes of incidence of the microfacets spread around the mean plane, so the polarization partly cancels. The coherence texture
+          holds the GGX-weighted average of cos(2*delta), where delta is the angle between the s-axis of a microfacet and the s-axis of N.
+        - The environment isn't uniform over the lobe. The environment textures hold the radiance of the lobe weighted by cos(2*phi) and sin(2*phi),
+          where phi is the azimuth of the light around the texel direction R, measured in the frame of probePolarizationFrameX(R).
+        Like the specular texture of LightProbe, the environment textures are lat-long maps with one mip level per roughness.
+        Level i holds the roughness (i/(mipCount - 1))^2, which is what linearRoughnessToLod() maps back to level i.
+        The textures are cached in PsiLut::getCacheDirectory(), named after a hash of their inputs.
+    */
+    class ProbePolarization
+    {
+    public:
+        static const uint32_t kDefaultSize = 128;
+        static const uint32_t kDefaultSampleCount = 256;
+
+        /** The environment textures of a light probe
+        */
+        struct EnvironmentTextures
+        {
+            std::shared_ptr<Texture> pCos;  ///< RGB radiance weighted by cos(2*phi)
+            std::shared_ptr<Texture> pSin;  ///< RGB radiance weighted by sin(2*phi)
+        };
+
+        /** Bake the environment terms of a lat-long environment map
+            \param[in] environment The environment map, with the mapping of dirToSphericalCrd()
+            \param[in] size Width and height of the top mip level
+            \param[in] sampleCount Number of GGX samples per texel
+            \param[out] cosMips The cos(2*phi)-weighted radiance, one image per mip level
+            \param[out] sinMips The sin(2*phi)-weighted radiance, one image per mip level
+            \param[in] threadCount Number of worker threads. 0 will use all hardware threads.
+        */
+        static void bakeEnvironment(const TextureBaker::Image& environment, uint32_t size, uint32_t sampleCount, std::vector<TextureBaker::Image>& cosMips, std::vector<TextureBaker::Image>& sinMips, uint32_t threadCount = 0);
+
+        /** Bake the coherence of the GGX lobe. The texture is PSI_LUT_SIZE x PSI_LUT_SIZE texels, indexed with psiLutCoord() of NdotV in x and the GGX roughness in y.
+            \param[in] sampleCount Number of GGX samples per texel
+            \param[in] threadCount Number of worker threads. 0 will use all hardware threads.
+        */
+        static TextureBaker::Image bakeCoherence(uint32_t sampleCount, uint32_t threadCount = 0);
+
+        /** Create the environment textures of a light probe, or load them from the cache.
+            The source image is loaded again from the file of LightProbe::getOrigTexture(), so that the result doesn't depend on the GPU copy.
+            \param[in] pProbe The light probe
+            \param[out] textures The textures
+            \param[in] size Width and height of the top mip level
+            \param[in] sampleCount Number of GGX samples per texel
+            \return false if the source image can't be loaded
+        */
+        static bool createEnvironmentTextures(const LightProbe* pProbe, EnvironmentTextures& textures, uint32_t size = kDefaultSize, uint32_t sampleCount = kDefaultSampleCount);
+
+        /** Create a texture with bakeCoherence(), or load it from the cache. Doesn't depend on the light probe.
+        */
+        static std::shared_ptr<Texture> createCoherenceTexture();
+    };
+}
@@ -0,0 +1,223 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "PsiLut.h"
+#include "Utils/Polarization.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/Platform/OS.h"
+#include "Utils/CpuTimer.h"
+#include "Data/HostDevicePolarization.h"
+#include "API/Texture.h"
+#include "Graphics/TextureHelper.h"
+#include <cstring>
+#include <functional>
+
+namespace Falcor
+{
+    using namespace Polarization;
+
+    namespace
+    {
+        // Increment when the baked functions or the file layout change, so that old cache files are ignored
+        const uint32_t kCacheVersion = 2;
+
+        // psi_DielectricExact() is undefined at R0 = 1, so the dielectric rows stop here
+        const float kMaxDielectricR0 = 0.99f;
+
+        // Half floats would add a rounding error of up to 2.4e-4 near 1, more than the interpolation error of PSI_LUT_SIZE texels
+        const ResourceFormat kFormat = ResourceFormat::RGBA32Float;
+
+        /** cos(theta) and sin^2(theta) of the texel columns
+        */
+        struct Columns
+        {
+            float cosTheta[PSI_LUT_SIZE];
+            float sin2Theta[PSI_LUT_SIZE];
+
+            Columns()
+            {
+                for (uint32_t i = 0; i < PSI_LUT_SIZE; i++)
+                {
+                    cosTheta[i] = float(i) / float(PSI_LUT_SIZE - 1);
+                    sin2Theta[i] = 1.0f - cosTheta[i] * cosTheta[i];
+                }
+            }
+        };
+
+        /** 64-bit FNV-1a hash of the inputs of a texture
+        */
+        class CacheKey
+        {
+        public:
+            CacheKey(const char* type) : mType(type)
+            {
+                add(type, std::strlen(type));
+                add(&kCacheVersion, sizeof(kCacheVersion));
+                uint32_t size = PSI_LUT_SIZE;
+                add(&size, sizeof(size));
+            }
+
+            void add(const void* pData, size_t size)
+            {
+                const uint8_t* pBytes = (const uint8_t*)pData;
+                for (size_t i = 0; i < size; i++) mHash = (mHash ^ pBytes[i]) * 1099511628211ull;
+            }
+
+            std::string getFilename() const
+            {
+                char hash[17];
+                snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)mHash);
+                return PsiLut::getCacheDirectory() + "/PsiLut" + mType + "_" + hash + ".dds";
+            }
+
+        private:
+            std::string mType;
+            uint64_t mHash = 14695981039346656037ull;
+        };
+
+        Texture::SharedPtr loadOrBake(const std::string& filename, bool useCache, const std::function<TextureBaker::Image()>& bake)
+        {
+            if (useCache && doesFileExist(filename))
+            {
+                Texture::SharedPtr pTexture = createTextureFromFile(filename, false, false);
+                if (pTexture && pTexture->getWidth() == PSI_LUT_SIZE && pTexture->getFormat() == kFormat) return pTexture;
+                logWarning("PsiLut - can't use the cached texture " + filename + ". Baking it again.");
+            }
+
+            auto start = CpuTimer::getCurrentTimePoint();
+            TextureBaker::Image image = bake();
+            std::vector<uint8_t> data = TextureBaker::encodeMipChain({ image }, kFormat);
+            logInfo("PsiLut - baked a " + std::to_string(image.width) + "x" + std::to_string(image.height) + " texture in " + std::to_string(CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint())) + " ms");
+
+            if (useCache)
+            {
+                const std::string& dir = PsiLut::getCacheDirectory();
+                if ((isDirectoryExists(dir) || createDirectory(dir)) == false || TextureBaker::saveDds(filename, kFormat, image.width, image.height, 1, data.data(), data.size()) == false)
+                {
+                    logWarning("PsiLut - can't write the cached texture " + filename);
+                }
+            }
+
+            return Texture::create2D(image.width, image.height, kFormat, 1, 1, data.data());
+        }
+    }
+
+    TextureBaker::Image PsiLut::bakeMaterials(const std::vector<Material>& materials, uint32_t threadCount)
+    {
+        static const Columns kColumns;
+
+        TextureBaker::Image image;
+        image.width = PSI_LUT_SIZE;
+        image.height = (uint32_t)materials.size();
+        image.texels.resize(image.width * image.height);
+
+        parallelFor(image.height, threadCount, [&](uint32_t row)
+        {
+            PsiInputs inputs;
+            inputs.pCosTheta = kColumns.cosTheta;
+            inputs.pSin2Theta = kColumns.sin2Theta;
+
+            float n[PSI_LUT_SIZE], k[PSI_LUT_SIZE], psi[PSI_LUT_SIZE];
+            inputs.pN = n;
+            inputs.pK = k;
+
+            vec4* pRow = &image.texels[row * image.width];
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                std::fill_n(n, PSI_LUT_SIZE, materials[row].n[c]);
+                std::fill_n(k, PSI_LUT_SIZE, materials[row].k[c]);
+                evaluatePsi(PsiModel::Exact, inputs, psi, PSI_LUT_SIZE);
+                for (uint32_t i = 0; i < PSI_LUT_SIZE; i++) pRow[i][c] = psi[i];
+            }
+            for (uint32_t i = 0; i < PSI_LUT_SIZE; i++) pRow[i].a = 1.0f;
+        });
+        return image;
+    }
+
+    TextureBaker::Image PsiLut::bakeReflectance(uint32_t threadCount)
+    {
+        static const Columns kColumns;
+
+        TextureBaker::Image image;
+        image.width = PSI_LUT_SIZE;
+        image.height = PSI_LUT_SIZE;
+        image.texels.resize(image.width * image.height);
+
+        parallelFor(image.height, threadCount, [&](uint32_t row)
+        {
+            PsiInputs inputs;
+            inputs.pCosTheta = kColumns.cosTheta;
+            inputs.pSin2Theta = kColumns.sin2Theta;
+
+            float R0[PSI_LUT_SIZE], metal[PSI_LUT_SIZE], dielectric[PSI_LUT_SIZE];
+            inputs.pR0 = R0;
+
+            float rowR0 = float(row) / float(PSI_LUT_SIZE - 1);
+            std::fill_n(R0, PSI_LUT_SIZE, rowR0);
+            evaluatePsi(PsiModel::MetalApprox, inputs, metal, PSI_LUT_SIZE);
+            std::fill_n(R0, PSI_LUT_SIZE, std::min(rowR0, kMaxDielectricR0));
+            evaluatePsi(PsiModel::DielectricExact, inputs, dielectric, PSI_LUT_SIZE);
+
+            vec4* pRow = &image.texels[row * image.width];
+            for (uint32_t i = 0; i < PSI_LUT_SIZE; i++) pRow[i] = vec4(metal[i], dielectric[i], 0.0f, 1.0f);
+        });
+        return image;
+    }
+
+    std::shared_ptr<Texture> PsiLut::createMaterialTexture(const std::vector<Material>& materials, bool useCache)
+    {
+        if (materials.empty())
+        {
+            logError("PsiLut::createMaterialTexture() - the material list is empty");
+            return nullptr;
+        }
+
+        CacheKey key("Materials");
+        key.add(materials.data(), materials.size() * sizeof(Material));
+        return loadOrBake(key.getFilename(), useCache, [&]() { return bakeMaterials(materials); });
+    }
+
+    std::shared_ptr<Texture> PsiLut::createReflectanceTexture()
+    {
+        CacheKey key("Reflectance");
+        return loadOrBake(key.getFilename(), true, []() { return bakeReflectance(); });
+    }
+
+    ResourceFormat PsiLut::getTextureFormat()
+    {
+        return kFormat;
+    }
+
+    const std::string& PsiLut::getCacheDirectory()
+    {
+        static const std::string kDir = getExecutableDirectory() + "/PsiLutCache";
+        return kDir;
+    }
+}
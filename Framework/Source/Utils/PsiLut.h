@@ -0,0 +1,86 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Utils/TextureBaker.h"
+#include <memory>
+
+namespace Falcor
+{
+    class Texture;
+
+    /** Lookup textures of the psi functions in Data/HostDevicePolarization.h, sampled by shaders compiled with _PSI_LUT.
+        The texels are baked on the CPU with the batch functions in Utils/Polarization.h, one row per thread. Textures are cached on disk
+        as DDS files named after a hash of their inputs, so later runs with the same inputs only load the file.
+        Both axes of the textures map [0, 1] with psiLutCoord(), and the texels are stored as RGBA32Float,
+        so that the shaders sample the same values the tests check.
+    */
+    class PsiLut
+    {
+    public:
+        /** A material with one (n, k) pair per color channel
+        */
+        struct Material
+        {
+            vec3 n;     ///< Simple refractive index
+            vec3 k;     ///< Extinction coefficient
+        };
+
+        /** Bake psi_Exact() for a list of materials. The texture is PSI_LUT_SIZE texels wide with one row per material.
+            Row i holds material i, the columns are cos(theta) and the RGB channels are the color channels.
+            \param[in] materials The materials
+            \param[in] threadCount Number of worker threads. 0 will use all hardware threads.
+        */
+        static TextureBaker::Image bakeMaterials(const std::vector<Material>& materials, uint32_t threadCount = 0);
+
+        /** Bake the psi functions of the specular reflectance. The texture is PSI_LUT_SIZE x PSI_LUT_SIZE texels.
+            The columns are cos(theta) and the rows are R0. R holds psi_MetalApprox() and G holds psi_DielectricExact().
+            \param[in] threadCount Number of worker threads. 0 will use all hardware threads.
+        */
+        static TextureBaker::Image bakeReflectance(uint32_t threadCount = 0);
+
+        /** Create a texture with bakeMaterials(), or load it from the cache
+            \param[in] materials The materials
+            \param[in] useCache Whether to use the cache. Disable it for materials that are edited interactively, to avoid filling the cache with files that won't be used again.
+        */
+        static std::shared_ptr<Texture> createMaterialTexture(const std::vector<Material>& materials, bool useCache = true);
+
+        /** Create a texture with bakeReflectance(), or load it from the cache
+        */
+        static std::shared_ptr<Texture> createReflectanceTexture();
+
+        /** Get the directory of the cached textures
+        */
+        static const std::string& getCacheDirectory();
+
+        /** Get the format of the textures
+        */
+        static ResourceFormat getTextureFormat();
+    };
+}
@@ -0,0 +1,462 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SpectralIoR.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/StringUtils.h"
+#include "Utils/Platform/OS.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+
+namespace Falcor
+{
+    namespace
+    {
+        // Increment when the integration or the fit changes, so that old cache entries are ignored
+        const uint32_t kCacheVersion = 1;
+        const char* kCacheFilename = "SpectralIoRCache.csv";
+
+        // Integration range and step, in nm
+        const float kMinWavelength = 380.0f;
+        const float kMaxWavelength = 780.0f;
+        const float kWavelengthStep = 5.0f;
+        const uint32_t kWavelengthCount = uint32_t((kMaxWavelength - kMinWavelength) / kWavelengthStep) + 1;
+
+        // The fit compares the curves at cos(theta) = (i + 1)/kFitAngleCount, which includes normal incidence
+        const uint32_t kFitAngleCount = 32;
+
+        // Search range of the effective n and k
+        const float kMinN = 0.02f;
+        const float kMaxN = 8.0f;
+        const float kMaxK = 12.0f;
+        const uint32_t kFitGridSize = 48;
+
+        /** Piecewise Gaussian used by the color-matching function fit
+        */
+        float gaussian(float x, float mu, float sigmaLow, float sigmaHigh)
+        {
+            float t = (x - mu) / (x < mu ? sigmaLow : sigmaHigh);
+            return std::exp(-0.5f * t * t);
+        }
+
+        /** CIE 1931 2-degree color-matching functions, using the multi-lobe fit of Wyman, Sloan and Shirley,
+            "Simple Analytic Approximations to the CIE XYZ Color Matching Functions", JCGT 2013
+        */
+        vec3 colorMatchingFunctions(float wavelength)
+        {
+            float x = 1.056f * gaussian(wavelength, 599.8f, 37.9f, 31.0f) + 0.362f * gaussian(wavelength, 442.0f, 16.0f, 26.7f) - 0.065f * gaussian(wavelength, 501.1f, 20.4f, 26.2f);
+            float y = 0.821f * gaussian(wavelength, 568.8f, 46.9f, 40.5f) + 0.286f * gaussian(wavelength, 530.9f, 16.3f, 31.1f);
+            float z = 1.217f * gaussian(wavelength, 437.0f, 11.8f, 36.0f) + 0.681f * gaussian(wavelength, 459.0f, 26.0f, 13.8f);
+            return vec3(x, y, z);
+        }
+
+        /** Linear sRGB weight of each wavelength, normalized so that a constant spectrum of 1 integrates to white
+        */
+        struct RgbWeights
+        {
+            vec3 weights[kWavelengthCount];
+
+            RgbWeights()
+            {
+                vec3 sum(0.0f);
+                for (uint32_t i = 0; i < kWavelengthCount; i++)
+                {
+                    vec3 xyz = colorMatchingFunctions(kMinWavelength + i * kWavelengthStep);
+                    weights[i].r = 3.2406f * xyz.x - 1.5372f * xyz.y - 0.4986f * xyz.z;
+                    weights[i].g = -0.9689f * xyz.x + 1.8758f * xyz.y + 0.0415f * xyz.z;
+                    weights[i].b = 0.0557f * xyz.x - 0.2040f * xyz.y + 1.0570f * xyz.z;
+                    sum += weights[i];
+                }
+                for (auto& w : weights) w /= sum;
+            }
+        };
+
+        float interpolate(const std::vector<vec2>& table, float x)
+        {
+            if (table.empty()) return 0.0f;
+            if (x <= table.front().x) return table.front().y;
+            if (x >= table.back().x) return table.back().y;
+
+            auto it = std::lower_bound(table.begin(), table.end(), x, [](const vec2& a, float b) { return a.x < b; });
+            const vec2& hi = *it;
+            const vec2& lo = *(it - 1);
+            return hi.x > lo.x ? glm::mix(lo.y, hi.y, (x - lo.x) / (hi.x - lo.x)) : hi.y;
+        }
+
+        /** Mean squared difference of the reflectance and psi of (n, k) from the target curves
+        */
+        float fitError(float n, float k, const float* pCosTheta, const float* pReflectance, const float* pPsi)
+        {
+            float error = 0;
+            for (uint32_t a = 0; a < kFitAngleCount; a++)
+            {
+                vec2 R = SpectralIoR::evaluateFresnel(n, k, pCosTheta[a]);
+                float F = 0.5f * (R.x + R.y);
+                float psi = (R.x + R.y) > 0 ? (R.x - R.y) / (R.x + R.y) : 0.0f;
+                error += (F - pReflectance[a]) * (F - pReflectance[a]) + (psi - pPsi[a]) * (psi - pPsi[a]);
+            }
+            return error / (2 * kFitAngleCount);
+        }
+
+        /** Fit n and k of one channel with a grid search followed by a pattern search. n is searched in log space.
+            \return (n, k, mean squared error)
+        */
+        vec3 fitChannel(bool isDielectric, const float* pCosTheta, const float* pReflectance, const float* pPsi)
+        {
+            const float logMinN = std::log(kMinN);
+            const float logMaxN = std::log(kMaxN);
+
+            float bestLogN = 0, bestK = 0;
+            float bestError = FLT_MAX;
+            uint32_t kSteps = isDielectric ? 1 : kFitGridSize;
+            for (uint32_t i = 0; i < kFitGridSize; i++)
+            {
+                float logN = glm::mix(logMinN, logMaxN, float(i) / (kFitGridSize - 1));
+                for (uint32_t j = 0; j < kSteps; j++)
+                {
+                    float k = kMaxK * float(j) / (kFitGridSize - 1);
+                    float error = fitError(std::exp(logN), k, pCosTheta, pReflectance, pPsi);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        bestLogN = logN;
+                        bestK = k;
+                    }
+                }
+            }
+
+            float stepLogN = (logMaxN - logMinN) / (kFitGridSize - 1);
+            float stepK = isDielectric ? 0.0f : kMaxK / (kFitGridSize - 1);
+            for (uint32_t iteration = 0; iteration < 64 && (stepLogN > 1e-6f || stepK > 1e-6f); iteration++)
+            {
+                const vec2 kOffsets[] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+                bool improved = false;
+                for (const vec2& o : kOffsets)
+                {
+                    float logN = glm::clamp(bestLogN + o.x * stepLogN, logMinN, logMaxN);
+                    float k = glm::clamp(bestK + o.y * stepK, 0.0f, kMaxK);
+                    float error = fitError(std::exp(logN), k, pCosTheta, pReflectance, pPsi);
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        bestLogN = logN;
+                        bestK = k;
+                        improved = true;
+                    }
+                }
+                if (improved == false)
+                {
+                    stepLogN *= 0.5f;
+                    stepK *= 0.5f;
+                }
+            }
+            return vec3(std::exp(bestLogN), bestK, bestError);
+        }
+
+        bool readFile(const std::string& filename, std::string& contents)
+        {
+            std::ifstream stream(filename, std::ios::binary);
+            if (stream.fail()) return false;
+            std::stringstream buffer;
+            buffer << stream.rdbuf();
+            contents = buffer.str();
+            return true;
+        }
+
+        uint64_t hashContents(const std::string& contents)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            auto add = [&hash](const void* pData, size_t size)
+            {
+                const uint8_t* pBytes = (const uint8_t*)pData;
+                for (size_t i = 0; i < size; i++) hash = (hash ^ pBytes[i]) * 1099511628211ull;
+            };
+            add(&kCacheVersion, sizeof(kCacheVersion));
+            add(contents.data(), contents.size());
+            return hash;
+        }
+
+        std::string getCachePath()
+        {
+            return getExecutableDirectory() + "/" + kCacheFilename;
+        }
+
+        /** Cache line: hash, n (3), k (3), R0 (3), isDielectric, fitError, name
+        */
+        std::unordered_map<uint64_t, SpectralIoR::RgbMaterial> loadCache()
+        {
+            std::unordered_map<uint64_t, SpectralIoR::RgbMaterial> cache;
+            std::ifstream stream(getCachePath());
+            std::string line;
+            while (std::getline(stream, line))
+            {
+                unsigned long long hash;
+                SpectralIoR::RgbMaterial m;
+                int isDielectric;
+                int nameOffset = 0;
+                if (sscanf(line.c_str(), "%llx,%f,%f,%f,%f,%f,%f,%f,%f,%f,%d,%f,%n", &hash, &m.n.r, &m.n.g, &m.n.b, &m.k.r, &m.k.g, &m.k.b,
+                    &m.R0.r, &m.R0.g, &m.R0.b, &isDielectric, &m.fitError, &nameOffset) == 12 && nameOffset > 0)
+                {
+                    m.isDielectric = isDielectric != 0;
+                    m.name = line.substr(nameOffset);
+                    cache[hash] = m;
+                }
+            }
+            return cache;
+        }
+
+        void saveCache(const std::unordered_map<uint64_t, SpectralIoR::RgbMaterial>& cache)
+        {
+            std::ofstream stream(getCachePath());
+            if (stream.fail())
+            {
+                logWarning("SpectralIoR - can't write " + getCachePath());
+                return;
+            }
+            for (const auto& entry : cache)
+            {
+                const SpectralIoR::RgbMaterial& m = entry.second;
+                char line[512];
+                snprintf(line, sizeof(line), "%016llx,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d,%.9g,", (unsigned long long)entry.first,
+                    m.n.r, m.n.g, m.n.b, m.k.r, m.k.g, m.k.b, m.R0.r, m.R0.g, m.R0.b, m.isDielectric ? 1 : 0, m.fitError);
+                stream << line << m.name << "\n";
+            }
+        }
+    }
+
+    bool SpectralIoR::loadCsv(const std::string& filename, Material& material)
+    {
+        std::string contents;
+        if (readFile(filename, contents) == false)
+        {
+            logError("SpectralIoR::loadCsv() - can't open " + filename);
+            return false;
+        }
+
+        material.name = fs::path(filename).stem().string();
+        if (parseCsv(contents, material) == false)
+        {
+            logError("SpectralIoR::loadCsv() - " + filename + " doesn't contain a refractive index table");
+            return false;
+        }
+        return true;
+    }
+
+    bool SpectralIoR::parseCsv(const std::string& csv, Material& material)
+    {
+        material.n.clear();
+        material.k.clear();
+
+        // The tables of the columns after the wavelength. Files without a header hold wl,n.
+        std::vector<std::vector<vec2>*> columns = { &material.n };
+
+        std::istringstream stream(csv);
+        std::string line;
+        while (std::getline(stream, line))
+        {
+            line = removeLeadingTrailingWhitespaces(line);
+            if (line.empty()) continue;
+
+            std::vector<std::string> fields = splitString(line, ",");
+            if (std::isalpha((unsigned char)line[0]))
+            {
+                columns.clear();
+                for (size_t i = 1; i < fields.size(); i++)
+                {
+                    std::string name = removeLeadingTrailingWhitespaces(fields[i]);
+                    if (name == "n") columns.push_back(&material.n);
+                    else if (name == "k") columns.push_back(&material.k);
+                    else columns.push_back(nullptr);
+                }
+                continue;
+            }
+
+            if (fields.size() < columns.size() + 1) return false;
+            float wavelength = std::strtof(fields[0].c_str(), nullptr) * 1000.0f;
+            for (size_t i = 0; i < columns.size(); i++)
+            {
+                if (columns[i]) columns[i]->push_back(vec2(wavelength, std::strtof(fields[i + 1].c_str(), nullptr)));
+            }
+        }
+
+        auto byWavelength = [](const vec2& a, const vec2& b) { return a.x < b.x; };
+        std::sort(material.n.begin(), material.n.end(), byWavelength);
+        std::sort(material.k.begin(), material.k.end(), byWavelength);
+        return material.n.empty() == false;
+    }
+
+    vec2 SpectralIoR::evaluate(const Material& material, float wavelength)
+    {
+        return vec2(interpolate(material.n, wavelength), interpolate(material.k, wavelength));
+    }
+
+    vec2 SpectralIoR::evaluateFresnel(float n, float k, float cosTheta)
+    {
+        float ct = glm::clamp(cosTheta, 0.0f, 1.0f);
+        float ct2 = ct * ct;
+        float st2 = 1.0f - ct2;
+
+        // h = a^2 + b^2, where a + ib is the complex cosine of the refracted angle scaled by the IoR
+        float c = n * n - k * k - st2;
+        float h = std::sqrt(c * c + 4.0f * n * n * k * k);
+        float a = std::sqrt(std::max(0.0f, 0.5f * (h + c)));
+
+        float sDenom = h + 2.0f * a * ct + ct2;
+        float Rs = sDenom > 0 ? (h - 2.0f * a * ct + ct2) / sDenom : 1.0f;
+        float pDenom = h * ct2 + 2.0f * a * ct * st2 + st2 * st2;
+        float Rp = pDenom > 0 ? Rs * (h * ct2 - 2.0f * a * ct * st2 + st2 * st2) / pDenom : Rs;
+        return vec2(Rs, Rp);
+    }
+
+    SpectralIoR::RgbMaterial SpectralIoR::integrate(const Material& material)
+    {
+        static const RgbWeights kWeights;
+
+        float cosTheta[kFitAngleCount];
+        for (uint32_t a = 0; a < kFitAngleCount; a++) cosTheta[a] = float(a + 1) / kFitAngleCount;
+
+        // Integrate the reflectance and the polarized reflectance (Rs - Rp)/2 of each channel
+        bool isDielectric = true;
+        vec3 reflectance[kFitAngleCount] = {};
+        vec3 polarized[kFitAngleCount] = {};
+        for (uint32_t i = 0; i < kWavelengthCount; i++)
+        {
+            vec2 ior = evaluate(material, kMinWavelength + i * kWavelengthStep);
+            isDielectric = isDielectric && ior.y <= 0.0f;
+            for (uint32_t a = 0; a < kFitAngleCount; a++)
+            {
+                vec2 R = evaluateFresnel(ior.x, ior.y, cosTheta[a]);
+                reflectance[a] += kWeights.weights[i] * (0.5f * (R.x + R.y));
+                polarized[a] += kWeights.weights[i] * (0.5f * (R.x - R.y));
+            }
+        }
+
+        RgbMaterial result;
+        result.name = material.name;
+        result.isDielectric = isDielectric;
+        result.R0 = glm::clamp(reflectance[kFitAngleCount - 1], 0.0f, 1.0f);
+
+        float meanSquaredError = 0;
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            float F[kFitAngleCount], psi[kFitAngleCount];
+            for (uint32_t a = 0; a < kFitAngleCount; a++)
+            {
+                F[a] = reflectance[a][c];
+                psi[a] = F[a] > 0 ? glm::clamp(polarized[a][c] / F[a], 0.0f, 1.0f) : 0.0f;
+            }
+
+            vec3 fit = fitChannel(isDielectric, cosTheta, F, psi);
+            result.n[c] = fit.x;
+            result.k[c] = fit.y;
+            meanSquaredError += fit.z / 3.0f;
+        }
+        result.fitError = std::sqrt(meanSquaredError);
+        return result;
+    }
+
+    std::vector<SpectralIoR::RgbMaterial> SpectralIoR::loadDirectory(const std::string& directory, uint32_t threadCount)
+    {
+        struct Entry
+        {
+            std::string filename;
+            uint64_t hash = 0;
+            bool valid = false;
+            RgbMaterial result;
+        };
+
+        std::vector<Entry> entries;
+        std::error_code ec;
+        for (fs::directory_iterator i(directory, ec), end; !ec && i != end; i.increment(ec))
+        {
+            std::string extension = i->path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (fs::is_regular_file(i->status()) && extension == ".csv")
+            {
+                entries.push_back(Entry());
+                entries.back().filename = i->path().string();
+            }
+        }
+        if (ec)
+        {
+            logError("SpectralIoR::loadDirectory() - can't read " + directory);
+            return {};
+        }
+
+        std::unordered_map<uint64_t, RgbMaterial> cache = loadCache();
+        std::atomic<uint32_t> bakedCount(0);
+        parallelFor((uint32_t)entries.size(), threadCount, [&](uint32_t i)
+        {
+            Entry& entry = entries[i];
+            Material material;
+            std::string contents;
+            if (readFile(entry.filename, contents) == false) return;
+            material.name = fs::path(entry.filename).stem().string();
+
+            entry.hash = hashContents(contents);
+            auto cached = cache.find(entry.hash);
+            if (cached != cache.end())
+            {
+                entry.result = cached->second;
+                entry.result.name = material.name;
+                entry.valid = true;
+            }
+            else if (parseCsv(contents, material))
+            {
+                entry.result = integrate(material);
+                entry.valid = true;
+                bakedCount++;
+            }
+        });
+
+        std::vector<RgbMaterial> materials;
+        for (const Entry& entry : entries)
+        {
+            if (entry.valid == false)
+            {
+                logWarning("SpectralIoR::loadDirectory() - skipping " + entry.filename + ", it doesn't contain a refractive index table");
+                continue;
+            }
+            cache[entry.hash] = entry.result;
+            materials.push_back(entry.result);
+        }
+        if (bakedCount > 0) saveCache(cache);
+
+        std::sort(materials.begin(), materials.end(), [](const RgbMaterial& a, const RgbMaterial& b) { return a.name < b.name; });
+        logInfo("SpectralIoR - loaded " + std::to_string(materials.size()) + " materials from " + directory + ", " + std::to_string(bakedCount.load()) + " of them were integrated");
+        return materials;
+    }
+}
@@ -0,0 +1,104 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+    /** Tabulated spectral refractive indices and their RGB-effective values.
+        Materials are loaded from CSV files as exported by refractiveindex.info, with wavelengths in micrometers. A file holds one or more
+        sections that start with a header line, either "wl,n" and "wl,k" in separate sections, or "wl,n,k" in a single one.
+        The reflectance and psi are integrated over the visible spectrum against the CIE 1931 color-matching functions, and converted to
+        linear sRGB so that a perfect reflector is white. The effective n and k of each channel are then fitted to the integrated curves,
+        so they can be used with psi_Exact() and SpecularFromIOR() at no extra per-frame cost.
+    */
+    class SpectralIoR
+    {
+    public:
+        /** A tabulated refractive index
+        */
+        struct Material
+        {
+            std::string name;
+            std::vector<vec2> n;    ///< (wavelength in nm, n), sorted by wavelength
+            std::vector<vec2> k;    ///< (wavelength in nm, k), sorted by wavelength. Empty for dielectrics.
+        };
+
+        /** The RGB-effective values of a material
+        */
+        struct RgbMaterial
+        {
+            std::string name;
+            vec3 n;                     ///< Effective simple refractive index
+            vec3 k;                     ///< Effective extinction coefficient
+            vec3 R0;                    ///< Integrated reflectance at normal incidence
+            bool isDielectric = false;  ///< True if k is zero over the whole spectrum
+            float fitError = 0;         ///< RMS difference between the integrated reflectance and psi and those of the effective n and k
+        };
+
+        /** Load a CSV file. The material is named after the file.
+            \param[in] filename The file to load
+            \param[out] material The material
+            \return true on success, otherwise false
+        */
+        static bool loadCsv(const std::string& filename, Material& material);
+
+        /** Parse the contents of a CSV file
+            \param[in] csv The file contents
+            \param[out] material The material. The name is left as is.
+            \return true on success, otherwise false
+        */
+        static bool parseCsv(const std::string& csv, Material& material);
+
+        /** Evaluate the refractive index at a wavelength. Values are interpolated linearly, and clamped outside the tabulated range.
+            \return (n, k)
+        */
+        static vec2 evaluate(const Material& material, float wavelength);
+
+        /** Fresnel reflectance of a conductor for s- and p-polarized light. The unpolarized reflectance is (Rs + Rp)/2,
+            and psi is (Rs - Rp)/(Rs + Rp).
+            \return (Rs, Rp)
+        */
+        static vec2 evaluateFresnel(float n, float k, float cosTheta);
+
+        /** Integrate a material to RGB and fit the effective n and k
+        */
+        static RgbMaterial integrate(const Material& material);
+
+        /** Load and integrate every CSV file in a directory, in parallel. Results are cached next to the executable, keyed by the
+            contents of the files, so that unchanged files are only read.
+            \param[in] directory The directory
+            \param[in] threadCount Number of worker threads. 0 will use all hardware threads.
+            \return The materials, sorted by name. Files that can't be loaded are skipped.
+        */
+        static std::vector<RgbMaterial> loadDirectory(const std::string& directory, uint32_t threadCount = 0);
+    };
+}
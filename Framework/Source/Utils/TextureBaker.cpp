@@ -0,0 +1,494 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TextureBaker.h"
+#include "Utils/Bitmap.h"
+#include "Utils/BlockCompression.h"
+#include "Utils/DDSHeader.h"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/ThreadPool.h"
+#include "glm/gtc/packing.hpp"
+#include "Utils/Math/SimdVec.h"
+#include <cstring>
+
+namespace Falcor
+{
+    using namespace DdsHelper;
+
+    namespace
+    {
+        const uint32_t kDdsMagicNumber = 0x20534444;
+        const uint32_t kDx10FourCC = 0x30315844;    // "DX10"
+
+        // Kaiser filter parameters, in destination texels
+        const float kKaiserWidth = 3.0f;
+        const float kKaiserAlpha = 4.0f;
+
+        float srgbToLinear(float c)
+        {
+            return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float linearToSrgb(float c)
+        {
+            return (c <= 0.0031308f) ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+        }
+
+        const float* getSrgbToLinearTable()
+        {
+            static float sTable[256];
+            static bool sInitialized = []()
+            {
+                for (uint32_t i = 0; i < 256; i++) sTable[i] = srgbToLinear(i / 255.0f);
+                return true;
+            }();
+            (void)sInitialized;
+            return sTable;
+        }
+
+        uint8_t toUnorm8(float c)
+        {
+            return (uint8_t)clamp(int32_t(c * 255.0f + 0.5f), 0, 255);
+        }
+
+        /** Accumulate weight * src into dst for a single RGBA texel
+        */
+        inline void madd(vec4& dst, const vec4& src, float weight)
+        {
+#ifdef FALCOR_USE_SSE2
+            __m128 d = _mm_loadu_ps(&dst.x);
+            __m128 s = _mm_loadu_ps(&src.x);
+            _mm_storeu_ps(&dst.x, _mm_add_ps(d, _mm_mul_ps(s, _mm_set1_ps(weight))));
+#else
+            dst += src * weight;
+#endif
+        }
+
+        /** Average of 4 RGBA texels
+        */
+        inline vec4 average4(const vec4& a, const vec4& b, const vec4& c, const vec4& d)
+        {
+#ifdef FALCOR_USE_SSE2
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(&a.x), _mm_loadu_ps(&b.x)), _mm_add_ps(_mm_loadu_ps(&c.x), _mm_loadu_ps(&d.x)));
+            vec4 result;
+            _mm_storeu_ps(&result.x, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+            return result;
+#else
+            return (a + b + c + d) * 0.25f;
+#endif
+        }
+
+        float besselI0(float x)
+        {
+            // Power series, converges quickly for the small arguments used by the filter
+            float sum = 1.0f;
+            float term = 1.0f;
+            for (uint32_t k = 1; k < 32; k++)
+            {
+                float f = x / (2.0f * k);
+                term *= f * f;
+                sum += term;
+                if (term < sum * 1e-8f) break;
+            }
+            return sum;
+        }
+
+        float kaiserSinc(float x)
+        {
+            float t = x / kKaiserWidth;
+            if (t * t >= 1.0f) return 0.0f;
+            float window = besselI0(kKaiserAlpha * std::sqrt(1.0f - t * t)) / besselI0(kKaiserAlpha);
+            float sinc = (x == 0.0f) ? 1.0f : std::sin(float(M_PI) * x) / (float(M_PI) * x);
+            return sinc * window;
+        }
+
+        /** Filter taps for a 2:1 decimation. Tap i applies to source texel (2 * dst + kKaiserFirstTap + i).
+        */
+        const int32_t kKaiserFirstTap = 1 - 2 * int32_t(kKaiserWidth);
+        const uint32_t kKaiserTapCount = 4 * uint32_t(kKaiserWidth);
+
+        const float* getKaiserTaps()
+        {
+            static float sTaps[kKaiserTapCount];
+            static bool sInitialized = []()
+            {
+                float sum = 0;
+                for (uint32_t i = 0; i < kKaiserTapCount; i++)
+                {
+                    // Distance between the source and destination texel centers, in destination texels
+                    float x = (float(kKaiserFirstTap + int32_t(i)) - 0.5f) * 0.5f;
+                    sTaps[i] = kaiserSinc(x);
+                    sum += sTaps[i];
+                }
+                for (uint32_t i = 0; i < kKaiserTapCount; i++) sTaps[i] /= sum;
+                return true;
+            }();
+            (void)sInitialized;
+            return sTaps;
+        }
+
+        /** 1D Kaiser decimation along one axis. The image is addressed as texels[line * lineStride + i * texelStride].
+        */
+        void kaiserPass(const vec4* pSrc, vec4* pDst, uint32_t srcCount, uint32_t dstCount, uint32_t lines, uint32_t srcTexelStride, uint32_t srcLineStride, uint32_t dstTexelStride, uint32_t dstLineStride, uint32_t threadCount)
+        {
+            const float* pTaps = getKaiserTaps();
+            parallelFor(lines, threadCount, [&](uint32_t line)
+            {
+                const vec4* pSrcLine = pSrc + line * srcLineStride;
+                vec4* pDstLine = pDst + line * dstLineStride;
+                for (uint32_t x = 0; x < dstCount; x++)
+                {
+                    vec4 sum(0);
+                    for (uint32_t t = 0; t < kKaiserTapCount; t++)
+                    {
+                        int32_t s = clamp(int32_t(2 * x) + kKaiserFirstTap + int32_t(t), 0, int32_t(srcCount) - 1);
+                        madd(sum, pSrcLine[s * srcTexelStride], pTaps[t]);
+                    }
+                    // The negative lobes can produce values outside the valid range
+                    sum = max(sum, vec4(0));
+                    sum.a = min(sum.a, 1.0f);
+                    pDstLine[x * dstTexelStride] = sum;
+                }
+            });
+        }
+
+        DXFormat getDxgiFormat(ResourceFormat format)
+        {
+            switch (format)
+            {
+            case ResourceFormat::RGBA8Unorm:
+                return FORMAT_R8G8B8A8_UNORM;
+            case ResourceFormat::RGBA8UnormSrgb:
+                return FORMAT_R8G8B8A8_UNORM_SRGB;
+            case ResourceFormat::RGBA16Float:
+                return FORMAT_R16G16B16A16_FLOAT;
+            case ResourceFormat::RGBA32Float:
+                return FORMAT_R32G32B32A32_FLOAT;
+            case ResourceFormat::BC1Unorm:
+                return FORMAT_BC1_UNORM;
+            case ResourceFormat::BC1UnormSrgb:
+                return FORMAT_BC1_UNORM_SRGB;
+            case ResourceFormat::BC3Unorm:
+                return FORMAT_BC3_UNORM;
+            case ResourceFormat::BC3UnormSrgb:
+                return FORMAT_BC3_UNORM_SRGB;
+            case ResourceFormat::BC4Unorm:
+                return FORMAT_BC4_UNORM;
+            case ResourceFormat::BC5Unorm:
+                return FORMAT_BC5_UNORM;
+            case ResourceFormat::BC7Unorm:
+                return FORMAT_BC7_UNORM;
+            case ResourceFormat::BC7UnormSrgb:
+                return FORMAT_BC7_UNORM_SRGB;
+            default:
+                return FORMAT_UNKNOWN;
+            }
+        }
+
+        ResourceFormat getOutputFormat(const TextureBaker::Desc& desc, bool isHdr, bool isSrgb)
+        {
+            if (isHdr)
+            {
+                if (desc.compression != TextureBaker::Compression::None)
+                {
+                    logWarning("TextureBaker - block compression of HDR images is not supported. Storing as RGBA16Float.");
+                }
+                return ResourceFormat::RGBA16Float;
+            }
+
+            switch (desc.compression)
+            {
+            case TextureBaker::Compression::None:
+                return isSrgb ? ResourceFormat::RGBA8UnormSrgb : ResourceFormat::RGBA8Unorm;
+            case TextureBaker::Compression::BC1:
+                return isSrgb ? ResourceFormat::BC1UnormSrgb : ResourceFormat::BC1Unorm;
+            case TextureBaker::Compression::BC3:
+                return isSrgb ? ResourceFormat::BC3UnormSrgb : ResourceFormat::BC3Unorm;
+            case TextureBaker::Compression::BC5:
+                return ResourceFormat::BC5Unorm;
+            case TextureBaker::Compression::BC7:
+                return isSrgb ? ResourceFormat::BC7UnormSrgb : ResourceFormat::BC7Unorm;
+            default:
+                should_not_get_here();
+                return ResourceFormat::Unknown;
+            }
+        }
+    }
+
+    TextureBaker::Image TextureBaker::createImage(const Bitmap* pBitmap, bool isSrgb)
+    {
+        Image image;
+        image.width = pBitmap->getWidth();
+        image.height = pBitmap->getHeight();
+        image.texels.resize(image.width * image.height);
+
+        const ResourceFormat format = pBitmap->getFormat();
+        const uint32_t texelCount = image.width * image.height;
+        const uint8_t* pData = pBitmap->getData();
+        const float* pSrgbTable = getSrgbToLinearTable();
+        auto toLinear = [&](uint8_t c) { return isSrgb ? pSrgbTable[c] : c / 255.0f; };
+
+        for (uint32_t i = 0; i < texelCount; i++)
+        {
+            vec4& t = image.texels[i];
+            switch (format)
+            {
+            case ResourceFormat::RGBA32Float:
+                std::memcpy(&t.x, pData + i * 16, 16);
+                break;
+            case ResourceFormat::RGB32Float:
+                std::memcpy(&t.x, pData + i * 12, 12);
+                t.a = 1;
+                break;
+            case ResourceFormat::RGBA16Float:
+            case ResourceFormat::RGB16Float:
+            {
+                uint32_t channels = getFormatChannelCount(format);
+                const uint16_t* pHalf = (const uint16_t*)pData + i * channels;
+                for (uint32_t c = 0; c < channels; c++) t[c] = unpackHalf1x16(pHalf[c]);
+                if (channels == 3) t.a = 1;
+                break;
+            }
+            case ResourceFormat::BGRA8Unorm:
+            case ResourceFormat::BGRX8Unorm:
+            {
+                const uint8_t* pTexel = pData + i * 4;
+                t = vec4(toLinear(pTexel[2]), toLinear(pTexel[1]), toLinear(pTexel[0]), pTexel[3] / 255.0f);
+                break;
+            }
+            case ResourceFormat::RG8Unorm:
+                t = vec4(pData[i * 2] / 255.0f, pData[i * 2 + 1] / 255.0f, 0, 1);
+                break;
+            case ResourceFormat::R8Unorm:
+                t = vec4(pData[i] / 255.0f, 0, 0, 1);
+                break;
+            default:
+                logError("TextureBaker::createImage() - unsupported bitmap format " + to_string(format));
+                return Image();
+            }
+        }
+        return image;
+    }
+
+    TextureBaker::Image TextureBaker::downsample(const Image& image, MipFilter filter, uint32_t threadCount)
+    {
+        Image dst;
+        dst.width = std::max(1u, image.width / 2);
+        dst.height = std::max(1u, image.height / 2);
+        dst.texels.resize(dst.width * dst.height);
+
+        if (filter == MipFilter::Box)
+        {
+            parallelFor(dst.height, threadCount, [&](uint32_t y)
+            {
+                const vec4* pRow0 = image.texels.data() + std::min(2 * y, image.height - 1) * image.width;
+                const vec4* pRow1 = image.texels.data() + std::min(2 * y + 1, image.height - 1) * image.width;
+                vec4* pDst = dst.texels.data() + y * dst.width;
+                for (uint32_t x = 0; x < dst.width; x++)
+                {
+                    uint32_t x0 = std::min(2 * x, image.width - 1);
+                    uint32_t x1 = std::min(2 * x + 1, image.width - 1);
+                    pDst[x] = average4(pRow0[x0], pRow0[x1], pRow1[x0], pRow1[x1]);
+                }
+            });
+        }
+        else
+        {
+            // Separable filter, horizontal pass into a temporary image followed by a vertical pass
+            std::vector<vec4> temp(dst.width * image.height);
+            if (image.width > 1)
+            {
+                kaiserPass(image.texels.data(), temp.data(), image.width, dst.width, image.height, 1, image.width, 1, dst.width, threadCount);
+            }
+            else
+            {
+                temp = image.texels;
+            }
+
+            if (image.height > 1)
+            {
+                kaiserPass(temp.data(), dst.texels.data(), image.height, dst.height, dst.width, dst.width, 1, dst.width, 1, threadCount);
+            }
+            else
+            {
+                dst.texels = temp;
+            }
+        }
+        return dst;
+    }
+
+    std::vector<TextureBaker::Image> TextureBaker::generateMipChain(const Image& image, MipFilter filter, uint32_t threadCount)
+    {
+        uint32_t mipCount = bitScanReverse(image.width | image.height) + 1;
+        std::vector<Image> mips;
+        mips.reserve(mipCount);
+        mips.push_back(image);
+        for (uint32_t i = 1; i < mipCount; i++)
+        {
+            mips.push_back(downsample(mips.back(), filter, threadCount));
+        }
+        return mips;
+    }
+
+    std::vector<uint8_t> TextureBaker::encodeMipChain(const std::vector<Image>& mips, ResourceFormat format, uint32_t threadCount)
+    {
+        const bool srgb = isSrgbFormat(format);
+        auto encodeRgba8 = [&](const Image& mip, uint8_t* pDst)
+        {
+            parallelFor(mip.height, threadCount, [&](uint32_t y)
+            {
+                for (uint32_t x = 0; x < mip.width; x++)
+                {
+                    const vec4& t = mip.texels[y * mip.width + x];
+                    uint8_t* pTexel = pDst + (y * mip.width + x) * 4;
+                    for (uint32_t c = 0; c < 3; c++) pTexel[c] = toUnorm8(srgb ? linearToSrgb(clamp(t[c], 0.0f, 1.0f)) : t[c]);
+                    pTexel[3] = toUnorm8(t.a);
+                }
+            });
+        };
+
+        std::vector<uint8_t> data;
+        for (const auto& mip : mips)
+        {
+            const uint32_t texelCount = mip.width * mip.height;
+            const size_t offset = data.size();
+            switch (format)
+            {
+            case ResourceFormat::RGBA32Float:
+                data.resize(offset + texelCount * sizeof(vec4));
+                std::memcpy(data.data() + offset, mip.texels.data(), texelCount * sizeof(vec4));
+                break;
+            case ResourceFormat::RGBA16Float:
+            {
+                data.resize(offset + texelCount * 4 * sizeof(uint16_t));
+                uint16_t* pDst = (uint16_t*)(data.data() + offset);
+                for (uint32_t i = 0; i < texelCount * 4; i++) pDst[i] = packHalf1x16(mip.texels[i / 4][i % 4]);
+                break;
+            }
+            case ResourceFormat::RGBA8Unorm:
+            case ResourceFormat::RGBA8UnormSrgb:
+                data.resize(offset + texelCount * 4);
+                encodeRgba8(mip, data.data() + offset);
+                break;
+            default:
+            {
+                if (isCompressedFormat(format) == false)
+                {
+                    logError("TextureBaker::encodeMipChain() - unsupported format " + to_string(format));
+                    return {};
+                }
+                std::vector<uint8_t> rgba(texelCount * 4);
+                encodeRgba8(mip, rgba.data());
+                std::vector<uint8_t> blocks = BlockCompression::compressImage(format, mip.width, mip.height, rgba.data(), threadCount);
+                if (blocks.empty()) return {};
+                data.insert(data.end(), blocks.begin(), blocks.end());
+                break;
+            }
+            }
+        }
+        return data;
+    }
+
+    bool TextureBaker::saveDds(const std::string& filename, ResourceFormat format, uint32_t width, uint32_t height, uint32_t mipCount, const void* pData, size_t size)
+    {
+        DXFormat dxFormat = getDxgiFormat(format);
+        if (dxFormat == FORMAT_UNKNOWN)
+        {
+            logError("TextureBaker::saveDds() - format " + to_string(format) + " is not supported");
+            return false;
+        }
+
+        DdsHeader header = {};
+        header.headerSize = sizeof(DdsHeader);
+        header.flags = DdsHeader::kCapsMask | DdsHeader::kHeightMask | DdsHeader::kWidthMask | DdsHeader::kPixelFormatMask | DdsHeader::kMipCountMask;
+        header.width = width;
+        header.height = height;
+        header.depth = 1;
+        header.mipCount = mipCount;
+        if (isCompressedFormat(format))
+        {
+            header.flags |= DdsHeader::kLinearSizeMask;
+            header.linearSize = std::max(1u, (width + 3) / 4) * std::max(1u, (height + 3) / 4) * getFormatBytesPerBlock(format);
+        }
+        else
+        {
+            header.flags |= DdsHeader::kPitchMask;
+            header.pitch = width * getFormatBytesPerBlock(format);
+        }
+        header.pixelFormat.structSize = sizeof(DdsHeader::PixelFormat);
+        header.pixelFormat.flags = DdsHeader::PixelFormat::kFourCCFlag;
+        header.pixelFormat.fourCC = kDx10FourCC;
+        header.caps[0] = DdsHeader::kCapsTextureMask;
+        if (mipCount > 1) header.caps[0] |= DdsHeader::kCapsComplexMask | DdsHeader::kCapsMipMapMask;
+
+        DdsHeaderDX10 dx10Header = {};
+        dx10Header.dxgiFormat = dxFormat;
+        dx10Header.resourceDimension = RESOURCE_DIMENSION_TEXTURE2D;
+        dx10Header.arraySize = 1;
+
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+        stream << kDdsMagicNumber << header << dx10Header;
+        stream.write(pData, size);
+        if (stream.isFail())
+        {
+            logError("TextureBaker::saveDds() - failed to write " + filename);
+            return false;
+        }
+        return true;
+    }
+
+    bool TextureBaker::bakeFile(const std::string& srcFilename, const std::string& dstFilename, const Desc& desc)
+    {
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(srcFilename, true);
+        if (pBitmap == nullptr) return false;
+
+        const ResourceFormat srcFormat = pBitmap->getFormat();
+        const bool isHdr = getFormatType(srcFormat) == FormatType::Float;
+        const bool isSrgb = desc.isSrgb && (isHdr == false) && getFormatChannelCount(srcFormat) >= 3 && desc.compression != Compression::BC5;
+
+        Image image = createImage(pBitmap.get(), isSrgb);
+        if (image.texels.empty()) return false;
+        pBitmap = nullptr;
+
+        std::vector<Image> mips;
+        if (desc.generateMips)
+        {
+            mips = generateMipChain(image, desc.filter, desc.threadCount);
+        }
+        else
+        {
+            mips.push_back(std::move(image));
+        }
+
+        ResourceFormat dstFormat = getOutputFormat(desc, isHdr, isSrgb);
+        std::vector<uint8_t> data = encodeMipChain(mips, dstFormat, desc.threadCount);
+        if (data.empty()) return false;
+
+        return saveDds(dstFilename, dstFormat, mips[0].width, mips[0].height, (uint32_t)mips.size(), data.data(), data.size());
+    }
+}
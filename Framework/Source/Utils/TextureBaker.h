@@ -0,0 +1,119 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+    class Bitmap;
+
+    /** Offline texture processing. Builds mip-chains on the CPU, optionally block-compresses them and writes the result as a DDS file.
+        Nothing in this class requires a device, so it can run as part of asset preprocessing on machines without a GPU.
+        Textures created from the baked DDS files already contain the full mip-chain, so loading them skips mip generation.
+    */
+    class TextureBaker
+    {
+    public:
+        /** Filter used to generate the mip-chain
+        */
+        enum class MipFilter
+        {
+            Box,        ///< 2x2 box filter
+            Kaiser,     ///< Separable Kaiser-windowed sinc filter. Sharper than the box filter, at a higher cost.
+        };
+
+        /** Output compression
+        */
+        enum class Compression
+        {
+            None,   ///< Store uncompressed. RGBA8 for LDR images, RGBA16F for HDR images.
+            BC1,    ///< RGB, 4 bits per texel
+            BC3,    ///< RGBA, 8 bits per texel
+            BC5,    ///< Two channel (RG), 8 bits per texel. Suitable for normal maps. Always stored as linear data.
+            BC7,    ///< RGBA, 8 bits per texel, higher quality than BC3
+        };
+
+        struct Desc
+        {
+            MipFilter filter = MipFilter::Box;
+            Compression compression = Compression::None;
+            bool generateMips = true;   ///< If false, only the top level is stored
+            bool isSrgb = true;         ///< Treat the color channels of 8-bit images as sRGB-encoded. Filtering is done in linear space and the output uses an sRGB format.
+            uint32_t threadCount = 0;   ///< Number of worker threads. 0 will use all hardware threads.
+        };
+
+        /** A linear-space RGBA image with 32-bit float channels
+        */
+        struct Image
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<vec4> texels;
+        };
+
+        /** Load an image file, process it and write a DDS file.
+            \param[in] srcFilename The source image. Any format supported by Bitmap can be used. The file is searched for in the data directories.
+            \param[in] dstFilename The output DDS file
+            \param[in] desc Processing options
+            \return true on success, otherwise false
+        */
+        static bool bakeFile(const std::string& srcFilename, const std::string& dstFilename, const Desc& desc);
+
+        /** Convert a bitmap into a linear-space float image.
+            \param[in] pBitmap The source bitmap
+            \param[in] isSrgb Whether the color channels of 8-bit formats are sRGB-encoded
+        */
+        static Image createImage(const Bitmap* pBitmap, bool isSrgb);
+
+        /** Generate the full mip-chain for an image. The number of levels matches what Texture uses for Texture::kMaxPossible.
+            \return The mip levels, starting with a copy of the source image
+        */
+        static std::vector<Image> generateMipChain(const Image& image, MipFilter filter, uint32_t threadCount = 0);
+
+        /** Downsample an image by 2 in each dimension. Dimensions of 1 are kept.
+        */
+        static Image downsample(const Image& image, MipFilter filter, uint32_t threadCount = 0);
+
+        /** Convert a mip-chain into the texel data of a texture with the given format. Mip levels are stored consecutively.
+            \param[in] format RGBA8Unorm, RGBA8UnormSrgb, RGBA16Float, RGBA32Float or one of the formats supported by BlockCompression
+            \return The texel data, or an empty vector if the format isn't supported
+        */
+        static std::vector<uint8_t> encodeMipChain(const std::vector<Image>& mips, ResourceFormat format, uint32_t threadCount = 0);
+
+        /** Write a 2D texture to a DDS file with a DX10 header.
+            \param[in] filename The output filename
+            \param[in] format The texture format
+            \param[in] mipCount Number of mip levels stored in pData
+            \param[in] pData Texel data of all mip levels, as returned from encodeMipChain()
+            \param[in] size Size of pData in bytes
+            \return true on success, otherwise false
+        */
+        static bool saveDds(const std::string& filename, ResourceFormat format, uint32_t width, uint32_t height, uint32_t mipCount, const void* pData, size_t size);
+    };
+}
@@ -25,7 +25,11 @@
 # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
+#pragma once
+#include <algorithm>
+#include <atomic>
 #include <thread>
+#include <vector>
 
 template<uint32_t threadCount>
 class ThreadPool
@@ -50,4 +54,34 @@ public:
 private:
     std::thread mThreads[threadCount];
     uint32_t mCurrent = 0;
-};
\ No newline at end of file
+};
+
+/** Calls func(i) for every i in [0, count), distributing the indices dynamically across worker threads.
+    The calling thread participates in the work, and the function returns once all indices were processed.
+    \param[in] count Number of work items
+    \param[in] threadCount Maximum number of threads to use. 0 will use all hardware threads.
+    \param[in] func The callable to run. Must be safe to call concurrently for different indices.
+*/
+template<typename Func>
+void parallelFor(uint32_t count, uint32_t threadCount, const Func& func)
+{
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, count);
+    if (threadCount <= 1)
+    {
+        for (uint32_t i = 0; i < count; i++) func(i);
+        return;
+    }
+
+    std::atomic<uint32_t> next(0);
+    auto worker = [&]()
+    {
+        for (uint32_t i = next++; i < count; i = next++) func(i);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (uint32_t t = 1; t < threadCount; t++) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+}
@@ -0,0 +1,298 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TriangleBvh.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kBinCount = 12;
+        const uint32_t kMaxLeafSize = 8;
+        const uint32_t kMaxDepth = 64;
+
+        struct Bounds
+        {
+            vec3 min = vec3(FLT_MAX);
+            vec3 max = vec3(-FLT_MAX);
+
+            void grow(const vec3& p) { min = glm::min(min, p); max = glm::max(max, p); }
+            void grow(const Bounds& b) { min = glm::min(min, b.min); max = glm::max(max, b.max); }
+
+            float area() const
+            {
+                vec3 d = max - min;
+                return (d.x < 0) ? 0.0f : 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+            }
+        };
+
+        struct BuildItem
+        {
+            Bounds bounds;
+            vec3 centroid;
+            uint32_t triangle;
+        };
+
+        class Builder
+        {
+        public:
+            Builder(std::vector<BuildItem>& items, std::vector<uint32_t>& order) : mItems(items), mOrder(order) {}
+
+            /** Fill in the node of the range [begin, end) and append its subtree to nodes
+            */
+            template<typename Node>
+            void build(std::vector<Node>& nodes, uint32_t nodeIndex, uint32_t begin, uint32_t end, uint32_t depth)
+            {
+                Bounds bounds, centroidBounds;
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    bounds.grow(mItems[i].bounds);
+                    centroidBounds.grow(mItems[i].centroid);
+                }
+                nodes[nodeIndex].boundsMin = bounds.min;
+                nodes[nodeIndex].boundsMax = bounds.max;
+
+                uint32_t count = end - begin;
+                uint32_t mid = (count > 2 && depth < kMaxDepth) ? split(begin, end, bounds, centroidBounds) : begin;
+                if (mid == begin || mid == end)
+                {
+                    nodes[nodeIndex].first = (uint32_t)mOrder.size();
+                    nodes[nodeIndex].count = count;
+                    for (uint32_t i = begin; i < end; i++) mOrder.push_back(mItems[i].triangle);
+                    return;
+                }
+
+                // The first child follows its parent, the second child follows the subtree of the first
+                nodes[nodeIndex].count = 0;
+                nodes.emplace_back();
+                build(nodes, nodeIndex + 1, begin, mid, depth + 1);
+                nodes[nodeIndex].first = (uint32_t)nodes.size();
+                nodes.emplace_back();
+                build(nodes, nodes[nodeIndex].first, mid, end, depth + 1);
+            }
+
+        private:
+            /** Partition [begin, end) and return the start of the second half, or begin to make a leaf
+            */
+            uint32_t split(uint32_t begin, uint32_t end, const Bounds& bounds, const Bounds& centroidBounds)
+            {
+                uint32_t count = end - begin;
+                vec3 extent = centroidBounds.max - centroidBounds.min;
+                uint32_t axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : (extent.y > extent.z ? 1 : 2);
+                if (extent[axis] <= 0)
+                {
+                    // All centroids coincide. Split in the middle if the leaf would be too large.
+                    return count > kMaxLeafSize ? begin + count / 2 : begin;
+                }
+
+                // Bin the centroids along the longest axis
+                Bounds binBounds[kBinCount];
+                uint32_t binCounts[kBinCount] = {};
+                float scale = kBinCount / extent[axis];
+                auto getBin = [&](const BuildItem& item)
+                {
+                    return std::min(kBinCount - 1, uint32_t((item.centroid[axis] - centroidBounds.min[axis]) * scale));
+                };
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    uint32_t b = getBin(mItems[i]);
+                    binBounds[b].grow(mItems[i].bounds);
+                    binCounts[b]++;
+                }
+
+                // Sweep from the right to get the area of every suffix, then from the left to evaluate the splits
+                float rightArea[kBinCount];
+                Bounds right;
+                for (uint32_t b = kBinCount - 1; b > 0; b--)
+                {
+                    right.grow(binBounds[b]);
+                    rightArea[b] = right.area();
+                }
+
+                float bestCost = FLT_MAX;
+                uint32_t bestBin = 0;
+                Bounds left;
+                uint32_t leftCount = 0;
+                for (uint32_t b = 0; b < kBinCount - 1; b++)
+                {
+                    left.grow(binBounds[b]);
+                    leftCount += binCounts[b];
+                    float cost = left.area() * leftCount + rightArea[b + 1] * (count - leftCount);
+                    if (leftCount > 0 && leftCount < count && cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestBin = b;
+                    }
+                }
+
+                // Compare with the cost of a leaf, with a traversal step costing about as much as one triangle test
+                float leafCost = bounds.area() * count;
+                if (bestCost == FLT_MAX || (bestCost + bounds.area() >= leafCost && count <= kMaxLeafSize))
+                {
+                    return count > kMaxLeafSize ? begin + count / 2 : begin;
+                }
+
+                auto it = std::partition(mItems.begin() + begin, mItems.begin() + end, [&](const BuildItem& item) { return getBin(item) <= bestBin; });
+                return uint32_t(it - mItems.begin());
+            }
+
+            std::vector<BuildItem>& mItems;
+            std::vector<uint32_t>& mOrder;
+        };
+
+        inline bool intersectBounds(const vec3& boundsMin, const vec3& boundsMax, const vec3& origin, const vec3& invDir, float tMax, float& tEntry)
+        {
+            vec3 t0 = (boundsMin - origin) * invDir;
+            vec3 t1 = (boundsMax - origin) * invDir;
+            vec3 tNear = glm::min(t0, t1);
+            vec3 tFar = glm::max(t0, t1);
+            tEntry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+            float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+            return tEntry <= tExit;
+        }
+    }
+
+    void TriangleBvh::build(const std::vector<vec3>& positions)
+    {
+        uint32_t triangleCount = (uint32_t)(positions.size() / 3);
+        mNodes.clear();
+        mTriangles.clear();
+        if (triangleCount == 0) return;
+
+        std::vector<BuildItem> items(triangleCount);
+        for (uint32_t i = 0; i < triangleCount; i++)
+        {
+            BuildItem& item = items[i];
+            for (uint32_t j = 0; j < 3; j++) item.bounds.grow(positions[i * 3 + j]);
+            item.centroid = 0.5f * (item.bounds.min + item.bounds.max);
+            item.triangle = i;
+        }
+
+        // An unbalanced tree has at most 2n - 1 nodes
+        std::vector<uint32_t> order;
+        order.reserve(triangleCount);
+        mNodes.reserve(2 * triangleCount);
+        mNodes.emplace_back();
+        Builder(items, order).build(mNodes, 0, 0, triangleCount, 0);
+
+        // Store the triangles in leaf order, so that each leaf reads a contiguous range
+        mTriangles.resize(triangleCount);
+        for (uint32_t i = 0; i < triangleCount; i++)
+        {
+            const vec3* v = &positions[order[i] * 3];
+            mTriangles[i] = { v[0], v[1] - v[0], v[2] - v[0], order[i] };
+        }
+    }
+
+    template<bool kAnyHit>
+    bool TriangleBvh::traverse(const vec3& origin, const vec3& dir, float tMax, Hit& hit) const
+    {
+        if (mNodes.empty()) return false;
+
+        // Avoid 0 * inf = NaN in the slab tests of axis-aligned rays
+        vec3 invDir;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            invDir[i] = 1.0f / (std::abs(dir[i]) > 1e-20f ? dir[i] : std::copysign(1e-20f, dir[i]));
+        }
+        bool found = false;
+        float tEntry;
+        if (intersectBounds(mNodes[0].boundsMin, mNodes[0].boundsMax, origin, invDir, tMax, tEntry) == false) return false;
+
+        uint32_t stack[kMaxDepth + 1];
+        uint32_t stackSize = 0;
+        uint32_t nodeIndex = 0;
+        while (true)
+        {
+            const Node& node = mNodes[nodeIndex];
+            if (node.count > 0)
+            {
+                // Moller-Trumbore
+                for (uint32_t i = node.first; i < node.first + node.count; i++)
+                {
+                    const Triangle& tri = mTriangles[i];
+                    vec3 p = glm::cross(dir, tri.e2);
+                    float det = glm::dot(tri.e1, p);
+                    if (det == 0) continue;
+                    float invDet = 1.0f / det;
+                    vec3 s = origin - tri.v0;
+                    float u = glm::dot(s, p) * invDet;
+                    if (u < 0 || u > 1) continue;
+                    vec3 q = glm::cross(s, tri.e1);
+                    float v = glm::dot(dir, q) * invDet;
+                    if (v < 0 || u + v > 1) continue;
+                    float t = glm::dot(tri.e2, q) * invDet;
+                    if (t <= 0 || t >= tMax) continue;
+
+                    if (kAnyHit) return true;
+                    tMax = t;
+                    hit = { t, tri.index, u, v };
+                    found = true;
+                }
+            }
+            else
+            {
+                // Visit the closer child first
+                uint32_t a = nodeIndex + 1;
+                uint32_t b = node.first;
+                float tA, tB;
+                bool hitA = intersectBounds(mNodes[a].boundsMin, mNodes[a].boundsMax, origin, invDir, tMax, tA);
+                bool hitB = intersectBounds(mNodes[b].boundsMin, mNodes[b].boundsMax, origin, invDir, tMax, tB);
+                if (hitA && hitB)
+                {
+                    if (tB < tA) std::swap(a, b);
+                    stack[stackSize++] = b;
+                    nodeIndex = a;
+                    continue;
+                }
+                if (hitA || hitB)
+                {
+                    nodeIndex = hitA ? a : b;
+                    continue;
+                }
+            }
+
+            if (stackSize == 0) break;
+            nodeIndex = stack[--stackSize];
+        }
+        return found;
+    }
+
+    bool TriangleBvh::intersect(const vec3& origin, const vec3& dir, float tMax, Hit& hit) const
+    {
+        return traverse<false>(origin, dir, tMax, hit);
+    }
+
+    bool TriangleBvh::occluded(const vec3& origin, const vec3& dir, float tMax) const
+    {
+        Hit hit;
+        return traverse<true>(origin, dir, tMax, hit);
+    }
+}
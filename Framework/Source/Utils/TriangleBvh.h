@@ -0,0 +1,94 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+
+namespace Falcor
+{
+    /** A bounding volume hierarchy over a triangle soup, for ray casting on the CPU.
+        The tree is built with a binned surface area heuristic and stored as a flat array of nodes in depth-first order.
+        Queries don't modify the object, so a built BVH can be traversed from many threads at once.
+    */
+    class TriangleBvh
+    {
+    public:
+        /** Result of a closest-hit query
+        */
+        struct Hit
+        {
+            float t;            ///< Distance along the ray, in units of the ray direction
+            uint32_t triangle;  ///< Index of the triangle
+            float u;            ///< Barycentric weight of the second vertex
+            float v;            ///< Barycentric weight of the third vertex
+        };
+
+        /** Build the tree
+            \param[in] positions Three vertices per triangle
+        */
+        void build(const std::vector<vec3>& positions);
+
+        /** Find the closest intersection in (0, tMax)
+            \param[in] origin Ray origin
+            \param[in] dir Ray direction. Doesn't need to be normalized.
+            \param[in] tMax Maximum distance
+            \param[out] hit The closest hit, if there is one
+            \return Whether the ray hit a triangle
+        */
+        bool intersect(const vec3& origin, const vec3& dir, float tMax, Hit& hit) const;
+
+        /** Check if any triangle intersects the ray in (0, tMax). Faster than intersect(), since the traversal stops at the first hit.
+        */
+        bool occluded(const vec3& origin, const vec3& dir, float tMax) const;
+
+        uint32_t getTriangleCount() const { return (uint32_t)mTriangles.size(); }
+        uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+
+    private:
+        struct Node
+        {
+            vec3 boundsMin;
+            uint32_t first;     ///< Leaf: first entry in mTriangles. Inner node: index of the second child, the first child follows this node.
+            vec3 boundsMax;
+            uint32_t count;     ///< Number of triangles, 0 for inner nodes
+        };
+
+        struct Triangle
+        {
+            vec3 v0;
+            vec3 e1;            ///< v1 - v0
+            vec3 e2;            ///< v2 - v0
+            uint32_t index;     ///< Index in the input
+        };
+
+        template<bool kAnyHit>
+        bool traverse(const vec3& origin, const vec3& dir, float tMax, Hit& hit) const;
+
+        std::vector<Node> mNodes;
+        std::vector<Triangle> mTriangles;
+    };
+}
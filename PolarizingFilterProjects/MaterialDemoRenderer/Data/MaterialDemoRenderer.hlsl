@@ -34,8 +34,7 @@ __import Shading;
 __import Helpers;
 __import BRDF;
 __import Lights;
-
-#define M_SQRT2 1.41421356237309504880 // sqrt(2)
+__import Polarization;
 
 layout(binding = 0) cbuffer PerFrameCB : register(b0)
 {
@@ -53,154 +52,15 @@ layout(binding = 0) cbuffer PerFrameCB : register(b0)
     float3 gIOR_k;
     float  gRoughness;
     bool   gUseAsDielectric;
+    float  gPsiLutRow;
 };
 
 layout(set = 1, binding = 1) SamplerState gSampler;
 Texture2D gVisibilityBuffer;
 
-
-float3 SpecularFromIOR(float3 n, float3 k) {
-    float3 t1 = (n - float3(1.0));
-    float3 t2 = (n + float3(1.0));
-
-    return saturate((t1*t1 + k*k)/(t2*t2 + k*k));
-}
-
-//// Polarizing filter functions ////
-
-// Calculate rotation angle between the camera and the surface
-float calcRelativeAngle(float3 cameraX, float3 N, float3 V)
-{
-    float3 surfaceX = normalize(cross(N, V));
-    float dotX = dot(surfaceX, cameraX);
-    float detX = dot(V, cross(surfaceX, cameraX));
-    return gPolarizingFilterAngle + atan2(detX, dotX);
-}
-
-// n   - simple refractive index
-// k   - extinction coefficient
-// ct  - cos(theta)
-// st2 - sin^2(theta)
-float3 psi_Exact(float3 n, float3 k, float ct, float st2)
-{
-    float3 n2 = n*n;
-    float3 k2 = k*k;
-
-    float3 c = n2 - k2 - float3(st2);
-    float3 h = sqrt(c*c + 4.0*n2*k2);
-    float3 g = sqrt(h + c);
-
-    return saturate( ((M_SQRT2*ct*st2)*g)/((ct*ct)*h + float3(st2*st2)) );
-}
-
-// R0  - specular color
-// ct  - cos(theta)
-// st2 - sin^2(theta)
-float3 psi_MetalApprox(float3 R0, float ct, float st2)
-{
-    float3 Rb = float3(1.095) - R0;
-    float3 Rg = float3(1.18) - R0;
-    float3 beta  = float3(0.1)/(Rb*Rb*Rb) + 5.4*R0*R0 + float3(1.0);
-    float3 gamma = (0.16*R0*R0)/(Rg*Rg) + 0.35*Rg;
-    
-    float3 psi = (ct*st2)/(beta*ct*ct + gamma*st2*st2);
-    return saturate(psi);
-}
-
-// R0  - specular color
-// ct  - cos(theta)
-// st2 - sin^2(theta)
-float psi_DielectricExact(float R0, float ct, float st2)
-{
-    float n = (1.0 + sqrt(R0))/(1.0 - sqrt(R0));
-    float c = n*n - st2;
-
-    float psi = (2.0*sqrt(c)*ct*st2)/(c*ct*ct + st2*st2);
-
-    return saturate(psi);
-}
-
-// Assuming that all dilectrics have R0 = 0.04 i.e., n = 1.5
-float psi_DielectricOneFive(float ct, float st2)
-{
-    float e   = 2.25 - st2;
-    return saturate( (2.0*sqrt(e)*ct*st2)/(e*ct*ct + st2*st2) );
-}
-
-// cameraX - normalized vector that points to the right from the viewer's perspective
-float3 polarizingFilter(ShadingData sd, LightSample ls, float3 cameraX, bool useExact)
-{
-    float3 H     = normalize(sd.V + ls.L);
-    float  angle = calcRelativeAngle(cameraX, H, sd.V);
-    float st  = length(cross(ls.L, H)); // sin(theta)
-    float st2 = st*st;                  // sin^2(theta)
-
-    float3 psi;
-    if (useExact) {
-        psi = psi_Exact(gIOR_n, gIOR_k, ls.LdotH, st2);
-    } else if (sd.metalness > 0.5) {
-        psi = psi_MetalApprox(sd.specular, ls.LdotH, st2);
-    } else {
-        psi = float3(psi_DielectricExact(sd.specular.r, ls.LdotH, st2));
-    }
-
-    return (cos(2.0*angle)*psi + float3(1.0));
-}
-
-//// Material evaluation functions ////
-
-// Normal light sources
-ShadingResult evalMaterialWithFilter(ShadingData sd, LightData light, float shadowFactor, float3 cameraX, bool useExact)
-{
-    ShadingResult sr = initShadingResult();
-    LightSample ls = evalLight(light, sd);
-
-    // If the light doesn't hit the surface or we are viewing the surface from the back, return
-    if(ls.NdotL <= 0) return sr;
-    sd.NdotV = saturate(sd.NdotV);
-
-    // Calculate the diffuse term
-    sr.diffuseBrdf = saturate(evalDiffuseBrdf(sd, ls));
-    sr.diffuse = ls.diffuse * sr.diffuseBrdf * ls.NdotL;
-    sr.color.rgb = sr.diffuse;
-    sr.color.a = sd.opacity;
-
-    // Calculate the specular term
-    sr.specularBrdf = saturate(evalSpecularBrdf(sd, ls));
-    sr.specular = ls.specular * sr.specularBrdf * ls.NdotL;
-
-    // Apply polarizing filter
-    if (gEnablePolarizingFilter) {
-        sr.specular *= polarizingFilter(sd, ls, cameraX, useExact);
-    }
-
-    sr.color.rgb += sr.specular;
-
-    // Apply the shadow factor
-    sr.color.rgb *= shadowFactor;
-
-    return sr;
-}
-
-// Light probes
-ShadingResult evalMaterialWithFilter(ShadingData sd, LightProbeData probe, float3 cameraX, bool useExact)
-{
-    ShadingResult sr = initShadingResult();
-    LightSample ls = evalLightProbe(probe, sd);
-
-    sr.diffuse = ls.diffuse;
-    sr.color.rgb = sr.diffuse;
-    sr.specular = ls.specular;
-
-    // Apply polarizing filter
-    if (gEnablePolarizingFilter) {
-        sr.specular *= polarizingFilter(sd, ls, cameraX, useExact);
-    }
-    
-    sr.color.rgb += sr.specular;
-
-    return sr;
-}
+// psi_Exact() of the material, baked by PsiLut::bakeMaterials(). Used by the reference version when _PSI_LUT is defined.
+Texture2D gPsiLut;
+SamplerState gPsiLutSampler;
 
 //// Vertex and Pixel shader entry points ////
 
@@ -245,12 +105,28 @@ PsOut ps(MainVsOut vOut, float4 pixelCrd : SV_POSITION)
     sd.linearRoughness = max(0.08, gRoughness); // Clamp the roughness so that the BRDF won't explode
     sd.roughness = sd.linearRoughness * sd.linearRoughness;
 
-    float4 approxColor = float4(0, 0, 0, 1);
-    float4 correctColor = float4(0, 0, 0, 1);
+    float4 unfilteredColor = float4(0, 0, 0, 1);
 
     float3 cameraUp = normalize(gCamera.cameraV);
     float3 cameraX  = normalize(cross(cameraUp, sd.V));
 
+    // The approximation used by the renderers, and the reference it is compared against
+    SpecularPsi approxPsi;
+#ifdef _PSI_LUT
+    ExactPsiLut exactPsi;
+    exactPsi.lut = gPsiLut;
+    exactPsi.lutSampler = gPsiLutSampler;
+    exactPsi.row = gPsiLutRow;
+#else
+    ExactPsi exactPsi;
+    exactPsi.n = gIOR_n;
+    exactPsi.k = gIOR_k;
+#endif
+
+    // Only the polarized terms differ between the two versions
+    StokesTerms approxStokes = initStokesTerms();
+    StokesTerms exactStokes = initStokesTerms();
+
     [unroll]
     for (uint l = 0; l < _LIGHT_COUNT; l++) {
         float shadowFactor = 1;
@@ -260,27 +136,29 @@ PsOut ps(MainVsOut vOut, float4 pixelCrd : SV_POSITION)
             shadowFactor *= sd.opacity;
         }
 #endif
-        approxColor.rgb += evalMaterialWithFilter(sd, gLights[l], shadowFactor, cameraX, false).color.rgb;
-        correctColor.rgb += evalMaterialWithFilter(sd, gLights[l], shadowFactor, cameraX, true).color.rgb;
+        unfilteredColor.rgb += evalMaterialPolarized(sd, gLights[l], shadowFactor, cameraX, approxPsi, exactPsi, gEnablePolarizingFilter, approxStokes, exactStokes).color.rgb;
     }
 
     // Add the emissive component
-    approxColor.rgb += sd.emissive;
-    correctColor.rgb += sd.emissive;
+    unfilteredColor.rgb += sd.emissive;
 
 #ifdef _ENABLE_TRANSPARENCY
-    approxColor.a = sd.opacity * gOpacityScale;
-    correctColor.a = sd.opacity * gOpacityScale;
+    unfilteredColor.a = sd.opacity * gOpacityScale;
 #endif
 
 #ifdef _ENABLE_REFLECTIONS
-    approxColor.rgb += evalMaterialWithFilter(sd, gLightProbe, cameraX, false).color.rgb;
-    correctColor.rgb += evalMaterialWithFilter(sd, gLightProbe, cameraX, true).color.rgb;
+    unfilteredColor.rgb += evalMaterialPolarized(sd, gLightProbe, cameraX, approxPsi, exactPsi, gEnablePolarizingFilter, approxStokes, exactStokes).color.rgb;
 #endif
 
     // Add light-map
-    approxColor.rgb += sd.diffuse * sd.lightMap.rgb;
-    correctColor.rgb += sd.diffuse * sd.lightMap.rgb;
+    unfilteredColor.rgb += sd.diffuse * sd.lightMap.rgb;
+    float4 approxColor = unfilteredColor;
+    float4 correctColor = unfilteredColor;
+
+    if (gEnablePolarizingFilter) {
+        approxColor.rgb += evalPolarizingFilter(approxStokes, gPolarizingFilterAngle);
+        correctColor.rgb += evalPolarizingFilter(exactStokes, gPolarizingFilterAngle);
+    }
 
     if (gShowDiff) {
         float greyVal = 0.695;
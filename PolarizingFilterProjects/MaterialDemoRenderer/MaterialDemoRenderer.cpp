@@ -58,6 +58,46 @@ void MaterialDemoRenderer::initLightingPass()
     BlendState::Desc bsDesc;
     bsDesc.setRtBlend(0, true).setRtParams(0, BlendState::BlendOp::Add, BlendState::BlendOp::Add, BlendState::BlendFunc::SrcAlpha, BlendState::BlendFunc::OneMinusSrcAlpha, BlendState::BlendFunc::One, BlendState::BlendFunc::Zero);
     mLightingPass.pAlphaBlendBS = BlendState::create(bsDesc);
+
+    initPsiLut();
+}
+
+void MaterialDemoRenderer::initPsiLut()
+{
+    if (mPsiLut.pPresets) return;
+
+    std::vector<PsiLut::Material> presets(mMaterialPresetsN.size());
+    for (uint32_t i = 0; i < (uint32_t)presets.size(); i++)
+    {
+        presets[i] = { mMaterialPresetsN[i], mMaterialPresetsK[i] };
+    }
+    mPsiLut.pPresets = PsiLut::createMaterialTexture(presets);
+
+    Sampler::Desc samplerDesc;
+    samplerDesc.setAddressingMode(Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp).setFilterMode(Sampler::Filter::Linear, Sampler::Filter::Linear, Sampler::Filter::Point);
+    mPsiLut.pSampler = Sampler::create(samplerDesc);
+}
+
+void MaterialDemoRenderer::bindPsiLut(ConstantBuffer::SharedPtr& pCB)
+{
+    // The presets use their row of the shared texture. An edited material gets its own texture, which is baked again when the IoR changes.
+    Texture::SharedPtr pTexture = mPsiLut.pPresets;
+    uint32_t row = mSelectedMetal;
+    if (mMaterialIoRn != mMaterialPresetsN[mSelectedMetal] || mMaterialIoRk != mMaterialPresetsK[mSelectedMetal])
+    {
+        if (mPsiLut.pCustom == nullptr || mPsiLut.customN != mMaterialIoRn || mPsiLut.customK != mMaterialIoRk)
+        {
+            mPsiLut.pCustom = PsiLut::createMaterialTexture({ { mMaterialIoRn, mMaterialIoRk } }, false);
+            mPsiLut.customN = mMaterialIoRn;
+            mPsiLut.customK = mMaterialIoRk;
+        }
+        pTexture = mPsiLut.pCustom;
+        row = 0;
+    }
+
+    mLightingPass.pVars->setTexture("gPsiLut", pTexture);
+    mLightingPass.pVars->setSampler("gPsiLutSampler", mPsiLut.pSampler);
+    pCB["gPsiLutRow"] = (row + 0.5f) / pTexture->getHeight();
 }
 
 void MaterialDemoRenderer::initShadowPass(uint32_t windowWidth, uint32_t windowHeight)
@@ -72,6 +112,7 @@ void MaterialDemoRenderer::initShadowPass(uint32_t windowWidth, uint32_t windowH
 void MaterialDemoRenderer::initSSAO()
 {
     mSSAO.pSSAO = SSAO::create(uvec2(1024));
+    mSSAO.pSSAO->setResolution(SSAO::Resolution::Half);
     mSSAO.pApplySSAOPass = FullScreenPass::create("ApplyAO.ps.slang");
     mSSAO.pVars = GraphicsVars::create(mSSAO.pApplySSAOPass->getProgram()->getReflector());
 
@@ -248,9 +289,27 @@ void MaterialDemoRenderer::onLoad(SampleCallbacks* pSample, RenderContext* pRend
 {
     mpState = GraphicsState::create();    
     initPostProcess();
+    loadSpectralPresets();
     loadScene(pSample, skDefaultScene, true);
 }
 
+void MaterialDemoRenderer::loadSpectralPresets()
+{
+    for (const auto& dir : getDataDirectoriesList())
+    {
+        std::string spectralDir = dir + "/SpectralIoR";
+        if (isDirectoryExists(spectralDir) == false) continue;
+
+        for (const auto& material : SpectralIoR::loadDirectory(spectralDir))
+        {
+            mMaterialPresets.push_back({ (uint32_t)mMaterialPresetsN.size(), material.name });
+            mMaterialPresetsN.push_back(material.n);
+            mMaterialPresetsK.push_back(material.k);
+            mMaterialIsDielectric.push_back(material.isDielectric);
+        }
+    }
+}
+
 void MaterialDemoRenderer::renderSkyBox(RenderContext* pContext)
 {
     if (mSkyBox.pEffect)
@@ -332,6 +391,11 @@ void MaterialDemoRenderer::lightingPass(RenderContext* pContext, Fbo* pTargetFbo
         mLightingPass.pVars->setTexture("gVisibilityBuffer", mShadowPass.pVisibilityBuffer);
     }
 
+    if (mControls[ControlID::PsiLookupTexture].enabled)
+    {
+        bindPsiLut(pCB);
+    }
+
     if (mAAMode == AAMode::TAA)
     {
         pContext->clearFbo(mTAA.getActiveFbo().get(), vec4(0.0, 0.0, 0.0, 0.0), 1, 0, FboAttachmentType::Color);
@@ -30,20 +30,10 @@
 #pragma once
 #include "Falcor.h"
 #include "MaterialDemoRendererSceneRenderer.h"
+#include "MaterialDemoRendererPresets.h"
 
 
-/**
-Some X Macros to make it easy to add more materials
-
-Arguments
-    name: The name of the metal
-    nr  : IoR n at 650 nm (red)
-    ng  : IoR n at 550 nm (green)
-    nb  : IoR n at 450 nm (blue)
-    kr  : IoR k at 650 nm (red)
-    kg  : IoR k at 550 nm (green)
-    kb  : IoR k at 450 nm (blue)
-    d   : is dielectric
+/** Helpers that expand the rows of MATERIAL_TABLE
 */
 #define EXPAND( x ) x
 
@@ -59,20 +49,6 @@ Arguments
 #define X_IOR_K(...) EXPAND( X_IOR_K_(__VA_ARGS__) )
 #define X_IS_DIELECTRIC(...) EXPAND( X_IS_DIELECTRIC_(__VA_ARGS__) )
 
-// Materials from refractiveindex.info
-#define MATERIAL_TABLE \
-X(Aluminum  , 1.346f, 0.965f, 0.617f, 7.475f, 6.400f, 5.303, false) \
-X(Brass     , 0.444f, 0.527f, 1.094f, 3.695f, 2.765f, 1.829, false) \
-X(Copper    , 0.271f, 0.677f, 1.316f, 3.609f, 2.625f, 2.292, false) \
-X(Gold      , 0.183f, 0.421f, 1.373f, 3.424f, 2.346f, 1.770, false) \
-X(Iron      , 2.911f, 2.950f, 2.585f, 3.089f, 2.932f, 2.767, false) \
-X(Lead      , 1.910f, 1.830f, 1.440f, 3.510f, 3.400f, 3.180, false) \
-X(Platinum  , 2.376f, 2.085f, 1.845f, 4.266f, 3.715f, 3.137, false) \
-X(Silver    , 0.159f, 0.145f, 0.135f, 3.929f, 3.190f, 2.381, false) \
-X(Titanium  , 2.741f, 2.542f, 2.267f, 3.814f, 3.435f, 3.039, false) \
-X(Glass     , 1.521f, 1.525f, 1.532f, 0.000f, 0.000f, 0.000, true ) \
-X(Plastic   , 1.579f, 1.589f, 1.608f, 0.000f, 0.000f, 0.000, true )
-
 
 using namespace Falcor;
 
@@ -102,16 +78,17 @@ private:
     };
 #undef X
 
+    // The built-in presets come first, the materials integrated from spectral data in Data/SpectralIoR are appended at load time
 #define X(...) X_IOR_N(__VA_ARGS__)
-    glm::vec3 mMaterialPresetsN[MaterialPreset::NUM_MATERIALS] = { MATERIAL_TABLE };
+    std::vector<glm::vec3> mMaterialPresetsN = { MATERIAL_TABLE };
 #undef X
 
 #define X(...) X_IOR_K(__VA_ARGS__)
-    glm::vec3 mMaterialPresetsK[MaterialPreset::NUM_MATERIALS] = { MATERIAL_TABLE };
+    std::vector<glm::vec3> mMaterialPresetsK = { MATERIAL_TABLE };
 #undef X
 
 #define X(...) X_IS_DIELECTRIC(__VA_ARGS__)
-    bool mMaterialIsDielectric[MaterialPreset::NUM_MATERIALS] = { MATERIAL_TABLE };
+    std::vector<bool> mMaterialIsDielectric = { MATERIAL_TABLE };
 #undef X
 
     Fbo::SharedPtr mpMainFbo;
@@ -146,6 +123,16 @@ private:
         BlendState::SharedPtr pAlphaBlendBS;
     } mLightingPass;
 
+    // Lookup textures of psi_Exact(), sampled by the reference version when _PSI_LUT is defined
+    struct
+    {
+        Texture::SharedPtr pPresets;    // One row per material preset
+        Texture::SharedPtr pCustom;     // A single row for a material that was edited in the GUI
+        glm::vec3 customN;
+        glm::vec3 customK;
+        Sampler::SharedPtr pSampler;
+    } mPsiLut;
+
     struct
     {
         GraphicsVars::SharedPtr pVars;
@@ -214,6 +201,9 @@ private:
     void initSkyBox(const std::string& name);
     void initPostProcess();
     void initLightingPass();
+    void loadSpectralPresets();
+    void initPsiLut();
+    void bindPsiLut(ConstantBuffer::SharedPtr& pCB);
     void initDepthPass();
     void initShadowPass(uint32_t windowWidth, uint32_t windowHeight);
     void initSSAO();
@@ -252,13 +242,17 @@ private:
         EnableHashedAlpha,
         EnableTransparency,
         VisualizeCascades,
+        PsiLookupTexture,
         Count
     };
 
     enum class SamplePattern : uint32_t
     {
         Halton,
-        DX11
+        DX11,
+        Sobol,
+        R2,
+        PMJ02
     };
 
     enum class AAMode
@@ -55,6 +55,7 @@ void MaterialDemoRenderer::initControls()
     mControls[ControlID::EnableTransparency] = { false, false, "_ENABLE_TRANSPARENCY" };
     mControls[ControlID::EnableSSAO] = { true, false, "" };
     mControls[ControlID::VisualizeCascades] = { false, false, "_VISUALIZE_CASCADES" };
+    mControls[ControlID::PsiLookupTexture] = { false, false, "_PSI_LUT" };
 
     for (uint32_t i = 0; i < ControlID::Count; i++)
     {
@@ -92,6 +93,15 @@ void MaterialDemoRenderer::createTaaPatternGenerator(uint32_t fboWidth, uint32_t
     case SamplePattern::DX11:
         pGenerator = DxSamplePattern::create();
         break;
+    case SamplePattern::Sobol:
+        pGenerator = LowDiscrepancySamplePattern::create(LowDiscrepancySequence::Type::OwenScrambledSobol);
+        break;
+    case SamplePattern::R2:
+        pGenerator = LowDiscrepancySamplePattern::create(LowDiscrepancySequence::Type::R2);
+        break;
+    case SamplePattern::PMJ02:
+        pGenerator = LowDiscrepancySamplePattern::create(LowDiscrepancySequence::Type::PMJ02);
+        break;
     default:
         should_not_get_here();
         pGenerator = nullptr;
@@ -256,6 +266,10 @@ void MaterialDemoRenderer::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
             if (!mShowDiff) {
                 pGui->addCheckBox("Reference version", mUseExactPsi);
             }
+            if (pGui->addCheckBox("Psi Lookup Texture", mControls[ControlID::PsiLookupTexture].enabled)) {
+                applyLightingProgramControl(ControlID::PsiLookupTexture);
+            }
+            pGui->addTooltip("Sample the reference psi from a texture baked at load time instead of evaluating it in the shader");
 
             pGui->endGroup();
         }
@@ -326,7 +340,13 @@ void MaterialDemoRenderer::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
                     Gui::DropdownList samplePatternList;
                     samplePatternList.push_back({ (uint32_t)SamplePattern::Halton, "Halton" });
                     samplePatternList.push_back({ (uint32_t)SamplePattern::DX11, "DX11" });
-                    pGui->addDropdown("Sample Pattern", samplePatternList, (uint32_t&)mTAASamplePattern);
+                    samplePatternList.push_back({ (uint32_t)SamplePattern::Sobol, "Sobol" });
+                    samplePatternList.push_back({ (uint32_t)SamplePattern::R2, "R2" });
+                    samplePatternList.push_back({ (uint32_t)SamplePattern::PMJ02, "PMJ02" });
+                    if (pGui->addDropdown("Sample Pattern", samplePatternList, (uint32_t&)mTAASamplePattern))
+                    {
+                        createTaaPatternGenerator(pSample->getCurrentFbo()->getWidth(), pSample->getCurrentFbo()->getHeight());
+                    }
 
                     // Disable super-sampling
                     pGui->endGroup();
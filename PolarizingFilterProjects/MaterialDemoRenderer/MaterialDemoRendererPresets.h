@@ -0,0 +1,57 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+
+/**
+Material presets shared by MaterialDemoRenderer and PsiErrorAnalysis, as an X Macro to make it easy to add more materials
+
+Arguments
+    name: The name of the metal
+    nr  : IoR n at 650 nm (red)
+    ng  : IoR n at 550 nm (green)
+    nb  : IoR n at 450 nm (blue)
+    kr  : IoR k at 650 nm (red)
+    kg  : IoR k at 550 nm (green)
+    kb  : IoR k at 450 nm (blue)
+    d   : is dielectric
+*/
+// Materials from refractiveindex.info
+#define MATERIAL_TABLE \
+X(Aluminum  , 1.346f, 0.965f, 0.617f, 7.475f, 6.400f, 5.303, false) \
+X(Brass     , 0.444f, 0.527f, 1.094f, 3.695f, 2.765f, 1.829, false) \
+X(Copper    , 0.271f, 0.677f, 1.316f, 3.609f, 2.625f, 2.292, false) \
+X(Gold      , 0.183f, 0.421f, 1.373f, 3.424f, 2.346f, 1.770, false) \
+X(Iron      , 2.911f, 2.950f, 2.585f, 3.089f, 2.932f, 2.767, false) \
+X(Lead      , 1.910f, 1.830f, 1.440f, 3.510f, 3.400f, 3.180, false) \
+X(Platinum  , 2.376f, 2.085f, 1.845f, 4.266f, 3.715f, 3.137, false) \
+X(Silver    , 0.159f, 0.145f, 0.135f, 3.929f, 3.190f, 2.381, false) \
+X(Titanium  , 2.741f, 2.542f, 2.267f, 3.814f, 3.435f, 3.039, false) \
+X(Glass     , 1.521f, 1.525f, 1.532f, 0.000f, 0.000f, 0.000, true ) \
+X(Plastic   , 1.579f, 1.589f, 1.608f, 0.000f, 0.000f, 0.000, true )
@@ -0,0 +1,225 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "PolarizationPathTracer.h"
+#include "Utils/MuellerCalculus.h"
+#include "Utils/ThreadPool.h"
+
+int PolarizationPathTracer::sExitCode = 0;
+const std::string PolarizationPathTracer::skDefaultScene = "Arcade/Arcade.fscene";
+
+void PolarizationPathTracer::onLoad(SampleCallbacks* pSample, RenderContext* pRenderContext)
+{
+    ArgList args = pSample->getArgList();
+    std::string sceneFile = args.argExists("scene") ? args["scene"].asString() : skDefaultScene;
+    if (args.argExists("width")) mWidth = std::max(1u, args["width"].asUint());
+    if (args.argExists("height")) mHeight = std::max(1u, args["height"].asUint());
+    if (args.argExists("spp")) mTargetSpp = args["spp"].asUint();
+    if (args.argExists("passSpp")) mPassSpp = std::max(1u, args["passSpp"].asUint());
+    if (args.argExists("threads")) mThreadCount = args["threads"].asUint();
+    uint32_t maxBounces = args.argExists("maxBounces") ? args["maxBounces"].asUint() : 4;
+    mOutputPath = args.argExists("out") ? args["out"].asString() : getExecutableDirectory() + "/PolarizationReference";
+    if (args.argExists("filterAngle"))
+    {
+        std::string angle = args["filterAngle"].asString();
+        mEnableFilter = (angle != "off");
+        if (mEnableFilter) mFilterAngle = args["filterAngle"].asFloat();
+    }
+
+    Scene::SharedPtr pScene = Scene::loadFromFile(sceneFile);
+    mpScene = pScene ? PolarizationPathTracerScene::create(pScene, float(mWidth) / mHeight, maxBounces) : nullptr;
+    if (mpScene == nullptr)
+    {
+        logError("PolarizationPathTracer: can't load " + sceneFile);
+        sExitCode = 1;
+        pSample->shutdown();
+        return;
+    }
+
+    mSum.resize(mWidth * mHeight);
+    mpPreview = Texture::create2D(mWidth, mHeight, ResourceFormat::RGBA32Float, 1, 1, nullptr, Resource::BindFlags::ShaderResource);
+    mRenderThread = std::thread(&PolarizationPathTracer::renderPasses, this);
+}
+
+void PolarizationPathTracer::renderPass(std::vector<PolarizationPathTracerScene::Stokes>& pass, uint32_t firstSample)
+{
+    // Rows are distributed dynamically, since their cost varies a lot
+    parallelFor(mHeight, mThreadCount, [&](uint32_t y)
+    {
+        for (uint32_t x = 0; x < mWidth; x++)
+        {
+            PolarizationPathTracerScene::Stokes& pixel = pass[y * mWidth + x];
+            pixel = PolarizationPathTracerScene::Stokes();
+            for (uint32_t s = 0; s < mPassSpp; s++)
+            {
+                PolarizationPathTracerScene::Rng rng(y * mWidth + x, firstSample + s);
+                vec2 ndc = vec2((x + rng.next()) / mWidth * 2.0f - 1.0f, 1.0f - (y + rng.next()) / mHeight * 2.0f);
+                PolarizationPathTracerScene::Stokes sample = mpScene->tracePath(ndc, rng);
+
+                // A NaN would poison the pixel for the rest of the run
+                if (std::isfinite(sample.S0.r + sample.S0.g + sample.S0.b + sample.S1.r + sample.S1.g + sample.S1.b + sample.S2.r + sample.S2.g + sample.S2.b) == false) continue;
+                pixel.S0 += sample.S0;
+                pixel.S1 += sample.S1;
+                pixel.S2 += sample.S2;
+            }
+        }
+    });
+}
+
+void PolarizationPathTracer::renderPasses()
+{
+    std::vector<PolarizationPathTracerScene::Stokes> pass(mWidth * mHeight);
+    std::vector<PolarizationPathTracerScene::Stokes> sum(mWidth * mHeight);
+    uint32_t sampleCount = 0;
+    while (mStop == false && (mTargetSpp == 0 || sampleCount < mTargetSpp))
+    {
+        CpuTimer timer;
+        timer.update();
+        renderPass(pass, sampleCount);
+        for (size_t i = 0; i < sum.size(); i++)
+        {
+            sum[i].S0 += pass[i].S0;
+            sum[i].S1 += pass[i].S1;
+            sum[i].S2 += pass[i].S2;
+        }
+        sampleCount += mPassSpp;
+        timer.update();
+
+        float filterAngle;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mSum = sum;
+            mSampleCount = sampleCount;
+            mPassTime = timer.getElapsedTime();
+            filterAngle = mEnableFilter ? mFilterAngle : -1.0f;
+        }
+        logInfo("PolarizationPathTracer: " + std::to_string(sampleCount) + " samples per pixel, " + std::to_string(timer.getElapsedTime()) + " seconds per pass");
+        saveImages(sum, sampleCount, filterAngle);
+    }
+    mDone = true;
+}
+
+void PolarizationPathTracer::getFilteredImage(const std::vector<PolarizationPathTracerScene::Stokes>& sum, uint32_t sampleCount, float filterAngle, std::vector<vec4>& image) const
+{
+    // A negative angle disables the filter
+    image.resize(sum.size());
+    float scale = 1.0f / std::max(1u, sampleCount);
+    for (size_t i = 0; i < sum.size(); i++)
+    {
+        vec3 color = sum[i].S0;
+        if (filterAngle >= 0)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                color[c] = Polarization::linearPolarizerIntensity(vec4(sum[i].S0[c], sum[i].S1[c], sum[i].S2[c], 0.0f), glm::radians(filterAngle));
+            }
+        }
+        image[i] = vec4(color * scale, 1.0f);
+    }
+}
+
+void PolarizationPathTracer::saveImages(const std::vector<PolarizationPathTracerScene::Stokes>& sum, uint32_t sampleCount, float filterAngle) const
+{
+    std::vector<vec4> image;
+    getFilteredImage(sum, sampleCount, filterAngle, image);
+    Bitmap::saveImage(mOutputPath + ".exr", mWidth, mHeight, Bitmap::FileFormat::ExrFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA32Float, true, image.data());
+
+    float scale = 1.0f / sampleCount;
+    const char* kNames[] = { "_S0.exr", "_S1.exr", "_S2.exr" };
+    for (uint32_t component = 0; component < 3; component++)
+    {
+        for (size_t i = 0; i < sum.size(); i++)
+        {
+            const vec3& value = (component == 0) ? sum[i].S0 : (component == 1 ? sum[i].S1 : sum[i].S2);
+            image[i] = vec4(value * scale, 1.0f);
+        }
+        Bitmap::saveImage(mOutputPath + kNames[component], mWidth, mHeight, Bitmap::FileFormat::ExrFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA32Float, true, image.data());
+    }
+}
+
+void PolarizationPathTracer::onFrameRender(SampleCallbacks* pSample, RenderContext* pRenderContext, const Fbo::SharedPtr& pTargetFbo)
+{
+    pRenderContext->clearFbo(pTargetFbo.get(), vec4(0.0f, 0.0f, 0.0f, 1.0f), 1.0f, 0, FboAttachmentType::All);
+    if (mpScene == nullptr) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        float filterAngle = mEnableFilter ? mFilterAngle : -1.0f;
+        if (mSampleCount != mDisplayedSampleCount || filterAngle != mDisplayedFilterAngle)
+        {
+            std::vector<vec4> image;
+            getFilteredImage(mSum, mSampleCount, filterAngle, image);
+            pRenderContext->updateTextureData(mpPreview.get(), image.data());
+            mDisplayedSampleCount = mSampleCount;
+            mDisplayedFilterAngle = filterAngle;
+        }
+    }
+    pRenderContext->blit(mpPreview->getSRV(), pTargetFbo->getRenderTargetView(0));
+
+    if (mDone && mTargetSpp > 0) pSample->shutdown();
+}
+
+void PolarizationPathTracer::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    pGui->addText(("Samples per pixel: " + std::to_string(mSampleCount) + (mTargetSpp ? " / " + std::to_string(mTargetSpp) : "")).c_str());
+    pGui->addText(("Pass time: " + std::to_string(mPassTime) + " s").c_str());
+    pGui->addText(("Triangles: " + std::to_string(mpScene ? mpScene->getTriangleCount() : 0)).c_str());
+    pGui->addCheckBox("Polarizing Filter", mEnableFilter);
+    pGui->addFloatSlider("Filter Angle", mFilterAngle, 0.0f, 180.0f);
+    pGui->addTooltip("Applied to the preview and to the images written after the next pass");
+}
+
+void PolarizationPathTracer::onShutdown(SampleCallbacks* pSample)
+{
+    mStop = true;
+    if (mRenderThread.joinable()) mRenderThread.join();
+}
+
+#ifdef _WIN32
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+#else
+int main(int argc, char** argv)
+#endif
+{
+    PolarizationPathTracer::UniquePtr pRenderer = std::make_unique<PolarizationPathTracer>();
+    SampleConfig config;
+    config.windowDesc.title = "Polarization Path Tracer";
+    config.windowDesc.resizableWindow = false;
+    config.windowDesc.width = 1280;
+    config.windowDesc.height = 720;
+#ifdef _WIN32
+    Sample::run(config, pRenderer);
+#else
+    config.argc = (uint32_t)argc;
+    config.argv = argv;
+    Sample::run(config, pRenderer);
+#endif
+    return PolarizationPathTracer::getExitCode();
+}
@@ -0,0 +1,97 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+#include "PolarizationPathTracerScene.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace Falcor;
+
+/** Renders a polarization reference of a scene on the CPU, to compare against the images of PolarizingFilterRenderer.
+    The scene is loaded with the regular importers, then path traced progressively on worker threads while the window shows the current estimate.
+    After every pass the filtered image and the Stokes components S0, S1 and S2 are written as EXR files. S1 and S2 are in the frame of the camera's
+    right and up vectors, like the Q and U terms of PolarizingFilterRenderer's Stokes output.
+
+    Command line arguments:
+        -scene <file>           Scene to render. Defaults to the PolarizingFilterRenderer scene
+        -width <pixels>         Image width. Defaults to 1280
+        -height <pixels>        Image height. Defaults to 720
+        -spp <count>            Samples per pixel. The application exits when they are done. Defaults to 0, which renders until the window is closed
+        -passSpp <count>        Samples per pixel of each pass. Defaults to 4
+        -maxBounces <count>     Maximum number of reflections along a path. Defaults to 4
+        -filterAngle <degrees>  Angle of the polarizing filter, or "off". Defaults to 90
+        -threads <count>        Number of worker threads. Defaults to all hardware threads
+        -out <path>             Output path without the extension. Defaults to PolarizationReference in the executable directory
+*/
+class PolarizationPathTracer : public Renderer
+{
+public:
+    void onLoad(SampleCallbacks* pSample, RenderContext* pRenderContext) override;
+    void onFrameRender(SampleCallbacks* pSample, RenderContext* pRenderContext, const Fbo::SharedPtr& pTargetFbo) override;
+    void onShutdown(SampleCallbacks* pSample) override;
+    void onGuiRender(SampleCallbacks* pSample, Gui* pGui) override;
+
+    static int getExitCode() { return sExitCode; }
+
+private:
+    void renderPasses();
+    void renderPass(std::vector<PolarizationPathTracerScene::Stokes>& pass, uint32_t firstSample);
+    void saveImages(const std::vector<PolarizationPathTracerScene::Stokes>& sum, uint32_t sampleCount, float filterAngle) const;
+    void getFilteredImage(const std::vector<PolarizationPathTracerScene::Stokes>& sum, uint32_t sampleCount, float filterAngle, std::vector<vec4>& image) const;
+
+    PolarizationPathTracerScene::UniquePtr mpScene;
+    uint32_t mWidth = 1280;
+    uint32_t mHeight = 720;
+    uint32_t mTargetSpp = 0;
+    uint32_t mPassSpp = 4;
+    uint32_t mThreadCount = 0;
+    std::string mOutputPath;
+
+    bool mEnableFilter = true;
+    float mFilterAngle = 90.0f;     // Degrees
+
+    // Written by the render thread, read by the UI
+    std::mutex mMutex;
+    std::vector<PolarizationPathTracerScene::Stokes> mSum;
+    uint32_t mSampleCount = 0;
+    float mPassTime = 0;            // Seconds
+
+    std::thread mRenderThread;
+    std::atomic<bool> mStop{ false };
+    std::atomic<bool> mDone{ false };
+    uint32_t mDisplayedSampleCount = 0;
+    float mDisplayedFilterAngle = 0;
+    Texture::SharedPtr mpPreview;
+
+    static int sExitCode;
+    static const std::string skDefaultScene;
+};
@@ -0,0 +1,608 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "PolarizationPathTracerScene.h"
+#include "Utils/MuellerCalculus.h"
+#include "Utils/TextureBaker.h"
+#include "Data/HostDevicePolarization.h"
+#include "../MaterialDemoRenderer/MaterialDemoRendererPresets.h"
+#include <cfloat>
+
+using namespace Falcor::Polarization;
+
+namespace
+{
+    const float kPi = glm::pi<float>();
+    const float kRayOffset = 1e-4f;
+
+    /** The measured materials of MaterialDemoRenderer, used to derive a complex IoR from the specular color of a metal
+    */
+    struct IoRPreset
+    {
+        vec3 n;
+        vec3 k;
+        bool isDielectric;
+    };
+
+#define X(name, nr, ng, nb, kr, kg, kb, d, ...) { { nr, ng, nb }, { kr, kg, kb }, d },
+    const IoRPreset kIoRPresets[] = { MATERIAL_TABLE };
+#undef X
+
+    /** Get a complex IoR that reflects the specular color at normal incidence.
+        Non-metals are dielectrics with R0 = specular.r, as in PolarizingFilterRenderer.hlsl. Metals start from the measured metal
+        with the closest reflectance, and k is adjusted per channel so that the reflectance matches exactly.
+    */
+    void getIoRFromSpecular(const vec3& specular, bool isMetal, vec3& n, vec3& k)
+    {
+        auto dielectricN = [](float R0)
+        {
+            float r = sqrt(glm::clamp(R0, 0.0f, 0.99f));
+            return (1.0f + r) / (1.0f - r);
+        };
+
+        if (isMetal == false)
+        {
+            n = vec3(dielectricN(specular.r));
+            k = vec3(0.0f);
+            return;
+        }
+
+        const IoRPreset* pBest = nullptr;
+        float bestDistance = FLT_MAX;
+        for (const auto& preset : kIoRPresets)
+        {
+            if (preset.isDielectric) continue;
+            float distance = glm::length(SpecularFromIOR(preset.n, preset.k) - specular);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                pBest = &preset;
+            }
+        }
+
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            // R0 = ((n - 1)^2 + k^2) / ((n + 1)^2 + k^2), solved for k
+            float R0 = glm::clamp(specular[c], 0.0f, 0.99f);
+            float nc = pBest->n[c];
+            float k2 = (R0 * (nc + 1.0f) * (nc + 1.0f) - (nc - 1.0f) * (nc - 1.0f)) / (1.0f - R0);
+            if (k2 < 0)
+            {
+                nc = dielectricN(R0);
+                k2 = 0;
+            }
+            n[c] = nc;
+            k[c] = sqrt(k2);
+        }
+    }
+
+    /** GGX distribution, normalized. Same as evalGGX() in BRDF.slang divided by pi.
+    */
+    float evalGGX(float alpha, float NdotH)
+    {
+        float a2 = alpha * alpha;
+        float d = ((NdotH * a2 - NdotH) * NdotH + 1);
+        return a2 / (kPi * d * d);
+    }
+
+    /** Same as evalSmithGGX() in BRDF.slang, which includes the 1 / (4 NdotL NdotV) of the microfacet BRDF
+    */
+    float evalSmithGGX(float NdotL, float NdotV, float alpha)
+    {
+        float a2 = alpha * alpha;
+        float ggxv = NdotL * sqrt((-NdotV * a2 + NdotV) * NdotV + a2);
+        float ggxl = NdotV * sqrt((-NdotL * a2 + NdotL) * NdotL + a2);
+        return 0.5f / (ggxv + ggxl);
+    }
+
+    /** Transform a direction from the tangent space of N to world space
+    */
+    vec3 fromTangentSpace(const vec3& N, const vec3& v)
+    {
+        vec3 T = std::abs(N.x) > 0.9f ? vec3(0, 1, 0) : vec3(1, 0, 0);
+        T = glm::normalize(glm::cross(T, N));
+        vec3 B = glm::cross(N, T);
+        return v.x * T + v.y * B + v.z * N;
+    }
+}
+
+PolarizationPathTracerScene::Rng::Rng(uint32_t pixel, uint32_t sample)
+{
+    // Hash the pixel and the sample index so that every sample gets an independent sequence regardless of the thread that runs it
+    mState = pixel * 0x9E3779B9u ^ (sample + 0x7F4A7C15u) * 0x85EBCA6Bu;
+    next();
+}
+
+float PolarizationPathTracerScene::Rng::next()
+{
+    // PCG-RXS-M-XS
+    mState = mState * 747796405u + 2891336453u;
+    uint32_t word = ((mState >> ((mState >> 28u) + 4u)) ^ mState) * 277803737u;
+    word = (word >> 22u) ^ word;
+    return (word >> 8) * (1.0f / 16777216.0f);
+}
+
+PolarizationPathTracerScene::UniquePtr PolarizationPathTracerScene::create(const Scene::SharedPtr& pScene, float aspectRatio, uint32_t maxBounces)
+{
+    UniquePtr pThis = UniquePtr(new PolarizationPathTracerScene());
+    pThis->mMaxBounces = maxBounces;
+
+    for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+    {
+        const Model::SharedPtr& pModel = pScene->getModel(modelID);
+        for (uint32_t modelInstance = 0; modelInstance < pScene->getModelInstanceCount(modelID); modelInstance++)
+        {
+            glm::mat4 modelMat = pScene->getModelInstance(modelID, modelInstance)->getTransformMatrix();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Mesh::SharedPtr& pMesh = pModel->getMesh(meshID);
+                uint32_t materialID = pThis->addMaterial(pMesh->getMaterial());
+                for (uint32_t meshInstance = 0; meshInstance < pModel->getMeshInstanceCount(meshID); meshInstance++)
+                {
+                    pThis->addMesh(pMesh, modelMat * pModel->getMeshInstance(meshID, meshInstance)->getTransformMatrix(), materialID);
+                }
+            }
+        }
+    }
+
+    if (pThis->mPositions.empty())
+    {
+        logError("PolarizationPathTracer: the scene has no triangles");
+        return nullptr;
+    }
+
+    CpuTimer timer;
+    timer.update();
+    pThis->mBvh.build(pThis->mPositions);
+    timer.update();
+    logInfo("PolarizationPathTracer: built a BVH over " + std::to_string(pThis->mBvh.getTriangleCount()) + " triangles with " + std::to_string(pThis->mBvh.getNodeCount()) + " nodes in " + std::to_string(timer.getElapsedTime()) + " seconds");
+
+    for (uint32_t i = 0; i < pScene->getLightCount(); i++)
+    {
+        pThis->addLight(pScene->getLight(i));
+    }
+
+    pThis->mEnvironment = { vec3(0.0f) };
+    pThis->mEnvironmentWidth = pThis->mEnvironmentHeight = 1;
+    if (pScene->getLightProbeCount() > 0)
+    {
+        pThis->loadEnvironment(pScene->getLightProbe(0));
+    }
+
+    const Camera::SharedPtr& pCamera = pScene->getActiveCamera();
+    pCamera->setAspectRatio(aspectRatio);
+    const CameraData& camera = pCamera->getData();
+    pThis->mCameraPos = camera.posW;
+    pThis->mCameraU = camera.cameraU;
+    pThis->mCameraV = camera.cameraV;
+    pThis->mCameraW = camera.cameraW;
+
+    return pThis;
+}
+
+void PolarizationPathTracerScene::addMesh(const Mesh::SharedPtr& pMesh, const glm::mat4& worldMat, uint32_t materialID)
+{
+    const Vao::SharedPtr& pVao = pMesh->getVao();
+    if (pVao->getPrimitiveTopology() != Vao::Topology::TriangleList)
+    {
+        logWarning("PolarizationPathTracer: skipping a mesh that isn't a triangle list");
+        return;
+    }
+
+    // Read one vertex attribute. The importers store positions and normals as RGB32Float.
+    auto readAttribute = [&](uint32_t location, std::vector<vec3>& data)
+    {
+        Vao::ElementDesc desc = pVao->getElementIndexByLocation(location);
+        if (desc.elementIndex == Vao::ElementDesc::kInvalidIndex) return false;
+        const VertexBufferLayout::SharedConstPtr& pLayout = pVao->getVertexLayout()->getBufferLayout(desc.vbIndex);
+        if (pLayout->getElementFormat(desc.elementIndex) != ResourceFormat::RGB32Float) return false;
+
+        const Buffer::SharedPtr& pBuffer = pVao->getVertexBuffer(desc.vbIndex);
+        const uint8_t* pData = (const uint8_t*)pBuffer->map(Buffer::MapType::Read) + pLayout->getElementOffset(desc.elementIndex);
+        uint32_t stride = pLayout->getStride();
+        data.resize(pMesh->getVertexCount());
+        for (uint32_t i = 0; i < pMesh->getVertexCount(); i++)
+        {
+            std::memcpy(&data[i], pData + i * stride, sizeof(vec3));
+        }
+        pBuffer->unmap();
+        return true;
+    };
+
+    std::vector<vec3> positions, normals;
+    if (readAttribute(VERTEX_POSITION_LOC, positions) == false)
+    {
+        logWarning("PolarizationPathTracer: skipping a mesh without RGB32Float positions");
+        return;
+    }
+    bool hasNormals = readAttribute(VERTEX_NORMAL_LOC, normals);
+
+    std::vector<uint32_t> indices(pMesh->getIndexCount());
+    const Buffer::SharedPtr& pIB = pVao->getIndexBuffer();
+    if (pIB)
+    {
+        const void* pData = pIB->map(Buffer::MapType::Read);
+        for (uint32_t i = 0; i < pMesh->getIndexCount(); i++)
+        {
+            indices[i] = (pVao->getIndexBufferFormat() == ResourceFormat::R16Uint) ? ((const uint16_t*)pData)[i] : ((const uint32_t*)pData)[i];
+        }
+        pIB->unmap();
+    }
+    else
+    {
+        indices.resize(pMesh->getVertexCount());
+        for (uint32_t i = 0; i < indices.size(); i++) indices[i] = i;
+    }
+
+    glm::mat3 normalMat = glm::transpose(glm::inverse(glm::mat3(worldMat)));
+    for (uint32_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        vec3 p[3];
+        for (uint32_t j = 0; j < 3; j++) p[j] = vec3(worldMat * vec4(positions[indices[i + j]], 1.0f));
+        vec3 faceNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+        if (glm::dot(faceNormal, faceNormal) == 0) continue;
+
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            mPositions.push_back(p[j]);
+            vec3 N = hasNormals ? normalMat * normals[indices[i + j]] : faceNormal;
+            mNormals.push_back(glm::normalize(N));
+        }
+        mTriangleMaterials.push_back(materialID);
+    }
+}
+
+uint32_t PolarizationPathTracerScene::addMaterial(const Falcor::Material::SharedPtr& pMaterial)
+{
+    auto it = mMaterialIDs.find(pMaterial.get());
+    if (it != mMaterialIDs.end()) return it->second;
+
+    if (pMaterial->getBaseColorTexture() || pMaterial->getSpecularTexture() || pMaterial->getEmissiveTexture())
+    {
+        logWarning("PolarizationPathTracer: material '" + pMaterial->getName() + "' has textures. Only its constant parameters are used.");
+    }
+
+    // Same as prepareShadingData() in Shading.slang
+    vec4 baseColor = pMaterial->getBaseColor();
+    vec4 spec = pMaterial->getSpecularParams();
+    vec3 specular;
+    float linearRoughness;
+    float metalness = 0;
+    Material m;
+    if (pMaterial->getShadingModel() == ShadingModelMetalRough)
+    {
+        m.diffuse = glm::mix(vec3(baseColor), vec3(0.0f), spec.b);
+        specular = glm::mix(vec3(0.04f), vec3(baseColor), spec.b);
+        linearRoughness = spec.g;
+        metalness = spec.b;
+    }
+    else
+    {
+        m.diffuse = vec3(baseColor);
+        specular = vec3(spec);
+        linearRoughness = 1 - spec.a;
+    }
+    linearRoughness = std::max(0.08f, linearRoughness);
+    m.alpha = linearRoughness * linearRoughness;
+    m.emissive = pMaterial->getEmissiveColor();
+    getIoRFromSpecular(specular, metalness > 0.5f, m.n, m.k);
+
+    float diffuseWeight = luminance(m.diffuse);
+    float specularWeight = luminance(specular);
+    m.specularProbability = (diffuseWeight > 0) ? glm::clamp(specularWeight / (specularWeight + diffuseWeight), 0.1f, 0.9f) : 1.0f;
+
+    uint32_t id = (uint32_t)mMaterials.size();
+    mMaterials.push_back(m);
+    mMaterialIDs[pMaterial.get()] = id;
+    return id;
+}
+
+void PolarizationPathTracerScene::addLight(const Falcor::Light::SharedPtr& pLight)
+{
+    const LightData& data = pLight->getData();
+    Light light;
+    light.type = data.type;
+    light.posW = data.posW;
+    light.dirW = glm::normalize(data.dirW);
+    light.intensity = data.intensity;
+    light.openingAngle = data.openingAngle;
+    light.cosOpeningAngle = data.cosOpeningAngle;
+    light.penumbraAngle = data.penumbraAngle;
+    light.transMat = data.transMat;
+    light.transMatIT = data.transMatIT;
+    light.surfaceArea = data.surfaceArea;
+
+    switch (light.type)
+    {
+    case LightPoint:
+    case LightDirectional:
+    case LightAreaRect:
+    case LightAreaDisc:
+    case LightAreaSphere:
+        mLights.push_back(light);
+        break;
+    default:
+        // Mesh area lights are emissive triangles, which paths hit directly
+        break;
+    }
+}
+
+void PolarizationPathTracerScene::loadEnvironment(const LightProbe::SharedPtr& pProbe)
+{
+    // Reload the original image, so that the radiance doesn't depend on the texture format and mips of the GPU copy
+    const Texture::SharedPtr& pTexture = pProbe->getOrigTexture();
+    Bitmap::UniqueConstPtr pBitmap = pTexture ? Bitmap::createFromFile(pTexture->getSourceFilename(), true) : nullptr;
+    if (pBitmap == nullptr)
+    {
+        logWarning("PolarizationPathTracer: can't load the light probe image. Using a black environment.");
+        return;
+    }
+
+    TextureBaker::Image image = TextureBaker::createImage(pBitmap.get(), isSrgbFormat(pTexture->getFormat()));
+    mEnvironmentWidth = image.width;
+    mEnvironmentHeight = image.height;
+    mEnvironment.resize(image.texels.size());
+    for (size_t i = 0; i < image.texels.size(); i++)
+    {
+        mEnvironment[i] = vec3(image.texels[i]) * pProbe->getIntensity();
+    }
+}
+
+vec3 PolarizationPathTracerScene::getEnvironment(const vec3& dir) const
+{
+    // Same mapping as dirToSphericalCrd() in Helpers.slang
+    float u = (1.0f + atan2(-dir.z, dir.x) / kPi) * 0.5f;
+    float v = acos(glm::clamp(dir.y, -1.0f, 1.0f)) / kPi;
+    uint32_t x = std::min(uint32_t(u * mEnvironmentWidth), mEnvironmentWidth - 1);
+    uint32_t y = std::min(uint32_t(v * mEnvironmentHeight), mEnvironmentHeight - 1);
+    return mEnvironment[y * mEnvironmentWidth + x];
+}
+
+PolarizationPathTracerScene::SurfaceHit PolarizationPathTracerScene::getSurface(const TriangleBvh::Hit& hit, const vec3& dir) const
+{
+    const vec3* p = &mPositions[hit.triangle * 3];
+    const vec3* n = &mNormals[hit.triangle * 3];
+
+    SurfaceHit surface;
+    surface.posW = p[0] + hit.u * (p[1] - p[0]) + hit.v * (p[2] - p[0]);
+    surface.Ng = glm::normalize(glm::cross(p[1] - p[0], p[2] - p[0]));
+    surface.N = glm::normalize((1.0f - hit.u - hit.v) * n[0] + hit.u * n[1] + hit.v * n[2]);
+    surface.pMaterial = &mMaterials[mTriangleMaterials[hit.triangle]];
+
+    // All materials are treated as double-sided
+    if (glm::dot(surface.Ng, dir) > 0) surface.Ng = -surface.Ng;
+    if (glm::dot(surface.N, surface.Ng) < 0) surface.N = -surface.N;
+    return surface;
+}
+
+bool PolarizationPathTracerScene::sampleLight(const Light& light, const vec3& posW, Rng& rng, LightSample& ls) const
+{
+    switch (light.type)
+    {
+    case LightDirectional:
+        ls.L = -light.dirW;
+        ls.distance = FLT_MAX;
+        ls.radiance = light.intensity;
+        return true;
+
+    case LightPoint:
+    {
+        // Same falloff as evalPointLight() in Lights.slang
+        vec3 toLight = light.posW - posW;
+        float distSquared = glm::dot(toLight, toLight);
+        if (distSquared <= 1e-5f) return false;
+        ls.distance = sqrt(distSquared);
+        ls.L = toLight / ls.distance;
+        float falloff = 1.0f / (0.01f * 0.01f + distSquared);
+        float cosTheta = -glm::dot(ls.L, light.dirW);
+        if (cosTheta < light.cosOpeningAngle) return false;
+        if (light.penumbraAngle > 0)
+        {
+            float deltaAngle = light.openingAngle - acos(cosTheta);
+            falloff *= glm::clamp((deltaAngle - light.penumbraAngle) / light.penumbraAngle, 0.0f, 1.0f);
+        }
+        ls.radiance = light.intensity * falloff;
+        return true;
+    }
+
+    default:
+    {
+        // Uniformly sample the unit shape of the area light
+        float u = rng.next();
+        float v = rng.next();
+        vec3 local;
+        if (light.type == LightAreaRect)
+        {
+            local = vec3(2.0f * u - 1.0f, 2.0f * v - 1.0f, 0.0f);
+        }
+        else if (light.type == LightAreaDisc)
+        {
+            float r = sqrt(u);
+            local = vec3(r * cos(2.0f * kPi * v), r * sin(2.0f * kPi * v), 0.0f);
+        }
+        else
+        {
+            float z = 1.0f - 2.0f * u;
+            float r = sqrt(std::max(0.0f, 1.0f - z * z));
+            local = vec3(r * cos(2.0f * kPi * v), r * sin(2.0f * kPi * v), z);
+        }
+
+        vec3 lightPos = vec3(light.transMat * vec4(local, 1.0f));
+        vec3 localNormal = (light.type == LightAreaSphere) ? local : vec3(0, 0, 1);
+        vec3 lightNormal = glm::normalize(vec3(light.transMatIT * vec4(localNormal, 0.0f)));
+        vec3 toLight = lightPos - posW;
+        float distSquared = glm::dot(toLight, toLight);
+        if (distSquared <= 1e-8f) return false;
+        ls.distance = sqrt(distSquared);
+        ls.L = toLight / ls.distance;
+
+        // The lights emit from their front side. Convert the area density to solid angle.
+        float cosLight = -glm::dot(ls.L, lightNormal);
+        if (cosLight <= 0) return false;
+        ls.radiance = light.intensity * (cosLight * light.surfaceArea / distSquared);
+        return true;
+    }
+    }
+}
+
+bool PolarizationPathTracerScene::sampleBsdf(const SurfaceHit& surface, const vec3& V, Rng& rng, vec3& L) const
+{
+    const Material& m = *surface.pMaterial;
+    float u = rng.next();
+    float v = rng.next();
+    if (rng.next() < m.specularProbability)
+    {
+        // Sample the GGX distribution of normals and reflect V
+        float cosTheta2 = (1.0f - u) / (1.0f + (m.alpha * m.alpha - 1.0f) * u);
+        float cosTheta = sqrt(cosTheta2);
+        float sinTheta = sqrt(std::max(0.0f, 1.0f - cosTheta2));
+        vec3 H = fromTangentSpace(surface.N, vec3(sinTheta * cos(2.0f * kPi * v), sinTheta * sin(2.0f * kPi * v), cosTheta));
+        L = 2.0f * glm::dot(V, H) * H - V;
+    }
+    else
+    {
+        // Cosine-weighted hemisphere
+        float r = sqrt(u);
+        L = fromTangentSpace(surface.N, vec3(r * cos(2.0f * kPi * v), r * sin(2.0f * kPi * v), sqrt(std::max(0.0f, 1.0f - u))));
+    }
+    return glm::dot(surface.N, L) > 0 && glm::dot(surface.Ng, L) > 0;
+}
+
+float PolarizationPathTracerScene::evalBsdfPdf(const SurfaceHit& surface, const vec3& V, const vec3& L) const
+{
+    const Material& m = *surface.pMaterial;
+    vec3 H = glm::normalize(V + L);
+    float NdotH = std::max(0.0f, glm::dot(surface.N, H));
+    float VdotH = std::max(1e-6f, glm::dot(V, H));
+    float NdotL = std::max(0.0f, glm::dot(surface.N, L));
+    float specularPdf = evalGGX(m.alpha, NdotH) * NdotH / (4.0f * VdotH);
+    float diffusePdf = NdotL / kPi;
+    return m.specularProbability * specularPdf + (1.0f - m.specularProbability) * diffusePdf;
+}
+
+bool PolarizationPathTracerScene::evalBsdf(const SurfaceHit& surface, const vec3& V, const vec3& L, const vec3& frameX, glm::mat4 M[3], vec3& nextX) const
+{
+    const Material& m = *surface.pMaterial;
+    float NdotL = glm::dot(surface.N, L);
+    float NdotV = glm::dot(surface.N, V);
+    if (NdotL <= 0 || NdotV <= 0) return false;
+
+    // The s axis is perpendicular to the plane of reflection, which contains the microfacet normal. For retro-reflection any axis will do.
+    vec3 s = glm::cross(L, V);
+    float sLength = glm::length(s);
+    s = (sLength > 1e-6f) ? s / sLength : frameX;
+    vec3 pOut = glm::cross(V, s);
+    nextX = s;
+
+    vec3 H = glm::normalize(V + L);
+    float NdotH = glm::clamp(glm::dot(surface.N, H), 0.0f, 1.0f);
+    float LdotH = glm::clamp(glm::dot(L, H), 0.0f, 1.0f);
+    float specular = evalGGX(m.alpha, NdotH) * evalSmithGGX(NdotL, NdotV, m.alpha) * NdotL;
+
+    glm::mat4 toFrame = muellerRotation(s, pOut, frameX);
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        M[c] = toFrame * (muellerFresnelReflection(m.n[c], m.k[c], LdotH) * specular + muellerDepolarizer(m.diffuse[c] * NdotL / kPi));
+    }
+    return true;
+}
+
+PolarizationPathTracerScene::Stokes PolarizationPathTracerScene::tracePath(const vec2& ndc, Rng& rng) const
+{
+    vec3 origin = mCameraPos;
+    vec3 dir = glm::normalize(ndc.x * mCameraU + ndc.y * mCameraV + mCameraW);
+
+    // The Stokes frame at the camera: the camera's right vector projected perpendicular to the ray
+    vec3 frameX = glm::normalize(mCameraU - glm::dot(mCameraU, dir) * dir);
+
+    // throughput[c] maps a Stokes vector of the light arriving along the current ray, with the x axis frameX, to the camera frame.
+    // The light sources are unpolarized, so only the first column is needed to add their contribution.
+    glm::mat4 throughput[3] = { glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f) };
+    vec4 result[3] = { vec4(0.0f), vec4(0.0f), vec4(0.0f) };
+
+    for (uint32_t bounce = 0; ; bounce++)
+    {
+        TriangleBvh::Hit hit;
+        if (mBvh.intersect(origin, dir, FLT_MAX, hit) == false)
+        {
+            vec3 environment = getEnvironment(dir);
+            for (uint32_t c = 0; c < 3; c++) result[c] += throughput[c][0] * environment[c];
+            break;
+        }
+
+        SurfaceHit surface = getSurface(hit, dir);
+        for (uint32_t c = 0; c < 3; c++) result[c] += throughput[c][0] * surface.pMaterial->emissive[c];
+        if (bounce == mMaxBounces) break;
+
+        vec3 V = -dir;
+        vec3 shadowOrigin = surface.posW + surface.Ng * kRayOffset;
+        glm::mat4 M[3];
+        vec3 nextX;
+
+        // Direct lighting from the analytic lights
+        for (const Light& light : mLights)
+        {
+            LightSample ls;
+            if (sampleLight(light, surface.posW, rng, ls) == false) continue;
+            if (glm::dot(surface.Ng, ls.L) <= 0) continue;
+            if (evalBsdf(surface, V, ls.L, frameX, M, nextX) == false) continue;
+            float maxDistance = (ls.distance == FLT_MAX) ? FLT_MAX : ls.distance * (1.0f - 1e-4f);
+            if (mBvh.occluded(shadowOrigin, ls.L, maxDistance)) continue;
+            for (uint32_t c = 0; c < 3; c++) result[c] += throughput[c] * M[c][0] * ls.radiance[c];
+        }
+
+        // Continue the path
+        vec3 L;
+        if (sampleBsdf(surface, V, rng, L) == false) break;
+        float pdf = evalBsdfPdf(surface, V, L);
+        if (pdf <= 0 || evalBsdf(surface, V, L, frameX, M, nextX) == false) break;
+        for (uint32_t c = 0; c < 3; c++) throughput[c] = throughput[c] * M[c] * (1.0f / pdf);
+        frameX = nextX;
+
+        // Russian roulette on the transmitted intensity
+        if (bounce >= 2)
+        {
+            float q = std::min(0.95f, std::max(throughput[0][0][0], std::max(throughput[1][0][0], throughput[2][0][0])));
+            if (rng.next() >= q) break;
+            for (uint32_t c = 0; c < 3; c++) throughput[c] = throughput[c] * (1.0f / q);
+        }
+
+        origin = shadowOrigin;
+        dir = L;
+    }
+
+    Stokes stokes;
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        stokes.S0[c] = result[c].x;
+        stokes.S1[c] = result[c].y;
+        stokes.S2[c] = result[c].z;
+    }
+    return stokes;
+}
@@ -0,0 +1,164 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+#include "Utils/TriangleBvh.h"
+#include <unordered_map>
+
+using namespace Falcor;
+
+/** A CPU copy of a Falcor scene that is path traced with polarization.
+    Every path carries one Mueller matrix per color channel, which maps the Stokes vector of the light arriving at a vertex to the Stokes vector
+    at the camera. Specular reflections use the exact Fresnel equations of the complex IoR, diffuse reflections depolarize.
+    The geometry is read back from the GPU once and then only accessed on the CPU, so paths can be traced from many threads.
+*/
+class PolarizationPathTracerScene
+{
+public:
+    using UniquePtr = std::unique_ptr<PolarizationPathTracerScene>;
+
+    /** Small random number generator for one pixel sample
+    */
+    class Rng
+    {
+    public:
+        Rng(uint32_t pixel, uint32_t sample);
+        float next();
+    private:
+        uint32_t mState;
+    };
+
+    /** Stokes vectors of the RGB channels at the camera, in the frame of the camera's right and up vectors
+    */
+    struct Stokes
+    {
+        vec3 S0 = vec3(0.0f);
+        vec3 S1 = vec3(0.0f);
+        vec3 S2 = vec3(0.0f);
+    };
+
+    /** Copy a scene to the CPU and build the BVH
+        \param[in] pScene The scene. Its active camera is used.
+        \param[in] aspectRatio Aspect ratio of the image
+        \param[in] maxBounces Maximum number of reflections along a path
+        \return A new object, or nullptr if the scene has no triangles
+    */
+    static UniquePtr create(const Scene::SharedPtr& pScene, float aspectRatio, uint32_t maxBounces);
+
+    /** Trace one path through a point on the image plane
+        \param[in] ndc Point on the image plane in [-1, 1], y up
+        \param[in] rng Random numbers of the sample
+    */
+    Stokes tracePath(const vec2& ndc, Rng& rng) const;
+
+    uint32_t getTriangleCount() const { return mBvh.getTriangleCount(); }
+
+private:
+    PolarizationPathTracerScene() = default;
+
+    /** Material parameters, matching the ShadingData that Shading.slang creates from a constant material
+    */
+    struct Material
+    {
+        vec3 diffuse;
+        vec3 n;                     ///< Simple refractive index per channel, derived from the specular color
+        vec3 k;                     ///< Extinction coefficient per channel
+        vec3 emissive;
+        float alpha;                ///< GGX roughness
+        float specularProbability;  ///< Probability of sampling the specular lobe
+    };
+
+    struct Light
+    {
+        uint32_t type;
+        vec3 posW;
+        vec3 dirW;
+        vec3 intensity;
+        float openingAngle;
+        float cosOpeningAngle;
+        float penumbraAngle;
+        glm::mat4 transMat;         ///< Area lights: transform of the unit shape
+        glm::mat4 transMatIT;       ///< Area lights: inverse transpose of transMat
+        float surfaceArea;
+    };
+
+    struct LightSample
+    {
+        vec3 L;
+        float distance;
+        vec3 radiance;              ///< Radiance divided by the probability density of the sample
+    };
+
+    struct SurfaceHit
+    {
+        vec3 posW;
+        vec3 Ng;                    ///< Geometric normal, facing the ray
+        vec3 N;                     ///< Shading normal, facing the ray
+        const Material* pMaterial;
+    };
+
+    void addMesh(const Mesh::SharedPtr& pMesh, const glm::mat4& worldMat, uint32_t materialID);
+    uint32_t addMaterial(const Falcor::Material::SharedPtr& pMaterial);
+    void addLight(const Falcor::Light::SharedPtr& pLight);
+    void loadEnvironment(const LightProbe::SharedPtr& pProbe);
+
+    SurfaceHit getSurface(const TriangleBvh::Hit& hit, const vec3& dir) const;
+    vec3 getEnvironment(const vec3& dir) const;
+    bool sampleLight(const Light& light, const vec3& posW, Rng& rng, LightSample& ls) const;
+    bool sampleBsdf(const SurfaceHit& surface, const vec3& V, Rng& rng, vec3& L) const;
+    float evalBsdfPdf(const SurfaceHit& surface, const vec3& V, const vec3& L) const;
+
+    /** Evaluate the Mueller matrices of the BSDF times cos(theta) for each color channel.
+        Stokes frames are given by their x axis, the y axis is cross(direction of propagation, x).
+        \param[in] frameX Stokes frame of the reflected light, perpendicular to V
+        \param[out] M The Mueller matrices. The input is in the frame nextX of the incident light and the output in the frame frameX.
+        \param[out] nextX Stokes frame of the incident light, perpendicular to L
+        \return false if the BSDF is zero
+    */
+    bool evalBsdf(const SurfaceHit& surface, const vec3& V, const vec3& L, const vec3& frameX, glm::mat4 M[3], vec3& nextX) const;
+
+    TriangleBvh mBvh;
+    std::vector<vec3> mPositions;               // Three per triangle
+    std::vector<vec3> mNormals;                 // Three per triangle
+    std::vector<uint32_t> mTriangleMaterials;
+    std::vector<Material> mMaterials;
+    std::unordered_map<const Falcor::Material*, uint32_t> mMaterialIDs;
+    std::vector<Light> mLights;
+
+    uint32_t mEnvironmentWidth = 0;
+    uint32_t mEnvironmentHeight = 0;
+    std::vector<vec3> mEnvironment;             // Lat-long map, or a single texel for a constant color
+
+    vec3 mCameraPos;
+    vec3 mCameraU;
+    vec3 mCameraV;
+    vec3 mCameraW;
+    uint32_t mMaxBounces = 4;
+};
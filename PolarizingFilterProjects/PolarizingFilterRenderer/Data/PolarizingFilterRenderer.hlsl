@@ -30,10 +30,13 @@
 __import ShaderCommon;
 __import DefaultVS;
 __import Effects.CascadedShadowMap;
+__import Effects.LightClusters;
+__import Effects.ShadingCache;
 __import Shading;
 __import Helpers;
 __import BRDF;
 __import Lights;
+__import Polarization;
 
 layout(binding = 0) cbuffer PerFrameCB : register(b0)
 {
@@ -49,116 +52,15 @@ layout(binding = 0) cbuffer PerFrameCB : register(b0)
 layout(set = 1, binding = 1) SamplerState gSampler;
 Texture2D gVisibilityBuffer;
 
-//// Polarizing filter functions ////
+// psi of the specular reflectance, baked by PsiLut::bakeReflectance(). Used when _PSI_LUT is defined.
+Texture2D gPsiLut;
+SamplerState gPsiLutSampler;
 
-// Calculate rotation angle between the camera and the surface
-float calcRelativeAngle(float3 cameraX, float3 N, float3 V)
-{
-    float3 surfaceX = normalize(cross(N, V));
-    float dotX = dot(surfaceX, cameraX);
-    float detX = dot(V, cross(surfaceX, cameraX));
-    return gPolarizingFilterAngle + atan2(detX, dotX);
-}
-
-// R0  - specular color
-// ct  - cos(theta)
-// st2 - sin^2(theta)
-float3 psi_MetalApprox(float3 R0, float ct, float st2)
-{
-    float3 Rb = float3(1.095) - R0;
-    float3 Rg = float3(1.18) - R0;
-    float3 beta  = float3(0.1)/(Rb*Rb*Rb) + 5.4*R0*R0 + float3(1.0);
-    float3 gamma = (0.16*R0*R0)/(Rg*Rg) + 0.35*Rg;
-    
-    float3 psi = (ct*st2)/(beta*ct*ct + gamma*st2*st2);
-    return saturate(psi);
-}
-
-// R0  - specular color
-// ct  - cos(theta)
-// st2 - sin^2(theta)
-float psi_DielectricExact(float R0, float ct, float st2)
-{
-    float n = (1.0 + sqrt(R0))/(1.0 - sqrt(R0));
-    float c = n*n - st2;
-
-    float psi = (2.0*sqrt(c)*ct*st2)/(c*ct*ct + st2*st2);
-
-    return saturate(psi);
-}
-
-// cameraX - normalized vector that points to the right from the viewer's perspective
-float3 polarizingFilter(ShadingData sd, LightSample ls, float3 cameraX)
-{
-    float3 H = normalize(sd.V + ls.L);
-    float st  = length(cross(ls.L, H)); // sin(theta)
-    float st2 = st*st;                  // sin^2(theta)
-    float angle = calcRelativeAngle(cameraX, H, sd.V);
-
-    float3 psi;
-    if (sd.metalness > 0.5) {
-        psi = psi_MetalApprox(sd.specular, ls.LdotH, st2);
-    } else {
-        psi = float3(psi_DielectricExact(sd.specular.r, ls.LdotH, st2));
-    }
-
-    return (cos(2.0*angle)*psi + float3(1.0));
-}
-
-//// Material evaluation functions ////
-
-// Point and directional light sources //
-ShadingResult evalMaterialWithFilter(ShadingData sd, LightData light, float shadowFactor, float3 cameraX)
-{
-    ShadingResult sr = initShadingResult();
-    LightSample ls = evalLight(light, sd);
-
-    // If the light doesn't hit the surface or we are viewing the surface from the back, return
-    if(ls.NdotL <= 0) return sr;
-    sd.NdotV = saturate(sd.NdotV);
-
-    // Calculate the diffuse term
-    sr.diffuseBrdf = saturate(evalDiffuseBrdf(sd, ls));
-    sr.diffuse = ls.diffuse * sr.diffuseBrdf * ls.NdotL;
-    sr.color.rgb = sr.diffuse;
-    sr.color.a = sd.opacity;
-
-    // Calculate the specular term
-    sr.specularBrdf = saturate(evalSpecularBrdf(sd, ls));
-    sr.specular = ls.specular * sr.specularBrdf * ls.NdotL;
-
-    // Apply polarizing filter
-    if (gEnablePolarizingFilter) {
-        sr.specular *= polarizingFilter(sd, ls, cameraX);
-    }
-
-    sr.color.rgb += sr.specular;
-
-    // Apply the shadow factor
-    sr.color.rgb *= shadowFactor;
-
-    return sr;
-}
-
-// Light probes
-ShadingResult evalMaterialWithFilter(ShadingData sd, LightProbeData probe, float3 cameraX)
-{
-    ShadingResult sr = initShadingResult();
-    LightSample ls = evalLightProbe(probe, sd);
-
-    sr.diffuse = ls.diffuse;
-    sr.color.rgb = sr.diffuse;
-    sr.specular = ls.specular;
-
-    // Apply polarizing filter
-    if (gEnablePolarizingFilter) {
-        sr.specular *= polarizingFilter(sd, ls, cameraX);
-    }
-    
-    sr.color.rgb += sr.specular;
-
-    return sr;
-}
+// Polarization terms of the light probe, baked by ProbePolarization. Used when _PROBE_POLARIZATION is defined.
+// The coherence texture is sampled with gPsiLutSampler.
+Texture2D gProbePolarizationCos;
+Texture2D gProbePolarizationSin;
+Texture2D gProbeCoherence;
 
 //// Vertex and Pixel shader entry points ////
 
@@ -188,12 +90,43 @@ struct PsOut
 #ifdef _OUTPUT_MOTION_VECTORS
     float2 motion : SV_TARGET2;
 #endif
+#ifdef _OUTPUT_STOKES
+// The polarized terms follow the motion vectors when both are written
+#ifdef _OUTPUT_MOTION_VECTORS
+    float4 stokesQ : SV_TARGET3;
+    float4 stokesU : SV_TARGET4;
+#else
+    float4 stokesQ : SV_TARGET2;
+    float4 stokesU : SV_TARGET3;
+#endif
+#endif
 };
 
 PsOut ps(MainVsOut vOut, float4 pixelCrd : SV_POSITION)
 {
     PsOut psOut;
 
+#ifdef _SHADING_CACHE
+    // Reuse the reprojected shading of the previous frame. The cached color already contains the transparent surfaces, so they are blended with zero alpha.
+    float4 cachedColor;
+    if (getCachedShading(pixelCrd.xy, cachedColor, psOut.normal))
+    {
+        psOut.color = cachedColor;
+#ifdef _ENABLE_TRANSPARENCY
+        psOut.color.a = 0;
+#endif
+#ifdef _OUTPUT_STOKES
+        // The cache doesn't store the polarized terms, the renderer disables it with Stokes output
+        psOut.stokesQ = float4(0, 0, 0, psOut.color.a);
+        psOut.stokesU = float4(0, 0, 0, psOut.color.a);
+#endif
+#ifdef _OUTPUT_MOTION_VECTORS
+        psOut.motion = calcMotionVector(pixelCrd.xy, vOut.vsData.prevPosH, gRenderTargetDim);
+#endif
+        return psOut;
+    }
+#endif
+
     ShadingData sd = prepareShadingData(vOut.vsData, gMaterial, gCamera.posW);
 
     float4 finalColor = float4(0, 0, 0, 1);
@@ -201,8 +134,31 @@ PsOut ps(MainVsOut vOut, float4 pixelCrd : SV_POSITION)
     float3 cameraUp = normalize(gCamera.cameraV);
     float3 cameraX  = normalize(cross(cameraUp, sd.V));
 
+#ifdef _PSI_LUT
+    SpecularPsiLut psi;
+    psi.lut = gPsiLut;
+    psi.lutSampler = gPsiLutSampler;
+#else
+    SpecularPsi psi;
+#endif
+
+#ifdef _OUTPUT_STOKES
+    bool evalStokes = true;
+#else
+    bool evalStokes = gEnablePolarizingFilter;
+#endif
+    StokesTerms stokes = initStokesTerms();
+
+#ifdef _CLUSTERED_LIGHTING
+    uint2 clusterRange = getLightClusterRange(pixelCrd.xy / gRenderTargetDim, sd.posW);
+    for (uint i = 0; i < clusterRange.y; i++) {
+        uint l;
+        LightData light = getClusterLight(clusterRange, i, l);
+#else
     [unroll]
     for (uint l = 0; l < _LIGHT_COUNT; l++) {
+        LightData light = gLights[l];
+#endif
         float shadowFactor = 1;
 #ifdef _ENABLE_SHADOWS
         if (l == 0)
@@ -211,7 +167,7 @@ PsOut ps(MainVsOut vOut, float4 pixelCrd : SV_POSITION)
             shadowFactor *= sd.opacity;
         }
 #endif
-        finalColor.rgb += evalMaterialWithFilter(sd, gLights[l], shadowFactor, cameraX).color.rgb;
+        finalColor.rgb += evalMaterialPolarized(sd, light, shadowFactor, cameraX, psi, evalStokes, stokes).color.rgb;
     }
 
     // Add the emissive component
@@ -222,7 +178,23 @@ PsOut ps(MainVsOut vOut, float4 pixelCrd : SV_POSITION)
 #endif
 
 #ifdef _ENABLE_REFLECTIONS
-    finalColor.rgb += evalMaterialWithFilter(sd, gLightProbe, cameraX).color.rgb;
+#ifdef _PROBE_POLARIZATION
+    ProbePolarizationTextures probePolarization;
+    probePolarization.cosTexture = gProbePolarizationCos;
+    probePolarization.sinTexture = gProbePolarizationSin;
+    probePolarization.coherenceTexture = gProbeCoherence;
+    probePolarization.coherenceSampler = gPsiLutSampler;
+    finalColor.rgb += evalMaterialPolarized(sd, gLightProbe, probePolarization, cameraX, psi, evalStokes, stokes).color.rgb;
+#else
+    finalColor.rgb += evalMaterialPolarized(sd, gLightProbe, cameraX, psi, evalStokes, stokes).color.rgb;
+#endif
+#endif
+
+#ifndef _OUTPUT_STOKES
+    // The filter is linear in the specular terms, so it can be applied to their sum
+    if (gEnablePolarizingFilter) {
+        finalColor.rgb += evalPolarizingFilter(stokes, gPolarizingFilterAngle);
+    }
 #endif
 
     // Add light-map
@@ -231,6 +203,12 @@ PsOut ps(MainVsOut vOut, float4 pixelCrd : SV_POSITION)
     psOut.color = finalColor;
     psOut.normal = float4(vOut.vsData.normalW * 0.5f + 0.5f, 1.0f);
 
+#ifdef _OUTPUT_STOKES
+    // Use the same alpha as the color, so that blending transparent objects is the same for all three terms
+    psOut.stokesQ = float4(stokes.Q, finalColor.a);
+    psOut.stokesU = float4(stokes.U, finalColor.a);
+#endif
+
 #ifdef _OUTPUT_MOTION_VECTORS
     psOut.motion = calcMotionVector(pixelCrd.xy, vOut.vsData.prevPosH, gRenderTargetDim);
 #endif
@@ -35,16 +35,29 @@
 
 const std::string PolarizingFilterRenderer::skDefaultScene = "Arcade/Arcade.fscene";
 
+// The programs are kept when loading another scene, so that the compiled program versions are reused
 void PolarizingFilterRenderer::initDepthPass()
 {
-    mDepthPass.pProgram = GraphicsProgram::createFromFile("DepthPass.ps.slang", "", "main");
+    if (mDepthPass.pProgram == nullptr)
+    {
+        mDepthPass.pProgram = GraphicsProgram::createFromFile("DepthPass.ps.slang", "", "main");
+    }
     mDepthPass.pVars = GraphicsVars::create(mDepthPass.pProgram->getReflector());
 }
 
 void PolarizingFilterRenderer::initLightingPass()
 {
-    mLightingPass.pProgram = GraphicsProgram::createFromFile("PolarizingFilterRenderer.hlsl", "vs", "ps");
-    mLightingPass.pProgram->addDefine("_LIGHT_COUNT", std::to_string(mpSceneRenderer->getScene()->getLightCount()));
+    if (mLightingPass.pProgram == nullptr)
+    {
+        mLightingPass.pProgram = GraphicsProgram::createFromFile("PolarizingFilterRenderer.hlsl", "vs", "ps");
+    }
+    // The unrolled light loop reads the lights from the cbuffer array, which holds at most MAX_LIGHT_SOURCES. Use clustered lighting to shade with all of them.
+    uint32_t lightCount = std::min(mpSceneRenderer->getScene()->getLightCount(), (uint32_t)MAX_LIGHT_SOURCES);
+    mLightingPass.pProgram->addDefine("_LIGHT_COUNT", std::to_string(lightCount));
+    if (mLightingPass.pLightClusters == nullptr)
+    {
+        mLightingPass.pLightClusters = LightClusters::create();
+    }
     initControls();
     mLightingPass.pVars = GraphicsVars::create(mLightingPass.pProgram->getReflector());
     
@@ -59,6 +72,73 @@ void PolarizingFilterRenderer::initLightingPass()
     BlendState::Desc bsDesc;
     bsDesc.setRtBlend(0, true).setRtParams(0, BlendState::BlendOp::Add, BlendState::BlendOp::Add, BlendState::BlendFunc::SrcAlpha, BlendState::BlendFunc::OneMinusSrcAlpha, BlendState::BlendFunc::One, BlendState::BlendFunc::Zero);
     mLightingPass.pAlphaBlendBS = BlendState::create(bsDesc);
+
+    // The lookup texture only depends on R0, so it's shared by all scenes
+    if (mLightingPass.pPsiLut == nullptr)
+    {
+        mLightingPass.pPsiLut = PsiLut::createReflectanceTexture();
+
+        Sampler::Desc samplerDesc;
+        samplerDesc.setAddressingMode(Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp).setFilterMode(Sampler::Filter::Linear, Sampler::Filter::Linear, Sampler::Filter::Point);
+        mLightingPass.pPsiLutSampler = Sampler::create(samplerDesc);
+    }
+
+    mShadingCache.pCache->invalidate();
+}
+
+void PolarizingFilterRenderer::initStokes()
+{
+    mStokes.pReconstructPass = FullScreenPass::create("StokesReconstruct.ps.slang");
+    mStokes.pVars = GraphicsVars::create(mStokes.pReconstructPass->getProgram()->getReflector());
+}
+
+void PolarizingFilterRenderer::initCheckerboard(uint32_t width, uint32_t height)
+{
+    if (mCheckerboard.pMaskPass == nullptr)
+    {
+        mCheckerboard.pMaskPass = FullScreenPass::create("CheckerboardMask.ps.slang");
+        mCheckerboard.pMaskVars = GraphicsVars::create(mCheckerboard.pMaskPass->getProgram()->getReflector());
+
+        DepthStencilState::Desc maskDesc;
+        maskDesc.setDepthTest(false).setDepthWriteMask(false).setStencilTest(true).setStencilWriteMask(1).setStencilRef(1);
+        maskDesc.setStencilFunc(DepthStencilState::Face::FrontAndBack, DepthStencilState::Func::Always);
+        maskDesc.setStencilOp(DepthStencilState::Face::FrontAndBack, DepthStencilState::StencilOp::Keep, DepthStencilState::StencilOp::Keep, DepthStencilState::StencilOp::Replace);
+        mCheckerboard.pMaskDsState = DepthStencilState::create(maskDesc);
+
+        DepthStencilState::Desc lightingDesc;
+        lightingDesc.setDepthTest(true).setDepthFunc(DepthStencilState::Func::LessEqual).setStencilTest(true).setStencilReadMask(1).setStencilWriteMask(0).setStencilRef(0);
+        lightingDesc.setStencilFunc(DepthStencilState::Face::FrontAndBack, DepthStencilState::Func::Equal);
+        mCheckerboard.pLightingDsState = DepthStencilState::create(lightingDesc);
+    }
+
+    Program::DefineList defines;
+    if (mAAMode == AAMode::TAA) defines.add("_OUTPUT_MOTION_VECTORS");
+    mCheckerboard.pReconstructPass = FullScreenPass::create("CheckerboardReconstruct.ps.slang", defines);
+    mCheckerboard.pReconstructVars = GraphicsVars::create(mCheckerboard.pReconstructPass->getProgram()->getReflector());
+
+    Sampler::Desc samplerDesc;
+    samplerDesc.setAddressingMode(Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp).setFilterMode(Sampler::Filter::Linear, Sampler::Filter::Linear, Sampler::Filter::Point);
+    mCheckerboard.pReconstructVars->setSampler("gLinearSampler", Sampler::create(samplerDesc));
+
+    // Color, normal and the motion vectors with TAA
+    uint32_t targetCount = (mAAMode == AAMode::TAA) ? 3 : 2;
+    Fbo::Desc fboDesc;
+    fboDesc.setColorTarget(0, ResourceFormat::RGBA32Float).setColorTarget(1, ResourceFormat::RGBA8Unorm);
+    if (targetCount == 3) fboDesc.setColorTarget(2, ResourceFormat::RG16Float);
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        mCheckerboard.pReconstructFbo[i] = FboHelper::create2D(width, height, fboDesc);
+
+        // The passes after the lighting read the depth from the resolve FBO. It can't be attached while the reconstruction reads it.
+        mCheckerboard.pResolveFbo[i] = Fbo::create();
+        for (uint32_t t = 0; t < targetCount; t++)
+        {
+            mCheckerboard.pResolveFbo[i]->attachColorTarget(mCheckerboard.pReconstructFbo[i]->getColorTexture(t), t);
+        }
+        mCheckerboard.pResolveFbo[i]->attachDepthStencilTarget(mpMainFbo->getDepthStencilTexture());
+    }
+    mCheckerboard.historyValid = false;
 }
 
 void PolarizingFilterRenderer::initShadowPass(uint32_t windowWidth, uint32_t windowHeight)
@@ -68,11 +148,13 @@ void PolarizingFilterRenderer::initShadowPass(uint32_t windowWidth, uint32_t win
     mShadowPass.pCsm->setVsmLightBleedReduction(0.3f);
     mShadowPass.pCsm->setVsmMaxAnisotropy(4);
     mShadowPass.pCsm->setEvsmBlur(7, 3);
+    mShadowPass.pCsm->toggleStaticCasterCaching(true);   // The light and most of the geometry are static in the demo scenes
 }
 
 void PolarizingFilterRenderer::initSSAO()
 {
     mSSAO.pSSAO = SSAO::create(uvec2(1024));
+    mSSAO.pSSAO->setResolution(SSAO::Resolution::Half);
     mSSAO.pApplySSAOPass = FullScreenPass::create("ApplyAO.ps.slang");
     mSSAO.pVars = GraphicsVars::create(mSSAO.pApplySSAOPass->getProgram()->getReflector());
 
@@ -149,10 +231,12 @@ void PolarizingFilterRenderer::initScene(SampleCallbacks* pSample, Scene::Shared
     auto pTargetFbo = pSample->getCurrentFbo();
     initShadowPass(pTargetFbo->getWidth(), pTargetFbo->getHeight());
     initSSAO();
+    initStokes();
     initAA(pSample);
 
     mControls[EnableReflections].enabled = pScene->getLightProbeCount() > 0;
     applyLightingProgramControl(ControlID::EnableReflections);
+    updateProbePolarization();
     
     pSample->setCurrentTime(0);
 }
@@ -174,6 +258,8 @@ void PolarizingFilterRenderer::loadModel(SampleCallbacks* pSample, const std::st
         pBar = ProgressBar::create("Loading Model");
     }
 
+    watchSceneFile(pSample, "");
+
     Model::SharedPtr pModel = Model::createFromFile(filename.c_str());
     if (!pModel) return;
     Scene::SharedPtr pScene = Scene::create();
@@ -201,6 +287,23 @@ void PolarizingFilterRenderer::loadScene(SampleCallbacks* pSample, const std::st
         applyCustomSceneVars(pScene.get(), filename);
         applyCsSkinningMode();
     }
+
+    // Keep watching even if loading failed, so that fixing the file reloads it
+    watchSceneFile(pSample, filename);
+}
+
+void PolarizingFilterRenderer::watchSceneFile(SampleCallbacks* pSample, const std::string& filename)
+{
+    if (filename == mWatchedSceneFile) return;
+
+    FileWatcher::unsubscribe(mSceneFileSubscription);
+    mSceneFileSubscription = FileWatcher::kInvalidSubscriptionId;
+    mWatchedSceneFile = filename;
+
+    if (filename.size())
+    {
+        mSceneFileSubscription = FileWatcher::subscribe(filename, [this, pSample](const std::string&) { loadScene(pSample, mWatchedSceneFile, false); });
+    }
 }
 
 void PolarizingFilterRenderer::initSkyBox(const std::string& name)
@@ -217,6 +320,7 @@ void PolarizingFilterRenderer::initSkyBox(const std::string& name)
 void PolarizingFilterRenderer::updateLightProbe(const LightProbe::SharedPtr& pLight)
 {
     Scene::SharedPtr pScene = mpSceneRenderer->getScene();
+    mShadingCache.pCache->invalidate();
 
     // Remove existing light probes
     while (pScene->getLightProbeCount() > 0)
@@ -231,6 +335,27 @@ void PolarizingFilterRenderer::updateLightProbe(const LightProbe::SharedPtr& pLi
 
     mControls[EnableReflections].enabled = true;
     applyLightingProgramControl(ControlID::EnableReflections);
+    updateProbePolarization();
+}
+
+void PolarizingFilterRenderer::updateProbePolarization()
+{
+    mLightingPass.probePolarization = {};
+    if (mControls[ControlID::ProbePolarization].enabled == false) return;
+
+    const Scene* pScene = mpSceneRenderer->getScene().get();
+    if (pScene->getLightProbeCount() == 0 || ProbePolarization::createEnvironmentTextures(pScene->getLightProbe(0).get(), mLightingPass.probePolarization) == false)
+    {
+        mControls[ControlID::ProbePolarization].enabled = false;
+        applyLightingProgramControl(ControlID::ProbePolarization);
+        return;
+    }
+
+    // The coherence doesn't depend on the light probe
+    if (mLightingPass.pProbeCoherence == nullptr)
+    {
+        mLightingPass.pProbeCoherence = ProbePolarization::createCoherenceTexture();
+    }
 }
 
 void PolarizingFilterRenderer::initAA(SampleCallbacks* pSample)
@@ -249,7 +374,33 @@ void PolarizingFilterRenderer::onLoad(SampleCallbacks* pSample, RenderContext* p
 {
     mpState = GraphicsState::create();    
     initPostProcess();
-    loadScene(pSample, skDefaultScene, true);
+    mShadingCache.pCache = ShadingCache::create();
+    mVariableRate.pGenerator = ShadingRateGenerator::create();
+
+    mpBatchCapture = PolarizingFilterRendererBatchCapture::create(pSample->getArgList(), skDefaultScene);
+    if (mpBatchCapture)
+    {
+        pSample->toggleUI(false);
+        pSample->toggleText(false);
+        pSample->freezeTime(true);
+        if (mpBatchCapture->getShadingCacheRefreshPeriod() > 0)
+        {
+            mShadingCache.enabled = true;
+            mShadingCache.pCache->setRefreshPeriod(mpBatchCapture->getShadingCacheRefreshPeriod());
+        }
+        if (mpBatchCapture->getShadingComparison() == "VariableRate" && gpDevice->isFeatureSupported(Device::SupportedFeatures::VariableRateShadingTier2) == false)
+        {
+            logWarning("Variable-rate shading isn't supported on this device, the shading comparison renders both images at full rate");
+        }
+        // Render each view once and apply the angles to it, unless TAA requires rendering every shot. A shading comparison renders every shot twice.
+        mStokes.enabled = mpBatchCapture->getShots().size() > 1 && mpBatchCapture->getShadingComparison().empty();
+        mBatchState.scene = mpBatchCapture->getCurrentView()->scene;
+        loadScene(pSample, mBatchState.scene, false);
+    }
+    else
+    {
+        loadScene(pSample, skDefaultScene, true);
+    }
 }
 
 void PolarizingFilterRenderer::renderSkyBox(RenderContext* pContext)
@@ -266,8 +417,20 @@ void PolarizingFilterRenderer::renderSkyBox(RenderContext* pContext)
 void PolarizingFilterRenderer::beginFrame(RenderContext* pContext, Fbo* pTargetFbo, uint64_t frameId)
 {
     pContext->pushGraphicsState(mpState);
-    pContext->clearFbo(mpMainFbo.get(), glm::vec4(0.7f, 0.7f, 0.7f, 1.0f), 1, 0, FboAttachmentType::All);
     pContext->clearFbo(mpPostProcessFbo.get(), glm::vec4(), 1, 0, FboAttachmentType::Color);
+    if (mRenderScene == false)
+    {
+        return;
+    }
+
+    pContext->clearFbo(mpMainFbo.get(), glm::vec4(0.7f, 0.7f, 0.7f, 1.0f), 1, 0, FboAttachmentType::All);
+
+    if (mStokes.enabled)
+    {
+        // The sky-box only writes the color, so there is no polarized light in the background
+        pContext->clearRtv(mpMainFbo->getColorTexture(mStokes.firstTarget)->getRTV().get(), vec4(0));
+        pContext->clearRtv(mpMainFbo->getColorTexture(mStokes.firstTarget + 1)->getRTV().get(), vec4(0));
+    }
 
     if (mAAMode == AAMode::TAA)
     {
@@ -283,10 +446,59 @@ void PolarizingFilterRenderer::endFrame(RenderContext* pContext)
     pContext->popGraphicsState();
 }
 
+Texture::SharedPtr PolarizingFilterRenderer::getLitColorTexture() const
+{
+    return mStokes.enabled ? mStokes.pFbo->getColorTexture(0) : mpResolveFbo->getColorTexture(0);
+}
+
 void PolarizingFilterRenderer::postProcess(RenderContext* pContext, Fbo::SharedPtr pTargetFbo)
 {
     PROFILE("postProcess");    
-    mpToneMapper->execute(pContext, mpResolveFbo->getColorTexture(0), pTargetFbo);
+    mpToneMapper->execute(pContext, getLitColorTexture(), pTargetFbo);
+}
+
+void PolarizingFilterRenderer::applyPolarizingFilter(RenderContext* pContext, float angle)
+{
+    if (mStokes.enabled)
+    {
+        PROFILE("applyPolarizingFilter");
+        float angle2 = 2.0f * angle * DEG_TO_RAD;
+        vec2 filterDir = mEnablePolarizingFilter ? vec2(cos(angle2), sin(angle2)) : vec2(0);
+        mStokes.pVars->getConstantBuffer("PerFrameCB")["gFilterDir"] = filterDir;
+        mStokes.pVars->setTexture("gColor", mpResolveFbo->getColorTexture(0));
+        mStokes.pVars->setTexture("gStokesQ", mStokes.pQ);
+        mStokes.pVars->setTexture("gStokesU", mStokes.pU);
+
+        pContext->getGraphicsState()->pushFbo(mStokes.pFbo);
+        pContext->setGraphicsVars(mStokes.pVars);
+        mStokes.pReconstructPass->execute(pContext);
+        pContext->getGraphicsState()->popFbo();
+    }
+}
+
+void PolarizingFilterRenderer::renderPostProcessChain(RenderContext* pContext, const Fbo::SharedPtr& pTargetFbo, bool runTemporalAA)
+{
+    Fbo::SharedPtr pPostProcessDst = mControls[EnableSSAO].enabled ? mpPostProcessFbo : pTargetFbo;
+    postProcess(pContext, pPostProcessDst);
+    if (runTemporalAA) runTAA(pContext, pPostProcessDst); // This will only run if we are in TAA mode
+    ambientOcclusion(pContext, pTargetFbo);
+    executeFXAA(pContext, pTargetFbo);
+}
+
+void PolarizingFilterRenderer::renderFilterAngle(RenderContext* pContext, float angle, const Fbo::SharedPtr& pTargetFbo)
+{
+    if (mpSceneRenderer == nullptr || mStokes.enabled == false || mStokes.sceneValid == false)
+    {
+        logWarning("PolarizingFilterRenderer::renderFilterAngle() - a frame must be rendered with Stokes output first");
+        return;
+    }
+
+    pContext->pushGraphicsState(mpState);
+    pContext->clearFbo(mpPostProcessFbo.get(), glm::vec4(), 1, 0, FboAttachmentType::Color);
+    applyPolarizingFilter(pContext, angle);
+    // TAA would blend the different angles together
+    renderPostProcessChain(pContext, pTargetFbo, false);
+    pContext->popGraphicsState();
 }
 
 void PolarizingFilterRenderer::depthPass(RenderContext* pContext)
@@ -297,6 +509,28 @@ void PolarizingFilterRenderer::depthPass(RenderContext* pContext)
         return;
     }
 
+    // The shading cache reprojects with the motion vectors of the depth pass
+    bool outputMotion = canUseShadingCache();
+    const Texture* pDepth = mpDepthPassFbo->getDepthStencilTexture().get();
+    if (outputMotion && (mShadingCache.pMotion == nullptr || mShadingCache.pMotion->getWidth() != pDepth->getWidth() || mShadingCache.pMotion->getHeight() != pDepth->getHeight()))
+    {
+        mShadingCache.pMotion = Texture::create2D(pDepth->getWidth(), pDepth->getHeight(), ResourceFormat::RGBA16Float, 1, 1, nullptr, Resource::BindFlags::RenderTarget | Resource::BindFlags::ShaderResource);
+    }
+    if (outputMotion != (mpDepthPassFbo->getColorTexture(0) != nullptr))
+    {
+        mpDepthPassFbo->attachColorTarget(outputMotion ? mShadingCache.pMotion : nullptr, 0);
+    }
+    if (outputMotion != (mDepthPass.pProgram->getDefines().count("_OUTPUT_MOTION_VECTORS") > 0))
+    {
+        if (outputMotion) mDepthPass.pProgram->addDefine("_OUTPUT_MOTION_VECTORS");
+        else mDepthPass.pProgram->removeDefine("_OUTPUT_MOTION_VECTORS");
+        mDepthPass.pVars = GraphicsVars::create(mDepthPass.pProgram->getReflector());
+    }
+    if (outputMotion)
+    {
+        mDepthPass.pVars->getConstantBuffer("DepthPassCB")["gRenderTargetDim"] = vec2((float)pDepth->getWidth(), (float)pDepth->getHeight());
+    }
+
     mpState->setFbo(mpDepthPassFbo);
     mpState->setProgram(mDepthPass.pProgram);
     pContext->setGraphicsVars(mDepthPass.pVars);
@@ -306,11 +540,129 @@ void PolarizingFilterRenderer::depthPass(RenderContext* pContext)
     mpSceneRenderer->renderScene(pContext);
 }
 
+bool PolarizingFilterRenderer::canUseShadingCache() const
+{
+    // The cache reprojects the single-sampled depth of the depth pass, and doesn't store the polarized terms. The checkerboard leaves holes in the color it would cache.
+    return mShadingCache.enabled && mEnableDepthPass && mAAMode != AAMode::MSAA && mStokes.enabled == false && mCheckerboard.pReconstructFbo[0] == nullptr;
+}
+
+void PolarizingFilterRenderer::shadingCachePass(RenderContext* pContext)
+{
+    bool active = canUseShadingCache();
+    if (active != mShadingCache.active)
+    {
+        mShadingCache.active = active;
+        if (active)
+        {
+            mLightingPass.pProgram->addDefine("_SHADING_CACHE");
+            mShadingCache.pCache->invalidate();
+        }
+        else
+        {
+            mLightingPass.pProgram->removeDefine("_SHADING_CACHE");
+        }
+    }
+    if (active == false) return;
+
+    PROFILE("shadingCache");
+
+    // The reprojection only sees changes of the geometry, including moving and skinned models. Changes of the lighting have to invalidate the cache.
+    const Scene* pScene = mpSceneRenderer->getScene().get();
+    bool lightsChanged = (mShadingCache.lights.size() != pScene->getLightCount());
+    mShadingCache.lights.resize(pScene->getLightCount());
+    for (uint32_t i = 0; i < pScene->getLightCount(); i++)
+    {
+        const LightData& light = pScene->getLight(i)->getData();
+        if (lightsChanged == false && std::memcmp(&light, &mShadingCache.lights[i], sizeof(LightData)) != 0) lightsChanged = true;
+        mShadingCache.lights[i] = light;
+    }
+    if (lightsChanged || mShadingCache.filterAngle != mPolarizingFilterAngle || mShadingCache.filterEnabled != mEnablePolarizingFilter)
+    {
+        mShadingCache.filterAngle = mPolarizingFilterAngle;
+        mShadingCache.filterEnabled = mEnablePolarizingFilter;
+        mShadingCache.pCache->invalidate();
+    }
+
+    mShadingCache.pCache->reproject(pContext, pScene->getActiveCamera().get(), mpDepthPassFbo->getDepthStencilTexture(), mShadingCache.pMotion);
+    mShadingCache.pCache->setIntoProgramVars(mLightingPass.pVars.get());
+}
+
+void PolarizingFilterRenderer::checkerboardMaskPass(RenderContext* pContext)
+{
+    mCheckerboard.active = mCheckerboard.pReconstructFbo[0] && mEnableDepthPass;
+    if (mCheckerboard.active == false)
+    {
+        mCheckerboard.historyValid = false;
+        return;
+    }
+
+    // Mark the skipped quads after the depth pass, so that the lighting pass rejects them with the stencil test before running the pixel shader
+    PROFILE("checkerboard");
+    mCheckerboard.phase = 1 - mCheckerboard.phase;
+    mCheckerboard.pMaskVars->getConstantBuffer("CheckerboardCB")["gPhase"] = mCheckerboard.phase;
+    mpState->setFbo(mpDepthPassFbo);
+    pContext->setGraphicsVars(mCheckerboard.pMaskVars);
+    mCheckerboard.pMaskPass->execute(pContext, mCheckerboard.pMaskDsState);
+}
+
+void PolarizingFilterRenderer::checkerboardReconstructPass(RenderContext* pContext)
+{
+    if (mCheckerboard.active == false)
+    {
+        // Go back to the main FBO after the checkerboard was turned off
+        if (mpResolveFbo == mCheckerboard.pResolveFbo[0] || mpResolveFbo == mCheckerboard.pResolveFbo[1]) mpResolveFbo = mpMainFbo;
+        return;
+    }
+
+    PROFILE("checkerboard");
+    uint32_t historyFbo = mCheckerboard.curFbo;
+    mCheckerboard.curFbo = 1 - mCheckerboard.curFbo;
+    const Fbo::SharedPtr& pFbo = mCheckerboard.pReconstructFbo[mCheckerboard.curFbo];
+
+    GraphicsVars* pVars = mCheckerboard.pReconstructVars.get();
+    ConstantBuffer::SharedPtr pCB = pVars->getConstantBuffer("CheckerboardCB");
+    pCB["gInvResolution"] = vec2(1.0f / pFbo->getWidth(), 1.0f / pFbo->getHeight());
+    pCB["gPhase"] = mCheckerboard.phase;
+    pCB["gHistoryValid"] = mCheckerboard.historyValid ? 1u : 0u;
+    mpSceneRenderer->getScene()->getActiveCamera()->setIntoConstantBuffer(pVars->getConstantBuffer("InternalPerFrameCB").get(), 0);
+    pVars->setTexture("gColor", mpMainFbo->getColorTexture(0));
+    pVars->setTexture("gNormal", mpMainFbo->getColorTexture(1));
+    if (mAAMode == AAMode::TAA) pVars->setTexture("gMotion", mpMainFbo->getColorTexture(2));
+    pVars->setTexture("gDepth", mpMainFbo->getDepthStencilTexture());
+    pVars->setTexture("gHistory", mCheckerboard.pReconstructFbo[historyFbo]->getColorTexture(0));
+
+    mpState->setFbo(pFbo);
+    pContext->setGraphicsVars(mCheckerboard.pReconstructVars);
+    mCheckerboard.pReconstructPass->execute(pContext);
+
+    // The passes after the lighting read the reconstructed frame
+    mpResolveFbo = mCheckerboard.pResolveFbo[mCheckerboard.curFbo];
+    mCheckerboard.historyValid = true;
+}
+
+void PolarizingFilterRenderer::updateShadingRateImage(RenderContext* pContext)
+{
+    mVariableRate.active = (mShadingMode == ShadingMode::VariableRate) && gpDevice->isFeatureSupported(Device::SupportedFeatures::VariableRateShadingTier2);
+    if (mVariableRate.active == false) return;
+
+    // The image is used by the next frame. Motion vectors are only written with TAA.
+    PROFILE("shadingRate");
+    Texture::SharedPtr pMotion = (mAAMode == AAMode::TAA) ? mpResolveFbo->getColorTexture(2) : nullptr;
+    mVariableRate.pGenerator->generate(pContext, getLitColorTexture(), pMotion);
+}
+
 void PolarizingFilterRenderer::lightingPass(RenderContext* pContext, Fbo* pTargetFbo)
 {
     PROFILE("lightingPass");
     mpState->setProgram(mLightingPass.pProgram);
-    mpState->setDepthStencilState(mEnableDepthPass ? mLightingPass.pDsState : nullptr);
+    if (mCheckerboard.active)
+    {
+        mpState->setDepthStencilState(mCheckerboard.pLightingDsState);
+    }
+    else
+    {
+        mpState->setDepthStencilState(mEnableDepthPass ? mLightingPass.pDsState : nullptr);
+    }
     pContext->setGraphicsVars(mLightingPass.pVars);
     ConstantBuffer::SharedPtr pCB = mLightingPass.pVars->getConstantBuffer("PerFrameCB");
     pCB["gOpacityScale"] = mOpacityScale;
@@ -325,12 +677,40 @@ void PolarizingFilterRenderer::lightingPass(RenderContext* pContext, Fbo* pTarge
         mLightingPass.pVars->setTexture("gVisibilityBuffer", mShadowPass.pVisibilityBuffer);
     }
 
+    if (mControls[ControlID::PsiLookupTexture].enabled)
+    {
+        mLightingPass.pVars->setTexture("gPsiLut", mLightingPass.pPsiLut);
+    }
+
+    if (mControls[ControlID::ProbePolarization].enabled)
+    {
+        mLightingPass.pVars->setTexture("gProbePolarizationCos", mLightingPass.probePolarization.pCos);
+        mLightingPass.pVars->setTexture("gProbePolarizationSin", mLightingPass.probePolarization.pSin);
+        mLightingPass.pVars->setTexture("gProbeCoherence", mLightingPass.pProbeCoherence);
+    }
+
+    if (mControls[ControlID::ClusteredLighting].enabled)
+    {
+        mLightingPass.pLightClusters->update(mpSceneRenderer->getScene().get(), mpSceneRenderer->getScene()->getActiveCamera().get());
+        mLightingPass.pLightClusters->setIntoProgramVars(mLightingPass.pVars.get());
+        pCB["gRenderTargetDim"] = glm::vec2(pTargetFbo->getWidth(), pTargetFbo->getHeight());
+    }
+
+    if (mControls[ControlID::PsiLookupTexture].enabled || mControls[ControlID::ProbePolarization].enabled)
+    {
+        mLightingPass.pVars->setSampler("gPsiLutSampler", mLightingPass.pPsiLutSampler);
+    }
+
     if (mAAMode == AAMode::TAA)
     {
         pContext->clearFbo(mTAA.getActiveFbo().get(), vec4(0.0, 0.0, 0.0, 0.0), 1, 0, FboAttachmentType::Color);
         pCB["gRenderTargetDim"] = glm::vec2(pTargetFbo->getWidth(), pTargetFbo->getHeight());
     }
 
+    // The shading-rate image was built from the previous frame
+    Texture::SharedPtr pShadingRate = mVariableRate.active ? mVariableRate.pGenerator->getShadingRateImage() : nullptr;
+    if (pShadingRate) pContext->setShadingRate(RenderContext::ShadingRate::Rate1x1, pShadingRate);
+
     if(mControls[EnableTransparency].enabled)
     {
         renderOpaqueObjects(pContext);
@@ -341,6 +721,8 @@ void PolarizingFilterRenderer::lightingPass(RenderContext* pContext, Fbo* pTarge
         mpSceneRenderer->setRenderMode(PolarizingFilterRendererSceneRenderer::Mode::All);
         mpSceneRenderer->renderScene(pContext);
     }
+
+    if (pShadingRate) pContext->setShadingRate(RenderContext::ShadingRate::Rate1x1);
     pContext->flush();
     mpState->setDepthStencilState(nullptr);
 }
@@ -376,6 +758,11 @@ void PolarizingFilterRenderer::resolveMSAA(RenderContext* pContext)
         PROFILE("resolveMSAA");
         pContext->resolveResource(mpMainFbo->getColorTexture(0), mpResolveFbo->getColorTexture(0));
         pContext->resolveResource(mpMainFbo->getColorTexture(1), mpResolveFbo->getColorTexture(1));
+        if (mStokes.enabled)
+        {
+            pContext->resolveResource(mpMainFbo->getColorTexture(mStokes.firstTarget), mStokes.pQ);
+            pContext->resolveResource(mpMainFbo->getColorTexture(mStokes.firstTarget + 1), mStokes.pU);
+        }
     }
 }
 
@@ -406,7 +793,7 @@ void PolarizingFilterRenderer::runTAA(RenderContext* pContext, Fbo::SharedPtr pC
         PROFILE("runTAA");
         //  Get the Current Color and Motion Vectors
         const Texture::SharedPtr pCurColor = pColorFbo->getColorTexture(0);
-        const Texture::SharedPtr pMotionVec = mpMainFbo->getColorTexture(2);
+        const Texture::SharedPtr pMotionVec = mpResolveFbo->getColorTexture(2);
 
         //  Get the Previous Color
         const Texture::SharedPtr pPrevColor = mTAA.getInactiveFbo()->getColorTexture(0);
@@ -451,11 +838,14 @@ void PolarizingFilterRenderer::executeFXAA(RenderContext* pContext, Fbo::SharedP
     }
 }
 
-void PolarizingFilterRenderer::onFrameRender(SampleCallbacks* pSample, RenderContext* pRenderContext, const Fbo::SharedPtr& pTargetFbo)
+void PolarizingFilterRenderer::renderFrame(SampleCallbacks* pSample, RenderContext* pRenderContext, const Fbo::SharedPtr& pTargetFbo)
 {
-    if (mpSceneRenderer)
+    // With Stokes output, changing the filter angle doesn't require rendering the scene again
+    mRenderScene = !(mStokes.enabled && mStokes.freezeScene && mStokes.sceneValid);
+
+    beginFrame(pRenderContext, pTargetFbo.get(), pSample->getFrameID());
+    if (mRenderScene)
     {
-        beginFrame(pRenderContext, pTargetFbo.get(), pSample->getFrameID());
         {
             PROFILE("updateScene");
             mpSceneRenderer->update(pSample->getCurrentTime());
@@ -464,18 +854,153 @@ void PolarizingFilterRenderer::onFrameRender(SampleCallbacks* pSample, RenderCon
         depthPass(pRenderContext);
         resolveDepthMSAA(pRenderContext); // Only runs in MSAA mode
         shadowPass(pRenderContext);
+        checkerboardMaskPass(pRenderContext);
+        shadingCachePass(pRenderContext);
         mpState->setFbo(mpMainFbo);
         renderSkyBox(pRenderContext);
         lightingPass(pRenderContext, pTargetFbo.get());
+        if (mShadingCache.active) mShadingCache.pCache->endFrame(pRenderContext, mpMainFbo->getColorTexture(0), mpMainFbo->getColorTexture(1));
         resolveMSAA(pRenderContext);      // This will only run if we are in MSAA mode
+        checkerboardReconstructPass(pRenderContext);
+        mStokes.sceneValid = mStokes.enabled;
+    }
+
+    applyPolarizingFilter(pRenderContext, mPolarizingFilterAngle); // Only runs with Stokes output
+    if (mRenderScene) updateShadingRateImage(pRenderContext);
+    renderPostProcessChain(pRenderContext, pTargetFbo, true);
 
-        Fbo::SharedPtr pPostProcessDst = mControls[EnableSSAO].enabled ? mpPostProcessFbo : pTargetFbo;
-        postProcess(pRenderContext, pPostProcessDst);
-        runTAA(pRenderContext, pPostProcessDst); // This will only run if we are in TAA mode
-        ambientOcclusion(pRenderContext, pTargetFbo);
-        executeFXAA(pRenderContext, pTargetFbo);
+    endFrame(pRenderContext);
+}
+
+bool PolarizingFilterRenderer::beginBatchView(SampleCallbacks* pSample, const PolarizingFilterRendererBatchCapture::View& view)
+{
+    if (view.scene != mBatchState.scene)
+    {
+        mBatchState.scene = view.scene;
+        loadScene(pSample, view.scene, false);
+    }
+
+    if (mpSceneRenderer == nullptr)
+    {
+        mpBatchCapture->skipView("the scene failed to load");
+        return false;
+    }
+
+    pSample->setCurrentTime(0);
+    if (view.keyFrame != PolarizingFilterRendererBatchCapture::kNoKeyFrame)
+    {
+        const Scene* pScene = mpSceneRenderer->getScene().get();
+        if (pScene->getPathCount() == 0 || view.keyFrame >= pScene->getPath(0)->getKeyFrameCount())
+        {
+            mpBatchCapture->skipView("the camera path doesn't have the key-frame");
+            return false;
+        }
+
+        mUseCameraPath = true;
+        applyCameraPathState();
+        pSample->setCurrentTime(pScene->getPath(0)->getKeyFrame(view.keyFrame).time);
+    }
+    return true;
+}
+
+void PolarizingFilterRenderer::runBatchCapture(SampleCallbacks* pSample, RenderContext* pRenderContext, const Fbo::SharedPtr& pTargetFbo)
+{
+    const PolarizingFilterRendererBatchCapture::View* pView = mpBatchCapture->getCurrentView();
+    if (pView == nullptr)
+    {
+        mpBatchCapture->finish();
+        mpBatchCapture = nullptr;
+        pSample->shutdown();
+        return;
+    }
 
-        endFrame(pRenderContext);
+    if (mBatchState.shot == 0 && mBatchState.frame == 0 && mBatchState.reducedShading == false && beginBatchView(pSample, *pView) == false) return;
+
+    const auto& shots = mpBatchCapture->getShots();
+    mEnablePolarizingFilter = shots[mBatchState.shot].filtered;
+    mPolarizingFilterAngle = shots[mBatchState.shot].angle;
+
+    // A shading comparison captures every shot at full rate first, then with the compared mode
+    const std::string& comparison = mpBatchCapture->getShadingComparison();
+    if (comparison.size())
+    {
+        ShadingMode comparedMode = (comparison == "Checkerboard") ? ShadingMode::Checkerboard : ShadingMode::VariableRate;
+        ShadingMode mode = mBatchState.reducedShading ? comparedMode : ShadingMode::Full;
+        if (mode != mShadingMode) setShadingMode(pSample, mode);
+    }
+
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    renderFrame(pSample, pRenderContext, pTargetFbo);
+    float renderTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    if (mBatchState.frame++ < mpBatchCapture->getWarmupFrames()) return;
+
+    if (comparison.size() && mBatchState.reducedShading == false)
+    {
+        mpBatchCapture->captureReference(pRenderContext, pTargetFbo->getColorTexture(0), mBatchState.shot, mBatchState.frame, renderTime, getShadingStats(pRenderContext));
+        mBatchState.reducedShading = true;
+        mBatchState.frame = 0;
+        return;
+    }
+
+    float cacheReuse = mShadingCache.active ? mShadingCache.pCache->getReuseRatio() : -1.0f;
+    mpBatchCapture->capture(pRenderContext, pTargetFbo->getColorTexture(0), mBatchState.shot, mBatchState.frame, renderTime, cacheReuse, getShadingStats(pRenderContext));
+    mBatchState.reducedShading = false;
+    mBatchState.frame = 0;
+    mBatchState.shot++;
+
+    // TAA accumulates over frames, so then every shot is rendered from scratch. Otherwise the remaining angles are applied to this frame.
+    if (mStokes.enabled && mAAMode != AAMode::TAA)
+    {
+        for (; mBatchState.shot < shots.size(); mBatchState.shot++)
+        {
+            mEnablePolarizingFilter = shots[mBatchState.shot].filtered;
+            start = CpuTimer::getCurrentTimePoint();
+            renderFilterAngle(pRenderContext, shots[mBatchState.shot].angle, pTargetFbo);
+            renderTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            mpBatchCapture->capture(pRenderContext, pTargetFbo->getColorTexture(0), mBatchState.shot, 1, renderTime);
+        }
+    }
+
+    if (mBatchState.shot == shots.size())
+    {
+        mBatchState.shot = 0;
+        mpBatchCapture->nextView();
+    }
+}
+
+PolarizingFilterRendererBatchCapture::ShadingStats PolarizingFilterRenderer::getShadingStats(RenderContext* pContext) const
+{
+    PolarizingFilterRendererBatchCapture::ShadingStats stats;
+#if _PROFILING_ENABLED
+    // The profiler reports the previous frame, which was rendered with the same settings after the warm-up frames
+    double gpuTime = Profiler::getEventGpuTime("lightingPass");
+    if (mCheckerboard.active) gpuTime += Profiler::getEventGpuTime("checkerboard");
+    if (mVariableRate.active) gpuTime += Profiler::getEventGpuTime("shadingRate");
+    stats.gpuTime = (float)gpuTime;
+#endif
+
+    if (mCheckerboard.active)
+    {
+        stats.shadedFraction = 0.5f;
+    }
+    else if (mVariableRate.active && mVariableRate.pGenerator->getShadingRateImage())
+    {
+        const Texture* pImage = mVariableRate.pGenerator->getShadingRateImage().get();
+        std::vector<uint8> rates = pContext->readTextureSubresource(pImage, 0);
+        stats.shadedFraction = ShadingRateGenerator::calcShadingCost(rates.data(), mVariableRate.pGenerator->getTileSize(), mpMainFbo->getWidth(), mpMainFbo->getHeight());
+    }
+    return stats;
+}
+
+void PolarizingFilterRenderer::onFrameRender(SampleCallbacks* pSample, RenderContext* pRenderContext, const Fbo::SharedPtr& pTargetFbo)
+{
+    if (mpBatchCapture)
+    {
+        runBatchCapture(pSample, pRenderContext, pTargetFbo);
+    }
+    else if (mpSceneRenderer)
+    {
+        renderFrame(pSample, pRenderContext, pTargetFbo);
     }
     else
     {
@@ -531,7 +1056,7 @@ bool PolarizingFilterRenderer::onKeyEvent(SampleCallbacks* pSample, const Keyboa
 
 void PolarizingFilterRenderer::onDroppedFile(SampleCallbacks* pSample, const std::string& filename)
 {
-    if (hasSuffix(filename, ".fscene", false) == false)
+    if (hasSuffix(filename, ".fscene", false) == false && hasSuffix(filename, ".fscenebin", false) == false)
     {
         msgBox("You can only drop a scene file into the window");
         return;
@@ -594,5 +1119,5 @@ int main(int argc, char** argv)
     config.argv = argv;
     Sample::run(config, pRenderer);
 #endif
-    return 0;
+    return PolarizingFilterRendererBatchCapture::getExitCode();
 }
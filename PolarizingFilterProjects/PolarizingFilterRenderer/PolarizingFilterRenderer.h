@@ -30,6 +30,7 @@
 #pragma once
 #include "Falcor.h"
 #include "PolarizingFilterRendererSceneRenderer.h"
+#include "PolarizingFilterRendererBatchCapture.h"
 
 using namespace Falcor;
 
@@ -44,6 +45,14 @@ public:
     void onGuiRender(SampleCallbacks* pSample, Gui* pGui) override;
     void onDroppedFile(SampleCallbacks* pSample, const std::string& filename) override;
 
+    /** Apply the polarizing filter at a different angle to the last rendered frame and run the post-processing passes, without rendering the scene again.
+        Requires Stokes output to be enabled and a frame to have been rendered with it.
+        \param[in] pContext Render context
+        \param[in] angle Filter angle in degrees
+        \param[in] pTargetFbo The FBO to write the final image to
+    */
+    void renderFilterAngle(RenderContext* pContext, float angle, const Fbo::SharedPtr& pTargetFbo);
+
 private:
     Fbo::SharedPtr mpMainFbo;
     Fbo::SharedPtr mpDepthPassFbo;
@@ -75,6 +84,11 @@ private:
         DepthStencilState::SharedPtr pDsState;
         RasterizerState::SharedPtr pNoCullRS;
         BlendState::SharedPtr pAlphaBlendBS;
+        Texture::SharedPtr pPsiLut;         // Sampled when _PSI_LUT is defined
+        Sampler::SharedPtr pPsiLutSampler;
+        ProbePolarization::EnvironmentTextures probePolarization;  // Sampled when _PROBE_POLARIZATION is defined
+        Texture::SharedPtr pProbeCoherence;
+        LightClusters::UniquePtr pLightClusters;  // Used when _CLUSTERED_LIGHTING is defined
     } mLightingPass;
 
     struct
@@ -124,12 +138,75 @@ private:
 
     FXAA::SharedPtr mpFXAA;
 
+    // Stokes output. The lighting pass writes the unfiltered color and two polarized terms, and the filter angle is applied by a full-screen pass
+    struct
+    {
+        bool enabled = false;
+        bool freezeScene = false;       // Don't render the scene, only re-apply the filter to the last frame
+        bool sceneValid = false;        // The targets hold a frame rendered with Stokes output
+        uint32_t firstTarget = 2;       // Index of the Q target in the main FBO, U follows it
+        Texture::SharedPtr pQ;          // Resolved polarized terms
+        Texture::SharedPtr pU;
+        Fbo::SharedPtr pFbo;            // Filtered color
+        FullScreenPass::UniquePtr pReconstructPass;
+        GraphicsVars::SharedPtr pVars;
+    } mStokes;
+
+    // Reuse of the previous frame's shading. The lighting pass only shades the pixels the cache rejects.
+    struct
+    {
+        bool enabled = false;
+        bool active = false;            // _SHADING_CACHE is defined. Needs the depth pass and a single-sampled target without Stokes output.
+        ShadingCache::UniquePtr pCache;
+        Texture::SharedPtr pMotion;     // Motion vectors of the depth pass, so that moving and skinned models are reprojected as well
+        float filterAngle = 0;          // Settings the cached frame was shaded with, changing them invalidates the cache
+        bool filterEnabled = false;
+        std::vector<LightData> lights;
+    } mShadingCache;
+
+    enum class ShadingMode : uint32_t
+    {
+        Full,
+        Checkerboard,   // Shades half of the 2x2 quads each frame and reconstructs the others from the previous frame
+        VariableRate    // Coarse shading of flat and moving tiles with a shading-rate image. Needs variable-rate shading tier 2.
+    };
+    ShadingMode mShadingMode = ShadingMode::Full;
+    void setShadingMode(SampleCallbacks* pSample, ShadingMode mode);
+
+    struct
+    {
+        bool active = false;            // Needs the depth pass, and a single-sampled target without Stokes output, with TAA or without AA
+        uint32_t phase = 0;             // Selects the quads shaded this frame
+        bool historyValid = false;
+        uint32_t curFbo = 0;
+        Fbo::SharedPtr pReconstructFbo[2];  // Reconstructed color, normal and motion. Alternates, so that the other one holds the history.
+        Fbo::SharedPtr pResolveFbo[2];      // The same targets with the depth attached, used as mpResolveFbo
+        FullScreenPass::UniquePtr pMaskPass;
+        GraphicsVars::SharedPtr pMaskVars;
+        DepthStencilState::SharedPtr pMaskDsState;
+        DepthStencilState::SharedPtr pLightingDsState;  // Depth test of the lighting pass, only passes where the mask didn't set the stencil
+        FullScreenPass::UniquePtr pReconstructPass;
+        GraphicsVars::SharedPtr pReconstructVars;
+    } mCheckerboard;
+
+    struct
+    {
+        bool active = false;
+        ShadingRateGenerator::UniquePtr pGenerator;     // Built from the previous frame
+    } mVariableRate;
+
     void beginFrame(RenderContext* pContext, Fbo* pTargetFbo, uint64_t frameId);
     void endFrame(RenderContext* pContext);
     void depthPass(RenderContext* pContext);
     void shadowPass(RenderContext* pContext);
     void renderSkyBox(RenderContext* pContext);
     void lightingPass(RenderContext* pContext, Fbo* pTargetFbo);
+    void shadingCachePass(RenderContext* pContext);
+    bool canUseShadingCache() const;
+    void checkerboardMaskPass(RenderContext* pContext);
+    void checkerboardReconstructPass(RenderContext* pContext);
+    void updateShadingRateImage(RenderContext* pContext);
+    void initCheckerboard(uint32_t width, uint32_t height);
     //Need to resolve depth first to pass resolved depth to shadow pass
     void resolveDepthMSAA(RenderContext* pContext);
     void resolveMSAA(RenderContext* pContext);
@@ -137,6 +214,25 @@ private:
     void runTAA(RenderContext* pContext, Fbo::SharedPtr pColorFbo);
     void postProcess(RenderContext* pContext, Fbo::SharedPtr pTargetFbo);
     void ambientOcclusion(RenderContext* pContext, Fbo::SharedPtr pTargetFbo);
+    void initStokes();
+    void applyPolarizingFilter(RenderContext* pContext, float angle);
+    void renderPostProcessChain(RenderContext* pContext, const Fbo::SharedPtr& pTargetFbo, bool runTemporalAA);
+    Texture::SharedPtr getLitColorTexture() const;
+    void renderFrame(SampleCallbacks* pSample, RenderContext* pContext, const Fbo::SharedPtr& pTargetFbo);
+    bool mRenderScene = true;
+
+    // Batch capture, replaces interactive rendering when requested on the command line
+    PolarizingFilterRendererBatchCapture::UniquePtr mpBatchCapture;
+    struct
+    {
+        std::string scene;      // The loaded scene
+        uint32_t shot = 0;      // Shot to capture from the current view
+        uint32_t frame = 0;     // Frames rendered for the current shot
+        bool reducedShading = false;    // With a shading comparison, the full-rate reference of the shot was captured
+    } mBatchState;
+    void runBatchCapture(SampleCallbacks* pSample, RenderContext* pContext, const Fbo::SharedPtr& pTargetFbo);
+    bool beginBatchView(SampleCallbacks* pSample, const PolarizingFilterRendererBatchCapture::View& view);
+    PolarizingFilterRendererBatchCapture::ShadingStats getShadingStats(RenderContext* pContext) const;
 
 
     void renderOpaqueObjects(RenderContext* pContext);
@@ -149,6 +245,7 @@ private:
     void initShadowPass(uint32_t windowWidth, uint32_t windowHeight);
     void initSSAO();
     void updateLightProbe(const LightProbe::SharedPtr& pLight);
+    void updateProbePolarization();
     void initAA(SampleCallbacks* pSample);
 
     void initControls();
@@ -161,6 +258,11 @@ private:
     void applyCustomSceneVars(const Scene* pScene, const std::string& filename);
     void resetScene();
 
+    // Reload the scene when its file is saved
+    void watchSceneFile(SampleCallbacks* pSample, const std::string& filename);
+    std::string mWatchedSceneFile;
+    FileWatcher::SubscriptionId mSceneFileSubscription = FileWatcher::kInvalidSubscriptionId;
+
     void setActiveCameraAspectRatio(uint32_t w, uint32_t h);
     void setSceneSampler(uint32_t maxAniso);
 
@@ -183,13 +285,19 @@ private:
         EnableHashedAlpha,
         EnableTransparency,
         VisualizeCascades,
+        PsiLookupTexture,
+        ProbePolarization,
+        ClusteredLighting,
         Count
     };
 
     enum class SamplePattern : uint32_t
     {
         Halton,
-        DX11
+        DX11,
+        Sobol,
+        R2,
+        PMJ02
     };
 
     enum class AAMode
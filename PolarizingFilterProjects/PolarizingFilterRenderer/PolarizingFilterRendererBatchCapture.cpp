@@ -0,0 +1,386 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "PolarizingFilterRendererBatchCapture.h"
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    const char kReportFilename[] = "CaptureTimings.csv";
+    const char kShadingReportFilename[] = "ShadingRateReport.csv";
+    const size_t kMaxQueuedImages = 4;  // Bounds the memory used by images waiting to be encoded
+
+    std::vector<ArgList::Arg> getArgValues(const ArgList& args, const ArgList& scriptArgs, const std::string& key)
+    {
+        return args.argExists(key) ? args.getValues(key) : scriptArgs.getValues(key);
+    }
+
+    bool parseScript(const std::string& filename, ArgList& scriptArgs)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            logError("Can't find capture script " + filename);
+            return false;
+        }
+
+        std::ifstream file(fullpath);
+        std::string commandLine;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            commandLine += " " + line.substr(0, line.find('#'));
+        }
+        scriptArgs.parseCommandLine(commandLine);
+        return true;
+    }
+}
+
+int PolarizingFilterRendererBatchCapture::sExitCode = 0;
+
+PolarizingFilterRendererBatchCapture::UniquePtr PolarizingFilterRendererBatchCapture::create(const ArgList& args, const std::string& defaultScene)
+{
+    // Arguments on the command line take precedence over the script
+    ArgList scriptArgs;
+    if (args.argExists("captureScript") && parseScript(args["captureScript"].asString(), scriptArgs) == false)
+    {
+        sExitCode = 1;
+        return nullptr;
+    }
+
+    std::vector<ArgList::Arg> angles = getArgValues(args, scriptArgs, "captureAngles");
+    if (angles.empty())
+    {
+        if (args.argExists("captureAngles") || args.argExists("captureScript"))
+        {
+            logError("Batch capture requires at least one filter angle");
+            sExitCode = 1;
+        }
+        return nullptr;
+    }
+
+    UniquePtr pBatch = UniquePtr(new PolarizingFilterRendererBatchCapture);
+    for (const auto& a : angles)
+    {
+        Shot shot;
+        std::string value = a.asString();
+        if (value == "off")
+        {
+            shot.filtered = false;
+            shot.name = "Unfiltered";
+        }
+        else
+        {
+            shot.angle = a.asFloat();
+            shot.name = "Filter" + value;
+        }
+        pBatch->mShots.push_back(shot);
+    }
+
+    std::vector<std::string> scenes;
+    for (const auto& s : getArgValues(args, scriptArgs, "captureScenes")) scenes.push_back(s.asString());
+    if (scenes.empty()) scenes.push_back(defaultScene);
+
+    std::vector<uint32_t> keyFrames;
+    for (const auto& k : getArgValues(args, scriptArgs, "captureKeyFrames")) keyFrames.push_back(k.asUint());
+    if (keyFrames.empty()) keyFrames.push_back(kNoKeyFrame);
+
+    // Render all views of a scene before moving on, so that each scene is only loaded once
+    for (const auto& scene : scenes)
+    {
+        for (uint32_t keyFrame : keyFrames)
+        {
+            pBatch->mViews.push_back({ scene, keyFrame });
+        }
+    }
+
+    std::vector<ArgList::Arg> warmup = getArgValues(args, scriptArgs, "captureWarmupFrames");
+    if (warmup.size()) pBatch->mWarmupFrames = warmup[0].asUint();
+
+    std::vector<ArgList::Arg> cache = getArgValues(args, scriptArgs, "captureShadingCache");
+    if (cache.size()) pBatch->mShadingCacheRefreshPeriod = cache[0].asUint();
+
+    std::vector<ArgList::Arg> shadingRate = getArgValues(args, scriptArgs, "captureShadingRate");
+    if (shadingRate.size())
+    {
+        std::string mode = shadingRate[0].asString();
+        if (mode == "checkerboard") pBatch->mShadingComparison = "Checkerboard";
+        else if (mode == "variable") pBatch->mShadingComparison = "VariableRate";
+        else
+        {
+            logError("Unknown shading-rate mode " + mode + ", expected checkerboard or variable");
+            sExitCode = 1;
+            return nullptr;
+        }
+    }
+
+    std::vector<ArgList::Arg> dir = getArgValues(args, scriptArgs, "captureDir");
+    pBatch->mOutputDir = dir.size() ? dir[0].asString() : getExecutableDirectory();
+    if (isDirectoryExists(pBatch->mOutputDir) == false && createDirectory(pBatch->mOutputDir) == false)
+    {
+        logError("Can't create the capture directory " + pBatch->mOutputDir);
+        sExitCode = 1;
+        return nullptr;
+    }
+
+    size_t imageCount = pBatch->mViews.size() * pBatch->mShots.size() * (pBatch->mShadingComparison.size() ? 2 : 1);
+    logInfo("Batch capture: " + std::to_string(imageCount) + " images to " + pBatch->mOutputDir);
+    pBatch->mStartTime = CpuTimer::getCurrentTimePoint();
+    pBatch->mEncoder = std::thread(&PolarizingFilterRendererBatchCapture::encodeImages, pBatch.get());
+    return pBatch;
+}
+
+PolarizingFilterRendererBatchCapture::~PolarizingFilterRendererBatchCapture()
+{
+    if (mEncoder.joinable()) finish();
+}
+
+void PolarizingFilterRendererBatchCapture::skipView(const std::string& reason)
+{
+    const View& view = mViews[mCurrentView];
+    logError("Batch capture: skipping " + view.scene + (view.keyFrame == kNoKeyFrame ? "" : " key-frame " + std::to_string(view.keyFrame)) + ", " + reason);
+    mFailedViews++;
+    nextView();
+}
+
+void PolarizingFilterRendererBatchCapture::capture(RenderContext* pContext, const Texture::SharedPtr& pTexture, uint32_t shotIndex, uint32_t frameCount, float renderTime, float cacheReuse, const ShadingStats& shading)
+{
+    const View& view = mViews[mCurrentView];
+    const Shot& shot = mShots[shotIndex];
+
+    Record record;
+    record.scene = view.scene;
+    record.keyFrame = view.keyFrame;
+    record.shot = shot.name;
+    record.frameCount = frameCount;
+    record.renderTime = renderTime;
+    record.cacheReuse = cacheReuse;
+    record.shading = shading;
+
+    std::string name = getFilenameFromPath(view.scene);
+    name = name.substr(0, name.find('.'));
+    if (view.keyFrame != kNoKeyFrame) name += "_KeyFrame" + std::to_string(view.keyFrame);
+    record.filename = mOutputDir + "/" + name + "_" + shot.name + (mShadingComparison.size() ? "_" + mShadingComparison : "") + ".png";
+    queueImage(pContext, pTexture, record, false);
+}
+
+void PolarizingFilterRendererBatchCapture::captureReference(RenderContext* pContext, const Texture::SharedPtr& pTexture, uint32_t shotIndex, uint32_t frameCount, float renderTime, const ShadingStats& shading)
+{
+    const View& view = mViews[mCurrentView];
+    const Shot& shot = mShots[shotIndex];
+
+    Record record;
+    record.scene = view.scene;
+    record.keyFrame = view.keyFrame;
+    record.shot = shot.name;
+    record.frameCount = frameCount;
+    record.renderTime = renderTime;
+    record.shading = shading;
+
+    std::string name = getFilenameFromPath(view.scene);
+    name = name.substr(0, name.find('.'));
+    if (view.keyFrame != kNoKeyFrame) name += "_KeyFrame" + std::to_string(view.keyFrame);
+    record.filename = mOutputDir + "/" + name + "_" + shot.name + ".png";
+    queueImage(pContext, pTexture, record, true);
+}
+
+void PolarizingFilterRendererBatchCapture::queueImage(RenderContext* pContext, const Texture::SharedPtr& pTexture, Record& record, bool isReference)
+{
+    // Reading back waits for the GPU to finish the frame
+    EncodeJob job;
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    job.data = pContext->readTextureSubresource(pTexture.get(), 0);
+    CpuTimer::TimePoint readbackEnd = CpuTimer::getCurrentTimePoint();
+    record.readbackTime = CpuTimer::calcDuration(start, readbackEnd);
+    job.width = pTexture->getWidth();
+    job.height = pTexture->getHeight();
+    job.format = pTexture->getFormat();
+
+    // The reference is kept until the image rendered with reduced shading is captured, and compared on the encoder thread
+    if (isReference == false && mpReferenceImage)
+    {
+        job.pReference = std::move(mpReferenceImage);
+        record.referenceRecord = mReferenceRecord;
+        mReferenceRecord = kNoReference;
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mQueueChanged.wait(lock, [this]() { return mQueue.size() < kMaxQueuedImages; });
+    record.stallTime = CpuTimer::calcDuration(readbackEnd, CpuTimer::getCurrentTimePoint());
+    job.recordIndex = mRecords.size();
+    if (isReference)
+    {
+        mpReferenceImage = std::make_shared<const std::vector<uint8>>(job.data);
+        mReferenceRecord = job.recordIndex;
+    }
+    mRecords.push_back(record);
+    mQueue.push_back(std::move(job));
+    lock.unlock();
+    mQueueChanged.notify_all();
+}
+
+void PolarizingFilterRendererBatchCapture::encodeImages()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mQueueChanged.wait(lock, [this]() { return mQueue.size() || mFinished; });
+        if (mQueue.empty()) return;
+
+        EncodeJob job = std::move(mQueue.front());
+        mQueue.pop_front();
+        std::string filename = mRecords[job.recordIndex].filename;
+        lock.unlock();
+        mQueueChanged.notify_all();
+
+        // Compare before saving, saveImage() swizzles RGBA8 data in place while the reference copy keeps the readback layout
+        ImageMetrics::Result metrics;
+        bool compared = job.pReference && job.pReference->size() == job.data.size() && getFormatBytesPerBlock(job.format) == 4;
+        if (compared)
+        {
+            metrics = ImageMetrics::compare(job.pReference->data(), job.data.data(), job.width, job.height);
+        }
+
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        Bitmap::saveImage(filename, job.width, job.height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, job.format, true, job.data.data());
+        float encodeTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        bool written = doesFileExist(filename);
+
+        lock.lock();
+        mRecords[job.recordIndex].encodeTime = encodeTime;
+        mRecords[job.recordIndex].written = written;
+        mRecords[job.recordIndex].compared = compared;
+        mRecords[job.recordIndex].metrics = metrics;
+    }
+}
+
+bool PolarizingFilterRendererBatchCapture::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFinished = true;
+    }
+    mQueueChanged.notify_all();
+    if (mEncoder.joinable()) mEncoder.join();
+
+    writeReport();
+    if (mShadingComparison.size()) writeShadingReport();
+
+    uint32_t failedImages = mFailedViews * (uint32_t)mShots.size() * (mShadingComparison.size() ? 2 : 1);
+    float renderTime = 0;
+    float readbackTime = 0;
+    float encodeTime = 0;
+    for (const auto& r : mRecords)
+    {
+        if (r.written == false)
+        {
+            logError("Batch capture: failed to write " + r.filename);
+            failedImages++;
+        }
+        renderTime += r.renderTime;
+        readbackTime += r.readbackTime;
+        encodeTime += r.encodeTime;
+    }
+
+    float count = (float)std::max<size_t>(mRecords.size(), 1);
+    std::stringstream ss;
+    ss << "Batch capture: " << mRecords.size() << " images in " << CpuTimer::calcDuration(mStartTime, CpuTimer::getCurrentTimePoint()) * 1.0e-3f << " s, " << failedImages << " failed. ";
+    ss << "Average render " << renderTime / count << " ms, readback " << readbackTime / count << " ms, encode " << encodeTime / count << " ms";
+    logInfo(ss.str());
+
+    if (mShadingComparison.size())
+    {
+        double ssimSum = 0;
+        double minSsim = 1;
+        uint32_t comparedCount = 0;
+        for (const auto& r : mRecords)
+        {
+            if (r.compared == false) continue;
+            ssimSum += r.metrics.ssim;
+            minSsim = std::min(minSsim, r.metrics.ssim);
+            comparedCount++;
+        }
+        std::stringstream shading;
+        shading << "Batch capture: " << mShadingComparison << " compared against full rate in " << comparedCount << " images. ";
+        shading << "Average SSIM " << ssimSum / std::max(comparedCount, 1u) << ", lowest " << minSsim;
+        logInfo(shading.str());
+    }
+
+    if (failedImages) sExitCode = 1;
+    return failedImages == 0;
+}
+
+void PolarizingFilterRendererBatchCapture::writeReport() const
+{
+    std::string filename = mOutputDir + "/" + kReportFilename;
+    std::ofstream report(filename);
+    if (report.fail())
+    {
+        logError("Batch capture: can't write " + filename);
+        return;
+    }
+
+    report << "scene,keyFrame,shot,file,frames,renderMs,readbackMs,stallMs,encodeMs,cacheReuse,written\n";
+    for (const auto& r : mRecords)
+    {
+        report << r.scene << "," << (r.keyFrame == kNoKeyFrame ? "" : std::to_string(r.keyFrame)) << "," << r.shot << "," << getFilenameFromPath(r.filename) << ",";
+        report << r.frameCount << "," << r.renderTime << "," << r.readbackTime << "," << r.stallTime << "," << r.encodeTime << ",";
+        report << (r.cacheReuse < 0 ? "" : std::to_string(r.cacheReuse)) << "," << (r.written ? 1 : 0) << "\n";
+    }
+}
+
+void PolarizingFilterRendererBatchCapture::writeShadingReport() const
+{
+    std::string filename = mOutputDir + "/" + kShadingReportFilename;
+    std::ofstream report(filename);
+    if (report.fail())
+    {
+        logError("Batch capture: can't write " + filename);
+        return;
+    }
+
+    report << "scene,keyFrame,shot,mode,referenceFile,file,shadedFraction,referenceShadingMs,shadingMs,psnr,ssim,maxError,errorFraction\n";
+    for (const auto& r : mRecords)
+    {
+        if (r.referenceRecord == kNoReference) continue;
+        const Record& ref = mRecords[r.referenceRecord];
+        report << r.scene << "," << (r.keyFrame == kNoKeyFrame ? "" : std::to_string(r.keyFrame)) << "," << r.shot << "," << mShadingComparison << ",";
+        report << getFilenameFromPath(ref.filename) << "," << getFilenameFromPath(r.filename) << "," << r.shading.shadedFraction << ",";
+        report << (ref.shading.gpuTime < 0 ? "" : std::to_string(ref.shading.gpuTime)) << "," << (r.shading.gpuTime < 0 ? "" : std::to_string(r.shading.gpuTime)) << ",";
+        if (r.compared)
+        {
+            report << r.metrics.psnr << "," << r.metrics.ssim << "," << r.metrics.maxError << "," << r.metrics.errorFraction << "\n";
+        }
+        else
+        {
+            report << ",,,\n";
+        }
+    }
+}
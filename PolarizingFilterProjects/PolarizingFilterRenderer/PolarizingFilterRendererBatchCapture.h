@@ -0,0 +1,195 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace Falcor;
+
+/** Renders a list of scenes, camera path key-frames and filter angles without user interaction, and writes the images and a timing report to disk.
+    The images are read back on the render thread and encoded on a separate thread, so that PNG compression overlaps with rendering the next image.
+
+    Command line arguments:
+        -captureAngles <angles>         Filter angles in degrees. "off" captures an image with the filter disabled. Required to enable batch capture
+        -captureScenes <files>          Scenes to capture. Defaults to the default scene
+        -captureKeyFrames <indices>     Camera path key-frames to capture each scene from. Defaults to the camera at time 0
+        -captureWarmupFrames <count>    Frames rendered before each capture, to let the shadow maps and TAA converge. Defaults to 8
+        -captureDir <directory>         Output directory. Defaults to the executable directory
+        -captureShadingCache <period>   Enable the shading cache with a refresh period in frames. The cache needs a single angle, several angles use Stokes output. The report records the fraction of reused pixels
+        -captureShadingRate <mode>      Compare reduced-rate shading against full-rate shading. <mode> is "checkerboard" or "variable". Every shot is captured at full rate and with the mode,
+                                        and ShadingRateReport.csv records the PSNR, SSIM and largest error of each pair along with the GPU time of the shading passes
+        -captureScript <file>           Read additional arguments from a file with the same syntax. '#' starts a comment
+*/
+class PolarizingFilterRendererBatchCapture
+{
+public:
+    using UniquePtr = std::unique_ptr<PolarizingFilterRendererBatchCapture>;
+
+    static constexpr uint32_t kNoKeyFrame = uint32_t(-1);
+
+    /** A scene and camera position to capture all shots from
+    */
+    struct View
+    {
+        std::string scene;
+        uint32_t keyFrame = kNoKeyFrame;
+    };
+
+    /** Shading statistics of a captured image, for the shading-rate comparison
+    */
+    struct ShadingStats
+    {
+        float gpuTime = -1;         // Milliseconds spent in the shading passes, negative if unknown
+        float shadedFraction = 1;   // Pixel-shader invocations relative to shading every pixel
+    };
+
+    /** A filter setting to capture
+    */
+    struct Shot
+    {
+        bool filtered = true;
+        float angle = 0;        // Degrees
+        std::string name;       // Used in the filename
+    };
+
+    /** Create a batch from the command line arguments.
+        \param[in] args The command line arguments
+        \param[in] defaultScene The scene to capture if no scenes were specified
+        \return A new object, or nullptr if batch capture wasn't requested or the arguments are invalid
+    */
+    static UniquePtr create(const ArgList& args, const std::string& defaultScene);
+    ~PolarizingFilterRendererBatchCapture();
+
+    /** Get the view to render, or nullptr if all views were captured
+    */
+    const View* getCurrentView() const { return mCurrentView < mViews.size() ? &mViews[mCurrentView] : nullptr; }
+
+    /** Move on to the next view
+    */
+    void nextView() { mCurrentView++; }
+
+    /** Skip the current view and record it as failed
+        \param[in] reason Message to log
+    */
+    void skipView(const std::string& reason);
+
+    const std::vector<Shot>& getShots() const { return mShots; }
+    uint32_t getWarmupFrames() const { return mWarmupFrames; }
+    uint32_t getShadingCacheRefreshPeriod() const { return mShadingCacheRefreshPeriod; }  // 0 if the cache wasn't requested
+    const std::string& getShadingComparison() const { return mShadingComparison; }       // "Checkerboard", "VariableRate", or empty if no comparison was requested
+
+    /** Read back a texture and queue it for encoding. Blocks if the encoder is too far behind.
+        \param[in] pContext Render context
+        \param[in] pTexture The texture to capture
+        \param[in] shotIndex Index of the captured shot
+        \param[in] frameCount Number of frames rendered for this image
+        \param[in] renderTime CPU time in milliseconds spent recording the final frame
+        \param[in] cacheReuse Fraction of the pixels that reused the shading cache, or a negative value if the cache isn't used
+        \param[in] shading Shading statistics. With a shading comparison, the image is compared against the last captureReference().
+    */
+    void capture(RenderContext* pContext, const Texture::SharedPtr& pTexture, uint32_t shotIndex, uint32_t frameCount, float renderTime, float cacheReuse = -1.0f, const ShadingStats& shading = ShadingStats());
+
+    /** Capture the full-rate reference of a shading comparison. The next capture() is compared against it.
+        The parameters are the same as capture().
+    */
+    void captureReference(RenderContext* pContext, const Texture::SharedPtr& pTexture, uint32_t shotIndex, uint32_t frameCount, float renderTime, const ShadingStats& shading);
+
+    /** Wait for the encoder to finish and write the timing report.
+        \return true if all images were written
+    */
+    bool finish();
+
+    /** Get the process exit code. Non-zero if a batch failed.
+    */
+    static int getExitCode() { return sExitCode; }
+
+private:
+    PolarizingFilterRendererBatchCapture() = default;
+    void encodeImages();
+    void writeReport() const;
+    void writeShadingReport() const;
+
+    static constexpr size_t kNoReference = size_t(-1);
+
+    struct Record
+    {
+        std::string scene;
+        uint32_t keyFrame = kNoKeyFrame;
+        std::string shot;
+        std::string filename;
+        uint32_t frameCount = 0;
+        float renderTime = 0;   // Milliseconds
+        float cacheReuse = -1;  // Negative without the shading cache
+        float readbackTime = 0;
+        float stallTime = 0;    // Time spent waiting for the encoder queue
+        float encodeTime = 0;
+        bool written = false;
+        ShadingStats shading;
+        size_t referenceRecord = kNoReference;  // The full-rate capture this image is compared against
+        bool compared = false;
+        ImageMetrics::Result metrics;
+    };
+
+    struct EncodeJob
+    {
+        size_t recordIndex;
+        uint32_t width;
+        uint32_t height;
+        ResourceFormat format;
+        std::vector<uint8> data;
+        std::shared_ptr<const std::vector<uint8>> pReference;  // Compared against data when set
+    };
+
+    void queueImage(RenderContext* pContext, const Texture::SharedPtr& pTexture, Record& record, bool isReference);
+
+    std::vector<View> mViews;
+    std::vector<Shot> mShots;
+    size_t mCurrentView = 0;
+    uint32_t mWarmupFrames = 8;
+    uint32_t mShadingCacheRefreshPeriod = 0;
+    std::string mShadingComparison;
+    std::shared_ptr<const std::vector<uint8>> mpReferenceImage;   // The last captureReference(), until capture() takes it
+    size_t mReferenceRecord = kNoReference;
+    std::string mOutputDir;
+    uint32_t mFailedViews = 0;
+    CpuTimer::TimePoint mStartTime;
+
+    std::vector<Record> mRecords;
+    std::deque<EncodeJob> mQueue;
+    std::mutex mMutex;
+    std::condition_variable mQueueChanged;
+    std::thread mEncoder;
+    bool mFinished = false;
+
+    static int sExitCode;
+};
@@ -55,6 +55,9 @@ void PolarizingFilterRenderer::initControls()
     mControls[ControlID::EnableTransparency] = { false, false, "_ENABLE_TRANSPARENCY" };
     mControls[ControlID::EnableSSAO] = { true, false, "" };
     mControls[ControlID::VisualizeCascades] = { false, false, "_VISUALIZE_CASCADES" };
+    mControls[ControlID::PsiLookupTexture] = { false, false, "_PSI_LUT" };
+    mControls[ControlID::ProbePolarization] = { false, false, "_PROBE_POLARIZATION" };
+    mControls[ControlID::ClusteredLighting] = { false, false, "_CLUSTERED_LIGHTING" };
 
     for (uint32_t i = 0; i < ControlID::Count; i++)
     {
@@ -65,6 +68,7 @@ void PolarizingFilterRenderer::initControls()
 void PolarizingFilterRenderer::applyLightingProgramControl(ControlID controlId)
 {
     const ProgramControl control = mControls[controlId];
+    mShadingCache.pCache->invalidate();
     if (control.define.size())
     {
         bool add = control.unsetOnEnabled ? !control.enabled : control.enabled;
@@ -92,6 +96,15 @@ void PolarizingFilterRenderer::createTaaPatternGenerator(uint32_t fboWidth, uint
     case SamplePattern::DX11:
         pGenerator = DxSamplePattern::create();
         break;
+    case SamplePattern::Sobol:
+        pGenerator = LowDiscrepancySamplePattern::create(LowDiscrepancySequence::Type::OwenScrambledSobol);
+        break;
+    case SamplePattern::R2:
+        pGenerator = LowDiscrepancySamplePattern::create(LowDiscrepancySequence::Type::R2);
+        break;
+    case SamplePattern::PMJ02:
+        pGenerator = LowDiscrepancySamplePattern::create(LowDiscrepancySequence::Type::PMJ02);
+        break;
     default:
         should_not_get_here();
         pGenerator = nullptr;
@@ -109,12 +122,16 @@ void PolarizingFilterRenderer::applyAaMode(SampleCallbacks* pSample)
     uint32_t w = pSample->getCurrentFbo()->getWidth();
     uint32_t h = pSample->getCurrentFbo()->getHeight();
 
+    // The checkerboard marks the quads the lighting pass skips in the stencil. FXAA uses the resolve FBO as a scratch target, which would overwrite the reconstruction history.
+    bool checkerboard = (mShadingMode == ShadingMode::Checkerboard) && (mAAMode == AAMode::None || mAAMode == AAMode::TAA) && mStokes.enabled == false;
+
     // Common FBO desc (2 color outputs - color and normal)
     Fbo::Desc fboDesc;
-    fboDesc.setColorTarget(0, ResourceFormat::RGBA32Float).setColorTarget(1, ResourceFormat::RGBA8Unorm).setDepthStencilTarget(ResourceFormat::D32Float);
+    fboDesc.setColorTarget(0, ResourceFormat::RGBA32Float).setColorTarget(1, ResourceFormat::RGBA8Unorm).setDepthStencilTarget(checkerboard ? ResourceFormat::D24UnormS8 : ResourceFormat::D32Float);
 
     // Release the TAA FBOs
     mTAA.resetFbos();
+    mShadingCache.pCache->invalidate();
 
     if (mAAMode == AAMode::TAA)
     {
@@ -139,6 +156,10 @@ void PolarizingFilterRenderer::applyAaMode(SampleCallbacks* pSample)
             Fbo::Desc resolveDesc;
             resolveDesc.setColorTarget(0, ResourceFormat::RGBA32Float);
             resolveDesc.setColorTarget(1, ResourceFormat::RGBA8Unorm).setColorTarget(2, ResourceFormat::R32Float);
+            if (mStokes.enabled)
+            {
+                resolveDesc.setColorTarget(3, ResourceFormat::RGBA16Float).setColorTarget(4, ResourceFormat::RGBA16Float);
+            }
             mpResolveFbo = FboHelper::create2D(w, h, resolveDesc);
         }
         else if (mAAMode == AAMode::FXAA)
@@ -149,6 +170,24 @@ void PolarizingFilterRenderer::applyAaMode(SampleCallbacks* pSample)
         }
     }
 
+    // Stokes output (unfiltered color in target 0, polarized terms after the other targets)
+    mStokes.sceneValid = false;
+    mStokes.firstTarget = (mAAMode == AAMode::TAA) ? 3 : 2;
+    if (mStokes.enabled)
+    {
+        mLightingPass.pProgram->addDefine("_OUTPUT_STOKES");
+        fboDesc.setColorTarget(mStokes.firstTarget, ResourceFormat::RGBA16Float).setColorTarget(mStokes.firstTarget + 1, ResourceFormat::RGBA16Float);
+
+        Fbo::Desc filteredDesc;
+        filteredDesc.setColorTarget(0, ResourceFormat::RGBA32Float);
+        mStokes.pFbo = FboHelper::create2D(w, h, filteredDesc);
+    }
+    else
+    {
+        mLightingPass.pProgram->removeDefine("_OUTPUT_STOKES");
+        mStokes.pFbo = nullptr;
+    }
+
     mpMainFbo = FboHelper::create2D(w, h, fboDesc);
     mpDepthPassFbo = Fbo::create();
     mpDepthPassFbo->attachDepthStencilTarget(mpMainFbo->getDepthStencilTexture());
@@ -157,6 +196,36 @@ void PolarizingFilterRenderer::applyAaMode(SampleCallbacks* pSample)
     {
         mpResolveFbo = mpMainFbo;
     }
+
+    if (checkerboard)
+    {
+        initCheckerboard(w, h);
+    }
+    else
+    {
+        mCheckerboard.pReconstructFbo[0] = mCheckerboard.pReconstructFbo[1] = nullptr;
+        mCheckerboard.pResolveFbo[0] = mCheckerboard.pResolveFbo[1] = nullptr;
+    }
+
+    if (mStokes.enabled)
+    {
+        uint32_t resolvedTarget = (mAAMode == AAMode::MSAA) ? 3 : mStokes.firstTarget;
+        mStokes.pQ = mpResolveFbo->getColorTexture(resolvedTarget);
+        mStokes.pU = mpResolveFbo->getColorTexture(resolvedTarget + 1);
+    }
+    else
+    {
+        mStokes.pQ = nullptr;
+        mStokes.pU = nullptr;
+    }
+}
+
+void PolarizingFilterRenderer::setShadingMode(SampleCallbacks* pSample, ShadingMode mode)
+{
+    mShadingMode = mode;
+    mVariableRate.active = false;
+    // The checkerboard changes the depth format and needs the reconstruction targets
+    applyAaMode(pSample);
 }
 
 void PolarizingFilterRenderer::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
@@ -247,6 +316,20 @@ void PolarizingFilterRenderer::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
                 pGui->addFloatSlider("Filter angle", mPolarizingFilterAngle, 0.f, 180.f, false, "%.1f");
             }
 
+            if (pGui->addCheckBox("Psi Lookup Texture", mControls[ControlID::PsiLookupTexture].enabled)) {
+                applyLightingProgramControl(ControlID::PsiLookupTexture);
+            }
+            pGui->addTooltip("Sample psi from a texture baked at load time instead of evaluating it in the shader");
+
+            if (pGui->addCheckBox("Stokes Output", mStokes.enabled)) {
+                applyAaMode(pSample);
+            }
+            pGui->addTooltip("Render the unfiltered color and the polarized terms to separate targets, and apply the filter angle in a full-screen pass");
+            if (mStokes.enabled) {
+                pGui->addCheckBox("Freeze Scene", mStokes.freezeScene);
+                pGui->addTooltip("Keep the last rendered frame and only re-apply the filter. Camera and scene changes are ignored while this is set");
+            }
+
             pGui->endGroup();
         }
 
@@ -267,6 +350,40 @@ void PolarizingFilterRenderer::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
                 setSceneSampler(maxAniso);
             }
 
+            if (pGui->addCheckBox("Clustered Lighting", mControls[ControlID::ClusteredLighting].enabled))
+            {
+                applyLightingProgramControl(ControlID::ClusteredLighting);
+            }
+            pGui->addTooltip("Shade each pixel with the lights of its view-space cluster instead of looping over every light. Lifts the limit of 16 lights");
+            if (mControls[ControlID::ClusteredLighting].enabled)
+            {
+                mLightingPass.pLightClusters->renderUI(pGui, "Light Clusters");
+            }
+
+            Gui::DropdownList shadingModeList = { { (uint32_t)ShadingMode::Full, "Full" }, { (uint32_t)ShadingMode::Checkerboard, "Checkerboard" } };
+            if (gpDevice->isFeatureSupported(Device::SupportedFeatures::VariableRateShadingTier2))
+            {
+                shadingModeList.push_back({ (uint32_t)ShadingMode::VariableRate, "Variable Rate" });
+            }
+            uint32_t shadingMode = (uint32_t)mShadingMode;
+            if (pGui->addDropdown("Shading Rate", shadingModeList, shadingMode))
+            {
+                setShadingMode(pSample, (ShadingMode)shadingMode);
+            }
+            pGui->addTooltip("Checkerboard shades every other 2x2 quad and reconstructs the others from the previous frame. It needs the depth pass, and doesn't run with MSAA, FXAA or Stokes output.\n"
+                "Variable Rate shades flat and fast-moving screen tiles at a coarser rate");
+            if (mShadingMode == ShadingMode::VariableRate)
+            {
+                mVariableRate.pGenerator->renderUI(pGui, "Variable Rate");
+            }
+
+            pGui->addCheckBox("Shading Cache", mShadingCache.enabled);
+            pGui->addTooltip("Reuse the lit color of the previous frame where the reprojected depth and normal match, and only shade the other pixels and a rotating subset. Needs the depth pass, and doesn't run with MSAA, Stokes output or checkerboard shading");
+            if (mShadingCache.enabled)
+            {
+                mShadingCache.pCache->renderUI(pGui, "Shading Cache");
+            }
+
             pGui->endGroup();
         }
 
@@ -298,7 +415,13 @@ void PolarizingFilterRenderer::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
                     Gui::DropdownList samplePatternList;
                     samplePatternList.push_back({ (uint32_t)SamplePattern::Halton, "Halton" });
                     samplePatternList.push_back({ (uint32_t)SamplePattern::DX11, "DX11" });
-                    pGui->addDropdown("Sample Pattern", samplePatternList, (uint32_t&)mTAASamplePattern);
+                    samplePatternList.push_back({ (uint32_t)SamplePattern::Sobol, "Sobol" });
+                    samplePatternList.push_back({ (uint32_t)SamplePattern::R2, "R2" });
+                    samplePatternList.push_back({ (uint32_t)SamplePattern::PMJ02, "PMJ02" });
+                    if (pGui->addDropdown("Sample Pattern", samplePatternList, (uint32_t&)mTAASamplePattern))
+                    {
+                        createTaaPatternGenerator(pSample->getCurrentFbo()->getWidth(), pSample->getCurrentFbo()->getHeight());
+                    }
 
                     // Disable super-sampling
                     pGui->endGroup();
@@ -335,6 +458,12 @@ void PolarizingFilterRenderer::onGuiRender(SampleCallbacks* pSample, Gui* pGui)
                 }
                 if (mControls[ControlID::EnableReflections].enabled)
                 {
+                    if (pGui->addCheckBox("Polarization Terms", mControls[ControlID::ProbePolarization].enabled))
+                    {
+                        applyLightingProgramControl(ControlID::ProbePolarization);
+                        updateProbePolarization();
+                    }
+                    pGui->addTooltip("Account for the spread of the GGX lobe and the environment around the reflection, with terms baked on the CPU when enabled");
                     pGui->addSeparator();
                     pScene->getLightProbe(0)->renderUI(pGui);
                 }
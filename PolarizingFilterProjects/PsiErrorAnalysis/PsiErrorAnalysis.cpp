@@ -0,0 +1,398 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Falcor.h"
+#include "Utils/ThreadPool.h"
+#include "../MaterialDemoRenderer/MaterialDemoRendererPresets.h"
+#include <cstdio>
+#include <fstream>
+
+using namespace Falcor;
+using namespace Falcor::Polarization;
+
+static const char* kUsage = R"(usage: PsiErrorAnalysis [-grid <nMin> <nMax> <kMin> <kMax> <resolution>] [-angles <count>] [-filterAngles <count>]
+                        [-threads <count>] [-outDir <dir>] [-heatMapScale <value>] [-maxError <value>]
+  -grid          The (n, k) grid of the heat maps. Defaults to 0.1 3.0 0.0 8.0 256.
+  -angles        Number of incidence angles in [0, 90] degrees. Defaults to 91.
+  -filterAngles  Number of filter angles in [0, 90] degrees. Defaults to 19.
+  -threads       Number of worker threads. Defaults to all hardware threads.
+  -outDir        Directory of the tables and heat maps. Defaults to the working directory.
+  -heatMapScale  The error mapped to the top of the heat map color scale. Defaults to the largest error of each map.
+  -maxError      Exit with a non-zero status if the psi error of a metal preset exceeds this value.
+)";
+
+/** The material presets of MaterialDemoRenderer
+*/
+struct MaterialPreset
+{
+    const char* name;
+    glm::vec3 n;
+    glm::vec3 k;
+    bool isDielectric;
+};
+
+#define X(name, nr, ng, nb, kr, kg, kb, d, ...) { #name, { nr, ng, nb }, { kr, kg, kb }, d },
+static const MaterialPreset kMaterialPresets[] = { MATERIAL_TABLE };
+#undef X
+
+static const char* kChannelNames[] = { "R", "G", "B" };
+
+/** Max, mean and RMS of an error
+*/
+struct ErrorStats
+{
+    float maxError = 0;
+    double sum = 0;
+    double sumSquared = 0;
+    uint64_t count = 0;
+
+    void add(float error)
+    {
+        error = std::abs(error);
+        maxError = std::max(maxError, error);
+        sum += error;
+        sumSquared += double(error) * error;
+        count++;
+    }
+
+    void merge(const ErrorStats& other)
+    {
+        maxError = std::max(maxError, other.maxError);
+        sum += other.sum;
+        sumSquared += other.sumSquared;
+        count += other.count;
+    }
+
+    float mean() const { return count ? float(sum / count) : 0.0f; }
+    float rms() const { return count ? float(std::sqrt(sumSquared / count)) : 0.0f; }
+};
+
+/** The sampled incidence angles
+*/
+struct AngleSamples
+{
+    std::vector<float> degrees;
+    std::vector<float> cosTheta;
+    std::vector<float> sin2Theta;
+
+    AngleSamples(uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float deg = count > 1 ? 90.0f * i / (count - 1) : 45.0f;
+            float ct = std::cos(glm::radians(deg));
+            degrees.push_back(deg);
+            cosTheta.push_back(ct);
+            sin2Theta.push_back(std::max(0.0f, 1.0f - ct * ct));
+        }
+    }
+};
+
+/** Fresnel term of the specular BRDF used by the renderers
+*/
+static glm::vec3 fresnelSchlick(glm::vec3 R0, float ct)
+{
+    return R0 + (glm::vec3(1.0f) - R0) * std::pow(1.0f - ct, 5.0f);
+}
+
+/** Convert a linear sRGB color to CIELAB, relative to a D65 white with luminance 1
+*/
+static glm::vec3 linearRgbToLab(glm::vec3 rgb)
+{
+    glm::vec3 xyz;
+    xyz.x = 0.4124f * rgb.r + 0.3576f * rgb.g + 0.1805f * rgb.b;
+    xyz.y = 0.2126f * rgb.r + 0.7152f * rgb.g + 0.0722f * rgb.b;
+    xyz.z = 0.0193f * rgb.r + 0.1192f * rgb.g + 0.9505f * rgb.b;
+    xyz /= glm::vec3(0.9505f, 1.0f, 1.089f);
+
+    auto f = [](float t) { return t > 216.0f / 24389.0f ? std::cbrt(t) : (24389.0f / 27.0f * t + 16.0f) / 116.0f; };
+    glm::vec3 fxyz(f(xyz.x), f(xyz.y), f(xyz.z));
+    return glm::vec3(116.0f * fxyz.y - 16.0f, 500.0f * (fxyz.x - fxyz.y), 200.0f * (fxyz.y - fxyz.z));
+}
+
+/** Evaluate psi of one channel over all the incidence angles
+    \param[in] model The psi function
+    \param[in] n Simple refractive index
+    \param[in] k Extinction coefficient
+    \param[in] R0 Specular reflectance at normal incidence
+    \param[in] angles The incidence angles
+    \param[out] psi The results, one per angle
+*/
+static void evaluateOverAngles(PsiModel model, float n, float k, float R0, const AngleSamples& angles, std::vector<float>& psi)
+{
+    uint32_t count = (uint32_t)angles.cosTheta.size();
+    std::vector<float> nArray(count, n), kArray(count, k), R0Array(count, R0);
+
+    PsiInputs inputs;
+    inputs.pN = nArray.data();
+    inputs.pK = kArray.data();
+    inputs.pR0 = R0Array.data();
+    inputs.pCosTheta = angles.cosTheta.data();
+    inputs.pSin2Theta = angles.sin2Theta.data();
+
+    psi.resize(count);
+    evaluatePsi(model, inputs, psi.data(), count);
+}
+
+/** Results of one material preset
+*/
+struct PresetResult
+{
+    PsiModel approxModel;
+    glm::vec3 R0;
+    ErrorStats psi[3];          ///< Error of psi, per channel
+    ErrorStats filtered[3];     ///< Error of the filtered specular reflectance, per channel
+    ErrorStats deltaE;          ///< CIE76 difference of the filtered specular color
+    float worstAngle = 0;       ///< Incidence angle of the largest deltaE
+    float worstFilterAngle = 0; ///< Filter angle of the largest deltaE
+    std::vector<float> deltaEMap; ///< deltaE per filter angle (rows) and incidence angle (columns)
+};
+
+/** Compare the approximation the renderers use for a preset against psi_Exact(), over all incidence and filter angles.
+    Dielectric presets are compared with psi_DielectricExact(), which is what the renderers use for them.
+*/
+static PresetResult analyzePreset(const MaterialPreset& preset, const AngleSamples& angles, uint32_t filterAngleCount)
+{
+    PresetResult result;
+    result.approxModel = preset.isDielectric ? PsiModel::DielectricExact : PsiModel::MetalApprox;
+    result.R0 = SpecularFromIOR(preset.n, preset.k);
+
+    uint32_t angleCount = (uint32_t)angles.cosTheta.size();
+    std::vector<float> exact[3], approx[3];
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        evaluateOverAngles(PsiModel::Exact, preset.n[c], preset.k[c], result.R0[c], angles, exact[c]);
+        evaluateOverAngles(result.approxModel, preset.n[c], preset.k[c], result.R0[c], angles, approx[c]);
+        for (uint32_t i = 0; i < angleCount; i++) result.psi[c].add(approx[c][i] - exact[c][i]);
+    }
+
+    result.deltaEMap.resize(filterAngleCount * angleCount);
+    for (uint32_t f = 0; f < filterAngleCount; f++)
+    {
+        float filterDeg = filterAngleCount > 1 ? 90.0f * f / (filterAngleCount - 1) : 0.0f;
+        float c2 = std::cos(2.0f * glm::radians(filterDeg));
+        for (uint32_t i = 0; i < angleCount; i++)
+        {
+            glm::vec3 F = fresnelSchlick(result.R0, angles.cosTheta[i]);
+            glm::vec3 exactColor, approxColor;
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                exactColor[c] = F[c] * (1.0f + c2 * exact[c][i]);
+                approxColor[c] = F[c] * (1.0f + c2 * approx[c][i]);
+                result.filtered[c].add(approxColor[c] - exactColor[c]);
+            }
+
+            float dE = glm::length(linearRgbToLab(approxColor) - linearRgbToLab(exactColor));
+            if (dE > result.deltaE.maxError)
+            {
+                result.worstAngle = angles.degrees[i];
+                result.worstFilterAngle = filterDeg;
+            }
+            result.deltaE.add(dE);
+            result.deltaEMap[f * angleCount + i] = dE;
+        }
+    }
+    return result;
+}
+
+/** Map a value in [0, 1] to a perceptually ordered color
+*/
+static glm::u8vec4 heatMapColor(float t)
+{
+    static const glm::vec3 kStops[] = { { 0, 0, 4 }, { 87, 16, 110 }, { 188, 55, 84 }, { 249, 142, 9 }, { 252, 255, 164 } };
+    const uint32_t kSegments = arraysize(kStops) - 1;
+    float x = glm::clamp(t, 0.0f, 1.0f) * kSegments;
+    uint32_t i = std::min((uint32_t)x, kSegments - 1);
+    glm::vec3 c = glm::mix(kStops[i], kStops[i + 1], x - i);
+    return glm::u8vec4(glm::u8vec3(c + 0.5f), 255);
+}
+
+/** Save a heat map of row-major values, with the first row at the bottom of the image
+    \return The value mapped to the top of the color scale
+*/
+static float saveHeatMap(const std::string& filename, uint32_t width, uint32_t height, const std::vector<float>& values, float scale)
+{
+    if (scale <= 0)
+    {
+        scale = *std::max_element(values.begin(), values.end());
+        if (scale <= 0) scale = 1;
+    }
+
+    std::vector<glm::u8vec4> pixels(values.size());
+    for (size_t i = 0; i < values.size(); i++) pixels[i] = heatMapColor(values[i] / scale);
+    Bitmap::saveImage(filename, width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA8Unorm, false, pixels.data());
+    return scale;
+}
+
+/** Sweeps psi_MetalApprox() against psi_Exact() over the MaterialDemoRenderer presets and a dense (n, k) grid, on all cores.
+    Writes error tables as CSV files and heat maps as PNG files, and prints a summary.
+*/
+int main(int argc, char** argv)
+{
+    Logger::initialize();
+    Logger::showBoxOnError(false);
+
+    ArgList args;
+    args.parseCommandLine(concatCommandLine(argc, argv));
+    if (args.argExists("h") || args.argExists("help"))
+    {
+        fprintf(stderr, "%s", kUsage);
+        return 0;
+    }
+
+    float nMin = 0.1f, nMax = 3.0f, kMin = 0.0f, kMax = 8.0f;
+    uint32_t resolution = 256;
+    if (args.argExists("grid"))
+    {
+        std::vector<ArgList::Arg> grid = args.getValues("grid");
+        if (grid.size() != 5)
+        {
+            fprintf(stderr, "-grid expects <nMin> <nMax> <kMin> <kMax> <resolution>\n%s", kUsage);
+            return 1;
+        }
+        nMin = grid[0].asFloat();
+        nMax = grid[1].asFloat();
+        kMin = grid[2].asFloat();
+        kMax = grid[3].asFloat();
+        resolution = std::max(grid[4].asUint(), 2u);
+    }
+
+    uint32_t angleCount = args.argExists("angles") ? std::max(args["angles"].asUint(), 2u) : 91;
+    uint32_t filterAngleCount = args.argExists("filterAngles") ? std::max(args["filterAngles"].asUint(), 2u) : 19;
+    uint32_t threadCount = args.argExists("threads") ? args["threads"].asUint() : 0;
+    float heatMapScale = args.argExists("heatMapScale") ? args["heatMapScale"].asFloat() : 0.0f;
+    float maxError = args.argExists("maxError") ? args["maxError"].asFloat() : -1.0f;
+
+    std::string outDir = args.argExists("outDir") ? args["outDir"].asString() : ".";
+    if (isDirectoryExists(outDir) == false && createDirectory(outDir) == false)
+    {
+        fprintf(stderr, "Can't create the output directory '%s'\n", outDir.c_str());
+        return 1;
+    }
+    outDir += "/";
+
+    AngleSamples angles(angleCount);
+    auto start = CpuTimer::getCurrentTimePoint();
+
+    // Material presets
+    const uint32_t presetCount = arraysize(kMaterialPresets);
+    std::vector<PresetResult> presets(presetCount);
+    parallelFor(presetCount, threadCount, [&](uint32_t p)
+    {
+        presets[p] = analyzePreset(kMaterialPresets[p], angles, filterAngleCount);
+    });
+
+    // (n, k) grid. Each cell covers all the incidence angles. The filter scales the error by |cos(2*phi)|, so the filtered error is reported at phi = 0.
+    const uint32_t cellCount = resolution * resolution;
+    std::vector<float> gridMax(cellCount), gridRms(cellCount), gridFiltered(cellCount), gridR0(cellCount);
+    parallelFor(resolution, threadCount, [&](uint32_t row)
+    {
+        float k = kMin + (kMax - kMin) * row / (resolution - 1);
+        std::vector<float> exact, approx;
+        for (uint32_t col = 0; col < resolution; col++)
+        {
+            float n = nMin + (nMax - nMin) * col / (resolution - 1);
+            float R0 = SpecularFromIOR(glm::vec3(n), glm::vec3(k)).x;
+            evaluateOverAngles(PsiModel::Exact, n, k, R0, angles, exact);
+            evaluateOverAngles(PsiModel::MetalApprox, n, k, R0, angles, approx);
+
+            ErrorStats psi, filtered;
+            for (uint32_t i = 0; i < angleCount; i++)
+            {
+                float error = approx[i] - exact[i];
+                psi.add(error);
+                filtered.add(fresnelSchlick(glm::vec3(R0), angles.cosTheta[i]).x * error);
+            }
+
+            uint32_t cell = row * resolution + col;
+            gridMax[cell] = psi.maxError;
+            gridRms[cell] = psi.rms();
+            gridFiltered[cell] = filtered.maxError;
+            gridR0[cell] = R0;
+        }
+    });
+
+    float seconds = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / 1000.0f;
+    uint32_t usedThreads = threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+
+    // Preset table
+    fprintf(stdout, "%u incidence angles, %u filter angles, %ux%u grid, %u threads, %s kernels, %.2f s\n\n", angleCount, filterAngleCount, resolution, resolution, usedThreads, getSimdName(), seconds);
+    fprintf(stdout, "%-10s %-17s %7s %7s %9s %9s %9s %9s %6s %6s\n", "Preset", "Approximation", "Max psi", "RMS psi", "Max filt", "RMS filt", "Max dE", "Mean dE", "theta", "phi");
+
+    std::ofstream presetCsv(outDir + "PsiErrorPresets.csv");
+    presetCsv << "Preset,Approximation,Channel,n,k,R0,MaxPsiError,RmsPsiError,MaxFilteredError,RmsFilteredError\n";
+
+    bool failed = false;
+    for (uint32_t p = 0; p < presetCount; p++)
+    {
+        const MaterialPreset& preset = kMaterialPresets[p];
+        const PresetResult& result = presets[p];
+
+        ErrorStats psi, filtered;
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            psi.merge(result.psi[c]);
+            filtered.merge(result.filtered[c]);
+            presetCsv << preset.name << "," << getPsiModelName(result.approxModel) << "," << kChannelNames[c] << "," << preset.n[c] << "," << preset.k[c] << "," << result.R0[c] << ","
+                << result.psi[c].maxError << "," << result.psi[c].rms() << "," << result.filtered[c].maxError << "," << result.filtered[c].rms() << "\n";
+        }
+
+        bool exceeded = maxError >= 0 && preset.isDielectric == false && psi.maxError > maxError;
+        failed = failed || exceeded;
+
+        fprintf(stdout, "%-10s %-17s %7.4f %7.4f %9.5f %9.5f %9.3f %9.3f %6.1f %6.1f%s\n", preset.name, getPsiModelName(result.approxModel), psi.maxError, psi.rms(), filtered.maxError, filtered.rms(),
+            result.deltaE.maxError, result.deltaE.mean(), result.worstAngle, result.worstFilterAngle, exceeded ? "  EXCEEDED" : "");
+
+        std::string mapName = outDir + "PsiErrorDeltaE_" + preset.name + ".png";
+        saveHeatMap(mapName, angleCount, filterAngleCount, result.deltaEMap, heatMapScale);
+    }
+
+    // Grid table and heat maps
+    std::ofstream gridCsv(outDir + "PsiErrorGrid.csv");
+    gridCsv << "n,k,R0,MaxPsiError,RmsPsiError,MaxFilteredError\n";
+    ErrorStats gridStats;
+    for (uint32_t cell = 0; cell < cellCount; cell++)
+    {
+        uint32_t row = cell / resolution, col = cell % resolution;
+        gridCsv << nMin + (nMax - nMin) * col / (resolution - 1) << "," << kMin + (kMax - kMin) * row / (resolution - 1) << "," << gridR0[cell] << ","
+            << gridMax[cell] << "," << gridRms[cell] << "," << gridFiltered[cell] << "\n";
+        gridStats.add(gridMax[cell]);
+    }
+
+    float maxScale = saveHeatMap(outDir + "PsiErrorGridMax.png", resolution, resolution, gridMax, heatMapScale);
+    float rmsScale = saveHeatMap(outDir + "PsiErrorGridRms.png", resolution, resolution, gridRms, heatMapScale);
+    float filteredScale = saveHeatMap(outDir + "PsiErrorGridFiltered.png", resolution, resolution, gridFiltered, heatMapScale);
+
+    fprintf(stdout, "\nGrid n [%g, %g] (x), k [%g, %g] (y): max psi error %.4f, mean of the per-cell max %.4f\n", nMin, nMax, kMin, kMax, gridStats.maxError, gridStats.mean());
+    fprintf(stdout, "Heat map scales: PsiErrorGridMax.png %.4f, PsiErrorGridRms.png %.4f, PsiErrorGridFiltered.png %.4f\n", maxScale, rmsScale, filteredScale);
+    fprintf(stdout, "Wrote the tables and heat maps to '%s'\n", outDir.c_str());
+
+    Logger::shutdown();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Falcor.h"
+#include "Utils/TextureBaker.h"
+#include <cstdio>
+
+using namespace Falcor;
+
+static const char* kUsage = R"(usage: BakeTextures -in <file> [<file> ...] [-out <dir>] [-filter box|kaiser] [-compress none|bc1|bc3|bc5|bc7] [-linear] [-nomips] [-threads <count>]
+  -in        Source images. Any format supported by Bitmap. Relative paths are searched for in the data directories.
+  -out       Output directory. Defaults to the directory of each source image.
+  -filter    Mip-chain filter. Defaults to box.
+  -compress  Block compression. Defaults to none. HDR images are always stored as RGBA16F.
+  -linear    Treat 8-bit color data as linear instead of sRGB.
+  -nomips    Only store the top level.
+  -threads   Number of worker threads. Defaults to all hardware threads.
+)";
+
+static bool parseDesc(const ArgList& args, TextureBaker::Desc& desc)
+{
+    if (args.argExists("filter"))
+    {
+        std::string filter = args["filter"].asString();
+        if (filter == "box") desc.filter = TextureBaker::MipFilter::Box;
+        else if (filter == "kaiser") desc.filter = TextureBaker::MipFilter::Kaiser;
+        else
+        {
+            fprintf(stderr, "Unknown filter '%s'\n", filter.c_str());
+            return false;
+        }
+    }
+
+    if (args.argExists("compress"))
+    {
+        static const std::pair<const char*, TextureBaker::Compression> kCompression[] =
+        {
+            { "none", TextureBaker::Compression::None },
+            { "bc1", TextureBaker::Compression::BC1 },
+            { "bc3", TextureBaker::Compression::BC3 },
+            { "bc5", TextureBaker::Compression::BC5 },
+            { "bc7", TextureBaker::Compression::BC7 },
+        };
+
+        std::string compression = args["compress"].asString();
+        bool found = false;
+        for (const auto& c : kCompression)
+        {
+            if (compression == c.first)
+            {
+                desc.compression = c.second;
+                found = true;
+            }
+        }
+        if (found == false)
+        {
+            fprintf(stderr, "Unknown compression '%s'\n", compression.c_str());
+            return false;
+        }
+    }
+
+    desc.isSrgb = args.argExists("linear") == false;
+    desc.generateMips = args.argExists("nomips") == false;
+    if (args.argExists("threads")) desc.threadCount = args["threads"].asUint();
+    return true;
+}
+
+static std::string getOutputFilename(const std::string& srcFile, const std::string& outDir)
+{
+    std::string filename = getFilenameFromPath(srcFile);
+    filename = filename.substr(0, filename.find_last_of('.')) + ".dds";
+    std::string dir = outDir.empty() ? getDirectoryFromFile(srcFile) : outDir;
+    return dir.empty() ? filename : dir + "/" + filename;
+}
+
+/** Headless texture preprocessing. Bakes mip-chains (and optionally BCn compression) into DDS files.
+    Doesn't create a window or a device, so it can run on build machines without a GPU.
+*/
+int main(int argc, char** argv)
+{
+    Logger::initialize();
+    Logger::showBoxOnError(false);
+
+    ArgList args;
+    args.parseCommandLine(concatCommandLine(argc, argv));
+
+    std::vector<ArgList::Arg> inputs = args.getValues("in");
+    if (inputs.empty() || args.argExists("h") || args.argExists("help"))
+    {
+        fprintf(stderr, "%s", kUsage);
+        return inputs.empty() ? 1 : 0;
+    }
+
+    TextureBaker::Desc desc;
+    if (parseDesc(args, desc) == false) return 1;
+
+    std::string outDir = args.argExists("out") ? args["out"].asString() : "";
+    if (outDir.empty() == false && isDirectoryExists(outDir) == false) createDirectory(outDir);
+
+    uint32_t failures = 0;
+    auto startTime = CpuTimer::getCurrentTimePoint();
+    for (const auto& input : inputs)
+    {
+        std::string srcFile = input.asString();
+        std::string fullPath;
+        if (findFileInDataDirectories(srcFile, fullPath) == false)
+        {
+            fprintf(stderr, "Can't find '%s'\n", srcFile.c_str());
+            failures++;
+            continue;
+        }
+
+        std::string dstFile = getOutputFilename(fullPath, outDir);
+        auto fileStart = CpuTimer::getCurrentTimePoint();
+        bool success = TextureBaker::bakeFile(fullPath, dstFile, desc);
+        float ms = CpuTimer::calcDuration(fileStart, CpuTimer::getCurrentTimePoint());
+
+        fprintf(stdout, "%s %s -> %s (%.1f ms)\n", success ? "Baked" : "FAILED", srcFile.c_str(), dstFile.c_str(), ms);
+        if (success == false) failures++;
+    }
+
+    float totalMs = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+    fprintf(stdout, "%zu textures, %u failed, %.1f ms\n", inputs.size(), failures, totalMs);
+
+    Logger::shutdown();
+    return failures ? 1 : 0;
+}
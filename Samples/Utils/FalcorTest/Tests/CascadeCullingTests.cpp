@@ -0,0 +1,186 @@
+/***************************************************************************
+# Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Effects/Shadows/CascadeCulling.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Crop a cascade to an NDC-space box of the global shadow space, the same way CascadedShadowMaps does
+        void setCascadeCrop(CsmData& csmData, uint32_t cascade, vec3 minNdc, vec3 maxNdc)
+        {
+            vec3 delta = maxNdc - minNdc;
+            vec3 scale = vec3(2.0f, 2.0f, 1.0f) / delta;
+            csmData.cascadeScale[cascade] = vec4(scale, 1.0f);
+            csmData.cascadeOffset[cascade] = vec4(-0.5f * (maxNdc.x + minNdc.x) * scale.x, -0.5f * (maxNdc.y + minNdc.y) * scale.y, -minNdc.z * scale.z, 0.0f);
+        }
+
+        // A directional light shadow space covering a sphere of radius 20 around the origin, split into three cascades
+        CsmData createCsmData()
+        {
+            CsmData csmData;
+            glm::mat4 view = glm::lookAt(vec3(0), normalize(vec3(0.3f, -1.0f, 0.2f)), vec3(0, 1, 0));
+            csmData.globalMat = glm::ortho(-20.0f, 20.0f, -20.0f, 20.0f, -20.0f, 20.0f) * view;
+            csmData.cascadeCount = 3;
+            setCascadeCrop(csmData, 0, vec3(-0.2f, -0.3f, 0.3f), vec3(0.1f, 0.0f, 0.6f));
+            setCascadeCrop(csmData, 1, vec3(-0.5f, -0.6f, 0.2f), vec3(0.3f, 0.2f, 0.8f));
+            setCascadeCrop(csmData, 2, vec3(-1.0f, -1.0f, 0.0f), vec3(1.0f, 1.0f, 1.0f));
+            return csmData;
+        }
+
+        BoundingBox createCascadeBox(const CsmData& csmData, uint32_t cascade, vec3 ndc, float extent)
+        {
+            vec4 posW = inverse(CascadeCulling::calcCascadeMatrix(csmData, cascade)) * vec4(ndc, 1.0f);
+            BoundingBox box;
+            box.center = vec3(posW) / posW.w;
+            box.extent = vec3(extent);
+            return box;
+        }
+    }
+
+    // Culling the projected global bounds must give the same lists as projecting each caster into each cascade
+    CPU_TEST(CascadeCullingMatchesReference)
+    {
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        std::vector<BoundingBox> casters(2000);
+        for (auto& box : casters)
+        {
+            box.center = vec3(unit(rng), unit(rng), unit(rng)) * 50.0f - 25.0f;
+            box.extent = vec3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+        }
+
+        CsmData csmData = createCsmData();
+        for (float minSize : { 0.0f, 0.02f })
+        {
+            CascadeCulling::CasterLists lists;
+            CascadeCulling::cullCasters(csmData, casters, minSize, lists);
+            EXPECT_EQ(lists.size(), (size_t)csmData.cascadeCount);
+
+            uint32_t drawCount = 0;
+            for (uint32_t c = 0; c < (uint32_t)csmData.cascadeCount; c++)
+            {
+                glm::mat4 cascadeMat = CascadeCulling::calcCascadeMatrix(csmData, c);
+                std::vector<uint32_t> expected;
+                for (uint32_t i = 0; i < (uint32_t)casters.size(); i++)
+                {
+                    if (CascadeCulling::isCasterVisible(cascadeMat, casters[i], minSize)) expected.push_back(i);
+                }
+                EXPECT(lists[c] == expected) << "cascade " << c;
+                drawCount += (uint32_t)lists[c].size();
+            }
+
+            // The inner cascades only cover part of the scene
+            EXPECT(drawCount < casters.size() * csmData.cascadeCount);
+            EXPECT(lists[0].size() < lists[2].size());
+        }
+    }
+
+    CPU_TEST(CascadeCullingRejection)
+    {
+        CsmData csmData = createCsmData();
+        glm::mat4 cascadeMat = CascadeCulling::calcCascadeMatrix(csmData, 0);
+
+        // Inside the cascade
+        EXPECT(CascadeCulling::isCasterVisible(cascadeMat, createCascadeBox(csmData, 0, vec3(0.0f, 0.0f, 0.5f), 0.1f), 0.0f));
+        // Between the light and the cascade. It still shadows the cascade.
+        EXPECT(CascadeCulling::isCasterVisible(cascadeMat, createCascadeBox(csmData, 0, vec3(0.0f, 0.0f, -3.0f), 0.1f), 0.0f));
+        // Behind the cascade
+        EXPECT(CascadeCulling::isCasterVisible(cascadeMat, createCascadeBox(csmData, 0, vec3(0.0f, 0.0f, 4.0f), 0.1f), 0.0f) == false);
+        // Beside the cascade
+        EXPECT(CascadeCulling::isCasterVisible(cascadeMat, createCascadeBox(csmData, 0, vec3(3.0f, 0.0f, 0.5f), 0.1f), 0.0f) == false);
+        EXPECT(CascadeCulling::isCasterVisible(cascadeMat, createCascadeBox(csmData, 0, vec3(0.0f, -3.0f, 0.5f), 0.1f), 0.0f) == false);
+
+        // Small casters are only rejected when a minimum size is set
+        BoundingBox small = createCascadeBox(csmData, 2, vec3(0.0f, 0.0f, 0.5f), 0.01f);
+        EXPECT(CascadeCulling::isCasterVisible(CascadeCulling::calcCascadeMatrix(csmData, 2), small, 0.0f));
+        EXPECT(CascadeCulling::isCasterVisible(CascadeCulling::calcCascadeMatrix(csmData, 2), small, 0.01f) == false);
+
+        // A caster around the eye of a perspective light can't be projected, so it's kept
+        CsmData spotData;
+        spotData.globalMat = glm::perspective(1.0f, 1.0f, 0.1f, 50.0f) * glm::lookAt(vec3(0, 10, 0), vec3(0), vec3(1, 0, 0));
+        spotData.cascadeCount = 1;
+        spotData.cascadeScale[0] = vec4(1);
+        spotData.cascadeOffset[0] = vec4(0);
+        BoundingBox aroundEye;
+        aroundEye.center = vec3(0, 10, 0);
+        aroundEye.extent = vec3(1);
+        CascadeCulling::CasterLists lists;
+        CascadeCulling::cullCasters(spotData, { aroundEye }, 0.0f, lists);
+        EXPECT(lists.size() == 1 && lists[0].size() == 1);
+    }
+
+    CPU_TEST(StaticCasterCacheInvalidation)
+    {
+        CsmData csmData = createCsmData();
+        std::vector<BoundingBox> casters = { createCascadeBox(csmData, 0, vec3(0.0f, 0.0f, 0.5f), 0.1f), createCascadeBox(csmData, 2, vec3(0.8f, 0.8f, 0.5f), 0.1f), createCascadeBox(csmData, 0, vec3(-0.5f, 0.0f, 0.5f), 0.1f) };
+        std::vector<bool> animated = { false, false, true };
+
+        StaticCasterCache cache;
+        auto update = [&]()
+        {
+            CascadeCulling::CasterLists lists;
+            CascadeCulling::cullCasters(csmData, casters, 0.0f, lists);
+            cache.update(csmData, lists, casters, animated);
+            std::vector<bool> redraw;
+            for (uint32_t c = 0; c < (uint32_t)csmData.cascadeCount; c++) redraw.push_back(cache.isRedrawNeeded(c));
+            return redraw;
+        };
+        const std::vector<bool> none = { false, false, false };
+        const std::vector<bool> all = { true, true, true };
+
+        // Everything is drawn on the first frame. The casters count as moved, since there's no previous frame.
+        EXPECT(update() == all);
+        EXPECT(cache.getStaticLists()[2].empty());
+        // Now the unanimated casters are static
+        EXPECT(update() == all);
+        EXPECT(update() == none);
+        EXPECT(cache.getStaticLists()[2] == std::vector<uint32_t>({ 0, 1 }));
+        EXPECT(cache.getDynamicLists()[2] == std::vector<uint32_t>({ 2 }));
+
+        // Caster 1 is only in the outer cascade. It's redrawn without it while it moves, and with it once it stops.
+        casters[1].center += vec3(0.5f, 0.0f, 0.0f);
+        EXPECT(update() == std::vector<bool>({ false, false, true }));
+        EXPECT(cache.getDynamicLists()[2] == std::vector<uint32_t>({ 1, 2 }));
+        casters[1].center += vec3(0.5f, 0.0f, 0.0f);
+        EXPECT(update() == none);
+        EXPECT(update() == std::vector<bool>({ false, false, true }));
+        EXPECT(update() == none);
+
+        // Moving the light changes all cascades
+        csmData.globalMat = glm::lookAt(vec3(0), normalize(vec3(0.1f, -1.0f, 0.3f)), vec3(0, 1, 0)) * csmData.globalMat;
+        EXPECT(update() == all);
+        EXPECT(update() == none);
+
+        cache.invalidate();
+        EXPECT(update() == all);
+    }
+}
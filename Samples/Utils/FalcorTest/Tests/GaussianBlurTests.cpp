@@ -0,0 +1,169 @@
+/***************************************************************************
+# Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Effects/Utils/GaussianBlur.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kWidth = 71, kHeight = 53;
+
+        std::vector<glm::vec4> createImage(uint32_t seed)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+            std::vector<glm::vec4> texels(kWidth * kHeight);
+            for (auto& t : texels)
+            {
+                t = glm::vec4(dist(rng), dist(rng), dist(rng), dist(rng));
+            }
+            return texels;
+        }
+
+        // Direct separable convolution, one tap per texel, clamped to the edges
+        std::vector<glm::vec4> convolve(const std::vector<glm::vec4>& src, const std::vector<float>& weights)
+        {
+            int32_t center = int32_t(weights.size() / 2);
+            std::vector<glm::vec4> tmp(src.size()), dst(src.size());
+            for (int32_t y = 0; y < int32_t(kHeight); y++)
+            {
+                for (int32_t x = 0; x < int32_t(kWidth); x++)
+                {
+                    glm::vec4 c(0);
+                    for (int32_t k = 0; k < int32_t(weights.size()); k++)
+                    {
+                        c += src[y * kWidth + glm::clamp(x + k - center, 0, int32_t(kWidth) - 1)] * weights[k];
+                    }
+                    tmp[y * kWidth + x] = c;
+                }
+            }
+            for (int32_t y = 0; y < int32_t(kHeight); y++)
+            {
+                for (int32_t x = 0; x < int32_t(kWidth); x++)
+                {
+                    glm::vec4 c(0);
+                    for (int32_t k = 0; k < int32_t(weights.size()); k++)
+                    {
+                        c += tmp[glm::clamp(y + k - center, 0, int32_t(kHeight) - 1) * kWidth + x] * weights[k];
+                    }
+                    dst[y * kWidth + x] = c;
+                }
+            }
+            return dst;
+        }
+
+        // Maximum difference, ignoring a border of the image
+        float maxDifference(const std::vector<glm::vec4>& a, const std::vector<glm::vec4>& b, uint32_t border = 0)
+        {
+            float diff = 0;
+            for (uint32_t y = border; y < kHeight - border; y++)
+            {
+                for (uint32_t x = border; x < kWidth - border; x++)
+                {
+                    for (int c = 0; c < 4; c++) diff = std::max(diff, std::abs(a[y * kWidth + x][c] - b[y * kWidth + x][c]));
+                }
+            }
+            return diff;
+        }
+    }
+
+    CPU_TEST(GaussianBlurLinearTaps)
+    {
+        for (uint32_t kernelWidth = 1; kernelWidth <= GaussianBlur::kMaxPixelShaderKernelWidth; kernelWidth += 2)
+        {
+            std::vector<float> weights = GaussianBlur::calcWeights(kernelWidth, 2.5f);
+            std::vector<float> offsets, tapWeights;
+            GaussianBlur::calcLinearTaps(weights, offsets, tapWeights);
+
+            // Pairs of texels on each side, and a tap of its own for the center
+            uint32_t center = kernelWidth / 2;
+            EXPECT_EQ(offsets.size(), size_t(1 + 2 * ((center + 1) / 2))) << "width " << kernelWidth;
+            EXPECT_EQ(offsets.size(), tapWeights.size());
+
+            float sum = 0;
+            for (size_t i = 0; i < offsets.size(); i++)
+            {
+                sum += tapWeights[i];
+                EXPECT_EQ(offsets[i], -offsets[offsets.size() - 1 - i]) << "width " << kernelWidth << ", tap " << i;
+                EXPECT_LE(std::abs(offsets[i]), float(center)) << "width " << kernelWidth << ", tap " << i;
+            }
+            EXPECT_LE(std::abs(sum - 1), 1e-5f) << "width " << kernelWidth;
+        }
+    }
+
+    CPU_TEST(GaussianBlurMatchesConvolution)
+    {
+        // The bilinear taps of the pixel shader path and the direct weights of the compute path give the same result as a convolution
+        std::vector<glm::vec4> src = createImage(17);
+        std::vector<glm::vec4> dst(src.size());
+        for (uint32_t kernelWidth : { 3u, 5u, 7u, 13u, 15u, 31u })
+        {
+            const float sigma = kernelWidth / 4.0f;
+            std::vector<glm::vec4> ref = convolve(src, GaussianBlur::calcWeights(kernelWidth, sigma));
+            GaussianBlur::execute(kernelWidth, sigma, src.data(), kWidth, kHeight, dst.data());
+            EXPECT_LE(maxDifference(dst, ref), 1e-5f) << "width " << kernelWidth;
+        }
+    }
+
+    CPU_TEST(GaussianBlurBoxCascade)
+    {
+        for (float sigma : { 3.0f, 8.0f, 20.0f })
+        {
+            // The variance of the boxes adds up to sigma^2
+            std::vector<uint32_t> boxWidths = GaussianBlur::calcBoxWidths(sigma);
+            EXPECT_EQ(boxWidths.size(), size_t(GaussianBlur::kBoxCascadeCount));
+            float variance = 0;
+            for (uint32_t w : boxWidths)
+            {
+                EXPECT_EQ(w & 1, 1u);
+                variance += (w * w - 1) / 12.0f;
+            }
+            EXPECT_LE(std::abs(std::sqrt(variance) - sigma), 0.1f * sigma) << "sigma " << sigma;
+        }
+
+        // Blurring with the cascade is close to the exact Gaussian.
+        // Each box clamps its input at the edges, so the cascade doesn't match a single convolution near them.
+        std::vector<glm::vec4> src(kWidth * kHeight);
+        for (uint32_t y = 0; y < kHeight; y++)
+        {
+            for (uint32_t x = 0; x < kWidth; x++)
+            {
+                src[y * kWidth + x] = glm::vec4((x % 16) < 8 ? 1.0f : 0.0f, (y % 20) < 10 ? 1.0f : 0.0f, 0.5f, 1.0f);
+            }
+        }
+        const float sigma = 4.0f;
+        const uint32_t kernelWidth = GaussianBlur::kMaxComputeKernelWidth + 2;
+        EXPECT(GaussianBlur::getPath(kernelWidth) == GaussianBlur::Path::BoxCascade);
+        std::vector<glm::vec4> dst(src.size());
+        GaussianBlur::execute(kernelWidth, sigma, src.data(), kWidth, kHeight, dst.data());
+        std::vector<glm::vec4> ref = convolve(src, GaussianBlur::calcWeights(8 * uint32_t(sigma) + 1, sigma));
+        EXPECT_LE(maxDifference(dst, ref, 3 * uint32_t(sigma)), 0.02f);
+    }
+}
@@ -0,0 +1,135 @@
+/***************************************************************************
+# Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Effects/LightClusters/LightClusters.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        LightClusters::View createView()
+        {
+            LightClusters::View view;
+            view.viewMat = glm::lookAt(vec3(3, 2, 8), vec3(0, 0, 0), vec3(0, 1, 0));
+            view.tanHalfFovY = std::tan(0.5f);
+            view.tanHalfFovX = view.tanHalfFovY * 16.0f / 9.0f;
+            view.nearZ = 0.1f;
+            view.farZ = 100.0f;
+            return view;
+        }
+
+        bool overlaps(const BoundingBox& box, const vec3& center, float radius)
+        {
+            vec3 d = glm::max(glm::max(box.getMinPos() - center, center - box.getMaxPos()), vec3(0.0f));
+            return glm::dot(d, d) <= radius * radius;
+        }
+    }
+
+    // The SIMD binning must produce the same light lists as testing every light against every cluster
+    CPU_TEST(LightClustersMatchBruteForce)
+    {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        std::vector<LightData> lights(500);
+        for (auto& light : lights)
+        {
+            light.type = LightPoint;
+            light.posW = vec3(unit(rng) * 60.0f - 30.0f, unit(rng) * 20.0f - 10.0f, unit(rng) * 60.0f - 40.0f);
+            light.intensity = vec3(unit(rng), unit(rng), unit(rng)) * 0.5f;
+        }
+        lights[17].type = LightDirectional;
+        lights[301].type = LightDirectional;
+        lights[42].intensity = vec3(0.0f);
+
+        const float cutoff = 0.02f;
+        LightClusters::View view = createView();
+        LightClusters::Bins bins, singleThreadBins;
+        LightClusters::binLights(view, lights, cutoff, bins);
+        LightClusters::binLights(view, lights, cutoff, singleThreadBins, 1);
+        EXPECT_EQ(bins.ranges.size(), (size_t)LightClusters::kClusterCount);
+        EXPECT(bins.ranges == singleThreadBins.ranges);
+        EXPECT(bins.indices == singleThreadBins.indices);
+
+        uint32_t nonEmpty = 0;
+        for (uint32_t z = 0; z < LIGHT_CLUSTER_COUNT_Z; z++)
+        {
+            for (uint32_t y = 0; y < LIGHT_CLUSTER_COUNT_Y; y++)
+            {
+                for (uint32_t x = 0; x < LIGHT_CLUSTER_COUNT_X; x++)
+                {
+                    BoundingBox box = LightClusters::calcClusterBounds(view, x, y, z);
+                    std::vector<uint32_t> expected;
+                    for (uint32_t i = 0; i < lights.size(); i++)
+                    {
+                        float radius = LightClusters::calcLightRadius(lights[i], cutoff);
+                        if (lights[i].type == LightDirectional || (radius > 0.0f && overlaps(box, vec3(view.viewMat * vec4(lights[i].posW, 1.0f)), radius)))
+                        {
+                            expected.push_back(i);
+                        }
+                    }
+
+                    glm::uvec2 range = bins.ranges[getLightClusterIndex(x, y, z)];
+                    std::vector<uint32_t> binned(bins.indices.begin() + range.x, bins.indices.begin() + range.x + range.y);
+                    std::sort(binned.begin(), binned.end());
+                    EXPECT(binned == expected) << "cluster " << x << " " << y << " " << z;
+                    if (expected.size() > 2) nonEmpty++;
+                }
+            }
+        }
+        EXPECT_LE(100u, nonEmpty);
+    }
+
+    // The shader finds the cluster of a point from its screen position and view depth. That cluster's bounds must contain the point.
+    CPU_TEST(LightClustersLookupMatchesBounds)
+    {
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        LightClusters::View view = createView();
+        LightClusterData data = LightClusters::calcClusterData(view);
+
+        for (uint32_t i = 0; i < 10000; i++)
+        {
+            float depth = view.nearZ * std::pow(view.farZ / view.nearZ, unit(rng));
+            vec2 ndc(unit(rng) * 2.0f - 1.0f, unit(rng) * 2.0f - 1.0f);
+            vec3 posV(ndc.x * depth * view.tanHalfFovX, ndc.y * depth * view.tanHalfFovY, -depth);
+
+            vec2 screenUv((ndc.x + 1.0f) * 0.5f, (1.0f - ndc.y) * 0.5f);
+            uint32_t x = std::min(uint32_t(screenUv.x * LIGHT_CLUSTER_COUNT_X), uint32_t(LIGHT_CLUSTER_COUNT_X - 1));
+            uint32_t y = std::min(uint32_t(screenUv.y * LIGHT_CLUSTER_COUNT_Y), uint32_t(LIGHT_CLUSTER_COUNT_Y - 1));
+            uint32_t z = getLightClusterSlice(data, depth);
+
+            BoundingBox box = LightClusters::calcClusterBounds(view, x, y, z);
+            vec3 tolerance = vec3(1e-4f * depth);
+            bool inside = glm::all(glm::lessThanEqual(box.getMinPos() - tolerance, posV)) && glm::all(glm::lessThanEqual(posV, box.getMaxPos() + tolerance));
+            EXPECT(inside) << "depth " << depth << " cluster " << x << " " << y << " " << z;
+        }
+    }
+}
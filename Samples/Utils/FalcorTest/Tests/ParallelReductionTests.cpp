@@ -0,0 +1,137 @@
+/***************************************************************************
+# Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Utils/Math/ParallelReduction.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kWidth = 83, kHeight = 45;     // Partial tiles on both axes
+
+        std::vector<glm::vec4> createImage(uint32_t sampleCount, uint32_t seed)
+        {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> dist(0.1f, 4.0f);
+            std::vector<glm::vec4> texels(kWidth * kHeight * sampleCount);
+            for (auto& t : texels)
+            {
+                t = glm::vec4(dist(rng), dist(rng), dist(rng), dist(rng));
+            }
+            return texels;
+        }
+
+        float relativeError(float a, float b) { return std::abs(a - b) / std::max(std::abs(b), 1e-6f); }
+    }
+
+    CPU_TEST(ParallelReductionSum)
+    {
+        for (uint32_t sampleCount : { 1u, 4u })
+        {
+            std::vector<glm::vec4> texels = createImage(sampleCount, 3);
+
+            // Reference in double precision, of the average of the samples of every pixel
+            glm::dvec4 sum(0), logSum(0);
+            for (uint32_t p = 0; p < kWidth * kHeight; p++)
+            {
+                glm::dvec4 pixel(0);
+                for (uint32_t s = 0; s < sampleCount; s++) pixel += glm::dvec4(texels[p * sampleCount + s]);
+                pixel /= double(sampleCount);
+                sum += pixel;
+                for (int c = 0; c < 4; c++) logSum[c] += std::log2(pixel[c]);
+            }
+            const double pixelCount = double(kWidth * kHeight);
+
+            glm::vec4 resultSum = ParallelReduction::reduce(ParallelReduction::Type::Sum, texels.data(), kWidth, kHeight, sampleCount);
+            glm::vec4 resultMean = ParallelReduction::reduce(ParallelReduction::Type::Mean, texels.data(), kWidth, kHeight, sampleCount);
+            glm::vec4 resultLogAvg = ParallelReduction::reduce(ParallelReduction::Type::LogAverage, texels.data(), kWidth, kHeight, sampleCount);
+            for (int c = 0; c < 4; c++)
+            {
+                EXPECT_LE(relativeError(resultSum[c], float(sum[c])), 1e-5f) << "samples " << sampleCount << ", channel " << c;
+                EXPECT_LE(relativeError(resultMean[c], float(sum[c] / pixelCount)), 1e-5f) << "samples " << sampleCount << ", channel " << c;
+                EXPECT_LE(relativeError(resultLogAvg[c], float(std::exp2(logSum[c] / pixelCount))), 1e-4f) << "samples " << sampleCount << ", channel " << c;
+            }
+        }
+    }
+
+    CPU_TEST(ParallelReductionMinMax)
+    {
+        const uint32_t sampleCount = 4;
+        std::vector<glm::vec4> texels(kWidth * kHeight * sampleCount, glm::vec4(1.0f));
+
+        // Without geometry, the range is empty
+        glm::vec4 range = ParallelReduction::reduce(ParallelReduction::Type::MinMax, texels.data(), kWidth, kHeight, sampleCount);
+        EXPECT_EQ(range.x, 1.0f);
+        EXPECT_EQ(range.y, 0.0f);
+
+        // The bounds are in single samples, in the partial tiles, and the background is ignored
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> dist(0.3f, 0.9f);
+        for (uint32_t i = 0; i < texels.size(); i += 2) texels[i].r = dist(rng);
+        texels[((44 * kWidth) + 82) * sampleCount + 3].r = 0.125f;
+        texels[((40 * kWidth) + 81) * sampleCount + 1].r = 0.97f;
+        range = ParallelReduction::reduce(ParallelReduction::Type::MinMax, texels.data(), kWidth, kHeight, sampleCount);
+        EXPECT_EQ(range.x, 0.125f);
+        EXPECT_EQ(range.y, 0.97f);
+    }
+
+    CPU_TEST(ParallelReductionHistogram)
+    {
+        std::vector<glm::vec4> texels = createImage(1, 7);
+
+        // Gray pixels fall in a known bin. 2^-20 and 2^20 are clamped to the first and last bins.
+        const glm::vec2 histogramRange(-4, 4);
+        const float binSize = (histogramRange.y - histogramRange.x) / ParallelReduction::kHistogramBinCount;
+        texels[0] = glm::vec4(std::exp2(histogramRange.x + 100.5f * binSize));
+        texels[1] = glm::vec4(std::exp2(-20.0f));
+        texels[2] = glm::vec4(std::exp2(20.0f));
+
+        std::vector<uint32_t> bins;
+        ParallelReduction::calcHistogram(texels.data(), kWidth, kHeight, 1, histogramRange, bins);
+        EXPECT_EQ(bins.size(), size_t(ParallelReduction::kHistogramBinCount));
+        uint32_t pixelCount = 0;
+        for (uint32_t count : bins) pixelCount += count;
+        EXPECT_EQ(pixelCount, kWidth * kHeight);
+
+        // Changing one pixel moves a single count
+        std::vector<uint32_t> prevBins = bins;
+        texels[0] = glm::vec4(std::exp2(histogramRange.x + 200.5f * binSize));
+        ParallelReduction::calcHistogram(texels.data(), kWidth, kHeight, 1, histogramRange, bins);
+        EXPECT_EQ(bins[100], prevBins[100] - 1);
+        EXPECT_EQ(bins[200], prevBins[200] + 1);
+
+        // Removing the clamped pixels empties the end bins, since the rest of the image is inside the range
+        EXPECT_GE(prevBins[0], 1u);
+        EXPECT_GE(prevBins[ParallelReduction::kHistogramBinCount - 1], 1u);
+        texels[1] = texels[2] = glm::vec4(1.0f);
+        ParallelReduction::calcHistogram(texels.data(), kWidth, kHeight, 1, histogramRange, bins);
+        EXPECT_EQ(bins[0], 0u);
+        EXPECT_EQ(bins[ParallelReduction::kHistogramBinCount - 1], 0u);
+    }
+}
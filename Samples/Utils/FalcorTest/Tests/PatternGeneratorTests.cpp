@@ -0,0 +1,169 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Utils/PatternGenerators/LowDiscrepancySequence.h"
+#include "Utils/PatternGenerators/BlueNoise.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kLog2Count = 10;
+
+        // Whether the first 2^log2n points are a (0,m,2)-net, with exactly one point in each elementary interval of area 2^-log2n
+        bool isNet(const std::vector<vec2>& points, uint32_t log2n)
+        {
+            const uint32_t n = 1u << log2n;
+            for (uint32_t j = 0; j <= log2n; j++)
+            {
+                std::vector<uint8_t> occupied(n, 0);
+                for (uint32_t i = 0; i < n; i++)
+                {
+                    uint32_t x = uint32_t(points[i].x * float(1u << j));
+                    uint32_t y = uint32_t(points[i].y * float(1u << (log2n - j)));
+                    uint32_t interval = (x << (log2n - j)) + y;
+                    if (interval >= n || occupied[interval]) return false;
+                    occupied[interval] = 1;
+                }
+            }
+            return true;
+        }
+
+        std::vector<vec2> generate(LowDiscrepancySequence::Type type, uint32_t count, uint32_t seed)
+        {
+            std::vector<vec2> points(count);
+            LowDiscrepancySequence::generate(type, 0, count, seed, points.data());
+            return points;
+        }
+    }
+
+    CPU_TEST(SobolFirstPoints)
+    {
+        const vec2 kExpected[] = { { 0.0f, 0.0f }, { 0.5f, 0.5f }, { 0.25f, 0.75f }, { 0.75f, 0.25f }, { 0.125f, 0.625f }, { 0.625f, 0.125f }, { 0.375f, 0.375f }, { 0.875f, 0.875f } };
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            vec2 p = LowDiscrepancySequence::sobol(i);
+            EXPECT(p == kExpected[i]) << "i = " << i;
+        }
+    }
+
+    CPU_TEST(SequencesAreNets)
+    {
+        struct Case { LowDiscrepancySequence::Type type; uint32_t seed; const char* name; };
+        const Case kCases[] =
+        {
+            { LowDiscrepancySequence::Type::Sobol, 0, "Sobol" },
+            { LowDiscrepancySequence::Type::OwenScrambledSobol, 1, "OwenScrambledSobol" },
+            { LowDiscrepancySequence::Type::OwenScrambledSobol, 1234, "OwenScrambledSobol" },
+            { LowDiscrepancySequence::Type::PMJ02, 1, "PMJ02" },
+            { LowDiscrepancySequence::Type::PMJ02, 1234, "PMJ02" },
+        };
+
+        for (const Case& c : kCases)
+        {
+            std::vector<vec2> points = generate(c.type, 1u << kLog2Count, c.seed);
+            for (uint32_t log2n = 0; log2n <= kLog2Count; log2n++)
+            {
+                EXPECT(isNet(points, log2n)) << c.name << ", seed = " << c.seed << ", n = " << (1u << log2n);
+            }
+        }
+
+        // Different seeds give different points
+        EXPECT(LowDiscrepancySequence::owenScrambledSobol(0, 1) != LowDiscrepancySequence::owenScrambledSobol(0, 2));
+        EXPECT(LowDiscrepancySequence::generatePMJ02(4, 1)[3] != LowDiscrepancySequence::generatePMJ02(4, 2)[3]);
+    }
+
+    CPU_TEST(SequenceBatchMatchesPoints)
+    {
+        // An offset start and a count that isn't a multiple of 4 cover both the SIMD and the scalar loops
+        const uint32_t kFirst = 5, kCount = 37, kSeed = 7;
+        std::vector<vec2> points(kCount);
+
+        LowDiscrepancySequence::generate(LowDiscrepancySequence::Type::Sobol, kFirst, kCount, kSeed, points.data());
+        for (uint32_t i = 0; i < kCount; i++) EXPECT(points[i] == LowDiscrepancySequence::sobol(kFirst + i)) << "Sobol, i = " << i;
+
+        LowDiscrepancySequence::generate(LowDiscrepancySequence::Type::OwenScrambledSobol, kFirst, kCount, kSeed, points.data());
+        for (uint32_t i = 0; i < kCount; i++) EXPECT(points[i] == LowDiscrepancySequence::owenScrambledSobol(kFirst + i, kSeed)) << "OwenScrambledSobol, i = " << i;
+
+        LowDiscrepancySequence::generate(LowDiscrepancySequence::Type::R2, kFirst, kCount, kSeed, points.data());
+        for (uint32_t i = 0; i < kCount; i++) EXPECT(points[i] == LowDiscrepancySequence::r2(kFirst + i, kSeed)) << "R2, i = " << i;
+
+        std::vector<vec2> prefix = LowDiscrepancySequence::generatePMJ02(kFirst + kCount, kSeed);
+        LowDiscrepancySequence::generate(LowDiscrepancySequence::Type::PMJ02, kFirst, kCount, kSeed, points.data());
+        for (uint32_t i = 0; i < kCount; i++) EXPECT(points[i] == prefix[kFirst + i]) << "PMJ02, i = " << i;
+    }
+
+    CPU_TEST(R2Sequence)
+    {
+        const double kPlastic = 1.32471795724474602596;
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            vec2 p = LowDiscrepancySequence::r2(i);
+            double x = 0.5 + i / kPlastic;
+            double y = 0.5 + i / (kPlastic * kPlastic);
+            EXPECT_LE(std::abs(p.x - (x - std::floor(x))), 1e-6) << "i = " << i;
+            EXPECT_LE(std::abs(p.y - (y - std::floor(y))), 1e-6) << "i = " << i;
+        }
+    }
+
+    CPU_TEST(BlueNoiseRanks)
+    {
+        const uint32_t kSize = 32;
+        std::vector<uint32_t> ranks = BlueNoise::generate(kSize, kSize, 3);
+        EXPECT_EQ(ranks.size(), kSize * kSize);
+
+        // The ranks are a permutation
+        std::vector<uint8_t> found(ranks.size(), 0);
+        for (uint32_t r : ranks)
+        {
+            EXPECT(r < ranks.size() && found[r] == 0) << "rank = " << r;
+            if (r < ranks.size()) found[r] = 1;
+        }
+
+        // The lowest ranks are spread out. At 1/8 of the texels, white noise would almost surely have adjacent texels.
+        const uint32_t kCount = kSize * kSize / 8;
+        std::vector<uvec2> texels;
+        for (uint32_t i = 0; i < ranks.size(); i++)
+        {
+            if (ranks[i] < kCount) texels.push_back(uvec2(i % kSize, i / kSize));
+        }
+        uint32_t minDistance2 = UINT32_MAX;
+        for (size_t i = 0; i < texels.size(); i++)
+        {
+            for (size_t j = i + 1; j < texels.size(); j++)
+            {
+                uint32_t dx = (texels[i].x - texels[j].x + kSize) % kSize;
+                uint32_t dy = (texels[i].y - texels[j].y + kSize) % kSize;
+                dx = std::min(dx, kSize - dx);
+                dy = std::min(dy, kSize - dy);
+                minDistance2 = std::min(minDistance2, dx * dx + dy * dy);
+            }
+        }
+        EXPECT_GE(minDistance2, 4u);
+    }
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+# Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Utils/PixelConversion.h"
+#include <random>
+
+namespace Falcor
+{
+    using namespace PixelConversion;
+
+    // The specialized kernels must match the per-pixel path exactly. The odd counts exercise the scalar tails of the SIMD loops.
+    CPU_TEST(PixelConversionKernels)
+    {
+        std::mt19937 rng(0);
+        std::vector<uint8_t> src8(1024 * 4);
+        for (auto& b : src8) b = (uint8_t)rng();
+        std::vector<float> srcFloat(1024 * 4);
+        std::uniform_real_distribution<float> dist(-0.25f, 1.25f);
+        for (auto& f : srcFloat) f = dist(rng);
+
+        const Layout kLayouts[] = { Layout::RGBA8, Layout::BGRA8, Layout::BGRX8, Layout::RGB8, Layout::BGR8, Layout::RGBA32Float };
+        for (Layout src : kLayouts)
+        {
+            for (Layout dst : kLayouts)
+            {
+                const void* pSrc = (src == Layout::RGBA32Float) ? (const void*)srcFloat.data() : (const void*)src8.data();
+                for (uint32_t count : { 1u, 5u, 6u, 7u, 1000u })
+                {
+                    std::vector<uint8_t> result(count * 16, 0xcd);
+                    std::vector<uint8_t> reference(count * 16, 0xcd);
+                    convertPixels(src, dst, pSrc, result.data(), count);
+                    convertPixelsGeneric(src, dst, pSrc, reference.data(), count);
+                    EXPECT(result == reference) << "src = " << int32_t(src) << ", dst = " << int32_t(dst) << ", count = " << count;
+                }
+            }
+        }
+
+        // RGB8 -> RGBA8 sets alpha, RGBA8 -> BGRA8 swaps red and blue
+        const uint8_t rgb[3] = { 1, 2, 3 };
+        uint8_t rgba[4];
+        convertPixels<Layout::RGB8, Layout::RGBA8>(rgb, rgba, 1);
+        EXPECT_EQ(rgba[3], 255);
+        convertPixels<Layout::RGBA8, Layout::BGRA8>(rgba, rgba, 1);
+        EXPECT_EQ(rgba[0], 3);
+        EXPECT_EQ(rgba[2], 1);
+    }
+
+    CPU_TEST(PixelConversionDownscale2x)
+    {
+        std::mt19937 rng(1);
+        std::vector<uint8_t> src(33 * 17 * 4);
+        for (auto& b : src) b = (uint8_t)rng();
+
+        for (uint32_t height = 1; height <= 17; height++)
+        {
+            for (uint32_t width = 1; width <= 33; width++)
+            {
+                std::vector<uint8_t> result(src.size(), 0);
+                std::vector<uint8_t> reference(src.size(), 0);
+                bool resultValid = downscale2x(src.data(), width, height, result.data());
+                bool referenceValid = downscale2xGeneric(src.data(), width, height, reference.data());
+                EXPECT_EQ(resultValid, referenceValid);
+                EXPECT(result == reference) << "width = " << width << ", height = " << height;
+            }
+        }
+
+        // The polyphase filter preserves constant images for odd sizes
+        std::vector<uint8_t> constant(9 * 7 * 4, 77);
+        std::vector<uint8_t> dst(4 * 3 * 4);
+        downscale2x(constant.data(), 9, 7, dst.data());
+        for (uint8_t v : dst) EXPECT_EQ(v, 77);
+    }
+
+}  // namespace Falcor
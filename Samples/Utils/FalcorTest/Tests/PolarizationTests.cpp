@@ -0,0 +1,329 @@
+/***************************************************************************
+# Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Utils/Polarization.h"
+#include "Utils/PsiLut.h"
+#include "Utils/MuellerCalculus.h"
+#include "Utils/ProbePolarization.h"
+#include "Data/HostDevicePolarization.h"
+#include <cstring>
+#include <random>
+
+namespace Falcor
+{
+    using namespace Polarization;
+
+    namespace
+    {
+        const PsiModel kModels[] = { PsiModel::Exact, PsiModel::MetalApprox, PsiModel::DielectricExact, PsiModel::DielectricOneFive };
+
+        struct TestInputs
+        {
+            std::vector<float> n, k, R0, cosTheta, sin2Theta;
+
+            PsiInputs get() const
+            {
+                PsiInputs inputs;
+                inputs.pN = n.data();
+                inputs.pK = k.data();
+                inputs.pR0 = R0.data();
+                inputs.pCosTheta = cosTheta.data();
+                inputs.pSin2Theta = sin2Theta.data();
+                return inputs;
+            }
+        };
+
+        // Must match testPsi() in PolarizationTests.cs.slang
+        TestInputs getTestInputs(uint32_t count)
+        {
+            TestInputs t;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                float ct = float((i & 63) * 2 + 1) * (1.0f / 128.0f);
+                t.cosTheta.push_back(ct);
+                t.sin2Theta.push_back(1.0f - ct * ct);
+                t.R0.push_back(float((i >> 6) & 15) * (1.0f / 16.0f));
+                t.n.push_back(1.0f + float((i >> 10) & 7) * 0.25f);
+                t.k.push_back(float((i >> 13) & 7) * 0.5f);
+            }
+            return t;
+        }
+    }
+
+    // The SIMD kernels must match the shared shader code. They can differ in the last bit if the compiler contracts the reference to FMAs.
+    // The odd counts exercise the scalar tails.
+    CPU_TEST(PolarizationPsiKernels)
+    {
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        TestInputs t;
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            float ct = dist(rng);
+            t.cosTheta.push_back(ct);
+            t.sin2Theta.push_back(1.0f - ct * ct);
+            t.R0.push_back(0.95f * dist(rng));
+            t.n.push_back(0.2f + 3.0f * dist(rng));
+            t.k.push_back(5.0f * dist(rng));
+        }
+
+        for (PsiModel model : kModels)
+        {
+            for (uint32_t count : { 1u, 7u, 9u, 1000u })
+            {
+                std::vector<float> result(count);
+                std::vector<float> reference(count);
+                evaluatePsi(model, t.get(), result.data(), count);
+                evaluatePsiGeneric(model, t.get(), reference.data(), count);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    EXPECT_LE(std::abs(result[i] - reference[i]), 1e-6f) << getPsiModelName(model) << ", i = " << i;
+                }
+            }
+        }
+    }
+
+    CPU_TEST(PolarizationPsiIdentities)
+    {
+        // No polarization at normal incidence
+        EXPECT_EQ(psi_DielectricOneFive(1.0f, 0.0f), 0.0f);
+        EXPECT_EQ(psi_MetalApprox(float3(0.9f), 1.0f, 0.0f).x, 0.0f);
+
+        // A dielectric with n = 1.5 reflects 4% at normal incidence, which is what psi_DielectricOneFive() assumes
+        float n = 1.5f;
+        EXPECT_LE(std::abs(SpecularFromIOR(float3(n), float3(0.0f)).x - 0.04f), 1e-6f);
+
+        // Full polarization at Brewster's angle, tan(theta) = n
+        float ct = 1.0f / std::sqrt(1.0f + n * n);
+        float st2 = n * n / (1.0f + n * n);
+        EXPECT_LE(std::abs(psi_DielectricOneFive(ct, st2) - 1.0f), 1e-5f);
+
+        // The dielectric functions agree with each other and with the conductor at k = 0
+        for (float c : { 0.1f, 0.3f, 0.5f, 0.7f, 0.9f })
+        {
+            float s2 = 1.0f - c * c;
+            float oneFive = psi_DielectricOneFive(c, s2);
+            EXPECT_LE(std::abs(psi_DielectricExact(0.04f, c, s2) - oneFive), 1e-5f) << "cos(theta) = " << c;
+            EXPECT_LE(std::abs(psi_Exact(float3(n), float3(0.0f), c, s2).x - oneFive), 1e-5f) << "cos(theta) = " << c;
+        }
+    }
+
+    // The lookup textures hold the functions at the texel centers, and linear filtering between the texels stays close to psi_Exact() for real materials
+    CPU_TEST(PolarizationPsiLut)
+    {
+        EXPECT_EQ(psiLutCoord(0.0f), 0.5f / PSI_LUT_SIZE);
+        EXPECT_EQ(psiLutCoord(1.0f), (PSI_LUT_SIZE - 0.5f) / PSI_LUT_SIZE);
+
+        // Gold and glass
+        std::vector<PsiLut::Material> materials = { { vec3(0.183f, 0.421f, 1.373f), vec3(3.424f, 2.346f, 1.770f) }, { vec3(1.521f), vec3(0.0f) } };
+        TextureBaker::Image image = PsiLut::bakeMaterials(materials);
+        EXPECT_EQ(image.width, PSI_LUT_SIZE);
+        EXPECT_EQ(image.height, (uint32_t)materials.size());
+
+        // Check the texels as they are uploaded. Only float texels are precise enough for the bound below.
+        std::vector<uint8_t> uploaded = TextureBaker::encodeMipChain({ image }, PsiLut::getTextureFormat());
+        EXPECT_EQ(uploaded.size(), image.texels.size() * sizeof(vec4));
+        std::vector<vec4> texels(image.texels.size());
+        std::memcpy(texels.data(), uploaded.data(), std::min(uploaded.size(), texels.size() * sizeof(vec4)));
+
+        // Linear interpolation between 128 texels is off by up to 1.2e-4 for glass at grazing angles
+        for (uint32_t row = 0; row < image.height; row++)
+        {
+            const vec4* pRow = &texels[row * image.width];
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                float3 n(materials[row].n[c]);
+                float3 k(materials[row].k[c]);
+                for (uint32_t s = 0; s <= 1000; s++)
+                {
+                    float ct = s / 1000.0f;
+                    float x = ct * (PSI_LUT_SIZE - 1);
+                    uint32_t i = std::min((uint32_t)x, PSI_LUT_SIZE - 2u);
+                    float lerped = glm::mix(pRow[i][c], pRow[i + 1][c], x - i);
+                    EXPECT_LE(std::abs(lerped - psi_Exact(n, k, ct, 1.0f - ct * ct).x), 2e-4f) << "row " << row << ", channel " << c << ", cos(theta) = " << ct;
+                }
+            }
+        }
+
+        image = PsiLut::bakeReflectance();
+        EXPECT_EQ(image.width, PSI_LUT_SIZE);
+        EXPECT_EQ(image.height, PSI_LUT_SIZE);
+        for (uint32_t row : { 0u, 10u, PSI_LUT_SIZE / 2u, PSI_LUT_SIZE - 10u })
+        {
+            float R0 = float(row) / (PSI_LUT_SIZE - 1);
+            for (uint32_t col : { 0u, 31u, PSI_LUT_SIZE / 2u, PSI_LUT_SIZE - 1u })
+            {
+                float ct = float(col) / (PSI_LUT_SIZE - 1);
+                const vec4& texel = image.texels[row * image.width + col];
+                EXPECT_LE(std::abs(texel.r - psi_MetalApprox(float3(R0), ct, 1.0f - ct * ct).x), 1e-6f) << "R0 = " << R0 << ", cos(theta) = " << ct;
+                EXPECT_LE(std::abs(texel.g - psi_DielectricExact(R0, ct, 1.0f - ct * ct)), 1e-6f) << "R0 = " << R0 << ", cos(theta) = " << ct;
+            }
+        }
+    }
+
+    // The Mueller matrices used by the CPU path tracer must agree with the psi functions that the renderers approximate
+    CPU_TEST(PolarizationMuellerCalculus)
+    {
+        const vec4 unpolarized(1.0f, 0.0f, 0.0f, 0.0f);
+        for (float n : { 0.18f, 1.5f, 2.9f })
+        {
+            for (float k : { 0.0f, 3.4f })
+            {
+                EXPECT_LE(std::abs(muellerFresnelReflection(n, k, 1.0f)[0][0] - SpecularFromIOR(float3(n), float3(k)).x), 1e-5f) << "n = " << n << ", k = " << k;
+
+                for (float ct : { 0.1f, 0.4f, 0.8f })
+                {
+                    glm::mat4 m = muellerFresnelReflection(n, k, ct);
+                    vec4 s = m * unpolarized;
+                    float psi = psi_Exact(float3(n), float3(k), ct, 1.0f - ct * ct).x;
+                    EXPECT_LE(std::abs(s.y / s.x - psi), 1e-4f) << "n = " << n << ", k = " << k << ", cos(theta) = " << ct;
+                    EXPECT_EQ(s.z, 0.0f);
+
+                    // A passive element can't create intensity or polarization: S0^2 >= S1^2 + S2^2 + S3^2 for fully polarized input
+                    vec4 p = m * vec4(1.0f, 0.0f, 0.6f, 0.8f);
+                    EXPECT_LE(p.y * p.y + p.z * p.z + p.w * p.w, p.x * p.x * 1.0001f) << "n = " << n << ", k = " << k << ", cos(theta) = " << ct;
+                    EXPECT_LE(p.x, 1.0f);
+                }
+            }
+        }
+
+        // Rotating the frame by a and back is the identity, and a rotation by 90 degrees swaps the x and y polarizations
+        glm::mat4 r = muellerRotation(cos(0.6f), sin(0.6f)) * muellerRotation(cos(-0.6f), sin(-0.6f));
+        vec4 s = r * vec4(1.0f, 0.3f, -0.5f, 0.2f);
+        EXPECT_LE(glm::length(s - vec4(1.0f, 0.3f, -0.5f, 0.2f)), 1e-6f);
+        s = muellerRotation(vec3(1, 0, 0), vec3(0, 1, 0), vec3(0, 1, 0)) * vec4(1.0f, 1.0f, 0.0f, 0.0f);
+        EXPECT_LE(glm::length(s - vec4(1.0f, -1.0f, 0.0f, 0.0f)), 1e-6f);
+
+        // Light polarized at 30 degrees passes a polarizer at 30 degrees fully and is blocked at 120 degrees. Unpolarized light always passes.
+        float a = glm::radians(30.0f);
+        vec4 polarized(1.0f, cos(2.0f * a), sin(2.0f * a), 0.0f);
+        EXPECT_LE(std::abs(linearPolarizerIntensity(polarized, a) - 2.0f), 1e-5f);
+        EXPECT_LE(std::abs(linearPolarizerIntensity(polarized, a + glm::radians(90.0f))), 1e-5f);
+        EXPECT_EQ(linearPolarizerIntensity(unpolarized, 1.0f), 1.0f);
+        EXPECT(muellerDepolarizer(0.5f) * polarized == vec4(0.5f, 0.0f, 0.0f, 0.0f));
+    }
+
+    // The environment terms of a light probe pick up the cos(2*phi) and sin(2*phi) harmonics of the radiance around a texel, in the frame of probePolarizationFrameX(),
+    // and vanish for a uniform environment. The coherence of the GGX lobe is 1 for a mirror and drops with the roughness.
+    CPU_TEST(PolarizationProbeTerms)
+    {
+        // Same mapping as sphericalCrdToDir() in Helpers.slang
+        auto latLongToDir = [](float u, float v)
+        {
+            float phi = float(M_PI) * v;
+            float theta = 2.0f * float(M_PI) * u - 0.5f * float(M_PI);
+            return vec3(sin(phi) * sin(theta), cos(phi), sin(phi) * cos(theta));
+        };
+
+        // Level 2 of a 16x16 texture has a linear roughness of 0.5 and is 4x4 texels
+        const uint32_t kSize = 16;
+        const uint32_t kLevel = 2;
+        const uint32_t kX = 1, kY = 2;
+        vec3 R = latLongToDir((kX + 0.5f) / 4.0f, (kY + 0.5f) / 4.0f);
+        vec3 X = probePolarizationFrameX(R);
+        vec3 Y = glm::cross(R, X);
+
+        TextureBaker::Image environment;
+        environment.width = 256;
+        environment.height = 128;
+        environment.texels.resize(environment.width * environment.height);
+        std::vector<TextureBaker::Image> cosMips[3], sinMips[3];
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            // Uniform, cos(2*phi) and sin(2*phi) around R
+            for (uint32_t y = 0; y < environment.height; y++)
+            {
+                for (uint32_t x = 0; x < environment.width; x++)
+                {
+                    vec3 d = latLongToDir((x + 0.5f) / environment.width, (y + 0.5f) / environment.height);
+                    float dx = glm::dot(d, X), dy = glm::dot(d, Y);
+                    float radiance = (i == 0) ? 1.0f : ((i == 1) ? 1.0f + dx * dx - dy * dy : 1.0f + 2.0f * dx * dy);
+                    environment.texels[y * environment.width + x] = vec4(radiance, radiance, radiance, 1.0f);
+                }
+            }
+            ProbePolarization::bakeEnvironment(environment, kSize, 256, cosMips[i], sinMips[i]);
+            EXPECT_EQ(cosMips[i].size(), 5u);
+            EXPECT_EQ(cosMips[i][kLevel].width, 4u);
+        }
+
+        for (uint32_t level = 0; level < 5; level++)
+        {
+            for (const vec4& t : cosMips[0][level].texels) EXPECT_LE(std::abs(t.r), 1e-3f) << "level " << level;
+            for (const vec4& t : sinMips[0][level].texels) EXPECT_LE(std::abs(t.r), 1e-3f) << "level " << level;
+        }
+
+        float cosTerm = cosMips[1][kLevel].texels[kY * 4 + kX].r;
+        float sinTerm = sinMips[2][kLevel].texels[kY * 4 + kX].r;
+        EXPECT_LE(0.01f, cosTerm);
+        EXPECT_LE(std::abs(sinTerm - cosTerm), 0.05f * cosTerm) << "cos " << cosTerm << ", sin " << sinTerm;
+        EXPECT_LE(std::abs(sinMips[1][kLevel].texels[kY * 4 + kX].r), 0.05f * cosTerm);
+        EXPECT_LE(std::abs(cosMips[2][kLevel].texels[kY * 4 + kX].r), 0.05f * cosTerm);
+
+        TextureBaker::Image coherence = ProbePolarization::bakeCoherence(256);
+        EXPECT_EQ(coherence.width, PSI_LUT_SIZE);
+        for (uint32_t col = 0; col < PSI_LUT_SIZE; col++)
+        {
+            EXPECT_LE(std::abs(coherence.texels[col].r - 1.0f), 1e-5f) << "NdotV column " << col;
+        }
+        for (const vec4& t : coherence.texels) EXPECT_LE(std::abs(t.r), 1.0f + 1e-5f);
+        const uint32_t kMid = PSI_LUT_SIZE / 2;
+        float smooth = coherence.texels[(PSI_LUT_SIZE / 10) * PSI_LUT_SIZE + kMid].r;
+        float rough = coherence.texels[(PSI_LUT_SIZE / 2) * PSI_LUT_SIZE + kMid].r;
+        EXPECT_LE(rough, smooth);
+        EXPECT_LE(smooth, 1.0f);
+    }
+
+    // Pins the CPU reference to the shader. GPU division and square roots aren't correctly rounded, so allow a small difference.
+    GPU_TEST(PolarizationPsiMatchesShader)
+    {
+        const uint32_t count = 1 << 16;
+        ctx.createProgram("PolarizationTests.cs.slang", "testPsi");
+        ctx.allocateStructuredBuffer("result", count * 4);
+        ctx["TestCB"]["resultSize"] = int32_t(count * 4);
+        ctx.runProgram(count);
+
+        TestInputs t = getTestInputs(count);
+        std::vector<float> cpu[arraysize(kModels)];
+        for (uint32_t m = 0; m < arraysize(kModels); m++)
+        {
+            cpu[m].resize(count);
+            evaluatePsi(kModels[m], t.get(), cpu[m].data(), count);
+        }
+
+        const float* pGpu = ctx.mapBuffer<const float>("result");
+        for (uint32_t i = 0; i < count; i++)
+        {
+            for (uint32_t m = 0; m < arraysize(kModels); m++)
+            {
+                EXPECT_LE(std::abs(pGpu[4 * i + m] - cpu[m][i]), 1e-4f) << getPsiModelName(kModels[m]) << ", i = " << i;
+            }
+        }
+        ctx.unmapBuffer("result");
+    }
+
+}  // namespace Falcor
@@ -0,0 +1,235 @@
+/***************************************************************************
+# Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Effects/Shadows/SdsmReduction.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        // A camera looking down -z from the origin, with the same conventions as Camera
+        CsmPartitionData createPartitionData(uint32_t cascadeCount, uint32_t partitionMode)
+        {
+            CsmPartitionData partition;
+            partition.nearPlane = 0.1f;
+            partition.farPlane = 100.0f;
+            partition.camProjMat = glm::perspective(glm::radians(60.0f), 1.5f, partition.nearPlane, partition.farPlane);
+            glm::mat4 invProj = glm::inverse(partition.camProjMat);
+            const vec3 clipSpace[8] =
+            {
+                vec3(-1, 1, 0), vec3(1, 1, 0), vec3(1, -1, 0), vec3(-1, -1, 0),
+                vec3(-1, 1, 1), vec3(1, 1, 1), vec3(1, -1, 1), vec3(-1, -1, 1),
+            };
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                vec4 crd = invProj * vec4(clipSpace[i], 1);
+                partition.camFrustum[i] = vec4(vec3(crd) / crd.w, 1);
+            }
+
+            // A light shining straight down, covering the whole frustum
+            glm::mat4 lightView = glm::lookAt(vec3(0, 0, -50), vec3(0, -1, -50), vec3(0, 0, -1));
+            partition.globalMat = glm::ortho(-100.0f, 100.0f, -100.0f, 100.0f, -100.0f, 100.0f) * lightView;
+
+            partition.cascadeCount = cascadeCount;
+            partition.partitionMode = partitionMode;
+            partition.pssmLambda = 0.5f;
+            partition.cascadeBlendThreshold = 0;
+            partition.stabilizeCascades = 0;
+            partition.padding = 0;
+            return partition;
+        }
+
+        // Depth buffer value of a point at a camera-space distance
+        float calcDepth(const CsmPartitionData& partition, float distance)
+        {
+            vec4 posC = partition.camProjMat * vec4(0, 0, -distance, 1);
+            return posC.z / posC.w;
+        }
+
+        // The xy bounds of a cascade in the global light clip-space
+        vec4 calcCascadeBounds(const CsmCascadeData& cascade)
+        {
+            vec2 scale = vec2(cascade.scale);
+            vec2 offset = vec2(cascade.offset);
+            return vec4((vec2(-1) - offset) / scale, (vec2(1) - offset) / scale);
+        }
+
+        bool isNear(float a, float b)
+        {
+            return std::abs(a - b) <= 1e-3f * std::max(1.0f, std::abs(b));
+        }
+    }
+
+    CPU_TEST(SdsmReduceDepth)
+    {
+        const uint32_t width = 61, height = 37, sampleCount = 4;
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> depthDist(0.3f, 0.9f);
+        std::vector<float> depth(width * height * sampleCount);
+        for (auto& d : depth)
+        {
+            d = (rng() % 3 == 0) ? 1.0f : depthDist(rng);
+        }
+
+        // The bounds are in different samples of different pixels, and the background is ignored
+        depth[((20 * width) + 45) * sampleCount + 3] = 0.25f;
+        depth[((33 * width) + 2) * sampleCount + 1] = 0.95f;
+        vec2 bounds = SdsmReduction::reduceDepth(depth.data(), width, height, sampleCount);
+        EXPECT_EQ(bounds.x, 0.25f);
+        EXPECT_EQ(bounds.y, 0.95f);
+
+        // Without geometry, the bounds are empty
+        std::fill(depth.begin(), depth.end(), 1.0f);
+        bounds = SdsmReduction::reduceDepth(depth.data(), width, height, sampleCount);
+        EXPECT_EQ(bounds.x, 1.0f);
+        EXPECT_EQ(bounds.y, 0.0f);
+    }
+
+    CPU_TEST(SdsmDistanceRange)
+    {
+        CsmPartitionData partition = createPartitionData(4, CsmPartitionLinear);
+        float range = partition.farPlane - partition.nearPlane;
+        vec2 depthRange(calcDepth(partition, 5.0f), calcDepth(partition, 40.0f));
+
+        vec2 distanceRange = SdsmReduction::calcDistanceRange(partition, depthRange);
+        EXPECT_LE(std::abs(distanceRange.x - (5.0f - partition.nearPlane) / range), 1e-3f);
+        EXPECT_LE(std::abs(distanceRange.y - (40.0f - partition.nearPlane) / range), 1e-3f);
+
+        // Stabilization snaps to 1/16
+        partition.stabilizeCascades = 1;
+        distanceRange = SdsmReduction::calcDistanceRange(partition, depthRange);
+        EXPECT_EQ(distanceRange.x, 0.0625f);
+        EXPECT_EQ(distanceRange.y, 0.375f);
+    }
+
+    CPU_TEST(SdsmPartitionCascades)
+    {
+        for (uint32_t mode : { CsmPartitionLinear, CsmPartitionLogarithmic, CsmPartitionPssm })
+        {
+            CsmPartitionData partition = createPartitionData(4, mode);
+            const vec2 distanceRange(0.05f, 0.6f);
+            CsmCascadeData cascades[CSM_MAX_CASCADES];
+            SdsmReduction::partitionCascades(partition, distanceRange, cascades);
+
+            // The cascades are contiguous and cover the distance range
+            float start = calcDepth(partition, glm::mix(partition.nearPlane, partition.farPlane, distanceRange.x));
+            float end = calcDepth(partition, glm::mix(partition.nearPlane, partition.farPlane, distanceRange.y));
+            EXPECT_LE(std::abs(cascades[0].range.x - start), 1e-4f) << "mode " << mode;
+            for (uint32_t c = 0; c < partition.cascadeCount; c++)
+            {
+                EXPECT_GT(cascades[c].range.y, 0.0f) << "mode " << mode << ", cascade " << c;
+                float cascadeEnd = cascades[c].range.x + cascades[c].range.y;
+                float nextStart = (c + 1 < partition.cascadeCount) ? cascades[c + 1].range.x : end;
+                EXPECT_LE(std::abs(cascadeEnd - nextStart), 1e-4f) << "mode " << mode << ", cascade " << c;
+            }
+
+            // The crop of each cascade maps a point on the camera axis inside the cascade into the shadow-map
+            for (uint32_t c = 0; c < partition.cascadeCount; c++)
+            {
+                float ndc = cascades[c].range.x + 0.5f * cascades[c].range.y;
+                vec4 posW = glm::inverse(partition.camProjMat) * vec4(0, 0, ndc, 1);
+                vec4 posL = partition.globalMat * (posW / posW.w);
+                vec3 posCascade = vec3(posL) / posL.w * vec3(cascades[c].scale) + vec3(cascades[c].offset);
+                EXPECT(glm::all(glm::lessThanEqual(glm::abs(vec2(posCascade)), vec2(1.0f)))) << "mode " << mode << ", cascade " << c;
+                EXPECT(posCascade.z >= 0.0f && posCascade.z <= 1.0f) << "mode " << mode << ", cascade " << c;
+            }
+        }
+
+        // A single cascade covers everything
+        CsmPartitionData partition = createPartitionData(1, CsmPartitionPssm);
+        CsmCascadeData cascade;
+        SdsmReduction::partitionCascades(partition, vec2(0.2f, 0.3f), &cascade);
+        EXPECT(cascade.scale == vec4(1));
+        EXPECT(cascade.offset == vec4(0));
+        EXPECT_EQ(cascade.range.x, 0.0f);
+        EXPECT_EQ(cascade.range.y, 1.0f);
+    }
+
+    CPU_TEST(SdsmCullingCascades)
+    {
+        for (uint32_t mode : { CsmPartitionLinear, CsmPartitionLogarithmic, CsmPartitionPssm })
+        {
+            CsmPartitionData partition = createPartitionData(4, mode);
+            partition.cascadeBlendThreshold = 0.2f;
+            CsmCascadeData culling[CSM_MAX_CASCADES];
+            SdsmReduction::partitionCullingCascades(partition, vec2(0.05f, 0.6f), culling);
+
+            // The distance range of a later frame moved by less than a cascade. Its cascades must be inside the culling cascades.
+            CsmCascadeData cascades[CSM_MAX_CASCADES];
+            SdsmReduction::partitionCascades(partition, vec2(0.07f, 0.55f), cascades);
+            for (uint32_t c = 0; c < partition.cascadeCount; c++)
+            {
+                vec4 outer = calcCascadeBounds(culling[c]);
+                vec4 inner = calcCascadeBounds(cascades[c]);
+                EXPECT(outer.x <= inner.x && outer.y <= inner.y && outer.z >= inner.z && outer.w >= inner.w) << "mode " << mode << ", cascade " << c;
+            }
+        }
+    }
+
+    GPU_TEST(SdsmPartitionMatchesShader)
+    {
+        const uint32_t width = 64, height = 48;
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> distanceDist(5.0f, 40.0f);
+        SdsmReduction::UniquePtr pReduction = SdsmReduction::create(0);
+
+        for (uint32_t mode : { CsmPartitionLinear, CsmPartitionLogarithmic, CsmPartitionPssm })
+        {
+            CsmPartitionData partition = createPartitionData(4, mode);
+            partition.cascadeBlendThreshold = 0.1f;
+            std::vector<float> depth(width * height);
+            for (auto& d : depth)
+            {
+                d = (rng() % 4 == 0) ? 1.0f : calcDepth(partition, distanceDist(rng));
+            }
+            Texture::SharedPtr pDepth = Texture::create2D(width, height, ResourceFormat::R32Float, 1, 1, depth.data(), Resource::BindFlags::ShaderResource);
+
+            // Without latency, the bounds of this call are returned
+            vec2 bounds = pReduction->execute(ctx.getRenderContext(), pDepth, partition);
+            vec2 cpuBounds = SdsmReduction::reduceDepth(depth.data(), width, height);
+            EXPECT_EQ(bounds.x, cpuBounds.x) << "mode " << mode;
+            EXPECT_EQ(bounds.y, cpuBounds.y) << "mode " << mode;
+
+            CsmCascadeData cpu[CSM_MAX_CASCADES];
+            SdsmReduction::partitionCascades(partition, SdsmReduction::calcDistanceRange(partition, cpuBounds), cpu);
+            const CsmCascadeData* pGpu = reinterpret_cast<const CsmCascadeData*>(pReduction->getCascadeBuffer()->map(Buffer::MapType::Read));
+            for (uint32_t c = 0; c < partition.cascadeCount; c++)
+            {
+                for (uint32_t i = 0; i < 4; i++)
+                {
+                    EXPECT(isNear(pGpu[c].scale[i], cpu[c].scale[i])) << "mode " << mode << ", cascade " << c << ", scale " << pGpu[c].scale[i] << " vs " << cpu[c].scale[i];
+                    EXPECT(isNear(pGpu[c].offset[i], cpu[c].offset[i])) << "mode " << mode << ", cascade " << c << ", offset " << pGpu[c].offset[i] << " vs " << cpu[c].offset[i];
+                }
+                EXPECT(isNear(pGpu[c].range.x, cpu[c].range.x)) << "mode " << mode << ", cascade " << c;
+                EXPECT(isNear(pGpu[c].range.y, cpu[c].range.y)) << "mode " << mode << ", cascade " << c;
+            }
+            pReduction->getCascadeBuffer()->unmap();
+        }
+    }
+}
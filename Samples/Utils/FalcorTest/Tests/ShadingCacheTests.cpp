@@ -0,0 +1,104 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Effects/ShadingCache/ShadingCache.h"
+#include <vector>
+
+namespace Falcor
+{
+    namespace
+    {
+        ShadingCacheData createData(uint32_t refreshPeriod, uint32_t frameIndex)
+        {
+            ShadingCacheData data = {};
+            data.refreshPeriod = refreshPeriod;
+            data.frameIndex = frameIndex;
+            return data;
+        }
+    }
+
+    // The dither indices of a 4x4 block are a permutation of 0..15, and tile the screen
+    CPU_TEST(ShadingCacheDitherIsPermutation)
+    {
+        uint32_t seen = 0;
+        for (uint32_t y = 0; y < 4; y++)
+        {
+            for (uint32_t x = 0; x < 4; x++)
+            {
+                uint32_t index = getShadingCacheDitherIndex(x, y);
+                EXPECT(index < 16);
+                seen |= 1u << index;
+                EXPECT_EQ(getShadingCacheDitherIndex(x + 4, y + 12), index);
+            }
+        }
+        EXPECT_EQ(seen, 0xffffu);
+
+        // Consecutive indices are never neighbors
+        EXPECT_EQ(getShadingCacheDitherIndex(0, 0), 0u);
+        EXPECT_EQ(getShadingCacheDitherIndex(1, 1), 4u);
+        EXPECT_EQ(getShadingCacheDitherIndex(2, 0), 2u);
+    }
+
+    // Every pixel is refreshed exactly once per period, and power-of-two periods refresh the same number of pixels in every 4x4 block each frame
+    CPU_TEST(ShadingCacheRefreshCoversEveryPixel)
+    {
+        const uint32_t size = 12;
+        for (uint32_t period = 1; period <= 16; period++)
+        {
+            std::vector<uint32_t> refreshCount(size * size, 0);
+            for (uint32_t frame = 100; frame < 100 + period; frame++)
+            {
+                ShadingCacheData data = createData(period, frame);
+                for (uint32_t by = 0; by < size; by += 4)
+                {
+                    for (uint32_t bx = 0; bx < size; bx += 4)
+                    {
+                        uint32_t blockCount = 0;
+                        for (uint32_t y = by; y < by + 4; y++)
+                        {
+                            for (uint32_t x = bx; x < bx + 4; x++)
+                            {
+                                if (isShadingCacheRefreshPixel(data, x, y))
+                                {
+                                    refreshCount[y * size + x]++;
+                                    blockCount++;
+                                }
+                            }
+                        }
+                        if ((period & (period - 1)) == 0)
+                        {
+                            EXPECT_EQ(blockCount, 16 / period) << "period " << period;
+                        }
+                    }
+                }
+            }
+
+            for (uint32_t c : refreshCount) EXPECT_EQ(c, 1u) << "period " << period;
+        }
+    }
+}
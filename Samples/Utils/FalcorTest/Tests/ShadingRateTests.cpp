@@ -0,0 +1,187 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Effects/ShadingRate/ShadingRateGenerator.h"
+#include "Utils/ImageMetrics.h"
+#include <cmath>
+#include <vector>
+
+namespace Falcor
+{
+    namespace
+    {
+        ShadingRateData createData(uint32_t maxRate, float motionScale)
+        {
+            ShadingRateData data = {};
+            data.tileSize = 8;
+            data.maxRate = maxRate;
+            data.contrastThreshold = 0.15f;
+            data.motionScale = motionScale;
+            return data;
+        }
+
+        std::vector<uint8_t> createImage(uint32_t width, uint32_t height)
+        {
+            std::vector<uint8_t> image(size_t(width) * height * 4);
+            for (size_t i = 0; i < image.size(); i++)
+            {
+                image[i] = uint8_t((i * 37 + (i >> 6) * 11) & 0xff);
+            }
+            return image;
+        }
+    }
+
+    // Flat tiles get the coarsest rate, and the rate refines as the contrast relative to the mean grows
+    CPU_TEST(ShadingRateTileContrast)
+    {
+        ShadingRateData data = createData(SHADING_RATE_4X4, 0.0f);
+        EXPECT_EQ(calcTileShadingRate(data, 0.5f, 0.0f, 0.0f), (uint32_t)SHADING_RATE_4X4);
+        EXPECT_EQ(calcTileShadingRate(data, 0.5f, 0.06f * 0.06f, 0.0f), (uint32_t)SHADING_RATE_2X2);
+        EXPECT_EQ(calcTileShadingRate(data, 0.5f, 0.1f * 0.1f, 0.0f), (uint32_t)SHADING_RATE_1X1);
+
+        // The same absolute variation is a higher contrast in a darker tile
+        EXPECT_EQ(calcTileShadingRate(data, 0.2f, 0.06f * 0.06f, 0.0f), (uint32_t)SHADING_RATE_1X1);
+
+        // A black tile with rounding noise in the variance must not divide by zero
+        EXPECT_EQ(calcTileShadingRate(data, 0.0f, -1e-9f, 0.0f), (uint32_t)SHADING_RATE_4X4);
+
+        data.maxRate = SHADING_RATE_2X2;
+        EXPECT_EQ(calcTileShadingRate(data, 0.5f, 0.0f, 0.0f), (uint32_t)SHADING_RATE_2X2);
+    }
+
+    // Motion raises the threshold, so moving detail is shaded coarser
+    CPU_TEST(ShadingRateTileMotion)
+    {
+        ShadingRateData data = createData(SHADING_RATE_4X4, 0.1f);
+        EXPECT_EQ(calcTileShadingRate(data, 0.5f, 0.1f * 0.1f, 0.0f), (uint32_t)SHADING_RATE_1X1);
+        EXPECT_EQ(calcTileShadingRate(data, 0.5f, 0.1f * 0.1f, 10.0f), (uint32_t)SHADING_RATE_2X2);
+        EXPECT_EQ(calcTileShadingRate(data, 0.5f, 0.1f * 0.1f, 40.0f), (uint32_t)SHADING_RATE_4X4);
+    }
+
+    CPU_TEST(ShadingRateCost)
+    {
+        EXPECT_EQ(getShadingRateCost(SHADING_RATE_1X1), 1.0f);
+        EXPECT_EQ(getShadingRateCost(SHADING_RATE_2X2), 0.25f);
+        EXPECT_EQ(getShadingRateCost(SHADING_RATE_4X4), 0.0625f);
+        EXPECT_EQ(getShadingRateCost(0x1), 0.5f);  // 1x2
+        EXPECT_EQ(getShadingRateCost(0x4), 0.5f);  // 2x1
+    }
+
+    // A 20x12 target with 8x8 tiles. The tiles on the right and bottom edges are only partially covered.
+    CPU_TEST(ShadingRateCpuImage)
+    {
+        const uint32_t width = 20;
+        const uint32_t height = 12;
+        ShadingRateData data = createData(SHADING_RATE_4X4, 0.1f);
+
+        // A checkerboard in the left column of tiles, flat everywhere else
+        std::vector<glm::vec4> color(width * height, glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < 8; x++)
+            {
+                color[y * width + x] = ((x ^ y) & 1) ? glm::vec4(0.7f, 0.7f, 0.7f, 1.0f) : glm::vec4(0.3f, 0.3f, 0.3f, 1.0f);
+            }
+        }
+
+        std::vector<uint8_t> rates;
+        ShadingRateGenerator::generate(data, color.data(), nullptr, width, height, rates);
+        EXPECT_EQ(rates.size(), 6u);
+        for (uint32_t tile = 0; tile < rates.size(); tile++)
+        {
+            uint32_t expected = (tile % 3 == 0) ? SHADING_RATE_1X1 : SHADING_RATE_4X4;
+            EXPECT_EQ((uint32_t)rates[tile], expected) << "tile " << tile;
+        }
+
+        // 8x12 pixels at full rate, 12x12 pixels at 1/16
+        float cost = ShadingRateGenerator::calcShadingCost(rates.data(), data.tileSize, width, height);
+        EXPECT_LE(std::abs(cost - (96.0f + 144.0f / 16.0f) / 240.0f), 1e-6f);
+
+        // Fast motion in the top-left tile makes it coarser. The motion vectors are in UV units.
+        std::vector<glm::vec2> motion(width * height, glm::vec2(0.0f));
+        motion[0] = glm::vec2(1.0f, 0.0f);
+        ShadingRateGenerator::generate(data, color.data(), motion.data(), width, height, rates);
+        EXPECT_GT((uint32_t)rates[0], (uint32_t)SHADING_RATE_1X1);
+        EXPECT_EQ((uint32_t)rates[3], (uint32_t)SHADING_RATE_1X1);
+    }
+
+    CPU_TEST(ImageMetricsIdentical)
+    {
+        std::vector<uint8_t> image = createImage(32, 16);
+        ImageMetrics::Result result = ImageMetrics::compare(image.data(), image.data(), 32, 16);
+        EXPECT_EQ(result.mse, 0.0);
+        EXPECT(std::isinf(result.psnr));
+        EXPECT_LE(std::abs(result.ssim - 1.0), 1e-9);
+        EXPECT_EQ(result.maxError, 0u);
+        EXPECT_EQ(result.errorFraction, 0.0);
+    }
+
+    CPU_TEST(ImageMetricsKnownError)
+    {
+        const uint32_t width = 32;
+        const uint32_t height = 16;
+        std::vector<uint8_t> reference(width * height * 4, 100);
+        std::vector<uint8_t> test = reference;
+
+        // Offset every color channel by 4, and the alpha channel by a lot to check that it's ignored
+        for (size_t i = 0; i < test.size(); i++)
+        {
+            test[i] = (i % 4 == 3) ? 0 : 104;
+        }
+        // One pixel with a visible error
+        test[0] = 120;
+
+        ImageMetrics::Result result = ImageMetrics::compare(reference.data(), test.data(), width, height);
+        double mse = (16.0 * (width * height * 3 - 1) + 400.0) / (width * height * 3);
+        EXPECT_LE(std::abs(result.mse - mse), 1e-9);
+        EXPECT_LE(std::abs(result.psnr - 10.0 * std::log10(255.0 * 255.0 / mse)), 1e-9);
+        EXPECT_EQ(result.maxError, 20u);
+        EXPECT_LE(std::abs(result.errorFraction - 1.0 / (width * height)), 1e-12);
+        EXPECT_LT(result.ssim, 1.0);
+        EXPECT_GT(result.ssim, 0.9);
+    }
+
+    // Structure matters more to SSIM than a small uniform offset
+    CPU_TEST(ImageMetricsSsimStructure)
+    {
+        const uint32_t width = 16;
+        const uint32_t height = 16;
+        std::vector<uint8_t> reference = createImage(width, height);
+        std::vector<uint8_t> offset = reference;
+        std::vector<uint8_t> flat(reference.size(), 128);
+        for (uint8_t& v : offset) v = uint8_t(std::min(255, v + 3));
+
+        double offsetSsim = ImageMetrics::calcSsim(reference.data(), offset.data(), width, height, 0);
+        double flatSsim = ImageMetrics::calcSsim(reference.data(), flat.data(), width, height, 0);
+        EXPECT_GT(offsetSsim, 0.9);
+        EXPECT_LT(flatSsim, 0.1);
+
+        // Smaller than a window
+        EXPECT_LE(std::abs(ImageMetrics::calcSsim(reference.data(), reference.data(), 4, 4, 1) - 1.0), 1e-9);
+    }
+}
@@ -0,0 +1,98 @@
+/***************************************************************************
+# Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Utils/SpectralIoR.h"
+#include "Data/HostDevicePolarization.h"
+
+namespace Falcor
+{
+    CPU_TEST(SpectralIoRParseCsv)
+    {
+        // Separate n and k sections, out of order
+        SpectralIoR::Material material;
+        EXPECT(SpectralIoR::parseCsv("wl,n\n0.6,2.0\n0.4,1.0\n\nwl,k\n0.4,3.0\n0.6,5.0\n", material));
+        EXPECT_EQ(material.n.size(), 2u);
+        EXPECT_EQ(material.k.size(), 2u);
+        EXPECT(SpectralIoR::evaluate(material, 500.0f) == vec2(1.5f, 4.0f));
+        EXPECT(SpectralIoR::evaluate(material, 300.0f) == vec2(1.0f, 3.0f));
+        EXPECT(SpectralIoR::evaluate(material, 700.0f) == vec2(2.0f, 5.0f));
+
+        // A single section with all three columns, with Windows line endings
+        EXPECT(SpectralIoR::parseCsv("wl,n,k\r\n0.5,1.5,0.25\r\n", material));
+        EXPECT(SpectralIoR::evaluate(material, 500.0f) == vec2(1.5f, 0.25f));
+
+        EXPECT_EQ(SpectralIoR::parseCsv("wl,k\n0.5,1.0\n", material), false);
+    }
+
+    // The Fresnel equations must agree with the shared psi and R0 functions
+    CPU_TEST(SpectralIoRFresnel)
+    {
+        for (float n : { 0.2f, 1.0f, 1.5f, 2.9f })
+        {
+            for (float k : { 0.0f, 0.5f, 3.4f })
+            {
+                vec2 R = SpectralIoR::evaluateFresnel(n, k, 1.0f);
+                EXPECT_LE(std::abs(0.5f * (R.x + R.y) - SpecularFromIOR(float3(n), float3(k)).x), 1e-5f) << "n = " << n << ", k = " << k;
+
+                // An index-matched surface reflects nothing, so psi is undefined
+                if (n == 1.0f && k == 0.0f) continue;
+
+                for (float ct : { 0.1f, 0.4f, 0.8f })
+                {
+                    R = SpectralIoR::evaluateFresnel(n, k, ct);
+                    float psi = (R.x - R.y) / (R.x + R.y);
+                    EXPECT_LE(std::abs(psi - psi_Exact(float3(n), float3(k), ct, 1.0f - ct * ct).x), 1e-4f) << "n = " << n << ", k = " << k << ", cos(theta) = " << ct;
+                }
+            }
+        }
+    }
+
+    // A spectrally constant material must integrate to its own n and k
+    CPU_TEST(SpectralIoRIntegrateConstant)
+    {
+        SpectralIoR::Material metal;
+        metal.n = { vec2(300.0f, 0.5f), vec2(800.0f, 0.5f) };
+        metal.k = { vec2(300.0f, 3.0f), vec2(800.0f, 3.0f) };
+        SpectralIoR::RgbMaterial result = SpectralIoR::integrate(metal);
+        EXPECT_EQ(result.isDielectric, false);
+        EXPECT_LE(result.fitError, 1e-4f);
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            EXPECT_LE(std::abs(result.n[c] - 0.5f), 1e-2f) << "channel " << c;
+            EXPECT_LE(std::abs(result.k[c] - 3.0f), 1e-2f) << "channel " << c;
+            EXPECT_LE(std::abs(result.R0[c] - SpecularFromIOR(float3(0.5f), float3(3.0f)).x), 1e-4f) << "channel " << c;
+        }
+
+        SpectralIoR::Material glass;
+        glass.n = { vec2(500.0f, 1.5f) };
+        result = SpectralIoR::integrate(glass);
+        EXPECT_EQ(result.isDielectric, true);
+        EXPECT(result.k == vec3(0.0f));
+        EXPECT_LE(std::abs(result.n.g - 1.5f), 1e-2f);
+    }
+}
@@ -0,0 +1,102 @@
+/***************************************************************************
+# Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Utils/TextureBaker.h"
+#include "Utils/BlockCompression.h"
+
+namespace Falcor
+{
+    // Filtering a constant image must not change its value, for any level of the chain.
+    CPU_TEST(TextureBakerConstantMipChain)
+    {
+        TextureBaker::Image image;
+        image.width = 37;
+        image.height = 20;
+        image.texels.assign(image.width * image.height, vec4(0.25f, 0.5f, 0.75f, 1.0f));
+
+        for (auto filter : { TextureBaker::MipFilter::Box, TextureBaker::MipFilter::Kaiser })
+        {
+            auto mips = TextureBaker::generateMipChain(image, filter);
+            EXPECT_EQ(mips.size(), 6u);
+            EXPECT_EQ(mips.back().width, 1u);
+            EXPECT_EQ(mips.back().height, 1u);
+
+            for (const auto& mip : mips)
+            {
+                EXPECT_EQ(mip.texels.size(), mip.width * mip.height);
+                for (const auto& t : mip.texels)
+                {
+                    EXPECT_LT(std::abs(t.x - 0.25f), 1e-4f);
+                    EXPECT_LT(std::abs(t.w - 1.0f), 1e-4f);
+                }
+            }
+        }
+    }
+
+    // Encode a diagonal gradient and check the decoded result is close to the source.
+    // All channels vary along the same line, which every format can represent with a single endpoint pair.
+    CPU_TEST(BlockCompressionRoundTrip)
+    {
+        uint8_t texels[64];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            uint32_t t = (i % 4) + (i / 4);
+            texels[i * 4 + 0] = uint8_t(40 + t * 15);
+            texels[i * 4 + 1] = uint8_t(200 - t * 12);
+            texels[i * 4 + 2] = uint8_t(90 + t * 10);
+            texels[i * 4 + 3] = uint8_t(255 - t * 20);
+        }
+
+        struct Case { ResourceFormat format; uint32_t channels; int32_t maxError; };
+        const Case cases[] =
+        {
+            { ResourceFormat::BC1Unorm, 3, 20 },
+            { ResourceFormat::BC3Unorm, 4, 20 },
+            { ResourceFormat::BC5Unorm, 2, 8 },
+            { ResourceFormat::BC7Unorm, 4, 6 },
+        };
+
+        for (const auto& c : cases)
+        {
+            std::vector<uint8_t> blocks = BlockCompression::compressImage(c.format, 4, 4, texels, 1);
+            EXPECT_EQ(blocks.size(), (size_t)getFormatBytesPerBlock(c.format));
+
+            uint8_t decoded[64];
+            EXPECT(BlockCompression::decodeBlock(c.format, blocks.data(), decoded));
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                for (uint32_t ch = 0; ch < c.channels; ch++)
+                {
+                    int32_t diff = std::abs(int32_t(decoded[i * 4 + ch]) - int32_t(texels[i * 4 + ch]));
+                    EXPECT_LE(diff, c.maxError) << "format = " << to_string(c.format) << ", texel = " << i << ", channel = " << ch;
+                }
+            }
+        }
+    }
+
+}  // namespace Falcor
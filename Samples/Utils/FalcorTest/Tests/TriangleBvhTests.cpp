@@ -0,0 +1,115 @@
+/***************************************************************************
+# Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "UnitTest.h"
+#include "Utils/TriangleBvh.h"
+#include <random>
+
+namespace Falcor
+{
+    namespace
+    {
+        bool intersectBruteForce(const std::vector<vec3>& positions, const vec3& origin, const vec3& dir, float tMax, TriangleBvh::Hit& hit)
+        {
+            bool found = false;
+            for (uint32_t i = 0; i < positions.size() / 3; i++)
+            {
+                vec3 e1 = positions[i * 3 + 1] - positions[i * 3];
+                vec3 e2 = positions[i * 3 + 2] - positions[i * 3];
+                vec3 p = glm::cross(dir, e2);
+                float invDet = 1.0f / glm::dot(e1, p);
+                vec3 s = origin - positions[i * 3];
+                float u = glm::dot(s, p) * invDet;
+                vec3 q = glm::cross(s, e1);
+                float v = glm::dot(dir, q) * invDet;
+                float t = glm::dot(e2, q) * invDet;
+                if (u >= 0 && v >= 0 && u + v <= 1 && t > 0 && t < tMax)
+                {
+                    tMax = t;
+                    hit = { t, i, u, v };
+                    found = true;
+                }
+            }
+            return found;
+        }
+    }
+
+    // The BVH must return the same closest hit as testing every triangle
+    CPU_TEST(TriangleBvhMatchesBruteForce)
+    {
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+        // Small random triangles in a box, plus a large floor and a cluster of identical triangles to exercise the degenerate splits
+        std::vector<vec3> positions;
+        for (uint32_t i = 0; i < 2000; i++)
+        {
+            vec3 center(unit(rng) * 10.0f, unit(rng) * 10.0f, unit(rng) * 10.0f);
+            for (uint32_t j = 0; j < 3; j++) positions.push_back(center + vec3(unit(rng), unit(rng), unit(rng)));
+        }
+        positions.insert(positions.end(), { vec3(-20, -11, -20), vec3(20, -11, -20), vec3(0, -11, 20) });
+        for (uint32_t i = 0; i < 20; i++)
+        {
+            positions.insert(positions.end(), { vec3(0, 12, 0), vec3(1, 12, 0), vec3(0, 12, 1) });
+        }
+
+        TriangleBvh bvh;
+        bvh.build(positions);
+        EXPECT_EQ(bvh.getTriangleCount(), (uint32_t)positions.size() / 3);
+
+        uint32_t hitCount = 0;
+        for (uint32_t i = 0; i < 2000; i++)
+        {
+            vec3 origin(unit(rng) * 15.0f, unit(rng) * 15.0f, unit(rng) * 15.0f);
+            vec3 dir = glm::normalize(vec3(unit(rng), unit(rng), unit(rng)));
+            if (i % 100 == 0) dir = vec3(0, i % 200 ? 1.0f : -1.0f, 0);
+            float tMax = (i % 3 == 0) ? 5.0f : 100.0f;
+
+            TriangleBvh::Hit expected, hit;
+            bool expectedFound = intersectBruteForce(positions, origin, dir, tMax, expected);
+            bool found = bvh.intersect(origin, dir, tMax, hit);
+            EXPECT_EQ(found, expectedFound) << "ray " << i;
+            EXPECT_EQ(bvh.occluded(origin, dir, tMax), expectedFound) << "ray " << i;
+            if (found && expectedFound)
+            {
+                // Coplanar triangles can tie, so compare the distance rather than the index
+                EXPECT_LE(std::abs(hit.t - expected.t), 1e-4f * expected.t) << "ray " << i;
+                hitCount++;
+            }
+        }
+        EXPECT_LE(200u, hitCount);
+    }
+
+    CPU_TEST(TriangleBvhEmpty)
+    {
+        TriangleBvh bvh;
+        bvh.build({});
+        TriangleBvh::Hit hit;
+        EXPECT_EQ(bvh.intersect(vec3(0.0f), vec3(0, 0, 1), 100.0f, hit), false);
+        EXPECT_EQ(bvh.occluded(vec3(0.0f), vec3(0, 0, 1), 100.0f), false);
+    }
+}
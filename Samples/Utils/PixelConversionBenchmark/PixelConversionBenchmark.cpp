@@ -0,0 +1,162 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Falcor.h"
+#include "Utils/PixelConversion.h"
+#include <cstdio>
+#include <random>
+
+using namespace Falcor;
+using namespace Falcor::PixelConversion;
+
+static const char* kUsage = R"(usage: PixelConversionBenchmark [-size <width> <height>] [-iterations <count>]
+  -size        Image size in pixels. Defaults to 2048x2048.
+  -iterations  Number of times each kernel runs. Defaults to 20.
+)";
+
+static const char* getLayoutName(Layout layout)
+{
+    switch (layout)
+    {
+    case Layout::RGBA8:         return "RGBA8";
+    case Layout::BGRA8:         return "BGRA8";
+    case Layout::BGRX8:         return "BGRX8";
+    case Layout::RGB8:          return "RGB8";
+    case Layout::BGR8:          return "BGR8";
+    case Layout::RGBA32Float:   return "RGBA32Float";
+    default:                    should_not_get_here(); return "";
+    }
+}
+
+/** Returns the average time of a function in milliseconds
+*/
+template<typename Func>
+static float measure(uint32_t iterations, const Func& func)
+{
+    func(); // Warm up the caches
+    auto start = CpuTimer::getCurrentTimePoint();
+    for (uint32_t i = 0; i < iterations; i++) func();
+    return CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / iterations;
+}
+
+static void printResult(const char* name, uint32_t pixelCount, float kernelMs, float genericMs, bool match)
+{
+    double mpix = pixelCount / 1.0e6;
+    fprintf(stdout, "%-30s %10.1f %10.1f %8.2fx  %s\n", name, mpix / (kernelMs / 1000.0), mpix / (genericMs / 1000.0), genericMs / kernelMs, match ? "OK" : "MISMATCH");
+}
+
+/** Measures the throughput of the PixelConversion kernels against the per-pixel reference path, and checks that both produce the same output.
+*/
+int main(int argc, char** argv)
+{
+    Logger::initialize();
+    Logger::showBoxOnError(false);
+
+    ArgList args;
+    args.parseCommandLine(concatCommandLine(argc, argv));
+    if (args.argExists("h") || args.argExists("help"))
+    {
+        fprintf(stderr, "%s", kUsage);
+        return 0;
+    }
+
+    uint32_t width = 2048;
+    uint32_t height = 2048;
+    if (args.argExists("size"))
+    {
+        std::vector<ArgList::Arg> size = args.getValues("size");
+        if (size.size() != 2)
+        {
+            fprintf(stderr, "%s", kUsage);
+            return 1;
+        }
+        width = size[0].asUint();
+        height = size[1].asUint();
+    }
+    uint32_t iterations = args.argExists("iterations") ? std::max(args["iterations"].asUint(), 1u) : 20;
+    const uint32_t pixelCount = width * height;
+
+    // Random source data. Float data covers values outside [0, 1] to exercise clamping.
+    std::mt19937 rng(0);
+    std::vector<uint8_t> src8(size_t(pixelCount) * 4);
+    for (auto& b : src8) b = (uint8_t)rng();
+    std::vector<float> srcFloat(size_t(pixelCount) * 4);
+    std::uniform_real_distribution<float> dist(-0.25f, 1.25f);
+    for (auto& f : srcFloat) f = dist(rng);
+
+    std::vector<uint8_t> dst(size_t(pixelCount) * 16);
+    std::vector<uint8_t> ref(size_t(pixelCount) * 16);
+
+    fprintf(stdout, "%ux%u, %u iterations\n", width, height, iterations);
+    fprintf(stdout, "%-30s %10s %10s %9s\n", "Conversion", "Kernel", "Generic", "Speedup");
+    fprintf(stdout, "%-30s %10s %10s\n", "", "(MPix/s)", "(MPix/s)");
+
+    static const std::pair<Layout, Layout> kPairs[] =
+    {
+        { Layout::RGBA8, Layout::BGRA8 },
+        { Layout::RGBA8, Layout::BGRX8 },
+        { Layout::RGB8, Layout::RGBA8 },
+        { Layout::BGR8, Layout::RGBA8 },
+        { Layout::RGBA32Float, Layout::RGBA8 },
+        { Layout::RGBA32Float, Layout::BGRA8 },
+        { Layout::RGBA8, Layout::RGBA32Float },
+    };
+
+    bool allMatch = true;
+    for (const auto& pair : kPairs)
+    {
+        const void* pSrc = (pair.first == Layout::RGBA32Float) ? (const void*)srcFloat.data() : (const void*)src8.data();
+        size_t dstSize = size_t(pixelCount) * getPixelSize(pair.second);
+
+        float kernelMs = measure(iterations, [&]() { convertPixels(pair.first, pair.second, pSrc, dst.data(), pixelCount); });
+        float genericMs = measure(iterations, [&]() { convertPixelsGeneric(pair.first, pair.second, pSrc, ref.data(), pixelCount); });
+        bool match = std::equal(dst.begin(), dst.begin() + dstSize, ref.begin());
+        allMatch = allMatch && match;
+
+        std::string name = std::string(getLayoutName(pair.first)) + " -> " + getLayoutName(pair.second);
+        printResult(name.c_str(), pixelCount, kernelMs, genericMs, match);
+    }
+
+    // Even dimensions use the SIMD box filter, odd ones the polyphase filter
+    for (uint32_t odd = 0; odd < 2; odd++)
+    {
+        uint32_t w = (width & ~1u) - odd;
+        uint32_t h = (height & ~1u) - odd;
+        if (w <= 1 || h <= 1) continue;
+        size_t dstSize = size_t(std::max(w / 2, 1u)) * std::max(h / 2, 1u) * 4;
+
+        float kernelMs = measure(iterations, [&]() { downscale2x(src8.data(), w, h, dst.data()); });
+        float genericMs = measure(iterations, [&]() { downscale2xGeneric(src8.data(), w, h, ref.data()); });
+        bool match = std::equal(dst.begin(), dst.begin() + dstSize, ref.begin());
+        allMatch = allMatch && match;
+
+        printResult(odd ? "downscale2x (odd size)" : "downscale2x", w * h, kernelMs, genericMs, match);
+    }
+
+    Logger::shutdown();
+    return allMatch ? 0 : 1;
+}
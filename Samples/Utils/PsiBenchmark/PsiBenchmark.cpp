@@ -0,0 +1,116 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION.
+# Copyright (c) 2020, Viktor Enfeldt.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Falcor.h"
+#include <cstdio>
+#include <random>
+
+using namespace Falcor;
+using namespace Falcor::Polarization;
+
+static const char* kUsage = R"(usage: PsiBenchmark [-count <elements>] [-iterations <count>]
+  -count       Number of elements per batch. Defaults to 4M.
+  -iterations  Number of times each function runs. Defaults to 20.
+)";
+
+/** Returns the average time of a function in milliseconds
+*/
+template<typename Func>
+static float measure(uint32_t iterations, const Func& func)
+{
+    func(); // Warm up the caches
+    auto start = CpuTimer::getCurrentTimePoint();
+    for (uint32_t i = 0; i < iterations; i++) func();
+    return CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / iterations;
+}
+
+/** Measures the throughput of the SIMD psi kernels against the generic path, and checks that both produce the same output.
+*/
+int main(int argc, char** argv)
+{
+    Logger::initialize();
+    Logger::showBoxOnError(false);
+
+    ArgList args;
+    args.parseCommandLine(concatCommandLine(argc, argv));
+    if (args.argExists("h") || args.argExists("help"))
+    {
+        fprintf(stderr, "%s", kUsage);
+        return 0;
+    }
+
+    uint32_t count = args.argExists("count") ? std::max(args["count"].asUint(), 1u) : 4 * 1024 * 1024;
+    uint32_t iterations = args.argExists("iterations") ? std::max(args["iterations"].asUint(), 1u) : 20;
+
+    // Random inputs covering the ranges used by the renderers
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> n(count), k(count), R0(count), cosTheta(count), sin2Theta(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        n[i] = 0.2f + 3.0f * dist(rng);
+        k[i] = 5.0f * dist(rng);
+        R0[i] = 0.95f * dist(rng);
+        cosTheta[i] = dist(rng);
+        sin2Theta[i] = 1.0f - cosTheta[i] * cosTheta[i];
+    }
+
+    PsiInputs inputs;
+    inputs.pN = n.data();
+    inputs.pK = k.data();
+    inputs.pR0 = R0.data();
+    inputs.pCosTheta = cosTheta.data();
+    inputs.pSin2Theta = sin2Theta.data();
+
+    std::vector<float> result(count);
+    std::vector<float> reference(count);
+
+    fprintf(stdout, "%u elements, %u iterations, %s kernels\n", count, iterations, getSimdName());
+    fprintf(stdout, "%-20s %10s %10s %9s %10s\n", "Function", "Kernel", "Generic", "Speedup", "Max error");
+    fprintf(stdout, "%-20s %10s %10s\n", "", "(M/s)", "(M/s)");
+
+    // The kernels can differ from the reference in the last bit when the compiler contracts the reference to FMAs
+    const float kTolerance = 1e-6f;
+    bool allMatch = true;
+    for (PsiModel model : { PsiModel::Exact, PsiModel::MetalApprox, PsiModel::DielectricExact, PsiModel::DielectricOneFive })
+    {
+        float kernelMs = measure(iterations, [&]() { evaluatePsi(model, inputs, result.data(), count); });
+        float genericMs = measure(iterations, [&]() { evaluatePsiGeneric(model, inputs, reference.data(), count); });
+
+        float maxError = 0;
+        for (uint32_t i = 0; i < count; i++) maxError = std::max(maxError, std::abs(result[i] - reference[i]));
+        allMatch = allMatch && maxError <= kTolerance;
+
+        double m = count / 1.0e6;
+        fprintf(stdout, "%-20s %10.1f %10.1f %8.2fx %10.2g  %s\n", getPsiModelName(model), m / (kernelMs / 1000.0), m / (genericMs / 1000.0), genericMs / kernelMs, maxError, maxError <= kTolerance ? "OK" : "MISMATCH");
+    }
+
+    Logger::shutdown();
+    return allMatch ? 0 : 1;
+}